@@ -0,0 +1,299 @@
+#pragma once
+
+#include "Core.h"
+#include "Shaders.h"
+#include "PSO.h"
+#include "Mesh.h"
+#include "Frustum.h"
+#include "GEMLoader.h"
+#include "Animation.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+// CPU-side state of one crowd member
+struct CrowdInstance
+{
+    Matrix world;
+    AnimationClip clip = 0;
+    float time = 0.0f;      // Seconds into the clip (clips loop on the GPU)
+    float radius = 0.0f;    // World-space bounding sphere around the world origin of the instance
+};
+
+// Per-instance vertex stream, matches VertexLayoutCache::getAnimatedInstancedLayout
+struct CrowdInstanceGPU
+{
+    Vec4 worldRows[3];      // World matrix rows 0..2 (row 3 is always 0,0,0,1)
+    unsigned int clip;
+    float time;
+    float pad[2];
+};
+
+// ============================================================================
+// AnimatedCrowd
+// ----------------------------------------------------------------------------
+// Many instances of one skinned model, drawn with one DrawIndexedInstanced per sub-mesh.
+// Every clip is sampled once at load time (bakeRate frames per second) into a structured buffer
+// of skinning matrices, so instances carry only a clip, a time and a world transform and the
+// CPU does no per-instance skinning work. Baked frames are blended linearly in the vertex shader.
+// ============================================================================
+class AnimatedCrowd
+{
+public:
+    std::vector<Mesh*> meshes;              // Model sub-meshes (owned)
+    Animation animation;                    // Skeleton + clips (used for baking and clip lookup)
+    Texture texture;                        // Albedo texture SRV
+    std::vector<CrowdInstance> instances;
+
+    std::string shaderName = "AnimatedInstanced";
+    std::string psoName = "AnimatedInstancedPSO";
+
+    float bakeRate = 30.0f;                 // Baked frames per second of clip time
+    float boundsPadding = 1.5f;             // Bind-pose radius multiplier, so animated limbs stay inside
+
+    static const int MAX_CLIPS = 32;        // Size of clipInfo in VSAnimInstanced
+
+    void load(Core* core, const std::string& modelFilename, const std::string& textureFilename,
+        PSOManager* psos, Shaders* shaders, int fromYZX = 0)
+    {
+        GEMLoader::GEMModelLoader loader;
+        std::vector<GEMLoader::GEMMesh> gemmeshes;
+        GEMLoader::GEMAnimation gemanimation;
+        loader.load(modelFilename, gemmeshes, gemanimation);
+
+        modelRadius = 0.0f;
+        for (int i = 0; i < gemmeshes.size(); i++)
+        {
+            Mesh* mesh = new Mesh();
+            std::vector<ANIMATED_VERTEX> vertices;
+            for (int j = 0; j < gemmeshes[i].verticesAnimated.size(); j++)
+            {
+                ANIMATED_VERTEX v;
+                memcpy(&v, &gemmeshes[i].verticesAnimated[j], sizeof(ANIMATED_VERTEX));
+                vertices.push_back(v);
+                modelRadius = (std::max)(modelRadius, v.pos.length());
+            }
+            mesh->init(core, vertices, gemmeshes[i].indices);
+            meshes.push_back(mesh);
+        }
+
+        animation.load(gemanimation);
+        if ((int)animation.clips.size() > MAX_CLIPS)
+        {
+            std::cout << "[AnimatedCrowd] WARNING: " << modelFilename << " has " << animation.clips.size()
+                << " clips, only the first " << MAX_CLIPS << " are baked\n";
+        }
+        bake(core, fromYZX);
+
+        texture = core->loadTexture(textureFilename);
+
+        shaders->load(core, shaderName, "Shaders/VSAnimInstanced.txt", "Shaders/PSAnim.txt");
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("staticMeshBuffer", "VP");
+        clipInfoConstant = shader->getConstantVS("staticMeshBuffer", "clipInfo");
+        skinParamsConstant = shader->getConstantVS("staticMeshBuffer", "skinParams");
+
+        // Clip table and bone count never change after baking
+        clipInfoConstant.set(clipInfo.data());
+        Vec4 skinParams((float)boneCount, 0.0f, 0.0f, 0.0f);
+        skinParamsConstant.set(&skinParams);
+
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
+            VertexLayoutCache::getAnimatedInstancedLayout());
+    }
+
+    // Add an instance; returns its index in instances
+    int add(const Matrix& world, AnimationClip clip, float time = 0.0f)
+    {
+        CrowdInstance instance;
+        instance.world = world;
+        instance.clip = (clip >= 0 && clip < bakedClipCount) ? clip : 0;
+        instance.time = time;
+
+        // Largest axis scale of the world matrix (columns 0..2)
+        float scale = 0.0f;
+        for (int c = 0; c < 3; c++)
+        {
+            Vec3 axis(world.a[0][c], world.a[1][c], world.a[2][c]);
+            scale = (std::max)(scale, axis.length());
+        }
+        instance.radius = modelRadius * scale * boundsPadding;
+
+        instances.push_back(instance);
+        return (int)instances.size() - 1;
+    }
+
+    // Advance every instance's clock (they loop on the GPU, so no wrapping is needed here)
+    void update(float dt)
+    {
+        for (auto& instance : instances)
+        {
+            instance.time += dt;
+        }
+    }
+
+    // Frustum-cull the instances and draw the survivors; returns how many were drawn
+    int draw(Core* core, PSOManager* psos, Shaders* shaders, const Matrix& vp)
+    {
+        if (instances.empty() || bakedBones == nullptr)
+            return 0;
+
+        Frustum frustum(vp);
+        int visible = 0;
+        for (const auto& instance : instances)
+        {
+            if (frustum.testSphere(instancePosition(instance), instance.radius))
+                visible++;
+        }
+        if (visible == 0)
+            return 0;
+
+        FrameAllocation alloc = core->frameAllocator.allocate(visible * sizeof(CrowdInstanceGPU), 16);
+        CrowdInstanceGPU* out = (CrowdInstanceGPU*)alloc.cpuAddress;
+        for (const auto& instance : instances)
+        {
+            if (!frustum.testSphere(instancePosition(instance), instance.radius))
+                continue;
+
+            CrowdInstanceGPU gpu;
+            for (int r = 0; r < 3; r++)
+            {
+                gpu.worldRows[r] = Vec4(instance.world.a[r][0], instance.world.a[r][1],
+                    instance.world.a[r][2], instance.world.a[r][3]);
+            }
+            gpu.clip = (unsigned int)instance.clip;
+            gpu.time = instance.time;
+            gpu.pad[0] = gpu.pad[1] = 0.0f;
+            *out++ = gpu; // Write-combined memory: whole-struct stores only
+        }
+
+        vpConstant.set(&vp);
+        shader->apply(core);
+        psos->bind(core, pso);
+
+        core->getCommandList()->SetGraphicsRootDescriptorTable(2, texture.srvHandle);
+        core->getCommandList()->SetGraphicsRootShaderResourceView(3, bakedBones->GetGPUVirtualAddress());
+
+        D3D12_VERTEX_BUFFER_VIEW instanceView;
+        instanceView.BufferLocation = alloc.gpuAddress;
+        instanceView.StrideInBytes = sizeof(CrowdInstanceGPU);
+        instanceView.SizeInBytes = visible * sizeof(CrowdInstanceGPU);
+
+        core->getCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        for (auto* mesh : meshes)
+        {
+            D3D12_VERTEX_BUFFER_VIEW views[2];
+            views[0] = mesh->getVertexBufferView();
+            views[1] = instanceView;
+            core->getCommandList()->IASetVertexBuffers(0, 2, views);
+
+            D3D12_INDEX_BUFFER_VIEW ibView = mesh->getIndexBufferView();
+            core->getCommandList()->IASetIndexBuffer(&ibView);
+
+            core->getCommandList()->DrawIndexedInstanced(mesh->getIndexCount(), visible, 0, 0, 0);
+            core->countDraw(visible);
+        }
+
+        return visible;
+    }
+
+    AnimationClip findClip(const std::string& name) const { return animation.findClip(name); }
+    UINT64 getBakedBytes() const { return bakedBytes; }
+
+    ~AnimatedCrowd()
+    {
+        for (auto* mesh : meshes)
+        {
+            delete mesh;
+        }
+        meshes.clear();
+        if (bakedBones) bakedBones->Release();
+    }
+
+private:
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    ConstantHandle vpConstant;
+    ConstantHandle clipInfoConstant;
+    ConstantHandle skinParamsConstant;
+
+    ID3D12Resource* bakedBones = nullptr;   // StructuredBuffer<float4>: 3 rows per bone per baked frame
+    UINT64 bakedBytes = 0;
+    std::vector<Vec4> clipInfo;             // MAX_CLIPS entries: first frame, frame count, rate, duration
+    int bakedClipCount = 0;
+    int boneCount = 0;
+    float modelRadius = 0.0f;
+
+    static Vec3 instancePosition(const CrowdInstance& instance)
+    {
+        return Vec3(instance.world.a[0][3], instance.world.a[1][3], instance.world.a[2][3]);
+    }
+
+    // Sample every clip at bakeRate with the regular CPU evaluator and upload the skinning matrices
+    void bake(Core* core, int fromYZX)
+    {
+        boneCount = animation.bonesSize();
+        bakedClipCount = (std::min)((int)animation.clips.size(), MAX_CLIPS);
+        clipInfo.assign(MAX_CLIPS, Vec4(0.0f, 1.0f, bakeRate, 1.0f));
+        if (boneCount == 0 || bakedClipCount == 0)
+            return;
+
+        // 64KB of matrices; keep it off the stack
+        std::vector<AnimationInstance> sampler(1);
+        AnimationInstance& pose = sampler[0];
+        pose.init(&animation, fromYZX);
+
+        std::vector<Vec4> rows;
+        int totalFrames = 0;
+        for (int c = 0; c < bakedClipCount; c++)
+        {
+            float duration = animation.clips[c]->duration();
+            int frameCount = (std::max)(1, (int)ceilf(duration * bakeRate));
+            clipInfo[c] = Vec4((float)totalFrames, (float)frameCount, bakeRate, (std::max)(duration, 1e-3f));
+
+            pose.clip = c;
+            for (int f = 0; f < frameCount; f++)
+            {
+                pose.t = (std::min)((float)f / bakeRate, duration);
+                pose.evaluate();
+                for (int b = 0; b < boneCount; b++)
+                {
+                    const Matrix& m = pose.matrices[b];
+                    rows.push_back(Vec4(m.m[0], m.m[1], m.m[2], m.m[3]));
+                    rows.push_back(Vec4(m.m[4], m.m[5], m.m[6], m.m[7]));
+                    rows.push_back(Vec4(m.m[8], m.m[9], m.m[10], m.m[11]));
+                }
+            }
+            totalFrames += frameCount;
+        }
+
+        bakedBytes = rows.size() * sizeof(Vec4);
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Width = bakedBytes;
+        bufferDesc.Height = 1;
+        bufferDesc.DepthOrArraySize = 1;
+        bufferDesc.MipLevels = 1;
+        bufferDesc.SampleDesc.Count = 1;
+        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        HRESULT hr = core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&bakedBones));
+        if (FAILED(hr))
+        {
+            std::cout << "[AnimatedCrowd] ERROR: Failed to create baked bone buffer (" << bakedBytes << " bytes)\n";
+            bakedBones = nullptr;
+            return;
+        }
+
+        core->uploadResource(bakedBones, rows.data(), (unsigned int)bakedBytes,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        std::cout << "[AnimatedCrowd] Baked " << bakedClipCount << " clips, " << totalFrames << " frames x "
+            << boneCount << " bones (" << (bakedBytes / 1024) << " KB)\n";
+    }
+};
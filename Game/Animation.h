@@ -5,6 +5,11 @@
 #include <map>
 
 #include "Maths.h"
+#include "GEMLoader.h"
+
+// Index of a clip in Animation::clips, resolved once from its name with Animation::findClip
+typedef int AnimationClip;
+static const AnimationClip INVALID_CLIP = -1;
 
 struct Bone
 {
@@ -18,6 +23,45 @@ struct Skeleton
 	std::vector<Bone> bones;   // Bone hierarchy
 	Matrix globalInverse;      // Inverse of model/root transform from importer
 
+	// Evaluation order built by sortBones(): parents always precede children. The parent and
+	// offset arrays are stored in that order so the per-frame loop walks them linearly.
+	std::vector<int> order;          // Bone index at each evaluation step
+	std::vector<int> orderParent;    // Parent bone index of order[i] (-1 for roots)
+	std::vector<Matrix> orderOffset; // Offset matrix of order[i]
+
+	void sortBones()
+	{
+		int n = (int)bones.size();
+		std::vector<int> depth(n, -1);
+		for (int i = 0; i < n; i++)
+		{
+			// Walk up to the first bone with a known depth (guards against parent cycles)
+			int d = 0;
+			int b = bones[i].parentIndex;
+			while (b > -1 && depth[b] < 0 && d <= n)
+			{
+				b = bones[b].parentIndex;
+				d++;
+			}
+			depth[i] = d + ((b > -1 && depth[b] >= 0) ? depth[b] + 1 : 0);
+		}
+
+		order.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int x, int y) { return depth[x] < depth[y]; });
+
+		orderParent.resize(n);
+		orderOffset.resize(n);
+		for (int i = 0; i < n; i++)
+		{
+			orderParent[i] = bones[order[i]].parentIndex;
+			orderOffset[i] = bones[order[i]].offset;
+		}
+	}
+
 	// Linear search bone index by name
 	int findBone(std::string name)
 	{
@@ -87,19 +131,25 @@ struct AnimationSequence
 		return std::min(frame + 1, (int)(frames.size() - 1));
 	}
 
-	// Build this bone's global matrix using interpolated local S/R/T and parent global
-	Matrix interpolateBoneToGlobal(Matrix* matrices, int baseFrame, float interpolationFact, Skeleton* skeleton, int boneIndex)
+	// Bone-local transform at an interpolated pose. Builds scale * rotation * translation directly
+	// (rotation columns scaled, translation in the last column) instead of two matrix multiplies.
+	Matrix localTransform(int baseFrame, int nextFrame, float interpolationFact, int boneIndex)
 	{
-		Matrix scale = Matrix::scaling(interpolate(frames[baseFrame].scales[boneIndex], frames[nextFrame(baseFrame)].scales[boneIndex], interpolationFact));
-		Matrix rotation = interpolate(frames[baseFrame].rotations[boneIndex], frames[nextFrame(baseFrame)].rotations[boneIndex], interpolationFact).toMatrix();
-		Matrix translation = Matrix::translation(interpolate(frames[baseFrame].positions[boneIndex], frames[nextFrame(baseFrame)].positions[boneIndex], interpolationFact));
-		Matrix local = scale * rotation * translation;
+		const AnimationFrame& f0 = frames[baseFrame];
+		const AnimationFrame& f1 = frames[nextFrame];
+		Vec3 s = interpolate(f0.scales[boneIndex], f1.scales[boneIndex], interpolationFact);
+		Vec3 p = interpolate(f0.positions[boneIndex], f1.positions[boneIndex], interpolationFact);
+		Matrix local = interpolate(f0.rotations[boneIndex], f1.rotations[boneIndex], interpolationFact).toMatrix();
 
-		if (skeleton->bones[boneIndex].parentIndex > -1)
+		for (int r = 0; r < 3; r++)
 		{
-			Matrix global = local * matrices[skeleton->bones[boneIndex].parentIndex];
-			return global;
+			local.a[r][0] *= s.x;
+			local.a[r][1] *= s.y;
+			local.a[r][2] *= s.z;
 		}
+		local.a[0][3] = p.x;
+		local.a[1][3] = p.y;
+		local.a[2][3] = p.z;
 		return local;
 	}
 };
@@ -110,31 +160,85 @@ public:
 	std::map<std::string, AnimationSequence> animations;  // Named animation clips
 	Skeleton skeleton;                                    // Shared skeleton definition
 
-	// Number of bones in the skeleton
-	int bonesSize()
+	// Clip handles: clips[h] points into animations (map nodes never move), clipNames[h] is its key
+	std::vector<AnimationSequence*> clips;
+	std::vector<std::string> clipNames;
+
+	// Copy skeleton and clips from a loaded .gem file, then finalize()
+	void load(const GEMLoader::GEMAnimation& source)
 	{
-		return skeleton.bones.size();
+		memcpy(&skeleton.globalInverse, &source.globalInverse, 16 * sizeof(float)); // Importer root inverse
+
+		// Bone hierarchy + inverse bind offsets
+		for (int i = 0; i < source.bones.size(); i++)
+		{
+			Bone bone;
+			bone.name = source.bones[i].name;
+			memcpy(&bone.offset, &source.bones[i].offset, 16 * sizeof(float));
+			bone.parentIndex = source.bones[i].parentIndex;
+			skeleton.bones.push_back(bone);
+		}
+
+		// Clips (per-frame per-bone TRS)
+		for (int i = 0; i < source.animations.size(); i++)
+		{
+			AnimationSequence aseq;
+			aseq.ticksPerSecond = source.animations[i].ticksPerSecond;
+
+			for (int j = 0; j < source.animations[i].frames.size(); j++)
+			{
+				const GEMLoader::GEMAnimationFrame& gemFrame = source.animations[i].frames[j];
+				AnimationFrame frame;
+				for (int index = 0; index < gemFrame.positions.size(); index++)
+				{
+					Vec3 p;
+					Quaternion q;
+					Vec3 s;
+					memcpy(&p, &gemFrame.positions[index], sizeof(Vec3));
+					frame.positions.push_back(p);
+					memcpy(&q, &gemFrame.rotations[index], sizeof(Quaternion));
+					frame.rotations.push_back(q);
+					memcpy(&s, &gemFrame.scales[index], sizeof(Vec3));
+					frame.scales.push_back(s);
+				}
+				aseq.frames.push_back(frame);
+			}
+			animations.insert({ source.animations[i].name, aseq }); // Register clip by name
+		}
+
+		finalize();
 	}
 
-	// Time-to-frame conversion for a given clip
-	void calcFrame(std::string name, float t, int& frame, float& interpolationFact)
+	// Call once after bones and clips are loaded: assigns clip handles and sorts the skeleton
+	void finalize()
 	{
-		animations[name].calcFrame(t, frame, interpolationFact);
+		clips.clear();
+		clipNames.clear();
+		for (auto& clip : animations)
+		{
+			clips.push_back(&clip.second);
+			clipNames.push_back(clip.first);
+		}
+		skeleton.sortBones();
 	}
 
-	// Bone global matrix at time t (interpolated), using supplied parent globals
-	Matrix interpolateBoneToGlobal(std::string name, Matrix* matrices, int baseFrame, float interpolationFact, int boneIndex)
+	// Number of bones in the skeleton
+	int bonesSize()
 	{
-		return animations[name].interpolateBoneToGlobal(matrices, baseFrame, interpolationFact, &skeleton, boneIndex);
+		return skeleton.bones.size();
 	}
 
-	// Convert globals into final skinning matrices used by the shader
-	void calcTransforms(Matrix* matrices, Matrix coordTransform)
+	// Resolve a clip name to its handle (INVALID_CLIP if missing)
+	AnimationClip findClip(const std::string& name) const
 	{
-		for (int i = 0; i < bonesSize(); i++)
+		for (int i = 0; i < (int)clipNames.size(); i++)
 		{
-			matrices[i] = skeleton.bones[i].offset * matrices[i] * skeleton.globalInverse * coordTransform;
+			if (clipNames[i] == name)
+			{
+				return i;
+			}
 		}
+		return INVALID_CLIP;
 	}
 
 	// Clip existence check
@@ -151,18 +255,22 @@ public:
 class AnimationInstance
 {
 public:
-	Animation* animation;       // Shared animation data (skeleton + clips)
-	std::string usingAnimation; // Current clip name
-	float t;                    // Current time in seconds
+	Animation* animation = nullptr;   // Shared animation data (skeleton + clips)
+	AnimationClip clip = INVALID_CLIP; // Current clip
+	float t = 0.0f;                     // Current time in seconds
 
 	Matrix matrices[256];       // Final skinning matrices (shader limit = 256)
-	Matrix matricesPose[256];   // Pose globals for querying bone world transforms
+	Matrix matricesPose[256];   // Pose globals from the last update, for querying bone world transforms
 	Matrix coordTransform;      // Coordinate-system conversion (importer -> engine)
 
 	// Initialise instance and optional coordinate conversion
 	void init(Animation* _animation, int fromYZX)
 	{
 		animation = _animation;
+		if (animation->clips.size() != animation->animations.size())
+		{
+			animation->finalize();
+		}
 		if (fromYZX == 1)
 		{
 			memset(coordTransform.a, 0, 16 * sizeof(float));
@@ -174,33 +282,55 @@ public:
 	}
 
 	// Advance animation time, evaluate pose, and compute final skinning matrices
-	void update(std::string name, float dt)
+	void update(AnimationClip newClip, float dt)
 	{
-		if (name == usingAnimation)
+		if (newClip == clip)
 		{
 			t += dt;
 		}
 		else
 		{
-			usingAnimation = name;
+			clip = newClip;
 			t = 0;
 		}
 
-		if (animationFinished() == true)
+		if (clip == INVALID_CLIP || animationFinished() == true)
 		{
 			return;
 		}
 
+		evaluate();
+	}
+
+	// Compute pose globals and skinning matrices for the current clip and time (no time advance)
+	void evaluate()
+	{
+		AnimationSequence& sequence = *animation->clips[clip];
 		int frame = 0;
 		float interpolationFact = 0;
-		animation->calcFrame(name, t, frame, interpolationFact);
-
-		for (int i = 0; i < animation->bonesSize(); i++)
+		sequence.calcFrame(t, frame, interpolationFact);
+		int next = sequence.nextFrame(frame);
+
+		// Parents come first in the evaluation order, so their globals are ready for the children.
+		// Skinning matrix = offset * global * (globalInverse * coordTransform), the last term shared by every bone.
+		const Skeleton& skeleton = animation->skeleton;
+		Matrix rootToModel = skeleton.globalInverse * coordTransform;
+		int count = (int)skeleton.order.size();
+		for (int i = 0; i < count; i++)
 		{
-			matrices[i] = animation->interpolateBoneToGlobal(name, matrices, frame, interpolationFact, i);
+			int bone = skeleton.order[i];
+			int parent = skeleton.orderParent[i];
+
+			Matrix local = sequence.localTransform(frame, next, interpolationFact, bone);
+			matricesPose[bone] = (parent > -1) ? local * matricesPose[parent] : local;
+			matrices[bone] = skeleton.orderOffset[i] * matricesPose[bone] * rootToModel;
 		}
+	}
 
-		animation->calcTransforms(matrices, coordTransform);
+	// Name-based variant; prefer resolving the handle once with Animation::findClip
+	void update(const std::string& name, float dt)
+	{
+		update(animation->findClip(name), dt);
 	}
 
 	// Force restart of the current clip
@@ -212,35 +342,21 @@ public:
 	// Non-looping clip end condition
 	bool animationFinished()
 	{
-		if (t > animation->animations[usingAnimation].duration())
+		if (clip == INVALID_CLIP || t > animation->clips[clip]->duration())
 		{
 			return true;
 		}
 		return false;
 	}
 
-	// Compute current bone world matrix by rebuilding its parent chain pose
-	Matrix findWorldMatrix(std::string boneName)
+	// World matrix of a bone at the last evaluated pose
+	Matrix boneWorldMatrix(int boneIndex)
 	{
-		int boneID = animation->skeleton.findBone(boneName);
-		std::vector<int> boneChain;
-
-		int ID = boneID;
-		while (ID != -1)
-		{
-			boneChain.push_back(ID);
-			ID = animation->skeleton.bones[ID].parentIndex;
-		}
-
-		int frame = 0;
-		float interpolationFact = 0;
-		animation->calcFrame(usingAnimation, t, frame, interpolationFact);
-
-		for (int i = boneChain.size() - 1; i > -1; i = i - 1)
-		{
-			matricesPose[boneChain[i]] = animation->interpolateBoneToGlobal(usingAnimation, matricesPose, frame, interpolationFact, boneChain[i]);
-		}
+		return (matricesPose[boneIndex] * coordTransform);
+	}
 
-		return (matricesPose[boneID] * coordTransform);
+	Matrix findWorldMatrix(std::string boneName)
+	{
+		return boneWorldMatrix(animation->skeleton.findBone(boneName));
 	}
 };
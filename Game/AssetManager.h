@@ -4,6 +4,8 @@
 #include "Mesh.h"
 #include "GEMLoader.h"
 #include "HybridGrassField.h"  // Include for GrassGroupConfig and GrassTypeConfig
+#include "ThreadPool.h"
+#include "CookedMesh.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -42,6 +44,13 @@ struct RockSetAsset
     std::vector<std::string> texturePaths; // Per-rock texture path
 };
 
+// CPU-side mesh produced by a decode worker, turned into a Mesh on the render thread
+struct DecodedMesh
+{
+    std::vector<STATIC_VERTEX> vertices;
+    std::vector<unsigned int> indices;
+};
+
 class AssetManager
 {
 public:
@@ -50,63 +59,90 @@ public:
     {
         std::cout << "[AssetManager] Loading assets from: " << configFilePath << "\n";
 
-        std::ifstream file(configFilePath);
-        if (!file.is_open())
-        {
-            std::cout << "[AssetManager] ERROR: Could not open config file!\n";
+        if (!parseConfig(configFilePath))
             return false;
-        }
 
-        std::string line;
-        std::string currentSection = "";
-
-        while (std::getline(file, line))
+        // Decode all files on the worker pool (textures first: they are the long jobs)
+        int numTextures = (int)textureConfigs.size();
+        int numModels = (int)modelConfigs.size();
+        std::vector<TextureImage> decodedTextures(numTextures);
+        std::vector<DecodedMesh> decodedModels(numModels);
+
+        // Models with an up-to-date .cmesh are memory-mapped instead of decoded. The cook is checked
+        // against the source hash on the workers below; config models are static meshes, so a skinned
+        // or stale cook is closed again and the model is decoded instead.
+        std::vector<CookedMeshFile> cookedModels(numModels);
+        for (int i = 0; i < numModels; i++)
         {
-            // Strip inline // comments before parsing
-            size_t commentPos = line.find("//");
-            if (commentPos != std::string::npos)
-                line = line.substr(0, commentPos);
-
-            line = trim(line);
-            if (line.empty()) continue;
+            std::string cookedPath = CookedMeshWriter::cookedPathFor(modelConfigs[i].path);
+            std::error_code ec;
+            if (std::filesystem::exists(cookedPath, ec) && cookedModels[i].open(cookedPath) && cookedModels[i].isAnimated())
+                cookedModels[i].close();
+        }
 
-            // Section header: [MODELS] / [TEXTURES] / [GRASS_GROUPS] / [ROCKS]
-            if (line[0] == '[' && line[line.length() - 1] == ']')
+        std::cout << "[AssetManager] Decoding " << numModels << " models and " << numTextures << " textures on "
+            << ThreadPool::get().getThreadCount() + 1 << " threads...\n";
+        ThreadPool::get().parallelFor(numTextures + numModels, [&](int i)
+        {
+            if (i < numTextures)
             {
-                currentSection = line.substr(1, line.length() - 2);
-                continue;
+                // Mip generation (or the .dds read) happens here, off the render thread
+                TextureImageLoader::load(textureConfigs[i].path, decodedTextures[i]);
             }
+            else
+            {
+                // A missing source leaves nothing to decode, so a shipped cook is used as is
+                int m = i - numTextures;
+                CookedMeshFile& cooked = cookedModels[m];
+                if (cooked.isOpen())
+                {
+                    unsigned long long sourceHash = hashFile(modelConfigs[m].path);
+                    if (sourceHash != 0 && !CookedMeshWriter::isUpToDate(cooked, sourceHash))
+                        cooked.close();
+                }
+                if (!cooked.isOpen())
+                    decodeMesh(modelConfigs[m].path, decodedModels[m]);
+            }
+        });
 
-            // Dispatch section-specific parsing
-            if (currentSection == "MODELS")
-                parseModel(line);
-            else if (currentSection == "TEXTURES")
-                parseTexture(line);
-            else if (currentSection == "GRASS_GROUPS")
-                parseGrassGroup(file, line);
-            else if (currentSection == "ROCKS")
-                parseRockSet(file, line);
-        }
-
-        file.close();
+        // Batch all model/texture uploads into one copy submission
+        core->beginUploadBatch();
 
-        // Load all model configs into Mesh objects
+        // Create Mesh objects from decoded geometry
         std::cout << "[AssetManager] Loading " << modelConfigs.size() << " models...\n";
-        for (auto& config : modelConfigs)
+        for (int i = 0; i < numModels; i++)
         {
-            config.mesh = loadMesh(core, config.path);
+            ModelAsset& config = modelConfigs[i];
+            if (cookedModels[i].isOpen())
+                config.mesh = cookedModels[i].createMesh(core, 0);
+            else
+                config.mesh = createMesh(core, config.path, decodedModels[i]);
             if (config.mesh)
                 loadedModels[config.name] = config.mesh;
         }
 
-        // Load all texture configs into GPU textures + SRVs
+        // Create GPU textures + SRVs from decoded mip chains
         std::cout << "[AssetManager] Loading " << textureConfigs.size() << " textures...\n";
-        for (auto& config : textureConfigs)
+        for (int i = 0; i < numTextures; i++)
         {
-            config.texture = core->loadTexture(config.path);
+            TextureAsset& config = textureConfigs[i];
+            TextureImage& image = decodedTextures[i];
+            if (image.valid())
+            {
+                config.texture = core->createTexture(image, config.path);
+                image = {};
+            }
+            else
+            {
+                std::cout << "[AssetManager] WARNING: Failed to load " << config.path << "\n";
+                config.texture = {};
+            }
             loadedTextures[config.name] = config.texture;
         }
 
+        core->endUploadBatch();
+        cookedModels.clear();
+
         std::cout << "[AssetManager] Assets loaded successfully!\n";
         std::cout << "  Models: " << loadedModels.size() << "\n";
         std::cout << "  Textures: " << loadedTextures.size() << "\n";
@@ -116,6 +152,39 @@ public:
         return true;
     }
 
+    // Offline cook step: write a .cmesh (with LOD chain) next to every model and rock .gem in the config
+    bool cookFromConfig(const std::string& configFilePath, const std::vector<float>& lodRatios)
+    {
+        std::cout << "[AssetManager] Cooking meshes from: " << configFilePath << "\n";
+
+        if (!parseConfig(configFilePath))
+            return false;
+
+        std::vector<std::string> sources;
+        for (auto& config : modelConfigs)
+            sources.push_back(config.path);
+        for (auto& rockSet : rockSets)
+            sources.insert(sources.end(), rockSet.modelPaths.begin(), rockSet.modelPaths.end());
+
+        std::vector<char> results(sources.size(), 0);
+        ThreadPool::get().parallelFor((int)sources.size(), [&](int i)
+        {
+            results[i] = CookedMeshWriter::cookGEM(sources[i], CookedMeshWriter::cookedPathFor(sources[i]), lodRatios) ? 1 : 0;
+        });
+
+        int cooked = 0;
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            if (results[i])
+                cooked++;
+            else
+                std::cout << "[AssetManager] WARNING: Failed to cook " << sources[i] << "\n";
+        }
+
+        std::cout << "[AssetManager] Cooked " << cooked << " / " << sources.size() << " meshes\n";
+        return cooked == (int)sources.size();
+    }
+
     // Lookup loaded mesh by config name
     Mesh* getModel(const std::string& name)
     {
@@ -183,6 +252,51 @@ private:
     std::map<std::string, Mesh*> loadedModels;  // Loaded meshes by name
     std::map<std::string, Texture> loadedTextures; // Loaded textures by name
 
+    // Read config file into the *Configs / grassGroups / rockSets lists
+    bool parseConfig(const std::string& configFilePath)
+    {
+        std::ifstream file(configFilePath);
+        if (!file.is_open())
+        {
+            std::cout << "[AssetManager] ERROR: Could not open config file!\n";
+            return false;
+        }
+
+        std::string line;
+        std::string currentSection = "";
+
+        while (std::getline(file, line))
+        {
+            // Strip inline // comments before parsing
+            size_t commentPos = line.find("//");
+            if (commentPos != std::string::npos)
+                line = line.substr(0, commentPos);
+
+            line = trim(line);
+            if (line.empty()) continue;
+
+            // Section header: [MODELS] / [TEXTURES] / [GRASS_GROUPS] / [ROCKS]
+            if (line[0] == '[' && line[line.length() - 1] == ']')
+            {
+                currentSection = line.substr(1, line.length() - 2);
+                continue;
+            }
+
+            // Dispatch section-specific parsing
+            if (currentSection == "MODELS")
+                parseModel(line);
+            else if (currentSection == "TEXTURES")
+                parseTexture(line);
+            else if (currentSection == "GRASS_GROUPS")
+                parseGrassGroup(file, line);
+            else if (currentSection == "ROCKS")
+                parseRockSet(file, line);
+        }
+
+        file.close();
+        return true;
+    }
+
     // Trim whitespace from both ends
     std::string trim(const std::string& str)
     {
@@ -288,33 +402,34 @@ private:
         }
     }
 
-    // Load first GEM mesh into Mesh (STATIC_VERTEX + indices)
-    Mesh* loadMesh(Core* core, const std::string& path)
+    // Decode first GEM mesh into STATIC_VERTEX + indices (worker thread, no GPU access)
+    static void decodeMesh(const std::string& path, DecodedMesh& out)
     {
         GEMLoader::GEMModelLoader loader;
         std::vector<GEMLoader::GEMMesh> gemmeshes;
         loader.load(path, gemmeshes);
 
-        // Fail fast if file loads but produces no meshes
         if (gemmeshes.empty())
+            return;
+
+        // Copy GEM static vertices into engine STATIC_VERTEX format
+        out.vertices.resize(gemmeshes[0].verticesStatic.size());
+        memcpy(out.vertices.data(), gemmeshes[0].verticesStatic.data(), out.vertices.size() * sizeof(STATIC_VERTEX));
+        out.indices = std::move(gemmeshes[0].indices);
+    }
+
+    // Init GPU buffers for a decoded mesh (render thread)
+    Mesh* createMesh(Core* core, const std::string& path, DecodedMesh& decoded)
+    {
+        // Fail fast if file loads but produces no meshes
+        if (decoded.vertices.empty())
         {
             std::cout << "[AssetManager] WARNING: Failed to load " << path << "\n";
             return nullptr;
         }
 
         Mesh* mesh = new Mesh();
-
-        // Copy GEM static vertices into engine STATIC_VERTEX format
-        std::vector<STATIC_VERTEX> vertices;
-        for (auto& v : gemmeshes[0].verticesStatic)
-        {
-            STATIC_VERTEX vert;
-            memcpy(&vert, &v, sizeof(STATIC_VERTEX));
-            vertices.push_back(vert);
-        }
-
-        // Init GPU buffers for the mesh
-        mesh->init(core, vertices, gemmeshes[0].indices);
+        mesh->init(core, decoded.vertices, decoded.indices);
         return mesh;
     }
 };
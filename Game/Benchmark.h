@@ -0,0 +1,307 @@
+#pragma once
+
+#include "Maths.h"
+#include "Profiler.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// ============================================================================
+// BenchmarkSettings
+// ----------------------------------------------------------------------------
+// Game.exe --benchmark [--preset=<name>] [--grass-density=<x>] [--fog=0|1] [--froxel=0|1]
+//          [--duration=<s>] [--warmup=<frames>] [--path=<file>] [--out=<file>] [--summary=<file>]
+// Presets set everything below; explicit options after it override the preset.
+// ============================================================================
+struct BenchmarkSettings
+{
+    bool enabled = false;
+    std::string preset = "default";
+    float grassDensity = 1.0f;              // Multiplies grass cluster sizes (rocks are left alone)
+    bool fog = true;
+    bool froxelFog = false;
+    float duration = 30.0f;                 // Seconds of flythrough, simulated at fixedStep per frame
+    float fixedStep = 1.0f / 60.0f;         // Simulation step, so every run renders the same frames
+    int warmupFrames = 60;                  // Not recorded (pipeline/cache warm-up, first readbacks)
+    std::string pathFile;                   // Camera control points, "x y z" per line (world space)
+    std::string outputPath = "benchmark.txt";
+    std::string summaryPath = "benchmark_summary.csv";   // One line appended per run, for charting
+
+    static BenchmarkSettings parse(const char* commandLine)
+    {
+        BenchmarkSettings settings;
+        if (commandLine == nullptr || strstr(commandLine, "--benchmark") == nullptr)
+            return settings;
+
+        settings.enabled = true;
+        std::istringstream tokens(commandLine);
+        std::string token;
+        std::vector<std::string> options;
+        while (tokens >> token)
+            options.push_back(token);
+
+        // Preset first so individual options can refine it
+        for (const auto& option : options)
+        {
+            if (option.rfind("--preset=", 0) == 0)
+                settings.applyPreset(option.substr(9));
+        }
+
+        for (const auto& option : options)
+        {
+            std::string value = valueOf(option);
+            if (option.rfind("--grass-density=", 0) == 0) settings.grassDensity = (std::max)((float)atof(value.c_str()), 0.0f);
+            else if (option.rfind("--fog=", 0) == 0) settings.fog = atoi(value.c_str()) != 0;
+            else if (option.rfind("--froxel=", 0) == 0) settings.froxelFog = atoi(value.c_str()) != 0;
+            else if (option.rfind("--duration=", 0) == 0) settings.duration = (std::max)((float)atof(value.c_str()), 1.0f);
+            else if (option.rfind("--warmup=", 0) == 0) settings.warmupFrames = (std::max)(atoi(value.c_str()), 0);
+            else if (option.rfind("--path=", 0) == 0) settings.pathFile = value;
+            else if (option.rfind("--out=", 0) == 0) settings.outputPath = value;
+            else if (option.rfind("--summary=", 0) == 0) settings.summaryPath = value;
+        }
+        return settings;
+    }
+
+    // default, grass4x, grass16x, nofog, froxel
+    void applyPreset(const std::string& name)
+    {
+        preset = name;
+        if (name == "default") {}
+        else if (name == "grass4x") grassDensity = 4.0f;
+        else if (name == "grass16x") grassDensity = 16.0f;
+        else if (name == "nofog") fog = false;
+        else if (name == "froxel") froxelFog = true;
+        else std::cout << "[Benchmark] WARNING: Unknown preset " << name << ", using defaults\n";
+    }
+
+private:
+    static std::string valueOf(const std::string& option)
+    {
+        size_t eq = option.find('=');
+        return (eq == std::string::npos) ? std::string() : option.substr(eq + 1);
+    }
+};
+
+// ============================================================================
+// CameraSpline
+// ----------------------------------------------------------------------------
+// Closed Catmull-Rom loop through control points, walked at constant parameter speed. The camera
+// looks a short way ahead along the curve, so a path only needs positions.
+// ============================================================================
+class CameraSpline
+{
+public:
+    std::vector<Vec3> points;
+
+    void add(const Vec3& p) { points.push_back(p); }
+
+    // "x y z" per line; '#' starts a comment
+    bool load(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        if (!file)
+        {
+            std::cout << "[Benchmark] ERROR: Cannot open camera path " << filename << "\n";
+            return false;
+        }
+
+        std::vector<Vec3> loaded;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream in(line);
+            Vec3 p;
+            if (in >> p.x >> p.y >> p.z)
+                loaded.push_back(p);
+        }
+
+        if (loaded.size() < 4)
+        {
+            std::cout << "[Benchmark] ERROR: " << filename << " needs at least 4 points\n";
+            return false;
+        }
+        points = loaded;
+        return true;
+    }
+
+    // t in [0, 1) around the loop
+    Vec3 position(float t) const
+    {
+        int count = (int)points.size();
+        float f = (t - std::floor(t)) * count;
+        int i = (int)f;
+        float u = f - i;
+
+        const Vec3& p0 = points[(i - 1 + count) % count];
+        const Vec3& p1 = points[i % count];
+        const Vec3& p2 = points[(i + 1) % count];
+        const Vec3& p3 = points[(i + 2) % count];
+
+        float u2 = u * u;
+        float u3 = u2 * u;
+        return (p1 * 2.0f + (p2 - p0) * u + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * u2
+            + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * u3) * 0.5f;
+    }
+
+    Vec3 direction(float t, float lookAhead = 0.01f) const
+    {
+        Vec3 d = position(t + lookAhead) - position(t);
+        return (d.length() > 1e-5f) ? d.normalize() : Vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    bool valid() const { return points.size() >= 4; }
+};
+
+// ============================================================================
+// BenchmarkRecorder
+// ----------------------------------------------------------------------------
+// Collects wall-clock frame times, Profiler pass times and Core::stats counts for every frame after
+// warm-up, then writes percentiles to a report file plus one summary CSV line per run.
+// ============================================================================
+class BenchmarkRecorder
+{
+public:
+    void addFrame(float frameMs, const ProfileFrame& profile, unsigned int drawCalls, unsigned int instances)
+    {
+        frameTimes.push_back(frameMs);
+        this->drawCalls.push_back((float)drawCalls);
+        this->instances.push_back((float)instances);
+
+        // Profiler results lag a couple of frames; take each resolved frame once
+        if (profile.frame == lastProfileFrame || profile.samples.empty())
+            return;
+        lastProfileFrame = profile.frame;
+
+        gpuFrameTimes.push_back(profile.gpuMs);
+        std::map<std::string, float> gpuByName, cpuByName;
+        for (const auto& s : profile.samples)
+        {
+            if (s.gpuMs >= 0.0f)
+                gpuByName[s.name] += s.gpuMs;
+            cpuByName[s.name] += s.cpuMs;
+        }
+        for (const auto& entry : gpuByName)
+            passGpu[entry.first].push_back(entry.second);
+        for (const auto& entry : cpuByName)
+            passCpu[entry.first].push_back(entry.second);
+    }
+
+    size_t getFrameCount() const { return frameTimes.size(); }
+
+    bool writeReport(const BenchmarkSettings& settings, bool completed) const
+    {
+        std::ofstream file(settings.outputPath);
+        if (!file)
+        {
+            std::cout << "[Benchmark] ERROR: Cannot write " << settings.outputPath << "\n";
+            return false;
+        }
+
+        float total = 0.0f;
+        for (float t : frameTimes)
+            total += t;
+        float avg = frameTimes.empty() ? 0.0f : total / frameTimes.size();
+
+        file << "preset: " << settings.preset << "\n";
+        file << "completed: " << (completed ? "yes" : "no (aborted)") << "\n";
+        file << "grass_density: " << settings.grassDensity << "\n";
+        file << "fog: " << (settings.fog ? (settings.froxelFog ? "froxel" : "raymarch") : "off") << "\n";
+        file << "duration_s: " << settings.duration << "\n";
+        file << "frames: " << frameTimes.size() << "\n\n";
+
+        file << "frame_ms_avg: " << avg << "\n";
+        file << "fps_avg: " << (avg > 0.0f ? 1000.0f / avg : 0.0f) << "\n";
+        writePercentiles(file, "frame_ms", frameTimes);
+        writePercentiles(file, "gpu_frame_ms", gpuFrameTimes);
+        writePercentiles(file, "draw_calls", drawCalls);
+        writePercentiles(file, "instances", instances);
+
+        file << "\n[gpu_pass_ms] name avg p50 p95 p99\n";
+        for (const auto& entry : passGpu)
+            writePassLine(file, entry.first, entry.second);
+
+        file << "\n[cpu_pass_ms] name avg p50 p95 p99\n";
+        for (const auto& entry : passCpu)
+            writePassLine(file, entry.first, entry.second);
+
+        std::cout << "[Benchmark] " << frameTimes.size() << " frames, p50 " << percentile(frameTimes, 0.50f)
+            << " ms, p99 " << percentile(frameTimes, 0.99f) << " ms -> " << settings.outputPath << "\n";
+
+        appendSummary(settings, completed, avg);
+        return true;
+    }
+
+    // Nearest-rank percentile
+    static float percentile(std::vector<float> values, float p)
+    {
+        if (values.empty())
+            return 0.0f;
+        std::sort(values.begin(), values.end());
+        size_t rank = (size_t)std::ceil(p * values.size());
+        rank = (std::min)((std::max)(rank, (size_t)1), values.size());
+        return values[rank - 1];
+    }
+
+private:
+    std::vector<float> frameTimes;
+    std::vector<float> gpuFrameTimes;
+    std::vector<float> drawCalls;
+    std::vector<float> instances;
+    std::map<std::string, std::vector<float>> passGpu;
+    std::map<std::string, std::vector<float>> passCpu;
+    unsigned long long lastProfileFrame = ~0ull;
+
+    static float average(const std::vector<float>& values)
+    {
+        float sum = 0.0f;
+        for (float v : values)
+            sum += v;
+        return values.empty() ? 0.0f : sum / values.size();
+    }
+
+    static void writePercentiles(std::ofstream& file, const std::string& name, const std::vector<float>& values)
+    {
+        file << name << "_p50: " << percentile(values, 0.50f) << "\n";
+        file << name << "_p95: " << percentile(values, 0.95f) << "\n";
+        file << name << "_p99: " << percentile(values, 0.99f) << "\n";
+        file << name << "_max: " << percentile(values, 1.0f) << "\n";
+    }
+
+    static void writePassLine(std::ofstream& file, const std::string& name, const std::vector<float>& values)
+    {
+        file << name << " " << average(values) << " " << percentile(values, 0.50f) << " "
+            << percentile(values, 0.95f) << " " << percentile(values, 0.99f) << "\n";
+    }
+
+    void appendSummary(const BenchmarkSettings& settings, bool completed, float avg) const
+    {
+        if (settings.summaryPath.empty())
+            return;
+
+        bool exists = std::ifstream(settings.summaryPath).good();
+        std::ofstream file(settings.summaryPath, std::ios::app);
+        if (!file)
+            return;
+
+        if (!exists)
+            file << "preset,grass_density,fog,completed,frames,frame_ms_avg,frame_ms_p50,frame_ms_p95,frame_ms_p99,"
+                "gpu_ms_p50,gpu_ms_p95,draw_calls_p50,instances_p50\n";
+
+        file << settings.preset << "," << settings.grassDensity << ","
+            << (settings.fog ? (settings.froxelFog ? "froxel" : "raymarch") : "off") << ","
+            << (completed ? 1 : 0) << "," << frameTimes.size() << "," << avg << ","
+            << percentile(frameTimes, 0.50f) << "," << percentile(frameTimes, 0.95f) << ","
+            << percentile(frameTimes, 0.99f) << "," << percentile(gpuFrameTimes, 0.50f) << ","
+            << percentile(gpuFrameTimes, 0.95f) << "," << percentile(drawCalls, 0.50f) << ","
+            << percentile(instances, 0.50f) << "\n";
+    }
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "Core.h"
+#include "Mesh.h"
+#include "GEMLoader.h"
+#include "LOD.h"
+#include "Hash.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+
+// Cooked mesh (.cmesh) file layout:
+//   CookedMeshHeader
+//   CookedMeshLOD[lodCount]
+//   per LOD: vertex blob (vertexStride * vertexCount) and index blob (uint32 * indexCount), 16-byte aligned
+// Vertex blobs are stored in STATIC_VERTEX / ANIMATED_VERTEX layout so the loader can hand the
+// memory-mapped bytes straight to the upload heap.
+
+static const unsigned int COOKED_MESH_MAGIC = 0x48534D43; // 'CMSH'
+static const unsigned int COOKED_MESH_VERSION = 1;
+static const unsigned int COOKED_MESH_ANIMATED = 1;       // Header flag: vertices are ANIMATED_VERTEX
+
+struct CookedMeshHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int vertexStride;      // sizeof(STATIC_VERTEX) or sizeof(ANIMATED_VERTEX)
+    unsigned int flags;             // COOKED_MESH_* bits
+    unsigned int lodCount;          // Entries in the LOD table (LOD 0 = full detail)
+    unsigned int reserved;
+    unsigned long long sourceHash;  // Hash of the source .gem (0 if unknown)
+};
+
+struct CookedMeshLOD
+{
+    float ratio;                    // Simplification ratio this LOD was built with
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int reserved;
+    unsigned long long vertexOffset; // Byte offset from file start
+    unsigned long long indexOffset;  // Byte offset from file start
+};
+
+// Read-only memory-mapped file (Win32 file mapping)
+class MappedFile
+{
+public:
+    bool open(const std::string& filename)
+    {
+        close();
+
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        fileSize = (UINT64)size.QuadPart;
+
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            close();
+            return false;
+        }
+
+        view = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        view = nullptr;
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+        fileSize = 0;
+    }
+
+    const unsigned char* data() const { return view; }
+    UINT64 size() const { return fileSize; }
+    bool isOpen() const { return view != nullptr; }
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    const unsigned char* view = nullptr;
+    UINT64 fileSize = 0;
+};
+
+// Hash a whole file's contents (0 if it cannot be opened)
+inline unsigned long long hashFile(const std::string& filename)
+{
+    MappedFile file;
+    if (!file.open(filename))
+        return 0;
+    return hashBytes(file.data(), (size_t)file.size());
+}
+
+// Memory-mapped view of a cooked mesh; vertex/index pointers point straight into the mapping
+class CookedMeshFile
+{
+public:
+    // Map the file and validate header + LOD table bounds
+    bool open(const std::string& filename)
+    {
+        header = nullptr;
+        lods = nullptr;
+
+        if (!file.open(filename))
+            return false;
+
+        if (file.size() < sizeof(CookedMeshHeader))
+        {
+            std::cout << "[CookedMesh] ERROR: File too small: " << filename << "\n";
+            file.close();
+            return false;
+        }
+
+        const CookedMeshHeader* h = (const CookedMeshHeader*)file.data();
+        if (h->magic != COOKED_MESH_MAGIC || h->version != COOKED_MESH_VERSION || h->lodCount == 0)
+        {
+            std::cout << "[CookedMesh] ERROR: Bad header or version: " << filename << "\n";
+            file.close();
+            return false;
+        }
+
+        UINT64 tableEnd = sizeof(CookedMeshHeader) + (UINT64)h->lodCount * sizeof(CookedMeshLOD);
+        if (tableEnd > file.size())
+        {
+            std::cout << "[CookedMesh] ERROR: Truncated LOD table: " << filename << "\n";
+            file.close();
+            return false;
+        }
+
+        const CookedMeshLOD* table = (const CookedMeshLOD*)(file.data() + sizeof(CookedMeshHeader));
+        for (unsigned int i = 0; i < h->lodCount; i++)
+        {
+            UINT64 vertexEnd = table[i].vertexOffset + (UINT64)table[i].vertexCount * h->vertexStride;
+            UINT64 indexEnd = table[i].indexOffset + (UINT64)table[i].indexCount * sizeof(unsigned int);
+            if (vertexEnd > file.size() || indexEnd > file.size())
+            {
+                std::cout << "[CookedMesh] ERROR: LOD " << i << " out of bounds: " << filename << "\n";
+                file.close();
+                return false;
+            }
+        }
+
+        header = h;
+        lods = table;
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        header = nullptr;
+        lods = nullptr;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    unsigned int getLODCount() const { return header->lodCount; }
+    unsigned int getVertexStride() const { return header->vertexStride; }
+    unsigned int getVersion() const { return header->version; }
+    bool isAnimated() const { return (header->flags & COOKED_MESH_ANIMATED) != 0; }
+    unsigned long long getSourceHash() const { return header->sourceHash; }
+    const CookedMeshLOD& getLOD(unsigned int lod) const { return lods[lod]; }
+
+    const void* getVertices(unsigned int lod) const
+    {
+        return file.data() + lods[lod].vertexOffset;
+    }
+
+    const unsigned int* getIndices(unsigned int lod) const
+    {
+        return (const unsigned int*)(file.data() + lods[lod].indexOffset);
+    }
+
+    // Create a GPU mesh for one LOD; bytes go from the mapping straight into upload memory
+    Mesh* createMesh(Core* core, unsigned int lod) const
+    {
+        if (!isOpen() || lod >= header->lodCount)
+            return nullptr;
+
+        Mesh* mesh = new Mesh();
+        mesh->init(core, getVertices(lod), header->vertexStride, lods[lod].vertexCount,
+            getIndices(lod), lods[lod].indexCount);
+        return mesh;
+    }
+
+private:
+    MappedFile file;
+    const CookedMeshHeader* header = nullptr;
+    const CookedMeshLOD* lods = nullptr;
+};
+
+// One LOD's CPU geometry handed to the writer
+struct CookedLODSource
+{
+    float ratio;
+    const void* vertices;
+    unsigned int vertexCount;
+    const unsigned int* indices;
+    unsigned int indexCount;
+};
+
+// Offline cook step: GEM -> .cmesh
+class CookedMeshWriter
+{
+public:
+    // Write header, LOD table and aligned blobs
+    static bool write(const std::string& filename, unsigned int vertexStride, unsigned int flags,
+        unsigned long long sourceHash, const std::vector<CookedLODSource>& lods)
+    {
+        if (lods.empty())
+            return false;
+
+        CookedMeshHeader header = {};
+        header.magic = COOKED_MESH_MAGIC;
+        header.version = COOKED_MESH_VERSION;
+        header.vertexStride = vertexStride;
+        header.flags = flags;
+        header.lodCount = (unsigned int)lods.size();
+        header.sourceHash = sourceHash;
+
+        // Lay out blobs after the table
+        std::vector<CookedMeshLOD> table(lods.size());
+        unsigned long long offset = sizeof(CookedMeshHeader) + lods.size() * sizeof(CookedMeshLOD);
+        for (size_t i = 0; i < lods.size(); i++)
+        {
+            table[i] = {};
+            table[i].ratio = lods[i].ratio;
+            table[i].vertexCount = lods[i].vertexCount;
+            table[i].indexCount = lods[i].indexCount;
+
+            offset = align(offset);
+            table[i].vertexOffset = offset;
+            offset += (unsigned long long)lods[i].vertexCount * vertexStride;
+
+            offset = align(offset);
+            table[i].indexOffset = offset;
+            offset += (unsigned long long)lods[i].indexCount * sizeof(unsigned int);
+        }
+
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cout << "[CookedMesh] ERROR: Could not write " << filename << "\n";
+            return false;
+        }
+
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)table.data(), table.size() * sizeof(CookedMeshLOD));
+        for (size_t i = 0; i < lods.size(); i++)
+        {
+            pad(out, table[i].vertexOffset);
+            out.write((const char*)lods[i].vertices, (std::streamsize)lods[i].vertexCount * vertexStride);
+            pad(out, table[i].indexOffset);
+            out.write((const char*)lods[i].indices, (std::streamsize)lods[i].indexCount * sizeof(unsigned int));
+        }
+
+        return out.good();
+    }
+
+    // Cook the first mesh of a GEM file; static meshes get one simplified LOD per ratio
+    // sourceHash may be passed in when the caller already hashed the source (0 = hash it here)
+    static bool cookGEM(const std::string& gemPath, const std::string& cookedPath, const std::vector<float>& ratios,
+        unsigned long long sourceHash = 0)
+    {
+        GEMLoader::GEMModelLoader loader;
+        std::vector<GEMLoader::GEMMesh> gemmeshes;
+        loader.load(gemPath, gemmeshes);
+
+        if (gemmeshes.empty() || gemmeshes[0].indices.empty())
+        {
+            std::cout << "[CookedMesh] ERROR: No geometry in " << gemPath << "\n";
+            return false;
+        }
+
+        if (sourceHash == 0)
+            sourceHash = hashFile(gemPath);
+        GEMLoader::GEMMesh& gem = gemmeshes[0];
+
+        // Skinned meshes are cooked at full detail only
+        if (gem.isAnimated())
+        {
+            std::vector<ANIMATED_VERTEX> vertices(gem.verticesAnimated.size());
+            memcpy(vertices.data(), gem.verticesAnimated.data(), vertices.size() * sizeof(ANIMATED_VERTEX));
+
+            CookedLODSource lod = { 1.0f, vertices.data(), (unsigned int)vertices.size(),
+                gem.indices.data(), (unsigned int)gem.indices.size() };
+            return write(cookedPath, sizeof(ANIMATED_VERTEX), COOKED_MESH_ANIMATED, sourceHash, { lod });
+        }
+
+        std::vector<STATIC_VERTEX> vertices(gem.verticesStatic.size());
+        memcpy(vertices.data(), gem.verticesStatic.data(), vertices.size() * sizeof(STATIC_VERTEX));
+
+        std::vector<float> lodRatios = ratios.empty() ? std::vector<float>{ 1.0f } : ratios;
+        std::vector<std::vector<STATIC_VERTEX>> lodVertices(lodRatios.size());
+        std::vector<std::vector<unsigned int>> lodIndices(lodRatios.size());
+        std::vector<CookedLODSource> lods;
+
+        for (size_t i = 0; i < lodRatios.size(); i++)
+        {
+            if (!MeshSimplifier::simplifyGeometry(vertices, gem.indices, lodRatios[i], lodVertices[i], lodIndices[i]))
+                return false;
+
+            lods.push_back({ lodRatios[i], lodVertices[i].data(), (unsigned int)lodVertices[i].size(),
+                lodIndices[i].data(), (unsigned int)lodIndices[i].size() });
+        }
+
+        return write(cookedPath, sizeof(STATIC_VERTEX), 0, sourceHash, lods);
+    }
+
+    // Cooked file lives next to its source: Rock.gem -> Rock.cmesh
+    static std::string cookedPathFor(const std::string& gemPath)
+    {
+        std::filesystem::path path(gemPath);
+        path.replace_extension(".cmesh");
+        return path.string();
+    }
+
+    // Cooked file was written by this cooker version from exactly this source (sourceHash = hashFile
+    // of the .gem). Timestamps are not trusted: checkouts and copies reset them either way.
+    static bool isUpToDate(const CookedMeshFile& cooked, unsigned long long sourceHash)
+    {
+        return cooked.isOpen() && cooked.getVersion() == COOKED_MESH_VERSION && cooked.getSourceHash() == sourceHash;
+    }
+
+private:
+    static unsigned long long align(unsigned long long offset)
+    {
+        return (offset + 15) & ~15ULL;
+    }
+
+    // Zero-fill up to an absolute file offset
+    static void pad(std::ofstream& out, unsigned long long offset)
+    {
+        static const char zeros[16] = {};
+        unsigned long long pos = (unsigned long long)out.tellp();
+        if (offset > pos)
+            out.write(zeros, (std::streamsize)(offset - pos));
+    }
+};
@@ -1,13 +1,21 @@
 #pragma once
 
 #include <d3d12.h>
-#include <dxgi1_4.h>
+#include <dxgi1_5.h>
 #include <vector>
 
 #include <string>          
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
 #include "stb_image.h"
+#include "Hash.h"
+#include "TextureImage.h"
+#include "ThreadPool.h"
 #pragma comment(lib, "d3d12")
 #pragma comment(lib, "dxgi")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -69,11 +77,1201 @@ public:
 	}
 };
 
+// VRAM used by one texture created through Core::createTexture
+struct TextureMemoryRecord
+{
+	std::string name;
+	int width = 0;
+	int height = 0;
+	int mipCount = 0;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	UINT64 bytes = 0;
+	ID3D12Resource* resource = nullptr;   // Matches the record up in releaseTexture
+};
+
+// Contiguous run of CBV/SRV/UAV descriptors handed out by DescriptorAllocator
+struct DescriptorRange
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE cpu = {};   // First descriptor, for Create*View
+	D3D12_GPU_DESCRIPTOR_HANDLE gpu = {};   // First descriptor, for Set*RootDescriptorTable
+	unsigned int index = 0;                 // Offset from the start of the heap
+	unsigned int count = 0;                 // 0 = invalid (allocation failed or already freed)
+	unsigned int increment = 0;
+
+	bool valid() const { return count > 0; }
+
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuAt(unsigned int i) const
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE h = cpu;
+		h.ptr += (SIZE_T)i * increment;
+		return h;
+	}
+
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuAt(unsigned int i) const
+	{
+		D3D12_GPU_DESCRIPTOR_HANDLE h = gpu;
+		h.ptr += (UINT64)i * increment;
+		return h;
+	}
+};
+
+// Size of the root signature's bindless texture table (parameter 4). Kept within resource binding
+// tier 1's 128 SRVs per stage; every slot must hold a valid (or null) SRV on tier 1 hardware.
+static const unsigned int BINDLESS_TEXTURE_COUNT = 64;
+
 struct Texture {
 	ID3D12Resource* resource;                 // GPU texture resource
 	D3D12_GPU_DESCRIPTOR_HANDLE srvHandle;    // SRV handle in shader-visible heap
+	DescriptorRange srv;                      // Slot backing srvHandle, returned by Core::releaseTexture
+};
+
+// Region of upload memory handed out by UploadBatcher (ring slice or one-off overflow buffer)
+struct UploadAllocation
+{
+	ID3D12Resource* resource;   // Upload heap buffer backing this allocation
+	UINT64 offset;              // Byte offset into resource
+	unsigned char* cpuAddress;  // Persistently mapped CPU pointer at offset
+};
+
+// Records many uploads into one copy queue command list, sourced from a persistently mapped ring.
+// Resources written on the copy queue decay to COMMON when the list completes and are implicitly
+// promoted to their read state on first use by the graphics queue, so no barriers are recorded here.
+class UploadBatcher
+{
+public:
+	ID3D12Device5* device;
+	ID3D12CommandQueue* queue;
+	ID3D12CommandAllocator* commandAllocator;
+	ID3D12GraphicsCommandList4* commandList;
+	GPUFence fence;
+
+	ID3D12Resource* ringBuffer;
+	unsigned char* ringData;
+	UINT64 ringSize;
+	UINT64 ringOffset;
+	std::vector<ID3D12Resource*> overflowBuffers; // Released after the next submit completes
+
+	int batchDepth = 0;              // Nested begin/end count
+	bool reportStats = false;        // Outermost begin asked for a summary (explicit batches, not one-off uploads)
+	unsigned int pendingCopies = 0;  // Copies recorded since the last submit
+	unsigned int copyCount = 0;      // Stats for the current batch
+	unsigned int submitCount = 0;
+	UINT64 bytesUploaded = 0;
+
+	// Create ring buffer, copy allocator/list and fence
+	void init(ID3D12Device5* _device, ID3D12CommandQueue* _queue, UINT64 size)
+	{
+		device = _device;
+		queue = _queue;
+		ringSize = size;
+		ringOffset = 0;
+
+		ringBuffer = createUploadBuffer(ringSize);
+		ringBuffer->Map(0, nullptr, (void**)&ringData);
+
+		device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&commandAllocator));
+		device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_COPY, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&commandList));
+		fence.create(device);
+	}
+
+	// Open a batch (nestable); uploads are recorded until the matching outermost end()
+	void begin(bool report = false)
+	{
+		if (batchDepth++ > 0)
+			return;
+
+		reportStats = report;
+		copyCount = 0;
+		submitCount = 0;
+		bytesUploaded = 0;
+		openList();
+	}
+
+	// Close a batch; the outermost end submits everything and waits once
+	void end()
+	{
+		if (batchDepth == 0)
+			return;
+		if (--batchDepth > 0)
+			return;
+
+		submit();
+		if (reportStats && copyCount > 0)
+		{
+			std::cout << "[UploadBatcher] " << copyCount << " copies, " << (bytesUploaded / (1024 * 1024)) << " MB in "
+				<< submitCount << " submit(s)\n";
+		}
+	}
+
+	bool isRecording() const
+	{
+		return batchDepth > 0;
+	}
+
+	// Reserve upload memory; flushes the batch when the ring is full, overflows to a one-off buffer when too big
+	UploadAllocation allocate(UINT64 size, UINT64 alignment)
+	{
+		UploadAllocation alloc = {};
+		if (size > ringSize)
+		{
+			ID3D12Resource* buffer = createUploadBuffer(size);
+			buffer->Map(0, nullptr, (void**)&alloc.cpuAddress);
+			overflowBuffers.push_back(buffer);
+			alloc.resource = buffer;
+			alloc.offset = 0;
+			return alloc;
+		}
+
+		UINT64 aligned = (ringOffset + alignment - 1) & ~(alignment - 1);
+		if (aligned + size > ringSize)
+		{
+			submit();
+			aligned = 0;
+		}
+
+		alloc.resource = ringBuffer;
+		alloc.offset = aligned;
+		alloc.cpuAddress = ringData + aligned;
+		ringOffset = aligned + size;
+		return alloc;
+	}
+
+	// Record a buffer copy from previously filled upload memory
+	void copyBuffer(ID3D12Resource* dst, const UploadAllocation& src, UINT64 size, UINT64 dstOffset = 0)
+	{
+		commandList->CopyBufferRegion(dst, dstOffset, src.resource, src.offset, size);
+		recordCopy(size);
+	}
+
+	// Record one subresource texture copy; footprint describes the layout written at src (its Offset is
+	// relative to the allocation, as returned by GetCopyableFootprints)
+	void copyTexture(ID3D12Resource* dst, const UploadAllocation& src, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint, UINT64 size,
+		UINT subresource = 0)
+	{
+		D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+		srcLocation.pResource = src.resource;
+		srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		srcLocation.PlacedFootprint = footprint;
+		srcLocation.PlacedFootprint.Offset = src.offset + footprint.Offset;
+		D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
+		dstLocation.pResource = dst;
+		dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dstLocation.SubresourceIndex = subresource;
+		commandList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
+		recordCopy(size);
+	}
+
+	// Copy CPU data into upload memory and record the copy (texFootprint selects the texture path,
+	// dstOffset places buffer data inside a larger buffer)
+	void upload(ID3D12Resource* dst, const void* data, UINT64 size, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* texFootprint = NULL,
+		UINT64 dstOffset = 0)
+	{
+		UINT64 alignment = (texFootprint != NULL) ? D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 16;
+		UploadAllocation alloc = allocate(size, alignment);
+		memcpy(alloc.cpuAddress, data, size);
+
+		if (texFootprint != NULL)
+			copyTexture(dst, alloc, *texFootprint, size);
+		else
+			copyBuffer(dst, alloc, size, dstOffset);
+	}
+
+	// Execute recorded copies, wait for completion, then recycle the ring
+	void submit()
+	{
+		commandList->Close();
+		if (pendingCopies > 0)
+		{
+			ID3D12CommandList* lists[] = { commandList };
+			queue->ExecuteCommandLists(1, lists);
+			fence.signal(queue);
+			fence.wait();
+			submitCount++;
+		}
+		pendingCopies = 0;
+		ringOffset = 0;
+
+		for (auto* buffer : overflowBuffers)
+		{
+			buffer->Release();
+		}
+		overflowBuffers.clear();
+
+		// Keep recording if a batch is still open (mid-batch flush)
+		if (batchDepth > 0)
+			openList();
+	}
+
+	void release()
+	{
+		ringBuffer->Unmap(0, nullptr);
+		ringBuffer->Release();
+		commandList->Release();
+		commandAllocator->Release();
+	}
+
+private:
+	void openList()
+	{
+		commandAllocator->Reset();
+		commandList->Reset(commandAllocator, NULL);
+	}
+
+	void recordCopy(UINT64 size)
+	{
+		pendingCopies++;
+		copyCount++;
+		bytesUploaded += size;
+	}
+
+	ID3D12Resource* createUploadBuffer(UINT64 size)
+	{
+		ID3D12Resource* buffer;
+		D3D12_HEAP_PROPERTIES heapProps = {};
+		heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+		D3D12_RESOURCE_DESC bufferDesc = {};
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Width = size;
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, IID_PPV_ARGS(&buffer));
+		return buffer;
+	}
+};
+
+// Transient per-frame memory handed out by FrameAllocator
+struct FrameAllocation
+{
+	unsigned char* cpuAddress;              // Write-combined CPU pointer (write only, never read back)
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;   // For root CBVs / vertex buffer views
+	ID3D12Resource* resource;               // Backing upload buffer
+	UINT64 offset;                          // Byte offset into resource
+};
+
+// Linear allocator for data that lives for one frame (instance streams, constants, UI quads).
+// One persistently mapped upload buffer is split into a segment per frame in flight; a segment is
+// only reused after Core::beginFrame has waited on that frame's graphicsQueueFence.
+class FrameAllocator
+{
+public:
+	void init(ID3D12Device5* _device, UINT64 _bytesPerFrame, unsigned int _framesInFlight)
+	{
+		device = _device;
+		bytesPerFrame = _bytesPerFrame;
+		framesInFlight = _framesInFlight;
+		overflowBuffers.resize(framesInFlight);
+
+		buffer = createUploadBuffer(bytesPerFrame * framesInFlight);
+		D3D12_RANGE readRange = { 0, 0 };
+		buffer->Map(0, &readRange, (void**)&data);
+		gpuBase = buffer->GetGPUVirtualAddress();
+	}
+
+	// Start a frame's segment; the caller must already have waited for this frame's fence
+	void beginFrame(unsigned int frameIndex)
+	{
+		currentFrame = frameIndex;
+
+		// Overflow buffers from the last time this segment was used are done on the GPU now
+		for (auto b : overflowBuffers[currentFrame])
+		{
+			b->Release();
+		}
+		overflowBuffers[currentFrame].clear();
+
+		peakBytes = (std::max)(peakBytes, getFrameBytes());
+		offset = 0;
+		overflowBytes = 0;
+	}
+
+	// Bump-allocate size bytes (CBVs need 256-byte alignment, vertex data 16 is plenty)
+	FrameAllocation allocate(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+	{
+		std::lock_guard<std::mutex> lock(mutex);   // recordParallel jobs allocate concurrently
+		FrameAllocation alloc;
+		UINT64 aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+		if (aligned + size > bytesPerFrame)
+		{
+			// Segment exhausted: hand out a dedicated buffer kept alive until this frame retires
+			if (!overflowWarned)
+			{
+				std::cout << "[FrameAllocator] WARNING: " << (bytesPerFrame / (1024 * 1024))
+					<< " MB per frame exceeded, using overflow buffers\n";
+				overflowWarned = true;
+			}
+
+			ID3D12Resource* overflow = createUploadBuffer(size);
+			D3D12_RANGE readRange = { 0, 0 };
+			overflow->Map(0, &readRange, (void**)&alloc.cpuAddress);
+			alloc.gpuAddress = overflow->GetGPUVirtualAddress();
+			alloc.resource = overflow;
+			alloc.offset = 0;
+			overflowBuffers[currentFrame].push_back(overflow);
+			overflowBytes += size;
+			return alloc;
+		}
+
+		UINT64 base = currentFrame * bytesPerFrame + aligned;
+		alloc.cpuAddress = data + base;
+		alloc.gpuAddress = gpuBase + base;
+		alloc.resource = buffer;
+		alloc.offset = base;
+
+		offset = aligned + size;
+		return alloc;
+	}
+
+	// Allocate and fill in one go
+	FrameAllocation upload(const void* src, UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+	{
+		FrameAllocation alloc = allocate(size, alignment);
+		memcpy(alloc.cpuAddress, src, size);
+		return alloc;
+	}
+
+	// Bytes used this frame: ring segment plus overflow buffers (kept apart so neither hides the other)
+	UINT64 getFrameBytes() const { return offset + overflowBytes; }
+	UINT64 getOverflowBytes() const { return overflowBytes; }
+	UINT64 getPeakBytes() const { return (std::max)(peakBytes, getFrameBytes()); }
+
+	void release()
+	{
+		for (auto& list : overflowBuffers)
+		{
+			for (auto b : list)
+			{
+				b->Release();
+			}
+			list.clear();
+		}
+		buffer->Unmap(0, nullptr);
+		buffer->Release();
+	}
+
+private:
+	ID3D12Device5* device;
+	ID3D12Resource* buffer;
+	unsigned char* data;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuBase;
+	UINT64 bytesPerFrame = 0;
+	unsigned int framesInFlight = 0;
+	unsigned int currentFrame = 0;
+	UINT64 offset = 0;
+	UINT64 overflowBytes = 0;
+	UINT64 peakBytes = 0;
+	bool overflowWarned = false;
+	std::vector<std::vector<ID3D12Resource*>> overflowBuffers;
+	std::mutex mutex;
+
+	ID3D12Resource* createUploadBuffer(UINT64 size)
+	{
+		ID3D12Resource* res;
+		D3D12_HEAP_PROPERTIES heapProps = {};
+		heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+		D3D12_RESOURCE_DESC bufferDesc = {};
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Width = size;
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, IID_PPV_ARGS(&res));
+		return res;
+	}
+};
+
+// The one shader-visible CBV/SRV/UAV heap, shared by every subsystem so the heap is bound once per
+// command list and never switched mid-frame. Descriptors (textures, render target SRVs) are handed
+// out first-fit from a coalescing free list. Frees are deferred until the frame that issued them has
+// retired, like FrameAllocator's overflow buffers.
+class DescriptorAllocator
+{
+public:
+	void init(ID3D12Device5* device, unsigned int _persistentCount, unsigned int _framesInFlight)
+	{
+		persistentCount = _persistentCount;
+		framesInFlight = _framesInFlight;
+
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = persistentCount;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap));
+
+		increment = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		cpuBase = heap->GetCPUDescriptorHandleForHeapStart();
+		gpuBase = heap->GetGPUDescriptorHandleForHeapStart();
+
+		freeBlocks.clear();
+		freeBlocks.push_back({ 0, persistentCount });
+		pendingFree.assign(framesInFlight, {});
+	}
+
+	// Recycle the ranges freed the last time this frame index was recording; the caller must
+	// already have waited for this frame's fence
+	void beginFrame(unsigned int frameIndex)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentFrame = frameIndex;
+
+		for (const auto& block : pendingFree[currentFrame])
+		{
+			releaseBlock(block);
+		}
+		pendingFree[currentFrame].clear();
+	}
+
+	// Persistent descriptors, valid until free(); returns an invalid range when the heap is full
+	DescriptorRange allocate(unsigned int count)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < freeBlocks.size(); i++)
+		{
+			if (freeBlocks[i].count < count)
+				continue;
+
+			unsigned int index = freeBlocks[i].begin;
+			freeBlocks[i].begin += count;
+			freeBlocks[i].count -= count;
+			if (freeBlocks[i].count == 0)
+				freeBlocks.erase(freeBlocks.begin() + i);
+
+			persistentUsed += count;
+			peakPersistent = (std::max)(peakPersistent, persistentUsed);
+			return makeRange(index, count);
+		}
+
+		std::cout << "[DescriptorAllocator] ERROR: No run of " << count << " free descriptors ("
+			<< persistentUsed << "/" << persistentCount << " in use)\n";
+		return {};
+	}
+
+	// Return a persistent range; the slots are reused once the GPU has finished the current frame
+	void free(DescriptorRange& range)
+	{
+		if (!range.valid())
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		pendingFree[currentFrame].push_back({ range.index, range.count });
+		range = {};
+	}
+
+	ID3D12DescriptorHeap* getHeap() const { return heap; }
+	unsigned int getIncrement() const { return increment; }
+	unsigned int getPersistentUsed() const { return persistentUsed; }
+	unsigned int getPersistentPeak() const { return peakPersistent; }
+
+	void release()
+	{
+		if (heap) heap->Release();
+		heap = nullptr;
+	}
+
+private:
+	struct Block
+	{
+		unsigned int begin;
+		unsigned int count;
+	};
+
+	ID3D12DescriptorHeap* heap = nullptr;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuBase = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuBase = {};
+	unsigned int increment = 0;
+	unsigned int persistentCount = 0;
+	unsigned int framesInFlight = 0;
+	unsigned int currentFrame = 0;
+	unsigned int persistentUsed = 0;
+	unsigned int peakPersistent = 0;
+	std::vector<Block> freeBlocks;                  // Sorted by begin, never adjacent (merged on release)
+	std::vector<std::vector<Block>> pendingFree;    // Per frame: ranges freed while it was recording
+	std::mutex mutex;
+
+	DescriptorRange makeRange(unsigned int index, unsigned int count) const
+	{
+		DescriptorRange range;
+		range.index = index;
+		range.count = count;
+		range.increment = increment;
+		range.cpu.ptr = cpuBase.ptr + (SIZE_T)index * increment;
+		range.gpu.ptr = gpuBase.ptr + (UINT64)index * increment;
+		return range;
+	}
+
+	// Insert into the sorted free list, merging with the neighbours it touches
+	void releaseBlock(Block block)
+	{
+		auto it = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), block.begin,
+			[](const Block& b, unsigned int begin) { return b.begin < begin; });
+		it = freeBlocks.insert(it, block);
+		persistentUsed -= block.count;
+
+		auto next = it + 1;
+		if (next != freeBlocks.end() && it->begin + it->count == next->begin)
+		{
+			it->count += next->count;
+			freeBlocks.erase(next);
+		}
+		if (it != freeBlocks.begin())
+		{
+			auto prev = it - 1;
+			if (prev->begin + prev->count == it->begin)
+			{
+				prev->count += it->count;
+				freeBlocks.erase(it);
+			}
+		}
+	}
+};
+
+// Where a mesh lives in GeometryPool; page < 0 means not pooled
+struct GeometryAllocation
+{
+	int page = -1;
+	UINT64 vertexOffset = 0;    // Bytes into the page's vertex buffer, a multiple of the mesh's stride
+	UINT64 vertexSize = 0;
+	UINT64 indexOffset = 0;     // Bytes into the page's index buffer (32-bit indices)
+	UINT64 indexSize = 0;
+
+	bool valid() const { return page >= 0; }
+};
+
+// Shared vertex and index buffers that every static and animated Mesh is suballocated from, so meshes
+// on the same page draw back to back from one IASetVertexBuffers/IASetIndexBuffer pair using
+// BaseVertexLocation/StartIndexLocation. Pages are created on demand; each keeps a first-fit,
+// coalescing free list for its vertex and index bytes. Pages stay in COMMON and rely on implicit
+// promotion (copy queue writes, graphics reads), so fill them at load time, not while frames that
+// read the same page are in flight.
+class GeometryPool
+{
+public:
+	static const UINT64 VERTEX_PAGE_BYTES = 64ull * 1024 * 1024;
+	static const UINT64 INDEX_PAGE_BYTES = 32ull * 1024 * 1024;
+
+	void init(ID3D12Device5* _device)
+	{
+		device = _device;
+	}
+
+	// Returns an invalid allocation when the mesh is larger than a page (the caller keeps its own buffers)
+	GeometryAllocation allocate(UINT64 vertexBytes, unsigned int stride, UINT64 indexBytes)
+	{
+		GeometryAllocation alloc;
+		if (vertexBytes == 0 || indexBytes == 0 || stride == 0 ||
+			vertexBytes + stride > VERTEX_PAGE_BYTES || indexBytes + 4 > INDEX_PAGE_BYTES)
+			return alloc;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t p = 0; p <= pages.size(); p++)
+		{
+			if (p == pages.size() && !addPage())
+				return alloc;
+
+			Page& page = pages[p];
+			UINT64 vertexOffset, indexOffset;
+			if (!takeBlock(page.vertexFree, vertexBytes, stride, vertexOffset))
+				continue;
+			if (!takeBlock(page.indexFree, indexBytes, 4, indexOffset))
+			{
+				releaseBlock(page.vertexFree, { vertexOffset, vertexBytes });
+				continue;
+			}
+
+			page.vertexUsed += vertexBytes;
+			page.indexUsed += indexBytes;
+			alloc.page = (int)p;
+			alloc.vertexOffset = vertexOffset;
+			alloc.vertexSize = vertexBytes;
+			alloc.indexOffset = indexOffset;
+			alloc.indexSize = indexBytes;
+			return alloc;
+		}
+		return alloc;
+	}
+
+	// Immediate, like releasing a committed buffer: only free meshes the GPU has finished with
+	void free(GeometryAllocation& alloc)
+	{
+		if (!alloc.valid())
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Page& page = pages[alloc.page];
+		releaseBlock(page.vertexFree, { alloc.vertexOffset, alloc.vertexSize });
+		releaseBlock(page.indexFree, { alloc.indexOffset, alloc.indexSize });
+		page.vertexUsed -= alloc.vertexSize;
+		page.indexUsed -= alloc.indexSize;
+		alloc = {};
+	}
+
+	ID3D12Resource* getVertexBuffer(int page) const { return pages[page].vertexBuffer; }
+	ID3D12Resource* getIndexBuffer(int page) const { return pages[page].indexBuffer; }
+
+	// Whole-page views; a mesh on the page draws with its base vertex (offset / stride) and start index
+	D3D12_VERTEX_BUFFER_VIEW getVertexBufferView(int page, unsigned int stride) const
+	{
+		D3D12_VERTEX_BUFFER_VIEW view;
+		view.BufferLocation = pages[page].vertexBuffer->GetGPUVirtualAddress();
+		view.StrideInBytes = stride;
+		view.SizeInBytes = (UINT)VERTEX_PAGE_BYTES;
+		return view;
+	}
+
+	D3D12_INDEX_BUFFER_VIEW getIndexBufferView(int page) const
+	{
+		D3D12_INDEX_BUFFER_VIEW view;
+		view.BufferLocation = pages[page].indexBuffer->GetGPUVirtualAddress();
+		view.Format = DXGI_FORMAT_R32_UINT;
+		view.SizeInBytes = (UINT)INDEX_PAGE_BYTES;
+		return view;
+	}
+
+	unsigned int getPageCount() const { return (unsigned int)pages.size(); }
+
+	void printReport() const
+	{
+		std::cout << "[GeometryPool] " << pages.size() << " page(s)\n";
+		for (size_t p = 0; p < pages.size(); p++)
+		{
+			std::cout << "  Page " << p << ": vertices " << (pages[p].vertexUsed / 1024) << " / " << (VERTEX_PAGE_BYTES / 1024)
+				<< " KB, indices " << (pages[p].indexUsed / 1024) << " / " << (INDEX_PAGE_BYTES / 1024) << " KB\n";
+		}
+	}
+
+	void release()
+	{
+		for (auto& page : pages)
+		{
+			page.vertexBuffer->Release();
+			page.indexBuffer->Release();
+		}
+		pages.clear();
+	}
+
+private:
+	struct Block
+	{
+		UINT64 begin;
+		UINT64 size;
+	};
+
+	struct Page
+	{
+		ID3D12Resource* vertexBuffer = nullptr;
+		ID3D12Resource* indexBuffer = nullptr;
+		std::vector<Block> vertexFree;      // Sorted by begin, never adjacent (merged on release)
+		std::vector<Block> indexFree;
+		UINT64 vertexUsed = 0;
+		UINT64 indexUsed = 0;
+	};
+
+	ID3D12Device5* device = nullptr;
+	std::vector<Page> pages;
+	std::mutex mutex;
+
+	bool addPage()
+	{
+		Page page;
+		page.vertexBuffer = createBuffer(VERTEX_PAGE_BYTES);
+		page.indexBuffer = createBuffer(INDEX_PAGE_BYTES);
+		if (page.vertexBuffer == nullptr || page.indexBuffer == nullptr)
+		{
+			if (page.vertexBuffer) page.vertexBuffer->Release();
+			if (page.indexBuffer) page.indexBuffer->Release();
+			std::cout << "[GeometryPool] ERROR: Failed to create page " << pages.size() << "\n";
+			return false;
+		}
+		page.vertexFree.push_back({ 0, VERTEX_PAGE_BYTES });
+		page.indexFree.push_back({ 0, INDEX_PAGE_BYTES });
+		pages.push_back(page);
+		return true;
+	}
+
+	// First fit at a multiple of alignment; padding in front of the block stays free
+	static bool takeBlock(std::vector<Block>& freeBlocks, UINT64 size, UINT64 alignment, UINT64& outOffset)
+	{
+		for (size_t i = 0; i < freeBlocks.size(); i++)
+		{
+			Block block = freeBlocks[i];
+			UINT64 aligned = ((block.begin + alignment - 1) / alignment) * alignment;
+			if (aligned + size > block.begin + block.size)
+				continue;
+
+			freeBlocks.erase(freeBlocks.begin() + i);
+			UINT64 tail = block.begin + block.size - (aligned + size);
+			if (tail > 0)
+				freeBlocks.insert(freeBlocks.begin() + i, { aligned + size, tail });
+			if (aligned > block.begin)
+				freeBlocks.insert(freeBlocks.begin() + i, { block.begin, aligned - block.begin });
+
+			outOffset = aligned;
+			return true;
+		}
+		return false;
+	}
+
+	// Insert into the sorted free list, merging with the neighbours it touches
+	static void releaseBlock(std::vector<Block>& freeBlocks, Block block)
+	{
+		auto it = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), block.begin,
+			[](const Block& b, UINT64 begin) { return b.begin < begin; });
+		it = freeBlocks.insert(it, block);
+
+		auto next = it + 1;
+		if (next != freeBlocks.end() && it->begin + it->size == next->begin)
+		{
+			it->size += next->size;
+			freeBlocks.erase(next);
+		}
+		if (it != freeBlocks.begin())
+		{
+			auto prev = it - 1;
+			if (prev->begin + prev->size == it->begin)
+			{
+				prev->size += it->size;
+				freeBlocks.erase(it);
+			}
+		}
+	}
+
+	ID3D12Resource* createBuffer(UINT64 size)
+	{
+		ID3D12Resource* res = nullptr;
+		D3D12_HEAP_PROPERTIES heapProps = {};
+		heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+		D3D12_RESOURCE_DESC bufferDesc = {};
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Width = size;
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		if (FAILED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COMMON, NULL, IID_PPV_ARGS(&res))))
+			return nullptr;
+		return res;
+	}
+};
+
+// Extra direct command lists for Core::recordParallel, one set per frame in flight. Lists are
+// created on demand and a list handed out by acquire() is only reset again after Core::beginFrame
+// has waited on that frame's graphicsQueueFence.
+class CommandListPool
+{
+public:
+	void init(ID3D12Device5* _device, unsigned int framesInFlight)
+	{
+		device = _device;
+		frames.resize(framesInFlight);
+	}
+
+	void beginFrame(unsigned int frameIndex)
+	{
+		currentFrame = frameIndex;
+		frames[currentFrame].used = 0;
+	}
+
+	// Reset and open the next list of this frame (main thread only)
+	ID3D12GraphicsCommandList4* acquire()
+	{
+		Frame& frame = frames[currentFrame];
+		if (frame.used == frame.entries.size())
+		{
+			Entry entry;
+			device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&entry.allocator));
+			device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&entry.list));
+			frame.entries.push_back(entry);
+		}
+
+		Entry& entry = frame.entries[frame.used++];
+		entry.allocator->Reset();
+		entry.list->Reset(entry.allocator, NULL);
+		return entry.list;
+	}
+
+	// List that Core::getCommandList returns on the calling thread while a recordParallel job runs
+	static ID3D12GraphicsCommandList4*& threadList()
+	{
+		static thread_local ID3D12GraphicsCommandList4* list = nullptr;
+		return list;
+	}
+
+	unsigned int getUsedThisFrame() const { return frames.empty() ? 0 : (unsigned int)frames[currentFrame].used; }
+
+	void release()
+	{
+		for (auto& frame : frames)
+		{
+			for (auto& entry : frame.entries)
+			{
+				entry.list->Release();
+				entry.allocator->Release();
+			}
+			frame.entries.clear();
+		}
+	}
+
+private:
+	struct Entry
+	{
+		ID3D12CommandAllocator* allocator;
+		ID3D12GraphicsCommandList4* list;
+	};
+
+	struct Frame
+	{
+		std::vector<Entry> entries;
+		size_t used = 0;
+	};
+
+	ID3D12Device5* device = nullptr;
+	std::vector<Frame> frames;
+	unsigned int currentFrame = 0;
+};
+
+// Render targets and viewport that Core::recordParallel binds on every list it opens, so jobs
+// start from the same state the serial list had at the split
+struct RenderPassState
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE rtv = {};
+	D3D12_CPU_DESCRIPTOR_HANDLE dsv = {};
+	bool hasDepth = false;
+	D3D12_VIEWPORT viewport = {};
+	D3D12_RECT scissor = {};
+};
+
+// Work submitted this frame, counted at the draw/dispatch call sites (atomic: recordParallel jobs
+// count concurrently). ExecuteIndirect adds a draw but not its instances, which stay on the GPU.
+struct FrameStats
+{
+	std::atomic<unsigned int> drawCalls{ 0 };
+	std::atomic<unsigned int> instances{ 0 };
+	std::atomic<unsigned int> dispatches{ 0 };
+
+	void reset()
+	{
+		drawCalls = 0;
+		instances = 0;
+		dispatches = 0;
+	}
+};
+
+// Pipeline state cache backed by an ID3D12PipelineLibrary that is serialised to disk, so a warm
+// boot loads compiled PSOs from the driver blob instead of recompiling them. Entries are keyed on
+// the caller's name plus a hash of the description (bytecode, layout, fixed-function state), so an
+// edited shader misses cleanly and is recompiled.
+class PipelineCache
+{
+public:
+	void init(ID3D12Device5* _device, const std::string& _path)
+	{
+		device = _device;
+		path = _path;
+
+		// The library reads from this memory for its whole lifetime, so it is kept in a member
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (file.is_open())
+		{
+			std::streamsize size = file.tellg();
+			if (size > 0)
+			{
+				libraryData.resize((size_t)size);
+				file.seekg(0, std::ios::beg);
+				file.read((char*)libraryData.data(), size);
+			}
+		}
+
+		HRESULT hr = E_FAIL;
+		if (!libraryData.empty())
+		{
+			hr = device->CreatePipelineLibrary(libraryData.data(), libraryData.size(), IID_PPV_ARGS(&library));
+			if (FAILED(hr))
+			{
+				// Driver or adapter changed since the blob was written
+				std::cout << "[PipelineCache] Discarding stale library (" << path << ")\n";
+				libraryData.clear();
+			}
+		}
+		if (FAILED(hr))
+		{
+			hr = device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library));
+		}
+		if (FAILED(hr))
+		{
+			std::cout << "[PipelineCache] WARNING: Pipeline libraries unsupported, PSOs are compiled every launch\n";
+			library = nullptr;
+		}
+	}
+
+	ID3D12PipelineState* createGraphics(const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+	{
+		std::wstring key = makeKey(name, hashGraphicsDesc(desc));
+		ID3D12PipelineState* pso = nullptr;
+		if (library != nullptr && SUCCEEDED(library->LoadGraphicsPipeline(key.c_str(), &desc, IID_PPV_ARGS(&pso))))
+		{
+			record(key, pso, false);
+			return pso;
+		}
+		if (FAILED(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso))))
+		{
+			return nullptr;
+		}
+		record(key, pso, true);
+		return pso;
+	}
+
+	ID3D12PipelineState* createCompute(const std::string& name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+	{
+		unsigned long long hash = hashBytes(desc.CS.pShaderBytecode, desc.CS.BytecodeLength);
+		std::wstring key = makeKey(name, hash);
+		ID3D12PipelineState* pso = nullptr;
+		if (library != nullptr && SUCCEEDED(library->LoadComputePipeline(key.c_str(), &desc, IID_PPV_ARGS(&pso))))
+		{
+			record(key, pso, false);
+			return pso;
+		}
+		if (FAILED(device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso))))
+		{
+			return nullptr;
+		}
+		record(key, pso, true);
+		return pso;
+	}
+
+	// Write the library if anything was compiled since the last save. The file is rebuilt from
+	// this run's pipelines only, so entries for edited shaders do not accumulate.
+	void save()
+	{
+		if (library == nullptr || misses == 0)
+		{
+			return;
+		}
+
+		ID3D12PipelineLibrary* fresh = nullptr;
+		if (FAILED(device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&fresh))))
+		{
+			return;
+		}
+		for (auto& entry : entries)
+		{
+			fresh->StorePipeline(entry.first.c_str(), entry.second);
+		}
+
+		std::vector<unsigned char> data(fresh->GetSerializedSize());
+		HRESULT hr = fresh->Serialize(data.data(), data.size());
+		fresh->Release();
+		if (FAILED(hr))
+		{
+			std::cout << "[PipelineCache] WARNING: Failed to serialise pipeline library\n";
+			return;
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+		std::string tempPath = path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary);
+			if (!file.is_open())
+			{
+				std::cout << "[PipelineCache] WARNING: Cannot write " << path << "\n";
+				return;
+			}
+			file.write((const char*)data.data(), (std::streamsize)data.size());
+		}
+		std::filesystem::rename(tempPath, path, ec);
+
+		std::cout << "[PipelineCache] Saved " << entries.size() << " pipelines (" << hits << " loaded, "
+			<< misses << " compiled)\n";
+		misses = 0;
+	}
+
+	void release()
+	{
+		save();
+		for (auto& entry : entries)
+		{
+			entry.second->Release();
+		}
+		entries.clear();
+		if (library != nullptr)
+		{
+			library->Release();
+		}
+	}
+
+private:
+	ID3D12Device5* device;
+	ID3D12PipelineLibrary* library = nullptr;
+	std::string path;
+	std::vector<unsigned char> libraryData;
+	std::vector<std::pair<std::wstring, ID3D12PipelineState*>> entries;   // Referenced until release()
+	unsigned int hits = 0;
+	unsigned int misses = 0;
+
+	void record(const std::wstring& key, ID3D12PipelineState* pso, bool compiled)
+	{
+		pso->AddRef();
+		entries.push_back({ key, pso });
+		if (compiled)
+		{
+			misses++;
+		}
+		else
+		{
+			hits++;
+		}
+	}
+
+	static std::wstring makeKey(const std::string& name, unsigned long long hash)
+	{
+		char suffix[24];
+		snprintf(suffix, sizeof(suffix), "#%016llx", hash);
+		std::string key = name + suffix;
+		return std::wstring(key.begin(), key.end());
+	}
+
+	// For scalars and enums only; structs are hashed member by member so padding never reaches the key
+	template <typename T>
+	static unsigned long long hashField(const T& value, unsigned long long hash)
+	{
+		return hashBytes(&value, sizeof(value), hash);
+	}
+
+	// Strings by content with their terminator, so adjacent names cannot run together
+	static unsigned long long hashString(const char* text, unsigned long long hash)
+	{
+		return text ? hashBytes(text, strlen(text) + 1, hash) : hashField('\0', hash);
+	}
+
+	static unsigned long long hashBytecode(const D3D12_SHADER_BYTECODE& code, unsigned long long hash)
+	{
+		hash = hashField(code.BytecodeLength, hash);
+		return code.pShaderBytecode ? hashBytes(code.pShaderBytecode, code.BytecodeLength, hash) : hash;
+	}
+
+	static unsigned long long hashStencilOp(const D3D12_DEPTH_STENCILOP_DESC& op, unsigned long long hash)
+	{
+		hash = hashField(op.StencilFailOp, hash);
+		hash = hashField(op.StencilDepthFailOp, hash);
+		hash = hashField(op.StencilPassOp, hash);
+		return hashField(op.StencilFunc, hash);
+	}
+
+	// Everything that changes the compiled pipeline (the root signature is Core's one and only)
+	static unsigned long long hashGraphicsDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+	{
+		unsigned long long hash = hashBytecode(desc.VS, hashBytes(nullptr, 0));   // Chained from the FNV basis
+		hash = hashBytecode(desc.PS, hash);
+		hash = hashBytecode(desc.DS, hash);
+		hash = hashBytecode(desc.HS, hash);
+		hash = hashBytecode(desc.GS, hash);
+
+		hash = hashField(desc.StreamOutput.NumEntries, hash);
+		for (UINT i = 0; i < desc.StreamOutput.NumEntries; i++)
+		{
+			const D3D12_SO_DECLARATION_ENTRY& e = desc.StreamOutput.pSODeclaration[i];
+			hash = hashField(e.Stream, hash);
+			hash = hashString(e.SemanticName, hash);
+			hash = hashField(e.SemanticIndex, hash);
+			hash = hashField(e.StartComponent, hash);
+			hash = hashField(e.ComponentCount, hash);
+			hash = hashField(e.OutputSlot, hash);
+		}
+		hash = hashField(desc.StreamOutput.NumStrides, hash);
+		for (UINT i = 0; i < desc.StreamOutput.NumStrides; i++)
+		{
+			hash = hashField(desc.StreamOutput.pBufferStrides[i], hash);
+		}
+		hash = hashField(desc.StreamOutput.RasterizedStream, hash);
+
+		hash = hashField(desc.BlendState.AlphaToCoverageEnable, hash);
+		hash = hashField(desc.BlendState.IndependentBlendEnable, hash);
+		for (const D3D12_RENDER_TARGET_BLEND_DESC& rt : desc.BlendState.RenderTarget)
+		{
+			hash = hashField(rt.BlendEnable, hash);
+			hash = hashField(rt.LogicOpEnable, hash);
+			hash = hashField(rt.SrcBlend, hash);
+			hash = hashField(rt.DestBlend, hash);
+			hash = hashField(rt.BlendOp, hash);
+			hash = hashField(rt.SrcBlendAlpha, hash);
+			hash = hashField(rt.DestBlendAlpha, hash);
+			hash = hashField(rt.BlendOpAlpha, hash);
+			hash = hashField(rt.LogicOp, hash);
+			hash = hashField(rt.RenderTargetWriteMask, hash);
+		}
+		hash = hashField(desc.SampleMask, hash);
+
+		const D3D12_RASTERIZER_DESC& r = desc.RasterizerState;
+		hash = hashField(r.FillMode, hash);
+		hash = hashField(r.CullMode, hash);
+		hash = hashField(r.FrontCounterClockwise, hash);
+		hash = hashField(r.DepthBias, hash);
+		hash = hashField(r.DepthBiasClamp, hash);
+		hash = hashField(r.SlopeScaledDepthBias, hash);
+		hash = hashField(r.DepthClipEnable, hash);
+		hash = hashField(r.MultisampleEnable, hash);
+		hash = hashField(r.AntialiasedLineEnable, hash);
+		hash = hashField(r.ForcedSampleCount, hash);
+		hash = hashField(r.ConservativeRaster, hash);
+
+		const D3D12_DEPTH_STENCIL_DESC& ds = desc.DepthStencilState;
+		hash = hashField(ds.DepthEnable, hash);
+		hash = hashField(ds.DepthWriteMask, hash);
+		hash = hashField(ds.DepthFunc, hash);
+		hash = hashField(ds.StencilEnable, hash);
+		hash = hashField(ds.StencilReadMask, hash);
+		hash = hashField(ds.StencilWriteMask, hash);
+		hash = hashStencilOp(ds.FrontFace, hash);
+		hash = hashStencilOp(ds.BackFace, hash);
+
+		hash = hashField(desc.InputLayout.NumElements, hash);
+		for (UINT i = 0; i < desc.InputLayout.NumElements; i++)
+		{
+			const D3D12_INPUT_ELEMENT_DESC& e = desc.InputLayout.pInputElementDescs[i];
+			hash = hashString(e.SemanticName, hash);
+			hash = hashField(e.SemanticIndex, hash);
+			hash = hashField(e.Format, hash);
+			hash = hashField(e.InputSlot, hash);
+			hash = hashField(e.AlignedByteOffset, hash);
+			hash = hashField(e.InputSlotClass, hash);
+			hash = hashField(e.InstanceDataStepRate, hash);
+		}
+
+		hash = hashField(desc.IBStripCutValue, hash);
+		hash = hashField(desc.PrimitiveTopologyType, hash);
+		hash = hashField(desc.NumRenderTargets, hash);
+		for (UINT i = 0; i < desc.NumRenderTargets; i++)
+		{
+			hash = hashField(desc.RTVFormats[i], hash);
+		}
+		hash = hashField(desc.DSVFormat, hash);
+		hash = hashField(desc.SampleDesc.Count, hash);
+		hash = hashField(desc.SampleDesc.Quality, hash);
+		hash = hashField(desc.NodeMask, hash);
+		hash = hashField(desc.Flags, hash);
+		return hash;
+	}
 };
 
+// Swapchain/frame pacing options, read by Core::init. Each frame in flight owns a command
+// allocator, a fence and its slice of the per-frame allocators, and the swapchain has one
+// backbuffer per frame in flight.
+struct PresentSettings
+{
+	unsigned int framesInFlight = 3;       // 2..MAX_FRAMES_IN_FLIGHT
+	bool allowTearing = true;              // Present(0, ALLOW_TEARING) when vsync is off, if the display supports it
+	bool waitableSwapchain = true;         // Block beginFrame on the frame latency object instead of deep in Present
+	unsigned int maxFrameLatency = 1;      // Queued presents before the latency object blocks
+};
+
+static const unsigned int MAX_FRAMES_IN_FLIGHT = 3;
+
 class Core
 {
 public:
@@ -93,20 +1291,37 @@ public:
 	D3D12_VIEWPORT viewport;
 	D3D12_RECT scissorRect;
 
-	ID3D12DescriptorHeap* srvHeap;
-	unsigned int srvDescriptorSize;
-	unsigned int srvHeapIndex = 0;
-
-	ID3D12CommandAllocator* graphicsCommandAllocator[2];
-	ID3D12GraphicsCommandList4* graphicsCommandList[2];
+	DescriptorAllocator descriptors;   // The shared shader-visible CBV/SRV/UAV heap
+
+	PresentSettings presentSettings;   // Set before init
+	unsigned int framesInFlight = 2;
+	unsigned int frameSlot = 0;                            // Per-frame resource index, advanced every finishFrame
+	bool tearingSupported = false;
+	UINT swapchainFlags = 0;
+	HANDLE frameLatencyWaitable = nullptr;
+
+	ID3D12CommandAllocator* graphicsCommandAllocator[MAX_FRAMES_IN_FLIGHT];
+	ID3D12GraphicsCommandList4* graphicsCommandList[MAX_FRAMES_IN_FLIGHT];
+	ID3D12GraphicsCommandList4* currentCommandList = nullptr;  // Serial list getCommandList() returns outside jobs
+	std::vector<ID3D12CommandList*> pendingCommandLists;       // Closed earlier this frame, executed ahead of currentCommandList
+	CommandListPool commandListPool;
+	RenderPassState passState;
+	FrameStats stats;
+	bool vsync = true;                                         // false presents immediately (tearing when supported)
 	ID3D12RootSignature* rootSignature;
 	unsigned int srvTableIndex;
-	GPUFence graphicsQueueFence[2];
+	GPUFence graphicsQueueFence[MAX_FRAMES_IN_FLIGHT];
 	int width;
 	int height;
 	HWND windowHandle;
 	ID3D12DescriptorHeap* rtvHeap;
 	int frameInd;
+	UploadBatcher uploader;
+	FrameAllocator frameAllocator;
+	GeometryPool geometry;
+	std::vector<TextureMemoryRecord> textureMemory;   // One entry per live createTexture, for printTextureMemoryReport
+	std::vector<ID3D12Resource*> retiredResources[MAX_FRAMES_IN_FLIGHT]; // Released once that frame's fence has passed
+	PipelineCache pipelineCache;
 
 	// Initialise device, queues, swapchain, heaps, command lists, fences, root signature
 	void init(HWND hwnd, int _width, int _height)
@@ -116,6 +1331,18 @@ public:
 		if (FAILED(hrFactory) || factory == nullptr)
 			return;
 
+		framesInFlight = (std::min)((std::max)(presentSettings.framesInFlight, 2u), MAX_FRAMES_IN_FLIGHT);
+
+		// Tearing needs DXGI 1.5 and a flip-model swapchain created with the flag
+		IDXGIFactory5* factory5 = nullptr;
+		if (presentSettings.allowTearing && SUCCEEDED(factory->QueryInterface(IID_PPV_ARGS(&factory5))))
+		{
+			BOOL allow = FALSE;
+			if (SUCCEEDED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allow, sizeof(allow))))
+				tearingSupported = (allow == TRUE);
+			factory5->Release();
+		}
+
 		int i = 0;
 		IDXGIAdapter1* adapterf;
 		std::vector<IDXGIAdapter1*> adapters;
@@ -171,13 +1398,29 @@ public:
 		scDesc.Height = _height;
 		scDesc.SampleDesc.Count = 1; // MSAA here
 		scDesc.SampleDesc.Quality = 0;
-		scDesc.BufferCount = 2;
+		scDesc.BufferCount = framesInFlight;
 		scDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+		if (tearingSupported)
+			scDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+		if (presentSettings.waitableSwapchain)
+			scDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+		swapchainFlags = scDesc.Flags;
 		IDXGISwapChain1* swapChain1;
 		factory->CreateSwapChainForHwnd(graphicsQueue, hwnd, &scDesc, nullptr, nullptr, &swapChain1);
 		swapChain1->QueryInterface(&swapchain); // This is needed to map to the correct interface
 		swapChain1->Release();
 
+		if (presentSettings.waitableSwapchain)
+		{
+			swapchain->SetMaximumFrameLatency((std::max)(presentSettings.maxFrameLatency, 1u));
+			frameLatencyWaitable = swapchain->GetFrameLatencyWaitableObject();
+		}
+
+		// Exclusive fullscreen would reject ALLOW_TEARING presents; the game runs borderless/windowed
+		factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER);
+		std::cout << "[Core] " << framesInFlight << " frames in flight, tearing " << (tearingSupported ? "supported" : "unavailable")
+			<< ", latency waitable " << (frameLatencyWaitable ? "on" : "off") << "\n";
+
 		factory->Release();
 
 		D3D12_DESCRIPTOR_HEAP_DESC renderTargetViewHeapDesc;
@@ -189,8 +1432,10 @@ public:
 		device->CreateDescriptorHeap(&renderTargetViewHeapDesc, IID_PPV_ARGS(&backbufferHeap));
 		renderTargetViewHandle = backbufferHeap->GetCPUDescriptorHandleForHeapStart();
 		backbuffers = new ID3D12Resource * [scDesc.BufferCount];
-		backbuffers[0] = NULL;
-		backbuffers[1] = NULL;
+		for (unsigned int i = 0; i < scDesc.BufferCount; i++)
+		{
+			backbuffers[i] = NULL;
+		}
 
 		D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
 		memset(&dsvHeapDesc, 0, sizeof(D3D12_DESCRIPTOR_HEAP_DESC));
@@ -201,47 +1446,67 @@ public:
 		dsvHandle = dsvHeap->GetCPUDescriptorHandleForHeapStart();
 		dsv = NULL;
 
-		D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-		srvHeapDesc.NumDescriptors = 128; // Allow up to 128 textures
-		srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE; // Important!
-		device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&srvHeap));
-
-		srvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-		srvHeapIndex = 0;
+		descriptors.init(device, 8192, framesInFlight);
 
 		width = _width;
 		height = _height;
 		updateScreenResources(_width, _height);
 
-		device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&graphicsCommandAllocator[0]));
-		device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&graphicsCommandList[0]));
-		device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&graphicsCommandAllocator[1]));
-		device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&graphicsCommandList[1]));
+		for (unsigned int i = 0; i < framesInFlight; i++)
+		{
+			device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&graphicsCommandAllocator[i]));
+			device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&graphicsCommandList[i]));
+		}
+		currentCommandList = graphicsCommandList[0];
 
-		graphicsQueueFence[0].create(device);
-		graphicsQueueFence[1].create(device);
+		// All slots get a fence (GPUFence releases unconditionally); only framesInFlight are used
+		for (unsigned int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			graphicsQueueFence[i].create(device);
+		}
 
 		createRootSignature();
 
+		uploader.init(device, copyQueue, 128 * 1024 * 1024);
+		frameAllocator.init(device, 32 * 1024 * 1024, framesInFlight);
+		geometry.init(device);
+		commandListPool.init(device, framesInFlight);
+		pipelineCache.init(device, "ShaderCache/PSOLibrary.bin");
+
 		windowHandle = hwnd;
 	}
 
 
-	// Load image, upload to GPU, create SRV, return resource + GPU handle
+	// Load image (or its precompressed .dds), upload every mip to the GPU, create SRV
 	Texture loadTexture(std::string filename)
 	{
-		// 1. Load Pixels from file
-		int w, h, channels;
-		unsigned char* data = stbi_load(filename.c_str(), &w, &h, &channels, 4);
-		if (!data) return {};
+		// 1. Decode pixels / read the container (mips included)
+		TextureImage image;
+		if (!TextureImageLoader::load(filename, image))
+		{
+			std::cout << "[Core] WARNING: Failed to load texture " << filename << "\n";
+			return {};
+		}
+		return createTexture(image, filename);
+	}
+
+	// Create GPU texture from decoded RGBA8 pixels (mips are generated here)
+	Texture createTexture(const unsigned char* data, int w, int h, const std::string& name = "")
+	{
+		TextureImage image;
+		TextureImageLoader::fromRGBA(data, w, h, image);
+		return createTexture(image, name);
+	}
 
+	// Create GPU texture with the image's full mip chain, upload it and allocate an SRV
+	Texture createTexture(const TextureImage& image, const std::string& name = "")
+	{
 		// 2. Create the GPU Resource
 		D3D12_RESOURCE_DESC textureDesc = {};
-		textureDesc.MipLevels = 1;
-		textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		textureDesc.Width = w;
-		textureDesc.Height = h;
+		textureDesc.MipLevels = (UINT16)image.mipCount();
+		textureDesc.Format = image.format;
+		textureDesc.Width = image.width;
+		textureDesc.Height = image.height;
 		textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 		textureDesc.DepthOrArraySize = 1;
 		textureDesc.SampleDesc.Count = 1;
@@ -252,65 +1517,128 @@ public:
 		D3D12_HEAP_PROPERTIES heapProps = {};
 		heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
 
-		device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &textureDesc,
+		HRESULT hr = device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &textureDesc,
 			D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&textureResource));
+		if (FAILED(hr))
+		{
+			std::cout << "[Core] ERROR: Failed to create texture " << name << " (" << image.width << "x" << image.height
+				<< " " << TextureImageLoader::formatName(image.format) << ")\n";
+			return {};
+		}
 
-		// 3. Calculate Footprint
+		// 3. Calculate Footprints for every mip
+		UINT mipCount = (UINT)image.mipCount();
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(mipCount);
+		std::vector<UINT> numRows(mipCount);
 		UINT64 uploadBufferSize;
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
-		D3D12_RESOURCE_DESC desc = textureResource->GetDesc();
-		device->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, nullptr, nullptr, &uploadBufferSize);
+		device->GetCopyableFootprints(&textureDesc, 0, mipCount, 0, footprints.data(), numRows.data(), nullptr, &uploadBufferSize);
 
-		// 4. Pad rows to match footprint.RowPitch for CopyTextureRegion
-		std::vector<unsigned char> paddedData(uploadBufferSize);
+		// 4. Write rows straight into upload ring memory at each footprint's RowPitch. Outside a batch
+		// this opens a one-texture batch, so all mips still go out in a single submission.
+		bool ownBatch = !uploader.isRecording();
+		if (ownBatch)
+			uploader.begin();
 
-		// Copy row-by-row into padded layout
-		for (int y = 0; y < h; y++)
+		UploadAllocation alloc = uploader.allocate(uploadBufferSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		for (UINT m = 0; m < mipCount; m++)
 		{
-			unsigned char* src = data + (y * w * 4);
-			unsigned char* dst = paddedData.data() + (y * footprint.Footprint.RowPitch);
-			memcpy(dst, src, w * 4);
+			const TextureMip& mip = image.mips[m];
+			const unsigned char* src = image.mipData(m);
+			unsigned char* dst = alloc.cpuAddress + footprints[m].Offset;
+			for (UINT y = 0; y < numRows[m]; y++)
+			{
+				memcpy(dst + y * footprints[m].Footprint.RowPitch, src + (size_t)y * mip.rowBytes, mip.rowBytes);
+			}
 		}
 
-		// 5. Upload padded data and transition to shader resource state
-		uploadResource(textureResource, paddedData.data(), uploadBufferSize,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &footprint);
-
-		stbi_image_free(data);
-
-		// 6. Allocate SRV slot in descriptor heap
-		D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = srvHeap->GetCPUDescriptorHandleForHeapStart();
-		cpuHandle.ptr += srvHeapIndex * srvDescriptorSize;
+		// 5. Record one copy per mip (state decays to COMMON and is promoted on first use)
+		for (UINT m = 0; m < mipCount; m++)
+		{
+			uploader.copyTexture(textureResource, alloc, footprints[m],
+				(UINT64)footprints[m].Footprint.RowPitch * numRows[m], m);
+		}
 
-		D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = srvHeap->GetGPUDescriptorHandleForHeapStart();
-		gpuHandle.ptr += srvHeapIndex * srvDescriptorSize;
+		if (ownBatch)
+			uploader.end();
 
-		srvHeapIndex++;
+		// 6. Allocate a persistent SRV slot in the shared heap
+		DescriptorRange srv = descriptors.allocate(1);
+		if (!srv.valid())
+		{
+			textureResource->Release();
+			return {};
+		}
 
 		// 7. Create SRV descriptor
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 		srvDesc.Format = textureDesc.Format;
 		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = 1;
-		device->CreateShaderResourceView(textureResource, &srvDesc, cpuHandle);
+		srvDesc.Texture2D.MipLevels = mipCount;
+		device->CreateShaderResourceView(textureResource, &srvDesc, srv.cpu);
+
+		// 8. Record what the texture costs in VRAM
+		TextureMemoryRecord record;
+		record.name = name;
+		record.width = image.width;
+		record.height = image.height;
+		record.mipCount = (int)mipCount;
+		record.format = image.format;
+		record.bytes = device->GetResourceAllocationInfo(0, 1, &textureDesc).SizeInBytes;
+		record.resource = textureResource;
+		textureMemory.push_back(record);
+
+		return { textureResource, srv.gpu, srv };
+	}
+
+	// Free a texture from createTexture/loadTexture. The GPU may still be reading it this frame, so
+	// the resource and its SRV slot are only recycled once this frame index comes round again.
+	void releaseTexture(Texture& texture)
+	{
+		if (texture.resource == nullptr)
+			return;
+
+		textureMemory.erase(std::remove_if(textureMemory.begin(), textureMemory.end(),
+			[&](const TextureMemoryRecord& r) { return r.resource == texture.resource; }), textureMemory.end());
+
+		retiredResources[frameSlot].push_back(texture.resource);
+		descriptors.free(texture.srv);
+		texture = {};
+	}
+
+	// Per-texture VRAM, largest first
+	void printTextureMemoryReport() const
+	{
+		std::vector<TextureMemoryRecord> sorted = textureMemory;
+		std::sort(sorted.begin(), sorted.end(),
+			[](const TextureMemoryRecord& a, const TextureMemoryRecord& b) { return a.bytes > b.bytes; });
 
-		return { textureResource, gpuHandle };
+		UINT64 total = 0;
+		std::cout << "[Core] Texture memory (" << sorted.size() << " textures):\n";
+		for (const auto& record : sorted)
+		{
+			std::cout << "  " << (record.bytes / 1024) << " KB  " << record.width << "x" << record.height
+				<< " " << TextureImageLoader::formatName(record.format) << " " << record.mipCount << " mips  "
+				<< (record.name.empty() ? "(unnamed)" : record.name) << "\n";
+			total += record.bytes;
+		}
+		std::cout << "  Total: " << (total / (1024 * 1024)) << " MB\n";
 	}
 
-	// Recreate backbuffers/RTVs, viewport/scissor, depth buffer/DSV, and reset SRV heap
+	// Recreate backbuffers/RTVs, viewport/scissor and depth buffer/DSV (descriptors in the shared heap survive)
 	void updateScreenResources(int _width, int _height)
 	{
-		for (unsigned int i = 0; i < 2; i++)
+		for (unsigned int i = 0; i < framesInFlight; i++)
 		{
 			if (backbuffers[i] != NULL)
 			{
 				backbuffers[i]->Release();
+				backbuffers[i] = NULL;
 			}
 		}
 		if (_width != width || _height != height)
 		{
-			swapchain->ResizeBuffers(0, _width, _height, DXGI_FORMAT_UNKNOWN, 0);
+			swapchain->ResizeBuffers(0, _width, _height, DXGI_FORMAT_UNKNOWN, swapchainFlags);
 		}
 		DXGI_SWAP_CHAIN_DESC desc;
 		swapchain->GetDesc(&desc);
@@ -320,7 +1648,7 @@ public:
 		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetViewHandle;
 		renderTargetViewHandle = backbufferHeap->GetCPUDescriptorHandleForHeapStart();
 		unsigned int renderTargetViewDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-		for (unsigned int i = 0; i < 2; i++)
+		for (unsigned int i = 0; i < framesInFlight; i++)
 		{
 			swapchain->GetBuffer(i, IID_PPV_ARGS(&backbuffers[i]));
 			device->CreateRenderTargetView(backbuffers[i], nullptr, renderTargetViewHandle);
@@ -372,19 +1700,9 @@ public:
 		device->CreateCommittedResource(&heapprops, D3D12_HEAP_FLAG_NONE, &dsvDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue, __uuidof(ID3D12Resource), (void**)&dsv);
 		device->CreateDepthStencilView(dsv, &depthStencilDesc, dsvHeap->GetCPUDescriptorHandleForHeapStart());
 
-		// Recreate SRV heap and reset allocation index
-		D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-		srvHeapDesc.NumDescriptors = 128; // Allow up to 128 textures
-		srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE; // Important!
-		device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&srvHeap));
-
-		srvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-		srvHeapIndex = 0;
-
 	}
 
-	// Build root signature for VS/PS CBVs and a texture SRV table + sampler
+	// Build root signature for VS/PS CBVs, a texture SRV table + sampler and a VS buffer SRV
 	void createRootSignature()
 	{
 		std::vector<D3D12_ROOT_PARAMETER> parameters;
@@ -420,6 +1738,29 @@ public:
 		rootParameterSRV.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 		parameters.push_back(rootParameterSRV);
 
+		// Parameter 3: Vertex shader buffer SRV (t1), e.g. baked bone matrices for instanced skinning
+		D3D12_ROOT_PARAMETER rootParameterVSBuffer = {};
+		rootParameterVSBuffer.ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameterVSBuffer.Descriptor.ShaderRegister = 1;
+		rootParameterVSBuffer.Descriptor.RegisterSpace = 0;
+		rootParameterVSBuffer.ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		parameters.push_back(rootParameterVSBuffer);
+
+		// Parameter 4: Bindless texture table (t0, space1), indexed per draw or per instance (TextureTable)
+		D3D12_DESCRIPTOR_RANGE bindlessRange = {};
+		bindlessRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+		bindlessRange.NumDescriptors = BINDLESS_TEXTURE_COUNT;
+		bindlessRange.BaseShaderRegister = 0;
+		bindlessRange.RegisterSpace = 1;
+		bindlessRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+		D3D12_ROOT_PARAMETER rootParameterBindless = {};
+		rootParameterBindless.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		rootParameterBindless.DescriptorTable.NumDescriptorRanges = 1;
+		rootParameterBindless.DescriptorTable.pDescriptorRanges = &bindlessRange;
+		rootParameterBindless.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+		parameters.push_back(rootParameterBindless);
+
 		// Static sampler for texture sampling (s0)
 		D3D12_STATIC_SAMPLER_DESC sampler = {};
 		sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; // Linear filtering (smooth)
@@ -454,22 +1795,112 @@ public:
 	// Reset per-frame allocator + command list
 	void resetCommandList()
 	{
-		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
-		graphicsCommandAllocator[frameIndex]->Reset();
-		graphicsCommandList[frameIndex]->Reset(graphicsCommandAllocator[frameIndex], NULL);
+		graphicsCommandAllocator[frameSlot]->Reset();
+		graphicsCommandList[frameSlot]->Reset(graphicsCommandAllocator[frameSlot], NULL);
+		currentCommandList = graphicsCommandList[frameSlot];
+		pendingCommandLists.clear();
 	}
 
-	// Close and execute current command list on graphics queue
+	// Close the current command list and execute it, after any lists recordParallel queued, in one submission
 	void runCommandList()
 	{
-		getCommandList()->Close();
-		ID3D12CommandList* lists[] = { getCommandList() };
-		graphicsQueue->ExecuteCommandLists(1, lists);
+		currentCommandList->Close();
+		pendingCommandLists.push_back(currentCommandList);
+		graphicsQueue->ExecuteCommandLists((UINT)pendingCommandLists.size(), pendingCommandLists.data());
+		pendingCommandLists.clear();
+	}
+
+	// Bind a render target (and optional depth) and remember it for lists opened by recordParallel.
+	// Inside a job the bind only affects that job's list.
+	void setRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv)
+	{
+		getCommandList()->OMSetRenderTargets(1, &rtv, FALSE, dsv);
+		if (CommandListPool::threadList() == nullptr)
+		{
+			passState.rtv = rtv;
+			passState.hasDepth = (dsv != nullptr);
+			if (dsv)
+				passState.dsv = *dsv;
+		}
+	}
+
+	// Set viewport + scissor, remembered like setRenderTarget
+	void setViewport(const D3D12_VIEWPORT& vp, const D3D12_RECT& scissor)
+	{
+		getCommandList()->RSSetViewports(1, &vp);
+		getCommandList()->RSSetScissorRects(1, &scissor);
+		if (CommandListPool::threadList() == nullptr)
+		{
+			passState.viewport = vp;
+			passState.scissor = scissor;
+		}
+	}
+
+	// Run job(0..count-1) on the thread pool, each recording into its own command list through the usual
+	// getCommandList(). Each list starts with the shared descriptor heap, the default root signature and
+	// the current passState bound. The lists execute after everything recorded so far, in index order,
+	// and serial recording continues on a fresh list queued after them. Jobs must not share mutable CPU
+	// state (constant staging is per Shader, frameAllocator and descriptors lock internally).
+	void recordParallel(int count, const std::function<void(int)>& job)
+	{
+		if (count <= 0)
+			return;
+
+		currentCommandList->Close();
+		pendingCommandLists.push_back(currentCommandList);
+
+		std::vector<ID3D12GraphicsCommandList4*> lists(count);
+		for (int i = 0; i < count; i++)
+		{
+			lists[i] = openCommandList();
+		}
+
+		ThreadPool::get().parallelFor(count, [&](int i)
+			{
+				CommandListPool::threadList() = lists[i];
+				job(i);
+				CommandListPool::threadList() = nullptr;
+				lists[i]->Close();
+			});
+
+		for (auto list : lists)
+		{
+			pendingCommandLists.push_back(list);
+		}
+		currentCommandList = openCommandList();
+	}
+
+	// Open an upload batch: uploadResource/loadTexture record into one copy list instead of flushing each time
+	void beginUploadBatch()
+	{
+		uploader.begin(true);
+	}
+
+	// Submit every upload recorded since beginUploadBatch and wait once
+	void endUploadBatch()
+	{
+		uploader.end();
+	}
+
+	// Upload CPU data into part of a buffer that stays in COMMON (GeometryPool pages); joins an open
+	// batch, otherwise submits and waits on its own
+	void uploadBufferRegion(ID3D12Resource* dstResource, UINT64 dstOffset, const void* data, UINT64 size)
+	{
+		uploader.begin();
+		uploader.upload(dstResource, data, size, NULL, dstOffset);
+		uploader.end();
 	}
 
 	// Upload CPU data through an UPLOAD buffer, then transition to target state
 	void uploadResource(ID3D12Resource* dstResource, const void* data, unsigned int size, D3D12_RESOURCE_STATES targetState, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* texFootprint = NULL)
 	{
+		// Batched path: state decays to COMMON and is promoted to targetState on first use
+		if (uploader.isRecording())
+		{
+			uploader.upload(dstResource, data, size, texFootprint);
+			return;
+		}
+
 		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
 		ID3D12Resource* uploadBuffer;
 		D3D12_HEAP_PROPERTIES heapProps = {};
@@ -521,24 +1952,56 @@ public:
 		uploadBuffer->Release();
 	}
 
-	// Get command list for current backbuffer index
+	// Copy constants into this frame's transient memory and return the address for a root CBV
+	D3D12_GPU_VIRTUAL_ADDRESS uploadConstants(const void* data, unsigned int size)
+	{
+		return frameAllocator.upload(data, size).gpuAddress;
+	}
+
+	// Command list to record into: the calling job's list inside recordParallel, otherwise the serial list
 	ID3D12GraphicsCommandList4* getCommandList()
 	{
-		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
-		return graphicsCommandList[frameIndex];
+		ID3D12GraphicsCommandList4* jobList = CommandListPool::threadList();
+		return jobList ? jobList : currentCommandList;
 	}
 
-	// Begin frame: wait fence, transition backbuffer, bind RTV/DSV, clear
+	// Pool list with the frame-wide state already bound (see recordParallel)
+	ID3D12GraphicsCommandList4* openCommandList()
+	{
+		ID3D12GraphicsCommandList4* list = commandListPool.acquire();
+		ID3D12DescriptorHeap* heaps[] = { descriptors.getHeap() };
+		list->SetDescriptorHeaps(1, heaps);
+		list->SetGraphicsRootSignature(rootSignature);
+		list->OMSetRenderTargets(1, &passState.rtv, FALSE, passState.hasDepth ? &passState.dsv : nullptr);
+		list->RSSetViewports(1, &passState.viewport);
+		list->RSSetScissorRects(1, &passState.scissor);
+		return list;
+	}
+
+	// Begin frame: wait for a present slot and this frame slot's fence, transition backbuffer, bind RTV/DSV, clear
 	void beginFrame()
 	{
-		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
-		graphicsQueueFence[frameIndex].wait();
+		if (frameLatencyWaitable != nullptr)
+		{
+			WaitForSingleObjectEx(frameLatencyWaitable, 1000, TRUE);
+		}
+		graphicsQueueFence[frameSlot].wait();
+		frameAllocator.beginFrame(frameSlot);
+		descriptors.beginFrame(frameSlot);
+		commandListPool.beginFrame(frameSlot);
+		for (auto r : retiredResources[frameSlot])
+		{
+			r->Release();
+		}
+		retiredResources[frameSlot].clear();
+		stats.reset();
+		unsigned int backBuffer = backBufferIndex();
 		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetViewHandle = backbufferHeap->GetCPUDescriptorHandleForHeapStart();
 		unsigned int renderTargetViewDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-		renderTargetViewHandle.ptr += frameIndex * renderTargetViewDescriptorSize;
+		renderTargetViewHandle.ptr += backBuffer * renderTargetViewDescriptorSize;
 		resetCommandList();
-		Barrier::add(backbuffers[frameIndex], D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET, getCommandList());
-		getCommandList()->OMSetRenderTargets(1, &renderTargetViewHandle, FALSE, &dsvHandle);
+		Barrier::add(backbuffers[backBuffer], D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET, getCommandList());
+		setRenderTarget(renderTargetViewHandle, &dsvHandle);
 		float color[4];
 		color[0] = 0;
 		color[1] = 0;
@@ -548,40 +2011,58 @@ public:
 		getCommandList()->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, NULL);
 	}
 
+	void countDraw(unsigned int instanceCount)
+	{
+		stats.drawCalls++;
+		stats.instances += instanceCount;
+	}
+
+	void countDispatch()
+	{
+		stats.dispatches++;
+	}
+
 	// Set pipeline-wide frame state before issuing draw calls
 	void beginRenderPass()
 	{
-		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
-		getCommandList()->RSSetViewports(1, &viewport);
-		getCommandList()->RSSetScissorRects(1, &scissorRect);
+		setViewport(viewport, scissorRect);
 		getCommandList()->SetGraphicsRootSignature(rootSignature);
-		ID3D12DescriptorHeap* heaps[] = { srvHeap };
+		ID3D12DescriptorHeap* heaps[] = { descriptors.getHeap() };
 		getCommandList()->SetDescriptorHeaps(1, heaps);
 
 		getCommandList()->SetGraphicsRootSignature(rootSignature);
 	}
 
-	// Current swapchain buffer index
+	// Frame-in-flight slot for per-frame resources (0..framesInFlight-1)
 	int frameIndex()
+	{
+		return frameSlot;
+	}
+
+	// Current swapchain buffer index (render target only; not tied to frameIndex)
+	unsigned int backBufferIndex()
 	{
 		return swapchain->GetCurrentBackBufferIndex();
 	}
 
-	// End frame: transition backbuffer to present, submit, signal, present
+	// End frame: transition backbuffer to present, submit, signal, present, move to the next slot
 	void finishFrame()
 	{
-		unsigned int frameIndex = swapchain->GetCurrentBackBufferIndex();
-		Barrier::add(backbuffers[frameIndex], D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT, getCommandList());
+		Barrier::add(backbuffers[backBufferIndex()], D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT, getCommandList());
 		runCommandList();
-		graphicsQueueFence[frameIndex].signal(graphicsQueue);
-		swapchain->Present(1, 0);
+		graphicsQueueFence[frameSlot].signal(graphicsQueue);
+		if (vsync)
+			swapchain->Present(1, 0);
+		else
+			swapchain->Present(0, tearingSupported ? DXGI_PRESENT_ALLOW_TEARING : 0);
+		frameSlot = (frameSlot + 1) % framesInFlight;
 	}
 
-	// Force GPU to complete all outstanding graphics work
+	// Force GPU to complete all outstanding graphics work (the queue is in order, so one fence covers it)
 	void flushGraphicsQueue()
 	{
-		graphicsQueueFence[0].signal(graphicsQueue);
-		graphicsQueueFence[0].wait();
+		graphicsQueueFence[frameSlot].signal(graphicsQueue);
+		graphicsQueueFence[frameSlot].wait();
 	}
 
 	//fog
@@ -591,7 +2072,7 @@ public:
 	{
 		UINT rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = rtvHeap->GetCPUDescriptorHandleForHeapStart();
-		rtvHandle.ptr += frameIndex() * rtvDescriptorSize;
+		rtvHandle.ptr += backBufferIndex() * rtvDescriptorSize;
 		return rtvHandle;
 	}
 
@@ -606,15 +2087,15 @@ public:
 	{
 		UINT rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = backbufferHeap->GetCPUDescriptorHandleForHeapStart();
-		rtvHandle.ptr += frameIndex() * rtvDescriptorSize;
-		getCommandList()->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+		rtvHandle.ptr += backBufferIndex() * rtvDescriptorSize;
+		setRenderTarget(rtvHandle, &dsvHandle);
 	}
 
 	// Bind backbuffer RTV only (no depth)
 	void setBackBufferRenderTargetNoDepth()
 	{
 		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = getBackBufferRTVHandle();
-		getCommandList()->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+		setRenderTarget(rtvHandle, nullptr);
 	}
 
 	// Get screen width
@@ -623,34 +2104,50 @@ public:
 	// Get screen height  
 	int getHeight() const { return height; }
 
-	// Bind SRV heap on current command list
+	// Bind the shared descriptor heap on the current command list (beginRenderPass already does this)
 	void setDefaultDescriptorHeaps()
 	{
-		ID3D12DescriptorHeap* heaps[] = { srvHeap };
+		ID3D12DescriptorHeap* heaps[] = { descriptors.getHeap() };
 		getCommandList()->SetDescriptorHeaps(1, heaps);
 	}
 
 
 	~Core()
 	{
-		for (int i = 0; i < 2; i++)
+		for (unsigned int i = 0; i < framesInFlight; i++)
 		{
 			graphicsQueueFence[i].signal(graphicsQueue);
 			graphicsQueueFence[i].wait();
 		}
+		for (auto& list : retiredResources)
+		{
+			for (auto r : list)
+			{
+				r->Release();
+			}
+		}
+		uploader.release();
+		frameAllocator.release();
+		geometry.release();
+		commandListPool.release();
+		pipelineCache.release();
 		rootSignature->Release();
-		graphicsCommandList[0]->Release();
-		graphicsCommandAllocator[0]->Release();
-		graphicsCommandList[1]->Release();
-		graphicsCommandAllocator[1]->Release();
-		backbuffers[0]->Release();
-		backbuffers[1]->Release();
+		for (unsigned int i = 0; i < framesInFlight; i++)
+		{
+			graphicsCommandList[i]->Release();
+			graphicsCommandAllocator[i]->Release();
+			backbuffers[i]->Release();
+		}
 		delete[] backbuffers;
+		if (frameLatencyWaitable != nullptr)
+		{
+			CloseHandle(frameLatencyWaitable);
+		}
 		backbufferHeap->Release();
 		dsv->Release();
 		dsvHeap->Release();
 		swapchain->Release();
-		srvHeap->Release();
+		descriptors.release();
 		computeQueue->Release();
 		copyQueue->Release();
 		graphicsQueue->Release();
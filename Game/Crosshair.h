@@ -33,11 +33,17 @@ public:
         buildMesh(core);
 
         // Use standard blended PSO
-        psos->createBlendedPSO(core, psoName,
+        pso = psos->createBlendedPSO(core, psoName,
             shaders->find(shaderName)->vs,
             shaders->find(shaderName)->ps,
             VertexLayoutCache::getStaticLayout());
 
+        // Screen-space quad: W and VP never change, so stage them once
+        shader = shaders->find(shaderName);
+        Matrix identity;
+        shader->getConstantVS("staticMeshBuffer", "W").set(&identity);
+        shader->getConstantVS("staticMeshBuffer", "VP").set(&identity);
+
         initialized = true;
         std::cout << "[Crosshair] Initialized\n";
     }
@@ -46,17 +52,15 @@ public:
     {
         if (!initialized) return;
 
-        Matrix identity;
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", &identity);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", &identity);
-
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
 
         crosshairMesh.draw(core);
     }
 
 private:
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
     Mesh crosshairMesh;
     int screenWidth = 1920;
     int screenHeight = 1080;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Maths.h"
+
+class HiZOcclusion;
+
+// Passes that cull instanced vegetation independently.
+// Each cull writes its instances into Core's frame allocator, so culling the reflection view
+// never overwrites data the GPU may still be reading for the main view or an earlier frame.
+enum CullViewId
+{
+    CULL_VIEW_MAIN = 0,
+    CULL_VIEW_REFLECTION = 1,
+    CULL_VIEW_COUNT = 2
+};
+
+// Per-view culling input
+struct CullView
+{
+    Matrix viewProj;
+    Vec3 cameraPos;
+    int viewId = CULL_VIEW_MAIN;
+    float distanceScale = 1.0f;   // Multiplies the system's view distance
+    int minLOD = 0;               // Instances never use a finer LOD than this
+    const HiZOcclusion* occlusion = nullptr;   // Hi-Z built from this view's occluders, or none
+
+    // Full-quality camera view
+    static CullView main(const Matrix& vp, const Vec3& cameraPos)
+    {
+        CullView view;
+        view.viewProj = vp;
+        view.cameraPos = cameraPos;
+        view.viewId = CULL_VIEW_MAIN;
+        return view;
+    }
+
+    // Cheaper view for the lake reflection: half cull distance, no high-detail meshes by default
+    static CullView reflection(const Matrix& vp, const Vec3& cameraPos, float distanceScale = 0.5f, int minLOD = 1)
+    {
+        CullView view;
+        view.viewProj = vp;
+        view.cameraPos = cameraPos;
+        view.viewId = CULL_VIEW_REFLECTION;
+        view.distanceScale = distanceScale;
+        view.minLOD = minLOD;
+        return view;
+    }
+};
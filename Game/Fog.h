@@ -2,6 +2,8 @@
 
 #include "Core.h"
 #include "Maths.h"
+#include "ShaderCache.h"
+#include "Profiler.h"
 #include <d3d12.h>
 #include <d3dcompiler.h>
 #include <iostream>
@@ -11,8 +13,18 @@
 
 #pragma comment(lib, "d3dcompiler.lib")
 
+// Fog engine. Raymarch marches every fog-buffer pixel (cost ~ pixels x steps); Froxel injects
+// density and lighting into a low-res camera-aligned 3D grid with compute and integrates it once,
+// so its cost is set by the grid size instead of the resolution.
+enum class FogBackend
+{
+    Raymarch,
+    Froxel
+};
+
 struct FogConfig
 {
+    FogBackend backend = FogBackend::Raymarch;    // Chosen per GPU tier
     float density = 0.015f;              // Base fog density
     float heightFalloff = 0.08f;         // Exponential height attenuation
     float groundLevel = 0.0f;            // Fog start height reference
@@ -26,9 +38,20 @@ struct FogConfig
     float scattering = 0.5f;                      // Scattering intensity
     float mieG = 0.75f;                           // Mie phase asymmetry
 
-    int raymarchSteps = 24;            // Fog raymarch step count
+    int raymarchSteps = 24;            // Fog raymarch step count (full-length ray)
+    int minRaymarchSteps = 6;          // Floor for the depth-adaptive step count
     float maxDistance = 150.0f;        // Max ray distance
 
+    // Temporal mode: per-frame jittered raymarch with fewer steps, accumulated into a reprojected
+    // history at fog resolution
+    bool temporal = true;
+    int temporalRaymarchSteps = 12;    // Replaces raymarchSteps while temporal is on
+    float temporalBlend = 0.9f;        // History weight (higher = smoother, more ghosting)
+
+    // Froxel backend grid (fixed at init)
+    int froxelTileSize = 8;            // Screen pixels per froxel in x and y
+    int froxelSlices = 64;             // Depth slices out to maxDistance
+
     float windSpeed = 0.3f;            // Noise advection speed
     Vec2 windDirection = Vec2(1.0f, 0.3f); // Noise advection direction
 
@@ -57,12 +80,24 @@ public:
         std::cout << "  Full res: " << screenWidth << "x" << screenHeight << "\n";
         std::cout << "  Fog res: " << fogWidth << "x" << fogHeight << " (half)\n";
 
+        int tile = (std::max)(config.froxelTileSize, 1);
+        froxelWidth = (std::max)((screenWidth + tile - 1) / tile, 1);
+        froxelHeight = (std::max)((screenHeight + tile - 1) / tile, 1);
+        froxelDepth = (std::max)(config.froxelSlices, 1);
+        std::cout << "  Froxel grid: " << froxelWidth << "x" << froxelHeight << "x" << froxelDepth << "\n";
+
         createDescriptorHeaps();
+        if (!srvDescriptors.valid())
+        {
+            std::cout << "[VolumetricFog] ERROR: No space for fog descriptors, fog disabled\n";
+            return;
+        }
         createRenderTargets();
+        createFroxelVolumes();
         createRootSignature();
+        createFroxelRootSignature();
         loadShaders();
         createPSOs();
-        createConstantBuffers();
         createFullscreenQuad();
 
         initialized = true;
@@ -78,23 +113,25 @@ public:
 
         if (!enabled)
         {
+            historyValid = false;
+
             UINT rtvSize = core->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
             D3D12_CPU_DESCRIPTOR_HANDLE backBufferRTV = core->backbufferHeap->GetCPUDescriptorHandleForHeapStart();
-            backBufferRTV.ptr += core->frameIndex() * rtvSize;
+            backBufferRTV.ptr += core->backBufferIndex() * rtvSize;
 
-            cmdList->OMSetRenderTargets(1, &backBufferRTV, FALSE, &core->dsvHandle);
+            core->setRenderTarget(backBufferRTV, &core->dsvHandle);
 
             D3D12_VIEWPORT vp = { 0, 0, (float)screenWidth, (float)screenHeight, 0, 1 };
             D3D12_RECT scissor = { 0, 0, (LONG)screenWidth, (LONG)screenHeight };
-            cmdList->RSSetViewports(1, &vp);
-            cmdList->RSSetScissorRects(1, &scissor);
+            core->setViewport(vp, scissor);
             return;
         }
 
         transitionResource(sceneColorBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_RENDER_TARGET);
 
-        cmdList->OMSetRenderTargets(1, &sceneRTV, FALSE, &sceneDSV);
+        // Through Core so lists opened by recordParallel start on the scene targets
+        core->setRenderTarget(sceneRTV, &sceneDSV);
 
         float clearColor[4] = { 0.5f, 0.7f, 0.9f, 1.0f };
         cmdList->ClearRenderTargetView(sceneRTV, clearColor, 0, nullptr);
@@ -102,8 +139,7 @@ public:
 
         D3D12_VIEWPORT vp = { 0, 0, (float)screenWidth, (float)screenHeight, 0, 1 };
         D3D12_RECT scissor = { 0, 0, (LONG)screenWidth, (LONG)screenHeight };
-        cmdList->RSSetViewports(1, &vp);
-        cmdList->RSSetScissorRects(1, &scissor);
+        core->setViewport(vp, scissor);
     }
 
     // Execute fog + blur + composite passes and output to backbuffer
@@ -119,35 +155,78 @@ public:
         transitionResource(sceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE,
             D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-        renderFogPass(view, projection, cameraPos, totalTime);
-        renderBlurHorizontalPass();
-        renderBlurVerticalPass();
-        renderCompositePass();
+        Matrix viewCopy = view;
+        Matrix projCopy = projection;
+        Matrix vp = viewCopy * projCopy;
+        Matrix invVP = vp.invert();
+
+        bool froxel = config.backend == FogBackend::Froxel && froxelAvailable();
+        bool temporal = config.temporal && !froxel;
+        if (froxel)
+        {
+            ProfileScope scope("Fog Froxel");
+            renderFroxelPasses(invVP, cameraPos, totalTime);
+        }
+        else
+        {
+            ProfileScope scope("Fog Raymarch");
+            renderFogPass(invVP, cameraPos, totalTime);
+            if (temporal)
+            {
+                renderTemporalResolvePass(invVP);
+            }
+        }
+        {
+            ProfileScope scope("Fog Blur");
+            renderBlurHorizontalPass();
+            renderBlurVerticalPass();
+        }
+        {
+            ProfileScope scope("Fog Composite");
+            renderCompositePass();
+        }
+
+        // History is only valid for the frame straight after a temporal frame
+        prevViewProj = vp;
+        historyValid = temporal;
+        frameCounter++;
 
         transitionResource(sceneDepthBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_DEPTH_WRITE);
     }
 
+    // False if the froxel shaders failed to build; FogBackend::Froxel then renders as Raymarch
+    bool froxelAvailable() const
+    {
+        return froxelInjectPSO && froxelIntegratePSO && froxelApplyPSO;
+    }
+
     // Release all owned GPU resources/heaps/PSOs/shader blobs
     ~VolumetricFog()
     {
         if (sceneColorBuffer) sceneColorBuffer->Release();
         if (sceneDepthBuffer) sceneDepthBuffer->Release();
         if (fogBuffer) fogBuffer->Release();
+        if (fogRawBuffer) fogRawBuffer->Release();
+        if (fogHistoryBuffer) fogHistoryBuffer->Release();
         if (blurTempBuffer) blurTempBuffer->Release();
         if (blurredBuffer) blurredBuffer->Release();
-        if (fogConstantBuffer) fogConstantBuffer->Release();
-        if (blurConstantBuffer) blurConstantBuffer->Release();
-        if (compositeConstantBuffer) compositeConstantBuffer->Release();
+        if (froxelScatterVolume) froxelScatterVolume->Release();
+        if (froxelIntegratedVolume) froxelIntegratedVolume->Release();
         if (quadVertexBuffer) quadVertexBuffer->Release();
         if (fogRootSignature) fogRootSignature->Release();
+        if (froxelRootSignature) froxelRootSignature->Release();
+        if (froxelInjectPSO) froxelInjectPSO->Release();
+        if (froxelIntegratePSO) froxelIntegratePSO->Release();
+        if (froxelApplyPSO) froxelApplyPSO->Release();
         if (fogPSO) fogPSO->Release();
+        if (resolvePSO) resolvePSO->Release();
         if (blurHorizontalPSO) blurHorizontalPSO->Release();
         if (blurVerticalPSO) blurVerticalPSO->Release();
         if (compositePSO) compositePSO->Release();
         if (rtvHeap) rtvHeap->Release();
         if (dsvHeap) dsvHeap->Release();
-        if (srvHeap) srvHeap->Release();
+        if (core) core->descriptors.free(srvDescriptors);
     }
 
 private:
@@ -159,33 +238,54 @@ private:
 
     ID3D12Resource* sceneColorBuffer = nullptr;   // Full-res scene color
     ID3D12Resource* sceneDepthBuffer = nullptr;   // Full-res scene depth
-    ID3D12Resource* fogBuffer = nullptr;          // Half-res fog output
-    ID3D12Resource* blurTempBuffer = nullptr;     // Full-res blur intermediate
-    ID3D12Resource* blurredBuffer = nullptr;      // Full-res blurred scene
-
-    ID3D12Resource* fogConstantBuffer = nullptr;       // Fog CB (raymarch)
-    ID3D12Resource* blurConstantBuffer = nullptr;      // Blur CB (H/V)
-    ID3D12Resource* compositeConstantBuffer = nullptr; // Composite CB
+    ID3D12Resource* fogBuffer = nullptr;          // Half-res fog output (resolved in temporal mode)
+    ID3D12Resource* fogRawBuffer = nullptr;       // Half-res jittered raymarch (temporal mode)
+    ID3D12Resource* fogHistoryBuffer = nullptr;   // Half-res copy of last frame's resolved fog
+    ID3D12Resource* blurTempBuffer = nullptr;     // Half-res blur intermediate
+    ID3D12Resource* blurredBuffer = nullptr;      // Half-res blurred scene
+
+    // Froxel backend: camera-aligned volumes, x/y = screen UV, z = slice (quadratic in distance)
+    int froxelWidth = 0, froxelHeight = 0, froxelDepth = 0;
+    ID3D12Resource* froxelScatterVolume = nullptr;    // Per-froxel in-scattering + extinction
+    ID3D12Resource* froxelIntegratedVolume = nullptr; // Front-to-back scattering + transmittance
+
+    Matrix prevViewProj;                          // For history reprojection
+    bool historyValid = false;                    // False on the first frame and after fog was off
+    unsigned int frameCounter = 0;                // Drives the temporal jitter sequence
+
+    D3D12_GPU_VIRTUAL_ADDRESS blurConstants = 0;       // Blur CB for this frame (shared by H/V passes)
     ID3D12Resource* quadVertexBuffer = nullptr;        // Fullscreen triangle VB
 
     ID3D12RootSignature* fogRootSignature = nullptr; // Shared root signature (all passes)
     ID3D12PipelineState* fogPSO = nullptr;            // Raymarch fog PSO
+    ID3D12PipelineState* resolvePSO = nullptr;        // Temporal resolve PSO
     ID3D12PipelineState* blurHorizontalPSO = nullptr; // Horizontal blur PSO
     ID3D12PipelineState* blurVerticalPSO = nullptr;   // Vertical blur PSO
     ID3D12PipelineState* compositePSO = nullptr;      // Final composite PSO
 
+    ID3D12RootSignature* froxelRootSignature = nullptr; // Compute: b0, u0 table, t0 table
+    ID3D12PipelineState* froxelInjectPSO = nullptr;     // Density/lighting injection (compute)
+    ID3D12PipelineState* froxelIntegratePSO = nullptr;  // Front-to-back integration (compute)
+    ID3D12PipelineState* froxelApplyPSO = nullptr;      // Volume lookup into fogBuffer
+
     ID3DBlob* vsFullscreenBlob = nullptr;        // Fullscreen VS
     ID3DBlob* psFogBlob = nullptr;               // Fog PS
+    ID3DBlob* psResolveBlob = nullptr;           // Temporal resolve PS
     ID3DBlob* psBlurHorizontalBlob = nullptr;    // Blur H PS
     ID3DBlob* psBlurVerticalBlob = nullptr;      // Blur V PS
     ID3DBlob* psCompositeBlob = nullptr;         // Composite PS
+    ID3DBlob* csFroxelInjectBlob = nullptr;      // Froxel inject CS
+    ID3DBlob* csFroxelIntegrateBlob = nullptr;   // Froxel integrate CS
+    ID3DBlob* psFroxelApplyBlob = nullptr;       // Froxel apply PS
 
     ID3D12DescriptorHeap* rtvHeap = nullptr;     // RTV heap for offscreen RTs
     ID3D12DescriptorHeap* dsvHeap = nullptr;     // DSV heap for scene depth
-    ID3D12DescriptorHeap* srvHeap = nullptr;     // Shader-visible SRV heap
+    DescriptorRange srvDescriptors;              // 11 contiguous slots in Core's shared heap
 
     D3D12_CPU_DESCRIPTOR_HANDLE sceneRTV;        // Scene color RTV
     D3D12_CPU_DESCRIPTOR_HANDLE fogRTV;          // Fog RTV
+    D3D12_CPU_DESCRIPTOR_HANDLE fogRawRTV;       // Raw (unresolved) fog RTV
+    D3D12_CPU_DESCRIPTOR_HANDLE fogHistoryRTV;   // History RTV (only written by copies)
     D3D12_CPU_DESCRIPTOR_HANDLE blurTempRTV;     // Blur temp RTV
     D3D12_CPU_DESCRIPTOR_HANDLE blurredRTV;      // Blurred RTV
     D3D12_CPU_DESCRIPTOR_HANDLE sceneDSV;        // Scene DSV
@@ -195,6 +295,12 @@ private:
     D3D12_GPU_DESCRIPTOR_HANDLE fogSRV;          // Fog SRV
     D3D12_GPU_DESCRIPTOR_HANDLE blurTempSRV;     // Blur temp SRV
     D3D12_GPU_DESCRIPTOR_HANDLE blurredSRV;      // Blurred SRV
+    D3D12_GPU_DESCRIPTOR_HANDLE fogRawSRV;       // Raw fog SRV (t5)
+    D3D12_GPU_DESCRIPTOR_HANDLE fogHistorySRV;   // History SRV (t6)
+    D3D12_GPU_DESCRIPTOR_HANDLE froxelVolumeSRV;    // Integrated volume SRV (t7)
+    D3D12_GPU_DESCRIPTOR_HANDLE froxelScatterUAV;   // Compute-only descriptors, outside the graphics table
+    D3D12_GPU_DESCRIPTOR_HANDLE froxelScatterSRV;
+    D3D12_GPU_DESCRIPTOR_HANDLE froxelIntegratedUAV;
 
     D3D12_VERTEX_BUFFER_VIEW quadVBView;         // Fullscreen VB view
 
@@ -209,8 +315,32 @@ private:
         Vec4 sunColor_pad;           // rgb=sun color
         Vec4 ambientColor_pad;       // rgb=ambient color
         Vec4 screenSize;             // xy=screen, zw=fog buffer
-        int numSteps;                // raymarch steps
-        float pad[3];                // 16-byte alignment
+        int numSteps;                // raymarch steps for a full-length ray
+        int minSteps;                // adaptive step floor
+        float frameJitter;           // temporal jitter offset
+        float temporalMode;          // 1 = temporal jitter sequence
+    };
+
+    struct ResolveCB
+    {
+        Matrix invViewProj;          // Current frame ray reconstruction
+        Matrix prevViewProj;         // Previous frame projection
+        Vec4 fogSize;                // xy=fog buffer, zw=inv fog buffer
+        Vec4 resolveParams;          // x=history weight
+    };
+
+    // Shared by the inject, integrate and apply passes
+    struct FroxelCB
+    {
+        Matrix invViewProj;          // Inverse view-projection for froxel/pixel rays
+        Vec4 cameraPos_time;         // xyz=camera pos, w=time
+        Vec4 fogColor_density;       // rgb=fog color, a=density
+        Vec4 sunDir_scattering;      // xyz=sun dir, w=scattering
+        Vec4 params1;                // x=heightFalloff,y=groundLevel,z=maxHeight,w=mieG
+        Vec4 params2;                // x=maxDistance,y=windSpeed,zw=windDir
+        Vec4 sunColor_pad;           // rgb=sun color
+        Vec4 ambientColor_pad;       // rgb=ambient color
+        Vec4 froxelSize;             // xyz=grid dimensions
     };
 
     struct BlurCB
@@ -228,7 +358,7 @@ private:
     void createDescriptorHeaps()
     {
         D3D12_DESCRIPTOR_HEAP_DESC rtvDesc = {};
-        rtvDesc.NumDescriptors = 4;   // scene, fog, blurTemp, blurred
+        rtvDesc.NumDescriptors = 6;   // scene, fog, blurTemp, blurred, fogRaw, fogHistory
         rtvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
         core->device->CreateDescriptorHeap(&rtvDesc, IID_PPV_ARGS(&rtvHeap));
 
@@ -237,22 +367,19 @@ private:
         dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
         core->device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&dsvHeap));
 
-        D3D12_DESCRIPTOR_HEAP_DESC srvDesc = {};
-        srvDesc.NumDescriptors = 8;   // scene color/depth + fog + blur intermediates
-        srvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        srvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        core->device->CreateDescriptorHeap(&srvDesc, IID_PPV_ARGS(&srvHeap));
+        // scene color/depth + fog + blur + temporal fog + froxel volumes. Allocated from the shared
+        // heap, so the passes never switch descriptor heaps.
+        srvDescriptors = core->descriptors.allocate(11);
     }
 
     void createRenderTargets()
     {
         UINT rtvSize = core->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-        UINT srvSize = core->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
         D3D12_HEAP_PROPERTIES heapProps = {};
         heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
 
-        // Create RT + RTV + SRV in the local heaps (indices are caller-controlled)
+        // Create RT + RTV + SRV in the local RTV heap and srvDescriptors (indices are caller-controlled)
         auto createRT = [&](ID3D12Resource** resource, DXGI_FORMAT format, int w, int h,
             D3D12_CPU_DESCRIPTOR_HANDLE* rtv, D3D12_GPU_DESCRIPTOR_HANDLE* srv,
             int rtvIndex, int srvIndex)
@@ -277,10 +404,8 @@ private:
                 rtv->ptr += rtvIndex * rtvSize;
                 core->device->CreateRenderTargetView(*resource, nullptr, *rtv);
 
-                D3D12_CPU_DESCRIPTOR_HANDLE srvCpu = srvHeap->GetCPUDescriptorHandleForHeapStart();
-                srvCpu.ptr += srvIndex * srvSize;
-                *srv = srvHeap->GetGPUDescriptorHandleForHeapStart();
-                srv->ptr += srvIndex * srvSize;
+                D3D12_CPU_DESCRIPTOR_HANDLE srvCpu = srvDescriptors.cpuAt(srvIndex);
+                *srv = srvDescriptors.gpuAt(srvIndex);
 
                 D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
                 srvDesc.Format = format;
@@ -296,12 +421,19 @@ private:
         createRT(&fogBuffer, DXGI_FORMAT_R16G16B16A16_FLOAT, fogWidth, fogHeight,
             &fogRTV, &fogSRV, 1, 2);
 
-        createRT(&blurTempBuffer, DXGI_FORMAT_R11G11B10_FLOAT, screenWidth, screenHeight,
+        // Blur runs at fog resolution; the composite upsamples it with the linear sampler
+        createRT(&blurTempBuffer, DXGI_FORMAT_R11G11B10_FLOAT, fogWidth, fogHeight,
             &blurTempRTV, &blurTempSRV, 2, 3);
 
-        createRT(&blurredBuffer, DXGI_FORMAT_R11G11B10_FLOAT, screenWidth, screenHeight,
+        createRT(&blurredBuffer, DXGI_FORMAT_R11G11B10_FLOAT, fogWidth, fogHeight,
             &blurredRTV, &blurredSRV, 3, 4);
 
+        createRT(&fogRawBuffer, DXGI_FORMAT_R16G16B16A16_FLOAT, fogWidth, fogHeight,
+            &fogRawRTV, &fogRawSRV, 4, 5);
+
+        createRT(&fogHistoryBuffer, DXGI_FORMAT_R16G16B16A16_FLOAT, fogWidth, fogHeight,
+            &fogHistoryRTV, &fogHistorySRV, 5, 6);
+
         // Create depth texture as typeless, then view as DSV (D32) and SRV (R32_FLOAT)
         D3D12_RESOURCE_DESC depthDesc = {};
         depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -326,10 +458,8 @@ private:
         dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
         core->device->CreateDepthStencilView(sceneDepthBuffer, &dsvDesc, sceneDSV);
 
-        D3D12_CPU_DESCRIPTOR_HANDLE depthSrvCpu = srvHeap->GetCPUDescriptorHandleForHeapStart();
-        depthSrvCpu.ptr += 1 * srvSize;
-        sceneDepthSRV = srvHeap->GetGPUDescriptorHandleForHeapStart();
-        sceneDepthSRV.ptr += 1 * srvSize;
+        D3D12_CPU_DESCRIPTOR_HANDLE depthSrvCpu = srvDescriptors.cpuAt(1);
+        sceneDepthSRV = srvDescriptors.gpuAt(1);
 
         D3D12_SHADER_RESOURCE_VIEW_DESC depthSrvDesc = {};
         depthSrvDesc.Format = DXGI_FORMAT_R32_FLOAT;
@@ -341,11 +471,61 @@ private:
         std::cout << "[VolumetricFog] Render targets created\n";
     }
 
+    // 3D volumes for the froxel backend. Descriptors 7..10 of srvDescriptors: 7 is t7 of the graphics
+    // table, 8..10 are only bound by the compute passes.
+    void createFroxelVolumes()
+    {
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+        desc.Width = froxelWidth;
+        desc.Height = froxelHeight;
+        desc.DepthOrArraySize = (UINT16)froxelDepth;
+        desc.MipLevels = 1;
+        desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        desc.SampleDesc.Count = 1;
+        desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        // Rest states: scatter is written every frame (UAV), integrated is read by the apply pass
+        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&froxelScatterVolume));
+        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr, IID_PPV_ARGS(&froxelIntegratedVolume));
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = desc.Format;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture3D.MipLevels = 1;
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = desc.Format;
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE3D;
+        uavDesc.Texture3D.WSize = froxelDepth;
+
+        core->device->CreateShaderResourceView(froxelIntegratedVolume, &srvDesc, srvDescriptors.cpuAt(7));
+        froxelVolumeSRV = srvDescriptors.gpuAt(7);
+
+        core->device->CreateUnorderedAccessView(froxelScatterVolume, nullptr, &uavDesc, srvDescriptors.cpuAt(8));
+        froxelScatterUAV = srvDescriptors.gpuAt(8);
+
+        core->device->CreateShaderResourceView(froxelScatterVolume, &srvDesc, srvDescriptors.cpuAt(9));
+        froxelScatterSRV = srvDescriptors.gpuAt(9);
+
+        core->device->CreateUnorderedAccessView(froxelIntegratedVolume, nullptr, &uavDesc, srvDescriptors.cpuAt(10));
+        froxelIntegratedUAV = srvDescriptors.gpuAt(10);
+
+        UINT64 bytes = (UINT64)froxelWidth * froxelHeight * froxelDepth * 8 * 2;
+        std::cout << "[VolumetricFog] Froxel volumes created (" << (bytes / 1024) << " KB)\n";
+    }
+
     void createRootSignature()
     {
         D3D12_DESCRIPTOR_RANGE srvRange = {};
         srvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-        srvRange.NumDescriptors = 5;   // scene color/depth + fog + blur buffers
+        srvRange.NumDescriptors = 8;   // scene color/depth + fog + blur + raw/history fog + froxel volume
         srvRange.BaseShaderRegister = 0;
 
         D3D12_ROOT_PARAMETER params[2] = {};
@@ -354,7 +534,7 @@ private:
         params[0].Descriptor.ShaderRegister = 0;
         params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
-        params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // t0..t4
+        params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // t0..t7
         params[1].DescriptorTable.NumDescriptorRanges = 1;
         params[1].DescriptorTable.pDescriptorRanges = &srvRange;
         params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
@@ -391,6 +571,55 @@ private:
         std::cout << "[VolumetricFog] Root signature created\n";
     }
 
+    // Compute root signature for the froxel passes: b0, u0 (output volume), t0 (input volume)
+    void createFroxelRootSignature()
+    {
+        D3D12_DESCRIPTOR_RANGE uavRange = {};
+        uavRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        uavRange.NumDescriptors = 1;
+        uavRange.BaseShaderRegister = 0;
+
+        D3D12_DESCRIPTOR_RANGE srvRange = {};
+        srvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        srvRange.NumDescriptors = 1;
+        srvRange.BaseShaderRegister = 0;
+
+        D3D12_ROOT_PARAMETER params[3] = {};
+
+        params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // b0
+        params[0].Descriptor.ShaderRegister = 0;
+        params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // u0
+        params[1].DescriptorTable.NumDescriptorRanges = 1;
+        params[1].DescriptorTable.pDescriptorRanges = &uavRange;
+        params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // t0
+        params[2].DescriptorTable.NumDescriptorRanges = 1;
+        params[2].DescriptorTable.pDescriptorRanges = &srvRange;
+        params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
+        rsDesc.NumParameters = 3;
+        rsDesc.pParameters = params;
+
+        ID3DBlob* signature = nullptr;
+        ID3DBlob* error = nullptr;
+        D3D12SerializeRootSignature(&rsDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
+
+        if (error)
+        {
+            std::cout << "[VolumetricFog] Froxel root signature error: " << (char*)error->GetBufferPointer() << "\n";
+            error->Release();
+        }
+
+        core->device->CreateRootSignature(0, signature->GetBufferPointer(),
+            signature->GetBufferSize(), IID_PPV_ARGS(&froxelRootSignature));
+
+        if (signature) signature->Release();
+    }
+
     // Load shader source text from disk
     std::string loadShaderFile(const std::string& filename)
     {
@@ -406,16 +635,15 @@ private:
         return buffer.str();
     }
 
-    // Compile HLSL source into a shader blob
+    // Compile HLSL source into a shader blob (served from the on-disk cache when unchanged)
     ID3DBlob* compileShader(const std::string& source, const std::string& entryPoint,
         const std::string& target, const std::string& name)
     {
         ID3DBlob* blob = nullptr;
         ID3DBlob* error = nullptr;
 
-        HRESULT hr = D3DCompile(source.c_str(), source.length(), name.c_str(),
-            nullptr, nullptr, entryPoint.c_str(), target.c_str(),
-            D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &blob, &error);
+        HRESULT hr = ShaderCache::compile(source, name, entryPoint, target,
+            D3DCOMPILE_OPTIMIZATION_LEVEL3, &blob, &error);
 
         if (FAILED(hr) || error)
         {
@@ -425,7 +653,7 @@ private:
             return nullptr;
         }
 
-        std::cout << "[VolumetricFog] Compiled: " << name << "\n";
+        std::cout << "[VolumetricFog] Loaded: " << name << "\n";
         return blob;
     }
 
@@ -439,6 +667,9 @@ private:
         std::string psFogSource = loadShaderFile("Shaders/PSFogRaymarch.txt");
         psFogBlob = compileShader(psFogSource, "main", "ps_5_0", "PSFogRaymarch");
 
+        std::string psResolveSource = loadShaderFile("Shaders/PSFogTemporalResolve.txt");
+        psResolveBlob = compileShader(psResolveSource, "main", "ps_5_0", "PSFogTemporalResolve");
+
         std::string psBlurHSource = loadShaderFile("Shaders/PSBlurHorizontal.txt");
         psBlurHorizontalBlob = compileShader(psBlurHSource, "main", "ps_5_0", "PSBlurHorizontal");
 
@@ -447,12 +678,21 @@ private:
 
         std::string psCompSource = loadShaderFile("Shaders/PSFogComposite.txt");
         psCompositeBlob = compileShader(psCompSource, "main", "ps_5_0", "PSFogComposite");
+
+        std::string csInjectSource = loadShaderFile("Shaders/CSFogInject.txt");
+        csFroxelInjectBlob = compileShader(csInjectSource, "main", "cs_5_0", "CSFogInject");
+
+        std::string csIntegrateSource = loadShaderFile("Shaders/CSFogIntegrate.txt");
+        csFroxelIntegrateBlob = compileShader(csIntegrateSource, "main", "cs_5_0", "CSFogIntegrate");
+
+        std::string psApplySource = loadShaderFile("Shaders/PSFogFroxelApply.txt");
+        psFroxelApplyBlob = compileShader(psApplySource, "main", "ps_5_0", "PSFogFroxelApply");
     }
 
     void createPSOs()
     {
         // PSOs depend on all shader blobs being valid
-        if (!vsFullscreenBlob || !psFogBlob || !psBlurHorizontalBlob ||
+        if (!vsFullscreenBlob || !psFogBlob || !psResolveBlob || !psBlurHorizontalBlob ||
             !psBlurVerticalBlob || !psCompositeBlob)
         {
             std::cout << "[VolumetricFog] ERROR: Shader compilation failed, cannot create PSOs\n";
@@ -479,45 +719,48 @@ private:
 
         psoDesc.PS = { psFogBlob->GetBufferPointer(), psFogBlob->GetBufferSize() };
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
-        core->device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&fogPSO));
+        fogPSO = core->pipelineCache.createGraphics("FogRaymarch", psoDesc);
+
+        psoDesc.PS = { psResolveBlob->GetBufferPointer(), psResolveBlob->GetBufferSize() };
+        resolvePSO = core->pipelineCache.createGraphics("FogTemporalResolve", psoDesc);
+
+        // The froxel backend is optional: missing shaders only disable it
+        if (psFroxelApplyBlob)
+        {
+            psoDesc.PS = { psFroxelApplyBlob->GetBufferPointer(), psFroxelApplyBlob->GetBufferSize() };
+            froxelApplyPSO = core->pipelineCache.createGraphics("FogFroxelApply", psoDesc);
+        }
 
         psoDesc.PS = { psBlurHorizontalBlob->GetBufferPointer(), psBlurHorizontalBlob->GetBufferSize() };
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R11G11B10_FLOAT;
-        core->device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&blurHorizontalPSO));
+        blurHorizontalPSO = core->pipelineCache.createGraphics("FogBlurH", psoDesc);
 
         psoDesc.PS = { psBlurVerticalBlob->GetBufferPointer(), psBlurVerticalBlob->GetBufferSize() };
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R11G11B10_FLOAT;
-        core->device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&blurVerticalPSO));
+        blurVerticalPSO = core->pipelineCache.createGraphics("FogBlurV", psoDesc);
 
         psoDesc.PS = { psCompositeBlob->GetBufferPointer(), psCompositeBlob->GetBufferSize() };
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-        core->device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&compositePSO));
+        compositePSO = core->pipelineCache.createGraphics("FogComposite", psoDesc);
 
-        std::cout << "[VolumetricFog] PSOs created\n";
-    }
-
-    void createConstantBuffers()
-    {
-        D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+        if (csFroxelInjectBlob && csFroxelIntegrateBlob)
+        {
+            D3D12_COMPUTE_PIPELINE_STATE_DESC csDesc = {};
+            csDesc.pRootSignature = froxelRootSignature;
 
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = 256; // assumes CB payload fits within 256 bytes
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            csDesc.CS = { csFroxelInjectBlob->GetBufferPointer(), csFroxelInjectBlob->GetBufferSize() };
+            froxelInjectPSO = core->pipelineCache.createCompute("FogFroxelInject", csDesc);
 
-        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&fogConstantBuffer));
+            csDesc.CS = { csFroxelIntegrateBlob->GetBufferPointer(), csFroxelIntegrateBlob->GetBufferSize() };
+            froxelIntegratePSO = core->pipelineCache.createCompute("FogFroxelIntegrate", csDesc);
+        }
 
-        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&blurConstantBuffer));
+        if (!froxelAvailable())
+        {
+            std::cout << "[VolumetricFog] WARNING: Froxel backend unavailable, falling back to raymarch\n";
+        }
 
-        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&compositeConstantBuffer));
+        std::cout << "[VolumetricFog] PSOs created\n";
     }
 
     void createFullscreenQuad()
@@ -573,17 +816,14 @@ private:
         cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         cmdList->IASetVertexBuffers(0, 1, &quadVBView);
         cmdList->DrawInstanced(3, 1, 0, 0);
+        core->countDraw(1);
     }
 
-    void renderFogPass(const Matrix& view, const Matrix& proj, const Vec3& camPos, float time)
+    // Raymarch into fogBuffer, or into fogRawBuffer for the temporal resolve
+    void renderFogPass(const Matrix& invVP, const Vec3& camPos, float time)
     {
         auto cmdList = core->getCommandList();
 
-        Matrix viewCopy = view;
-        Matrix projCopy = proj;
-        Matrix vp = viewCopy * projCopy;
-        Matrix invVP = vp.invert();
-
         // Update fog raymarch constant buffer
         FogCB cb;
         cb.invViewProj = invVP;
@@ -595,19 +835,22 @@ private:
         cb.sunColor_pad = Vec4(config.sunColor.x, config.sunColor.y, config.sunColor.z, 0);
         cb.ambientColor_pad = Vec4(config.ambientColor.x, config.ambientColor.y, config.ambientColor.z, 0);
         cb.screenSize = Vec4((float)screenWidth, (float)screenHeight, (float)fogWidth, (float)fogHeight);
-        cb.numSteps = config.raymarchSteps;
+        cb.numSteps = config.temporal ? config.temporalRaymarchSteps : config.raymarchSteps;
+        cb.minSteps = (std::min)(config.minRaymarchSteps, cb.numSteps);
+        cb.frameJitter = (float)(frameCounter % 64) * 0.618034f;
+        cb.temporalMode = config.temporal ? 1.0f : 0.0f;
 
-        void* data;
-        fogConstantBuffer->Map(0, nullptr, &data);
-        memcpy(data, &cb, sizeof(cb));
-        fogConstantBuffer->Unmap(0, nullptr);
+        // Per-frame copy so the previous frame's fog constants are not overwritten in flight
+        D3D12_GPU_VIRTUAL_ADDRESS fogConstants = core->uploadConstants(&cb, sizeof(cb));
 
-        transitionResource(fogBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+        ID3D12Resource* target = config.temporal ? fogRawBuffer : fogBuffer;
+        D3D12_CPU_DESCRIPTOR_HANDLE targetRTV = config.temporal ? fogRawRTV : fogRTV;
+
+        transitionResource(target, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_RENDER_TARGET);
 
-        cmdList->OMSetRenderTargets(1, &fogRTV, FALSE, nullptr);
-        float clear[4] = { 0, 0, 0, 0 };
-        cmdList->ClearRenderTargetView(fogRTV, clear, 0, nullptr);
+        // Every pixel is written by the fullscreen triangle, so no clear is needed
+        cmdList->OMSetRenderTargets(1, &targetRTV, FALSE, nullptr);
 
         D3D12_VIEWPORT vp2 = { 0, 0, (float)fogWidth, (float)fogHeight, 0, 1 };
         D3D12_RECT scissor = { 0, 0, (LONG)fogWidth, (LONG)fogHeight };
@@ -616,10 +859,124 @@ private:
 
         cmdList->SetPipelineState(fogPSO);
         cmdList->SetGraphicsRootSignature(fogRootSignature);
-        cmdList->SetGraphicsRootConstantBufferView(0, fogConstantBuffer->GetGPUVirtualAddress());
+        cmdList->SetGraphicsRootConstantBufferView(0, fogConstants);
+
+        cmdList->SetGraphicsRootDescriptorTable(1, sceneColorSRV);
+
+        drawFullscreenQuad(cmdList);
+
+        transitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+
+    // Blend the raw raymarch with the reprojected history into fogBuffer, then keep a copy of the
+    // result as next frame's history
+    void renderTemporalResolvePass(const Matrix& invVP)
+    {
+        auto cmdList = core->getCommandList();
+
+        ResolveCB cb;
+        cb.invViewProj = invVP;
+        cb.prevViewProj = prevViewProj;
+        cb.fogSize = Vec4((float)fogWidth, (float)fogHeight, 1.0f / fogWidth, 1.0f / fogHeight);
+        cb.resolveParams = Vec4(historyValid ? config.temporalBlend : 0.0f, 0, 0, 0);
+
+        D3D12_GPU_VIRTUAL_ADDRESS resolveConstants = core->uploadConstants(&cb, sizeof(cb));
+
+        transitionResource(fogBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        cmdList->OMSetRenderTargets(1, &fogRTV, FALSE, nullptr);
+
+        D3D12_VIEWPORT vp = { 0, 0, (float)fogWidth, (float)fogHeight, 0, 1 };
+        D3D12_RECT scissor = { 0, 0, (LONG)fogWidth, (LONG)fogHeight };
+        cmdList->RSSetViewports(1, &vp);
+        cmdList->RSSetScissorRects(1, &scissor);
+
+        cmdList->SetPipelineState(resolvePSO);
+        cmdList->SetGraphicsRootSignature(fogRootSignature);
+        cmdList->SetGraphicsRootConstantBufferView(0, resolveConstants);
 
-        ID3D12DescriptorHeap* heaps[] = { srvHeap };
-        cmdList->SetDescriptorHeaps(1, heaps);
+        cmdList->SetGraphicsRootDescriptorTable(1, sceneColorSRV);
+
+        drawFullscreenQuad(cmdList);
+
+        transitionResource(fogBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_COPY_SOURCE);
+        transitionResource(fogHistoryBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST);
+
+        cmdList->CopyResource(fogHistoryBuffer, fogBuffer);
+
+        transitionResource(fogHistoryBuffer, D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        transitionResource(fogBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+
+    // Froxel backend: inject -> integrate (compute), then one volume lookup per fog-buffer pixel.
+    // Writes fogBuffer like the raymarch, so blur and composite are shared between backends.
+    void renderFroxelPasses(const Matrix& invVP, const Vec3& camPos, float time)
+    {
+        auto cmdList = core->getCommandList();
+
+        FroxelCB cb;
+        cb.invViewProj = invVP;
+        cb.cameraPos_time = Vec4(camPos.x, camPos.y, camPos.z, time);
+        cb.fogColor_density = Vec4(config.fogColor.x, config.fogColor.y, config.fogColor.z, config.density);
+        cb.sunDir_scattering = Vec4(config.sunDirection.x, config.sunDirection.y, config.sunDirection.z, config.scattering);
+        cb.params1 = Vec4(config.heightFalloff, config.groundLevel, config.maxHeight, config.mieG);
+        cb.params2 = Vec4(config.maxDistance, config.windSpeed, config.windDirection.x, config.windDirection.y);
+        cb.sunColor_pad = Vec4(config.sunColor.x, config.sunColor.y, config.sunColor.z, 0);
+        cb.ambientColor_pad = Vec4(config.ambientColor.x, config.ambientColor.y, config.ambientColor.z, 0);
+        cb.froxelSize = Vec4((float)froxelWidth, (float)froxelHeight, (float)froxelDepth, 0);
+
+        D3D12_GPU_VIRTUAL_ADDRESS froxelConstants = core->uploadConstants(&cb, sizeof(cb));
+
+        cmdList->SetComputeRootSignature(froxelRootSignature);
+        cmdList->SetComputeRootConstantBufferView(0, froxelConstants);
+
+        UINT groupsX = (froxelWidth + 7) / 8;
+        UINT groupsY = (froxelHeight + 7) / 8;
+
+        // Inject: one thread per froxel (t0 is unused, but the table must point at a valid descriptor)
+        cmdList->SetPipelineState(froxelInjectPSO);
+        cmdList->SetComputeRootDescriptorTable(1, froxelScatterUAV);
+        cmdList->SetComputeRootDescriptorTable(2, froxelScatterSRV);
+        cmdList->Dispatch(groupsX, groupsY, froxelDepth);
+        core->countDispatch();
+
+        transitionResource(froxelScatterVolume, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        transitionResource(froxelIntegratedVolume, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        // Integrate: one thread per froxel column
+        cmdList->SetPipelineState(froxelIntegratePSO);
+        cmdList->SetComputeRootDescriptorTable(1, froxelIntegratedUAV);
+        cmdList->SetComputeRootDescriptorTable(2, froxelScatterSRV);
+        cmdList->Dispatch(groupsX, groupsY, 1);
+        core->countDispatch();
+
+        transitionResource(froxelIntegratedVolume, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        transitionResource(froxelScatterVolume, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        // Apply: depth -> slice lookup at fog resolution
+        transitionResource(fogBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        cmdList->OMSetRenderTargets(1, &fogRTV, FALSE, nullptr);
+
+        D3D12_VIEWPORT vp = { 0, 0, (float)fogWidth, (float)fogHeight, 0, 1 };
+        D3D12_RECT scissor = { 0, 0, (LONG)fogWidth, (LONG)fogHeight };
+        cmdList->RSSetViewports(1, &vp);
+        cmdList->RSSetScissorRects(1, &scissor);
+
+        cmdList->SetPipelineState(froxelApplyPSO);
+        cmdList->SetGraphicsRootSignature(fogRootSignature);
+        cmdList->SetGraphicsRootConstantBufferView(0, froxelConstants);
         cmdList->SetGraphicsRootDescriptorTable(1, sceneColorSRV);
 
         drawFullscreenQuad(cmdList);
@@ -632,33 +989,29 @@ private:
     {
         auto cmdList = core->getCommandList();
 
-        // Horizontal blur CB update (sceneColor as input)
+        // Horizontal blur CB update (sceneColor as input). Runs at fog resolution, so the radius
+        // (given in full-res pixels) shrinks by the same factor to keep the same footprint.
         BlurCB cb;
-        cb.screenSize = Vec4((float)screenWidth, (float)screenHeight,
-            1.0f / screenWidth, 1.0f / screenHeight);
-        cb.blurParams = Vec4(config.blurStrength, config.blurRadius, 0, 0);
+        cb.screenSize = Vec4((float)fogWidth, (float)fogHeight,
+            1.0f / fogWidth, 1.0f / fogHeight);
+        cb.blurParams = Vec4(config.blurStrength, config.blurRadius * fogWidth / screenWidth, 0, 0);
 
-        void* data;
-        blurConstantBuffer->Map(0, nullptr, &data);
-        memcpy(data, &cb, sizeof(cb));
-        blurConstantBuffer->Unmap(0, nullptr);
+        blurConstants = core->uploadConstants(&cb, sizeof(cb));
 
         transitionResource(blurTempBuffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_RENDER_TARGET);
 
         cmdList->OMSetRenderTargets(1, &blurTempRTV, FALSE, nullptr);
 
-        D3D12_VIEWPORT vp = { 0, 0, (float)screenWidth, (float)screenHeight, 0, 1 };
-        D3D12_RECT scissor = { 0, 0, (LONG)screenWidth, (LONG)screenHeight };
+        D3D12_VIEWPORT vp = { 0, 0, (float)fogWidth, (float)fogHeight, 0, 1 };
+        D3D12_RECT scissor = { 0, 0, (LONG)fogWidth, (LONG)fogHeight };
         cmdList->RSSetViewports(1, &vp);
         cmdList->RSSetScissorRects(1, &scissor);
 
         cmdList->SetPipelineState(blurHorizontalPSO);
         cmdList->SetGraphicsRootSignature(fogRootSignature);
-        cmdList->SetGraphicsRootConstantBufferView(0, blurConstantBuffer->GetGPUVirtualAddress());
+        cmdList->SetGraphicsRootConstantBufferView(0, blurConstants);
 
-        ID3D12DescriptorHeap* heaps[] = { srvHeap };
-        cmdList->SetDescriptorHeaps(1, heaps);
         cmdList->SetGraphicsRootDescriptorTable(1, sceneColorSRV);
 
         drawFullscreenQuad(cmdList);
@@ -677,17 +1030,15 @@ private:
 
         cmdList->OMSetRenderTargets(1, &blurredRTV, FALSE, nullptr);
 
-        D3D12_VIEWPORT vp = { 0, 0, (float)screenWidth, (float)screenHeight, 0, 1 };
-        D3D12_RECT scissor = { 0, 0, (LONG)screenWidth, (LONG)screenHeight };
+        D3D12_VIEWPORT vp = { 0, 0, (float)fogWidth, (float)fogHeight, 0, 1 };
+        D3D12_RECT scissor = { 0, 0, (LONG)fogWidth, (LONG)fogHeight };
         cmdList->RSSetViewports(1, &vp);
         cmdList->RSSetScissorRects(1, &scissor);
 
         cmdList->SetPipelineState(blurVerticalPSO);
         cmdList->SetGraphicsRootSignature(fogRootSignature);
-        cmdList->SetGraphicsRootConstantBufferView(0, blurConstantBuffer->GetGPUVirtualAddress());
+        cmdList->SetGraphicsRootConstantBufferView(0, blurConstants);
 
-        ID3D12DescriptorHeap* heaps[] = { srvHeap };
-        cmdList->SetDescriptorHeaps(1, heaps);
         cmdList->SetGraphicsRootDescriptorTable(1, blurTempSRV);
 
         drawFullscreenQuad(cmdList);
@@ -705,15 +1056,12 @@ private:
         cb.screenSize = Vec4((float)screenWidth, (float)screenHeight, (float)fogWidth, (float)fogHeight);
         cb.compositeParams = Vec4(config.blurBlend, 0, 0, 0);
 
-        void* data;
-        compositeConstantBuffer->Map(0, nullptr, &data);
-        memcpy(data, &cb, sizeof(cb));
-        compositeConstantBuffer->Unmap(0, nullptr);
+        D3D12_GPU_VIRTUAL_ADDRESS compositeConstants = core->uploadConstants(&cb, sizeof(cb));
 
         // Bind swapchain backbuffer as output
         UINT rtvSize = core->device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
         D3D12_CPU_DESCRIPTOR_HANDLE backBufferRTV = core->backbufferHeap->GetCPUDescriptorHandleForHeapStart();
-        backBufferRTV.ptr += core->frameIndex() * rtvSize;
+        backBufferRTV.ptr += core->backBufferIndex() * rtvSize;
 
         cmdList->OMSetRenderTargets(1, &backBufferRTV, FALSE, nullptr);
 
@@ -724,10 +1072,8 @@ private:
 
         cmdList->SetPipelineState(compositePSO);
         cmdList->SetGraphicsRootSignature(fogRootSignature);
-        cmdList->SetGraphicsRootConstantBufferView(0, compositeConstantBuffer->GetGPUVirtualAddress());
+        cmdList->SetGraphicsRootConstantBufferView(0, compositeConstants);
 
-        ID3D12DescriptorHeap* heaps[] = { srvHeap };
-        cmdList->SetDescriptorHeaps(1, heaps);
         cmdList->SetGraphicsRootDescriptorTable(1, sceneColorSRV);
 
         drawFullscreenQuad(cmdList);
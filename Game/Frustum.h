@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Maths.h"
+#include <vector>
+#include <emmintrin.h>
+
+// Axis-aligned bounds for many objects stored as separate arrays (SoA), so the frustum test can
+// load 4 boxes per SSE register. Arrays are padded to a multiple of 4 with empty boxes.
+struct BoundsSoA
+{
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+    int count = 0;
+
+    void clear()
+    {
+        minX.clear(); minY.clear(); minZ.clear();
+        maxX.clear(); maxY.clear(); maxZ.clear();
+        count = 0;
+    }
+
+    // Append one box; returns its index
+    int add(const Vec3& bmin, const Vec3& bmax)
+    {
+        // Drop the padding from the previous add before appending
+        minX.resize(count); minY.resize(count); minZ.resize(count);
+        maxX.resize(count); maxY.resize(count); maxZ.resize(count);
+
+        minX.push_back(bmin.x); minY.push_back(bmin.y); minZ.push_back(bmin.z);
+        maxX.push_back(bmax.x); maxY.push_back(bmax.y); maxZ.push_back(bmax.z);
+        count++;
+
+        // Pad with inverted boxes (min > max) - these fail every plane and never show as visible
+        int padded = paddedCount();
+        minX.resize(padded, 1e30f); minY.resize(padded, 1e30f); minZ.resize(padded, 1e30f);
+        maxX.resize(padded, -1e30f); maxY.resize(padded, -1e30f); maxZ.resize(padded, -1e30f);
+        return count - 1;
+    }
+
+    // Overwrite box i (streamed chunks change contents in place)
+    void set(int i, const Vec3& bmin, const Vec3& bmax)
+    {
+        minX[i] = bmin.x; minY[i] = bmin.y; minZ[i] = bmin.z;
+        maxX[i] = bmax.x; maxY[i] = bmax.y; maxZ[i] = bmax.z;
+    }
+
+    int paddedCount() const { return (count + 3) & ~3; }
+};
+
+// View frustum as 6 inward-facing planes (nx, ny, nz, d): a point p is inside when dot(n, p) + d >= 0.
+class Frustum
+{
+public:
+    Vec4 planes[6];
+
+    Frustum() {}
+    Frustum(const Matrix& vp) { fromViewProj(vp); }
+
+    // Extract planes from a combined view-projection (rows of the engine's column-vector matrix,
+    // D3D clip space with 0 <= z <= w)
+    void fromViewProj(const Matrix& vp)
+    {
+        const float* r0 = vp.a[0];
+        const float* r1 = vp.a[1];
+        const float* r2 = vp.a[2];
+        const float* r3 = vp.a[3];
+
+        setPlane(0, r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]);   // Left
+        setPlane(1, r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]);   // Right
+        setPlane(2, r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]);   // Bottom
+        setPlane(3, r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]);   // Top
+        setPlane(4, r2[0], r2[1], r2[2], r2[3]);                                   // Near
+        setPlane(5, r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]);   // Far
+    }
+
+    // Scalar test for a single box (used for one-off objects like the tree)
+    bool testAABB(const Vec3& bmin, const Vec3& bmax) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            const Vec4& p = planes[i];
+            float px = (p.x >= 0.0f) ? bmax.x : bmin.x;
+            float py = (p.y >= 0.0f) ? bmax.y : bmin.y;
+            float pz = (p.z >= 0.0f) ? bmax.z : bmin.z;
+            if (p.x * px + p.y * py + p.z * pz + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    bool testSphere(const Vec3& center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            const Vec4& p = planes[i];
+            if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // SSE kernel: test 4 boxes per iteration. outVisible must hold bounds.paddedCount() entries.
+    // Per plane only the "positive vertex" (the box corner furthest along the normal) is tested,
+    // and since the normal is shared by all 4 lanes the corner is picked per array, not per lane.
+    void cullAABBs(const BoundsSoA& bounds, unsigned char* outVisible) const
+    {
+        const int padded = bounds.paddedCount();
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int i = 0; i < padded; i += 4)
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (int p = 0; p < 6; p++)
+            {
+                const Vec4& pl = planes[p];
+                const float* xs = (pl.x >= 0.0f) ? bounds.maxX.data() : bounds.minX.data();
+                const float* ys = (pl.y >= 0.0f) ? bounds.maxY.data() : bounds.minY.data();
+                const float* zs = (pl.z >= 0.0f) ? bounds.maxZ.data() : bounds.minZ.data();
+
+                __m128 d = _mm_set1_ps(pl.w);
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.x), _mm_loadu_ps(xs + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.y), _mm_loadu_ps(ys + i)));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.z), _mm_loadu_ps(zs + i)));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            outVisible[i + 0] = (mask >> 0) & 1;
+            outVisible[i + 1] = (mask >> 1) & 1;
+            outVisible[i + 2] = (mask >> 2) & 1;
+            outVisible[i + 3] = (mask >> 3) & 1;
+        }
+    }
+
+private:
+    void setPlane(int i, float a, float b, float c, float d)
+    {
+        // Normalise so plane distances are in world units (needed by testSphere)
+        float len = sqrtf(a * a + b * b + c * c);
+        float inv = (len > 0.0f) ? 1.0f / len : 1.0f;
+        planes[i] = Vec4(a * inv, b * inv, c * inv, d * inv);
+    }
+};
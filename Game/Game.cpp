@@ -8,6 +8,7 @@
 #include "SkyDome.h"
 #include "HeightmapTerrain.h"
 #include "Gun.h"
+#include "AnimatedCrowd.h"
 #include "HybridGrassField.h"
 #include "Rocks.h"
 #include "AssetManager.h"
@@ -20,6 +21,11 @@
 #include "Crosshair.h"
 #include "StartMenu.h"
 #include "RandomGenerator.h"
+#include "RenderJobs.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "VegetationStreamer.h"
+#include "HiZOcclusion.h"
 
 #include <algorithm>
 #include <Windows.h>
@@ -43,7 +49,8 @@ Lake* g_lake = nullptr;
 std::vector<GrassInstance> convertToGrassInstances(
     const std::vector<VegetationItem>& items,
     int numGroups,
-    int numTypesPerGroup)
+    int numTypesPerGroup,
+    bool verbose = true)
 {
     std::vector<GrassInstance> instances;
     instances.reserve(items.size());
@@ -91,7 +98,7 @@ std::vector<GrassInstance> convertToGrassInstances(
         instances.push_back(inst);
     }
 
-    if (skippedCount > 0)
+    if (verbose && skippedCount > 0)
     {
         std::cout << "[Grass] Skipped " << skippedCount << " grass instances inside lake area\n";
     }
@@ -102,7 +109,7 @@ std::vector<GrassInstance> convertToGrassInstances(
 // ============================================================================
 // HELPER: Convert VegetationItems to RockInstances
 // ============================================================================
-std::vector<RockInstance> convertToRockInstances(const std::vector<VegetationItem>& items)
+std::vector<RockInstance> convertToRockInstances(const std::vector<VegetationItem>& items, bool verbose = true)
 {
     std::vector<RockInstance> instances;
     instances.reserve(items.size());
@@ -125,12 +132,10 @@ std::vector<RockInstance> convertToRockInstances(const std::vector<VegetationIte
         inst.rotationY = item.rotationY;
         inst.scale = item.scale;
         inst.typeIndex = item.typeIndex;
-        inst.distanceToCamera = 0.0f;
-        inst.lodLevel = 2;
         instances.push_back(inst);
     }
 
-    if (skippedCount > 0)
+    if (verbose && skippedCount > 0)
     {
         std::cout << "[Rocks] Skipped " << skippedCount << " rocks near spawn point\n";
     }
@@ -150,51 +155,35 @@ struct SceneRenderData
     HeightmapTerrain* terrain;
     Rocks* rocks;
     HybridGrassField* grass;
-    Vec3 cameraPos;
     bool hasRocks;
     bool hasGrass;
 };
 
-void RenderSceneForReflection(void* userData, const Matrix& view, const Matrix& proj)
+// view comes from Lake: mirrored camera, near plane on the water surface, LakeConfig LOD/cull range
+void RenderSceneForReflection(void* userData, const CullView& view)
 {
     SceneRenderData* data = (SceneRenderData*)userData;
 
-    Matrix viewCopy = view;
-    Matrix projCopy = proj;
-    Matrix vp = viewCopy * projCopy;
     Matrix terrainW;
 
-    data->core->setDefaultDescriptorHeaps();
     data->core->getCommandList()->SetGraphicsRootSignature(data->core->rootSignature);
 
-    data->sky->draw(data->core, data->psos, data->shaders, vp, data->cameraPos);
-    data->terrain->draw(data->core, data->psos, data->shaders, vp, terrainW);
+    data->sky->draw(data->core, data->psos, data->shaders, view.viewProj, view.cameraPos);
+    data->terrain->draw(data->core, data->psos, data->shaders, view, terrainW);
 
+    // Reflection gets its own cull (shorter range, coarse LODs) and its own instance buffer slice
     if (data->hasRocks)
-        data->rocks->draw(data->core, data->psos, data->shaders, vp, data->cameraPos);
+        data->rocks->draw(data->core, data->psos, data->shaders, view.viewProj,
+            data->rocks->cull(data->core, view));
 }
 
 // ============================================================================
 // COLLISION: Check collision with rocks
 // ============================================================================
-bool checkRockCollision(const Vec3& position, const std::vector<RockInstance>& rockInstances, float playerRadius)
+bool checkRockCollision(const Vec3& position, const Rocks& rocks, float playerRadius)
 {
-    for (const auto& rock : rockInstances)
-    {
-        float rockRadius = rock.scale * 1.5f;
-
-        float dx = position.x - rock.position.x;
-        float dz = position.z - rock.position.z;
-        float distSq = dx * dx + dz * dz;
-
-        float minDist = playerRadius + rockRadius;
-
-        if (distSq < minDist * minDist)
-        {
-            return true;
-        }
-    }
-    return false;
+    // Only the grid cells around the player are tested (radius = scale * rocks.collisionRadius)
+    return rocks.getSpatialIndex().overlapsCircleXZ(position.x, position.z, playerRadius);
 }
 
 // ============================================================================
@@ -229,6 +218,23 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     freopen_s(&fp, "CONOUT$", "w", stdout);
     freopen_s(&fp, "CONOUT$", "w", stderr);
 
+    // ========================================================================
+    // OFFLINE COOK (Game.exe --cook): write .cmesh files next to every .gem and exit
+    // ========================================================================
+    if (lpCmdLine != nullptr && strstr(lpCmdLine, "--cook") != nullptr)
+    {
+        AssetManager cooker;
+        bool ok = cooker.cookFromConfig("assets.cfg", LODGenerator::getRatios());
+        return ok ? 0 : 1;
+    }
+
+    // Game.exe --benchmark [options]: scripted flythrough with a fixed step, report written on exit
+    BenchmarkSettings benchmark = BenchmarkSettings::parse(lpCmdLine);
+
+    // Game.exe --stream: grass/rock chunks are generated around the camera instead of for the whole map
+    bool streamVegetation = (lpCmdLine != nullptr && strstr(lpCmdLine, "--stream") != nullptr);
+    const float streamChunkSize = 32.0f;
+
     // ========================================================================
     // WINDOW & CORE
     // ========================================================================
@@ -271,6 +277,7 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     fog.config.scattering = 0.6f;
     fog.config.mieG = 0.75f;
 
+    fog.config.backend = FogBackend::Raymarch;  // Froxel is cheaper on GPUs that struggle with the per-pixel march
     fog.config.raymarchSteps = 24;
     fog.config.maxDistance = 150.0f;
 
@@ -279,8 +286,20 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
 
     fog.enabled = true;
 
+    if (benchmark.enabled)
+    {
+        fog.enabled = benchmark.fog;
+        fog.config.backend = benchmark.froxelFog ? FogBackend::Froxel : FogBackend::Raymarch;
+    }
+
     std::cout << "[Game] Fog system initialized\n";
 
+    // ========================================================================
+    // OCCLUSION (Hi-Z pyramid from a low-res terrain + large rock depth prepass)
+    // ========================================================================
+    HiZOcclusion occlusion;
+    occlusion.init(&core, WIDTH, HEIGHT);
+
     // ========================================================================
     // LOAD ASSETS
     // ========================================================================
@@ -377,6 +396,14 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     float treeZ = lake.config.center.z;
     float treeY = terrain.sampleHeightWorld(treeX, treeZ);
 
+    // Baked into the impostor at init, so set first
+    tree.trunkRadius = 0.3f;
+    tree.trunkHeight = 4.0f;
+    tree.trunkOffsetY = 0.0f;
+
+    tree.shadowRadius = 4.0f;
+    tree.shadowOpacity = 0.4f;
+
     tree.init(&core, &shaders, &psos,
         "Assets/Tree/Ash_Tree_Full_01b.gem",
         "Assets/Tree/Ash_Tree_Full_01b.jpg",
@@ -385,12 +412,28 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         2.0f,
         0.0f);
 
-    tree.trunkRadius = 0.3f;
-    tree.trunkHeight = 4.0f;
-    tree.trunkOffsetY = 0.0f;
+    // Forest: fixed seed so runs (and benchmarks) see the same trees; kept off the lake shore
+    {
+        std::mt19937 forestRng(2024);
+        std::uniform_real_distribution<float> randX(-terrainSizeX * 0.45f, terrainSizeX * 0.45f);
+        std::uniform_real_distribution<float> randZ(-terrainSizeZ * 0.45f, terrainSizeZ * 0.45f);
+        std::uniform_real_distribution<float> randScale(1.6f, 2.6f);
+        std::uniform_real_distribution<float> randRot(0.0f, 6.28318f);
+
+        const int forestSize = 80;
+        float shore = lake.config.radius + 8.0f;
+        for (int attempt = 0; attempt < forestSize * 4 && (int)tree.getInstanceCount() < forestSize + 1; attempt++)
+        {
+            float x = randX(forestRng);
+            float z = randZ(forestRng);
+            float dx = x - lake.config.center.x;
+            float dz = z - lake.config.center.z;
+            if (dx * dx + dz * dz < shore * shore) continue;
 
-    tree.shadowRadius = 4.0f;
-    tree.shadowOpacity = 0.4f;
+            tree.addInstance(Vec3(x, terrain.sampleHeightWorld(x, z), z), randScale(forestRng), randRot(forestRng));
+        }
+        std::cout << "[Tree] Forest: " << tree.getInstanceCount() << " trees\n";
+    }
 
     // ========================================================================
     // VEGETATION GENERATION
@@ -432,6 +475,14 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
 
     vegConfig.maxSlope = 40.0f;
 
+    // Benchmark density presets scale the grass clusters (the spacing-limited point count is fixed)
+    if (benchmark.enabled && benchmark.grassDensity != 1.0f)
+    {
+        vegConfig.grassCluster.minItems = (std::max)(1, (int)(vegConfig.grassCluster.minItems * benchmark.grassDensity + 0.5f));
+        vegConfig.grassCluster.maxItems = (std::max)(vegConfig.grassCluster.minItems,
+            (int)(vegConfig.grassCluster.maxItems * benchmark.grassDensity + 0.5f));
+    }
+
     unsigned int seed = 42;
 
     std::cout << "[VegetationGenerator] Configuration:\n";
@@ -441,7 +492,11 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     std::cout << "  Rock cluster prob: " << (vegConfig.rockCluster.probability * 100) << "%\n";
     std::cout << "  Seed: " << seed << "\n\n";
 
-    vegGen.generate(&terrain, vegConfig, terrainSizeX, terrainSizeZ, seed);
+    // Full-map layouts are cached under the seed/config/terrain key; tiles match the streaming chunks
+    vegGen.tileSize = streamChunkSize;
+    vegGen.cacheDirectory = "Cache/Vegetation";
+    if (!streamVegetation)
+        vegGen.generate(&terrain, vegConfig, terrainSizeX, terrainSizeZ, seed);
 
     const auto& generatedRocks = vegGen.getRockItems();
     const auto& generatedGrass = vegGen.getGrassItems();
@@ -481,6 +536,24 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         hasRocks = true;
         std::cout << "[Game] Rocks initialized: " << rockInstances.size() << " instances\n";
     }
+    else if (streamVegetation && !rockSets.empty())
+    {
+        rocks.terrainSizeX = terrainSizeX;
+        rocks.terrainSizeZ = terrainSizeZ;
+        rocks.initStreaming(&core, &psos, &shaders, &terrain,
+            rockSets[0].modelPaths,
+            rockSets[0].texturePaths,
+            100.0f,
+            streamChunkSize
+        );
+
+        rocks.rockColor = Vec4(0.75f, 0.72f, 0.68f, 1.0f);
+        rocks.lodDistanceHigh = 25.0f;
+        rocks.lodDistanceMedium = 60.0f;
+
+        hasRocks = true;
+        std::cout << "[Game] Rocks initialized for streaming\n";
+    }
     else
     {
         std::cout << "[Game] No rocks to initialize\n";
@@ -493,21 +566,22 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     bool hasGrass = false;
 
     auto grassConfigs = assets.getGrassGroupConfigs();
-    if (!grassConfigs.empty() && !generatedGrass.empty())
+    int numGroups = (int)grassConfigs.size();
+    int avgTypesPerGroup = 0;
+    for (const auto& group : grassConfigs)
     {
-        int numGroups = (int)grassConfigs.size();
-        int avgTypesPerGroup = 0;
-        for (const auto& group : grassConfigs)
-        {
-            avgTypesPerGroup += (int)group.types.size();
-        }
-        avgTypesPerGroup = numGroups > 0 ? avgTypesPerGroup / numGroups : 1;
+        avgTypesPerGroup += (int)group.types.size();
+    }
+    avgTypesPerGroup = numGroups > 0 ? avgTypesPerGroup / numGroups : 1;
 
+    if (!grassConfigs.empty() && !generatedGrass.empty())
+    {
         std::vector<GrassInstance> grassInstances = convertToGrassInstances(
             generatedGrass, numGroups, avgTypesPerGroup);
 
         grassField.terrainSizeX = terrainSizeX;
         grassField.terrainSizeZ = terrainSizeZ;
+        grassField.gpuCulling = true;
         grassField.initWithInstances(&core, &psos, &shaders, &terrain,
             grassConfigs,
             grassInstances,
@@ -524,11 +598,62 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         hasGrass = true;
         std::cout << "[Game] Grass initialized: " << grassInstances.size() << " instances\n";
     }
+    else if (streamVegetation && !grassConfigs.empty())
+    {
+        grassField.terrainSizeX = terrainSizeX;
+        grassField.terrainSizeZ = terrainSizeZ;
+        grassField.initStreaming(&core, &psos, &shaders, &terrain,
+            grassConfigs,
+            50.0f,
+            streamChunkSize
+        );
+
+        grassField.colorTop = Vec4(100.0f / 225.0f, 125.0f / 225.0f, 31.0f / 225.0f, 1.0f);
+        grassField.colorBottom = Vec4(100.0f / 225.0f, 125.0f / 225.0f, 31.0f / 225.0f, 1.0f);
+
+        grassField.windDirection = Vec2(1.0f, 0.3f);
+        grassField.windStrength = 0.0f;
+
+        hasGrass = true;
+        std::cout << "[Game] Grass initialized for streaming\n";
+    }
     else
     {
         std::cout << "[Game] No grass to initialize\n";
     }
 
+    // ========================================================================
+    // VEGETATION STREAMING (--stream)
+    // ========================================================================
+    // Each chunk is one VegetationGenerator tile, seeded from (seed, chunk), so it regenerates
+    // identically after eviction; built chunks are also cached on disk under the same key as the
+    // full-map layout (config, seed, terrain size and heights) with the chunk size as tile size.
+    VegetationStreamer vegStreamer;
+    if (streamVegetation && (hasGrass || hasRocks))
+    {
+        unsigned long long key = VegetationGenerator::makeCacheKey(&terrain, vegConfig, terrainSizeX, terrainSizeZ,
+            streamChunkSize, seed);
+        key = hashBytes(&numGroups, sizeof(numGroups), key);
+        key = hashBytes(&avgTypesPerGroup, sizeof(avgTypesPerGroup), key);
+
+        vegStreamer.cacheDirectory = "Cache/Vegetation";
+        vegStreamer.cacheKey = key;
+        vegStreamer.loadRadius = 110.0f;
+        vegStreamer.unloadRadius = 140.0f;
+        vegStreamer.init(terrainSizeX, terrainSizeZ, streamChunkSize,
+            [&terrain, &vegConfig, terrainSizeX, terrainSizeZ, streamChunkSize, seed, numGroups, avgTypesPerGroup]
+            (int chunkX, int chunkZ, VegetationChunkData& out)
+            {
+                VegetationGenerator tileGen;
+                tileGen.generateTile(&terrain, vegConfig, terrainSizeX, terrainSizeZ, chunkX, chunkZ, streamChunkSize, seed);
+                out.rocks = convertToRockInstances(tileGen.getRockItems(), false);
+                out.grass = convertToGrassInstances(tileGen.getGrassItems(), numGroups, avgTypesPerGroup, false);
+            });
+
+        vegStreamer.preload(Vec3(0.0f, 0.0f, 0.0f), hasGrass ? &grassField : nullptr, hasRocks ? &rocks : nullptr);
+        vegStreamer.printStats();
+    }
+
     std::cout << "\n========================================\n";
     std::cout << "   VEGETATION SETUP COMPLETE\n";
     std::cout << "========================================\n\n";
@@ -545,6 +670,36 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     AnimationInstance gunAnim;
     gunAnim.init(&gunModel.animation, 0);
 
+    // ========================================================================
+    // T-REX HERD (GPU instanced skinning from baked clips)
+    // ========================================================================
+    AnimatedCrowd trexHerd;
+    trexHerd.load(&core,
+        "Assets/Models/TRex.gem",
+        "Assets/Models/Textures/T-rex_Base_Color_alb.png",
+        &psos, &shaders);
+    {
+        const int herdSize = 16;
+        const float trexScale = 0.01f;
+        const Vec3 herdCenter(-70.0f, 0.0f, -60.0f);
+        AnimationClip herdClips[3] = { trexHerd.findClip("idle"), trexHerd.findClip("walk"), trexHerd.findClip("roar") };
+
+        // Golden-angle spiral keeps the animals spread out without overlapping
+        for (int i = 0; i < herdSize; i++)
+        {
+            float angle = (float)i * 2.39996f;
+            float dist = 6.0f + 9.0f * sqrtf((float)i);
+            float x = herdCenter.x + cosf(angle) * dist;
+            float z = herdCenter.z + sinf(angle) * dist;
+            float y = terrain.sampleHeightWorld(x, z);
+
+            Matrix world = Matrix::scaling(Vec3(trexScale, trexScale, trexScale)) *
+                Matrix::rotateY(angle) * Matrix::translation(Vec3(x, y, z));
+            AnimationClip clip = herdClips[i % 3];
+            trexHerd.add(world, (clip != INVALID_CLIP) ? clip : 0, (float)i * 0.37f);
+        }
+    }
+
     // ========================================================================
     // CAMERA & PLAYER STATE
     // ========================================================================
@@ -608,7 +763,10 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     // UI: START MENU & CROSSHAIR
     // ========================================================================
     startMenu.init(&core, &shaders, &psos, WIDTH, HEIGHT);
+    if (benchmark.enabled)
+        startMenu.release(&core);   // Benchmark runs skip the menu
     crosshair.init(&core, &shaders, &psos, WIDTH, HEIGHT);
+    Profiler::get().init(&core, &shaders, &psos);
 
     crosshair.size = 15.0f;
     crosshair.thickness = 2.0f;
@@ -617,12 +775,57 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     // Show cursor for menu
     ShowCursor(TRUE);
 
+    // Every PSO exists now; persist the pipeline library so a crash or kill still leaves a warm cache
+    core.pipelineCache.save();
+
+    // Every texture and mesh is loaded too
+    core.printTextureMemoryReport();
+    core.geometry.printReport();
+
     // ========================================================================
     // TIMING & GAME STATE
     // ========================================================================
     Timer timer;
     float totalTime = 0.0f;
-    bool gameStarted = false;
+    bool gameStarted = benchmark.enabled;   // Benchmark runs skip the start menu
+    RenderJobs sceneJobs;   // World + post recording, one command list per subsystem
+
+    // ========================================================================
+    // BENCHMARK PATH
+    // ========================================================================
+    CameraSpline benchmarkPath;
+    BenchmarkRecorder benchmarkRecorder;
+    float benchmarkTime = 0.0f;
+    int benchmarkFrame = 0;
+    bool benchmarkCompleted = false;
+
+    if (benchmark.enabled)
+    {
+        if (benchmark.pathFile.empty() || !benchmarkPath.load(benchmark.pathFile))
+        {
+            // Default loop: weaves between the terrain edge and the middle, with one low pass over the lake
+            const int pathPoints = 8;
+            for (int i = 0; i < pathPoints; i++)
+            {
+                float angle = (float)i * (2.0f * 3.141592654f / pathPoints);
+                float radius = (i % 2 == 0) ? terrainSizeX * 0.33f : terrainSizeX * 0.15f;
+                float x = cosf(angle) * radius;
+                float z = sinf(angle) * radius;
+                if (i == 2)
+                {
+                    x = lake.config.center.x;
+                    z = lake.config.center.z;
+                }
+                float ground = (std::max)(terrain.sampleHeightWorld(x, z), lake.config.waterLevel);
+                benchmarkPath.add(Vec3(x, ground + ((i % 2 == 0) ? 4.0f : 18.0f), z));
+            }
+        }
+
+        core.vsync = false;
+        window.useMouseClip = false;
+        std::cout << "[Benchmark] Preset " << benchmark.preset << ", " << benchmark.duration << " s after "
+            << benchmark.warmupFrames << " warm-up frames\n";
+    }
 
     std::cout << "========================================\n";
     std::cout << "   GAME RUNNING - Press ESC to exit\n";
@@ -634,9 +837,13 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     while (1)
     {
         core.beginFrame();
+        Profiler::get().beginFrame();
 
         float dt = timer.dt();
+        float frameMs = dt * 1000.0f;   // Unclamped, for the benchmark report
         dt = std::min(dt, 0.05f);
+        if (benchmark.enabled)
+            dt = benchmark.fixedStep;
 
         window.checkInput();
         if (window.keys[VK_ESCAPE]) break;
@@ -655,6 +862,7 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
             if (startKeyPressed)
             {
                 gameStarted = true;
+                startMenu.release(&core);
                 while (ShowCursor(FALSE) >= 0);
                 window.useMouseClip = true;
                 center = getCenterScreen();
@@ -682,6 +890,54 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         }
         togglePressed = window.keys['T'];
 
+        // Switch fog backend (raymarch <-> froxel)
+        static bool backendPressed = false;
+        if (window.keys['F'] && !backendPressed) {
+            fog.config.backend = (fog.config.backend == FogBackend::Raymarch) ? FogBackend::Froxel : FogBackend::Raymarch;
+        }
+        backendPressed = window.keys['F'];
+
+        // V toggles vsync (off presents immediately, with tearing where the display allows it)
+        static bool vsyncPressed = false;
+        if (window.keys['V'] && !vsyncPressed) {
+            core.vsync = !core.vsync;
+            std::cout << "[Game] VSync " << (core.vsync ? "on" : "off") << "\n";
+        }
+        vsyncPressed = window.keys['V'];
+
+        // Toggle parallel command list recording and print the last frame's per-job timings
+        static bool parallelPressed = false;
+        if (window.keys['P'] && !parallelPressed) {
+            sceneJobs.printTimings();
+            sceneJobs.parallel = !sceneJobs.parallel;
+        }
+        parallelPressed = window.keys['P'];
+
+        // Profiler: O toggles the overlay (and prints the row legend), K exports the kept frames
+        static bool overlayPressed = false;
+        if (window.keys['O'] && !overlayPressed) {
+            Profiler::get().showOverlay = !Profiler::get().showOverlay;
+            Profiler::get().printReport();
+            if (streamVegetation)
+                vegStreamer.printStats();
+        }
+        overlayPressed = window.keys['O'];
+
+        static bool exportPressed = false;
+        if (window.keys['K'] && !exportPressed) {
+            Profiler::get().writeCSV("profile.csv");
+            Profiler::get().writeChromeTrace("profile_trace.json");
+        }
+        exportPressed = window.keys['K'];
+
+        // C toggles Hi-Z occlusion culling and prints what it culled last frame
+        static bool occlusionPressed = false;
+        if (window.keys['C'] && !occlusionPressed) {
+            occlusion.enabled = !occlusion.enabled;
+            occlusion.printStats();
+        }
+        occlusionPressed = window.keys['C'];
+
         if (window.keys['G'] && !togglePressed) {
             fog.config.density = std::min(fog.config.density + 0.005f, 0.1f);
         }
@@ -693,17 +949,20 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         // ====================================================================
         // MOUSE LOOK
         // ====================================================================
-        center = getCenterScreen();
+        if (!benchmark.enabled)
+        {
+            center = getCenterScreen();
 
-        POINT cur{};
-        GetCursorPos(&cur);
-        float dx = float(cur.x - center.x);
-        float dy = float(cur.y - center.y);
-        SetCursorPos(center.x, center.y);
+            POINT cur{};
+            GetCursorPos(&cur);
+            float dx = float(cur.x - center.x);
+            float dy = float(cur.y - center.y);
+            SetCursorPos(center.x, center.y);
 
-        yaw += dx * mouseSens;
-        pitch -= dy * mouseSens;
-        pitch = clampf(pitch, -pitchLimit, +pitchLimit);
+            yaw += dx * mouseSens;
+            pitch -= dy * mouseSens;
+            pitch = clampf(pitch, -pitchLimit, +pitchLimit);
+        }
 
         Vec3 forward(
             sinf(yaw) * cosf(pitch),
@@ -727,9 +986,6 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         if (hasGrass)
             grassField.update(dt);
 
-        if (hasRocks)
-            rocks.update(camPos);
-
         // ====================================================================
         // PLAYER MOVEMENT WITH COLLISION
         // ====================================================================
@@ -751,7 +1007,7 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
             canMove = false;
         }
 
-        if (canMove && hasRocks && checkRockCollision(newPos, rockInstances, playerRadius))
+        if (canMove && hasRocks && checkRockCollision(newPos, rocks, playerRadius))
         {
             canMove = false;
         }
@@ -788,12 +1044,12 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
 
             bool canMoveX = true;
             if (checkLakeCollision(newPosX, lake, playerRadius)) canMoveX = false;
-            if (canMoveX && hasRocks && checkRockCollision(newPosX, rockInstances, playerRadius)) canMoveX = false;
+            if (canMoveX && hasRocks && checkRockCollision(newPosX, rocks, playerRadius)) canMoveX = false;
             if (newPosX.x < 1.0f || newPosX.x > terrainSizeX - 1.0f) canMoveX = false;
 
             bool canMoveZ = true;
             if (checkLakeCollision(newPosZ, lake, playerRadius)) canMoveZ = false;
-            if (canMoveZ && hasRocks && checkRockCollision(newPosZ, rockInstances, playerRadius)) canMoveZ = false;
+            if (canMoveZ && hasRocks && checkRockCollision(newPosZ, rocks, playerRadius)) canMoveZ = false;
             if (newPosZ.z < 1.0f || newPosZ.z > terrainSizeZ - 1.0f) canMoveZ = false;
 
             if (canMoveX) camPos.x = newPosX.x;
@@ -802,10 +1058,19 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
 
         camPos.y = groundY + eyeHeight + 5.0f;
 
+        // Benchmark: the spline replaces the player (warm-up frames hold the first point)
+        if (benchmark.enabled)
+        {
+            float t = benchmarkTime / benchmark.duration;
+            camPos = benchmarkPath.position(t);
+            forward = benchmarkPath.direction(t);
+        }
+
         // ====================================================================
         // UPDATE GUN STATE (before matrices so we can apply zoom offset)
         // ====================================================================
         modelState.update(window, gunAnim, dt);
+        trexHerd.update(dt);
         modelState.getGunOffset(gunX, gunY, gunZ, modelRotY);
 
         // ====================================================================
@@ -815,30 +1080,53 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         float zoomOffset = modelState.getCameraZoomOffset();
         Vec3 renderCamPos = camPos + forward * zoomOffset;
 
+        // Chunk residency changes land before any view culls grass/rocks this frame
+        if (streamVegetation)
+            vegStreamer.update(renderCamPos, hasGrass ? &grassField : nullptr, hasRocks ? &rocks : nullptr);
+
         float aspect = (float)WIDTH / (float)HEIGHT;
         Matrix pWorld = Matrix::perspective(0.01f, 10000.0f, aspect, 60.0f);
         Matrix vWorld = Matrix::lookAt(renderCamPos, renderCamPos + forward, worldUp);
         Matrix vpWorld = vWorld * pWorld;
 
+        // Picks up the newest finished pyramid readback for this frame's CPU chunk tests
+        occlusion.beginFrame(renderCamPos, forward);
+
         core.beginRenderPass();
 
         // ====================================================================
         // LAKE REFLECTION PASS
         // ====================================================================
-        sceneData.cameraPos = renderCamPos;
         sceneData.hasRocks = hasRocks;
         sceneData.hasGrass = hasGrass;
 
-        lake.beginReflectionPass(vWorld, pWorld, renderCamPos, RenderSceneForReflection, &sceneData);
+        {
+            ProfileScope scope("Reflection");
+            lake.beginReflectionPass(vWorld, pWorld, renderCamPos, RenderSceneForReflection, &sceneData);
+        }
+
+        // ====================================================================
+        // OCCLUSION PREPASS (serial, so every cull job below sees this frame's pyramid)
+        // ====================================================================
+        if (occlusion.enabled && occlusion.isReady())
+        {
+            ProfileScope scope("OcclusionPrepass");
+            CullView occluderView = CullView::main(vpWorld, renderCamPos);
+            Matrix terrainW;
+
+            occlusion.beginPrepass();
+            terrain.drawDepth(&core, &psos, occluderView, terrainW);
+            if (hasRocks)
+                rocks.drawDepth(&core, &psos, vpWorld, rocks.cullOccluders(&core, occluderView));
+            occlusion.endPrepass(vpWorld);
+        }
 
         core.setBackBufferRenderTarget();
-        core.setDefaultDescriptorHeaps();
         core.getCommandList()->SetGraphicsRootSignature(core.rootSignature);
 
         D3D12_VIEWPORT vp = { 0, 0, (float)WIDTH, (float)HEIGHT, 0, 1 };
         D3D12_RECT scissor = { 0, 0, (LONG)WIDTH, (LONG)HEIGHT };
-        core.getCommandList()->RSSetViewports(1, &vp);
-        core.getCommandList()->RSSetScissorRects(1, &scissor);
+        core.setViewport(vp, scissor);
 
         // ====================================================================
         // FOG CAPTURE BEGIN
@@ -851,53 +1139,84 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
         // ====================================================================
         // DRAW WORLD
         // ====================================================================
-        sky.draw(&core, &psos, &shaders, vpWorld, renderCamPos);
-
-        Matrix terrainW;
-        terrain.draw(&core, &psos, &shaders, vpWorld, terrainW);
+        // Each subsystem culls and records into its own command list on the thread pool; the lists
+        // execute in the order added, so sky still lands first and the water last.
+        CullView mainView = CullView::main(vpWorld, renderCamPos);
+        mainView.occlusion = occlusion.enabled ? &occlusion : nullptr;
+        float waterTime = totalTime;   // Water animates on last frame's clock, fog on this frame's
+        totalTime += dt;
 
+        sceneJobs.clear();
+        sceneJobs.add("Sky", [&]() { sky.draw(&core, &psos, &shaders, vpWorld, renderCamPos); });
+        sceneJobs.add("Terrain", [&]()
+            {
+                Matrix terrainW;
+                terrain.draw(&core, &psos, &shaders, mainView, terrainW);
+            });
         if (hasRocks)
-            rocks.draw(&core, &psos, &shaders, vpWorld, renderCamPos);
-
+            sceneJobs.add("Rocks", [&]() { rocks.draw(&core, &psos, &shaders, vpWorld, rocks.cull(&core, mainView)); });
         if (hasGrass)
-            grassField.draw(&core, &psos, &shaders, vpWorld, renderCamPos);
+            sceneJobs.add("Grass", [&]() { grassField.draw(&core, &psos, &shaders, vpWorld, grassField.cull(&core, mainView)); });
+        sceneJobs.add("LakeBottom", [&]() { lakeBottom.draw(&core, &psos, &shaders, vpWorld); });
+        sceneJobs.add("Tree", [&]() { tree.draw(&core, &psos, &shaders, vpWorld, renderCamPos); });
+        sceneJobs.add("Crowd", [&]() { trexHerd.draw(&core, &psos, &shaders, vpWorld); });
+        sceneJobs.add("Water", [&]() { lake.render(&core, &psos, &shaders, vpWorld, renderCamPos, waterTime); });
 
-        lakeBottom.draw(&core, &psos, &shaders, vpWorld);
-
-        tree.draw(&core, &psos, &shaders, vpWorld);
-
-        lake.render(&core, &psos, &shaders, vpWorld, renderCamPos, totalTime);
+        // ====================================================================
+        // FOG APPLY + GUN
+        // ====================================================================
+        // Recorded alongside the world (it only reads the scene targets on the GPU, after the lists above)
+        sceneJobs.add("PostAndGun", [&]()
+            {
+                if (fog.enabled)
+                {
+                    ProfileScope scope("Fog");
+                    fog.endSceneAndApplyFog(vWorld, pWorld, renderCamPos, totalTime);
+
+                    core.setBackBufferRenderTarget();
+                    core.getCommandList()->SetGraphicsRootSignature(core.rootSignature);
+                }
+
+                ProfileScope gunScope("Gun");
+                Matrix pGun = Matrix::perspective(0.001f, 1000.0f, aspect, 60.0f);
+                Matrix vpGun = pGun;
+                Matrix S = Matrix::scaling(gunScale);
+                Matrix R = Matrix::rotateZ(modelRotZ) * Matrix::rotateY(modelRotY) * Matrix::rotateX(modelRotX);
+                Matrix T = Matrix::translation(Vec3(gunX, gunY, gunZ));
+                Matrix Wgun = S * R * T;
+                gunModel.draw(&core, &psos, &shaders, &gunAnim, vpGun, Wgun);
+            });
+
+        sceneJobs.record(&core);
 
         // ====================================================================
-        // FOG APPLY
+        // UI (crosshair + profiler overlay)
         // ====================================================================
-        totalTime += dt;
-        if (fog.enabled)
         {
-            fog.endSceneAndApplyFog(vWorld, pWorld, renderCamPos, totalTime);
-
-            core.setBackBufferRenderTarget();
-            core.setDefaultDescriptorHeaps();
-            core.getCommandList()->SetGraphicsRootSignature(core.rootSignature);
+            ProfileScope scope("UI");
+            core.setBackBufferRenderTarget();   // The serial list resumes on the targets bound before the jobs
+            crosshair.draw(&core, &psos, &shaders);
+            Profiler::get().drawOverlay(&psos);
         }
 
-        // ====================================================================
-        // DRAW GUN
-        // ====================================================================
-        Matrix pGun = Matrix::perspective(0.001f, 1000.0f, aspect, 60.0f);
-        Matrix vpGun = pGun;
-        Matrix S = Matrix::scaling(gunScale);
-        Matrix R = Matrix::rotateZ(modelRotZ) * Matrix::rotateY(modelRotY) * Matrix::rotateX(modelRotX);
-        Matrix T = Matrix::translation(Vec3(gunX, gunY, gunZ));
-        Matrix Wgun = S * R * T;
-        gunModel.draw(&core, &psos, &shaders, &gunAnim, vpGun, Wgun);
+        Profiler::get().endFrame();
+        core.finishFrame();
 
-        // ====================================================================
-        // DRAW CROSSHAIR
-        // ====================================================================
-        crosshair.draw(&core, &psos, &shaders);
+        if (benchmark.enabled)
+        {
+            if (benchmarkFrame >= benchmark.warmupFrames)
+            {
+                benchmarkRecorder.addFrame(frameMs, Profiler::get().getLastFrame(), core.stats.drawCalls, core.stats.instances);
+                benchmarkTime += dt;
+            }
+            benchmarkFrame++;
 
-        core.finishFrame();
+            if (benchmarkTime >= benchmark.duration)
+            {
+                benchmarkCompleted = true;
+                break;
+            }
+        }
     }
 
     // ========================================================================
@@ -906,6 +1225,11 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nC
     g_lake = nullptr;
     core.flushGraphicsQueue();
 
+    if (benchmark.enabled)
+        benchmarkRecorder.writeReport(benchmark, benchmarkCompleted);
+
+    Profiler::get().release();
+
     std::cout << "\n========================================\n";
     std::cout << "   GAME ENDED\n";
     std::cout << "========================================\n";
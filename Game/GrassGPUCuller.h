@@ -0,0 +1,372 @@
+#pragma once
+
+#include "Core.h"
+#include "Maths.h"
+#include "Frustum.h"
+#include "CullView.h"
+#include "ShaderCache.h"
+#include "InstanceQuantization.h"
+#include "HiZOcclusion.h"
+#include <d3d12.h>
+#include <d3dcompiler.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+// Static per-instance record for GPU culling (matches CullInstance in CSGrassCull.txt)
+struct GrassCullInstance
+{
+    PackedInstance instance;    // Copied to the visible buffer as-is
+    unsigned int drawIndex;     // Flattened group/type index
+};
+
+// One indirect draw: mesh to use and the range it owns in the visible buffer
+struct GrassIndirectDraw
+{
+    unsigned int indexCount;
+    unsigned int firstInstance;  // First slot in the visible buffer
+    unsigned int maxInstances;   // Slots reserved for this draw
+};
+
+// GPU-driven grass culling: every instance lives in a default-heap buffer, a compute pass does the
+// frustum/distance test (plus the Hi-Z test when the view has a pyramid this frame) and appends
+// survivors, and draws are issued with ExecuteIndirect.
+// CPU cost per view is one dispatch plus one ExecuteIndirect per grass type, whatever the instance count.
+class GrassGPUCuller
+{
+public:
+    float bladeHeight = 1.5f;   // Per-unit-scale bounding sphere size (kept in sync by HybridGrassField)
+    InstanceQuantizer quantizer;    // How the instances were packed (set by HybridGrassField before init)
+
+    // Distance thinning and far meshes (kept in sync by HybridGrassField): densityParams as in VSGrass,
+    // instances beyond farMeshDistance append to draw DrawIndex + farDrawOffset (0: no far draws)
+    Vec4 densityParams = Vec4(1e30f, 1.0f, 1.0f, 1.0f);
+    float farMeshDistance = 1e30f;
+    unsigned int farDrawOffset = 0;
+
+    bool init(Core* core, const std::vector<GrassCullInstance>& instances,
+        const std::vector<GrassIndirectDraw>& draws)
+    {
+        this->core = core;
+        instanceCount = (unsigned int)instances.size();
+        drawCount = (unsigned int)draws.size();
+
+        if (instanceCount == 0 || drawCount == 0)
+            return false;
+
+        unsigned int visibleCapacity = 0;
+        for (const auto& d : draws)
+            visibleCapacity = std::max(visibleCapacity, d.firstInstance + d.maxInstances);
+
+        createRootSignature();
+        if (!loadShader())
+            return false;
+
+        createCommandSignature();
+        createBuffers(instances, draws, visibleCapacity);
+
+        initialized = true;
+        std::cout << "[GrassGPUCuller] Ready: " << instanceCount << " instances, "
+            << drawCount << " indirect draws\n";
+        return true;
+    }
+
+    bool isReady() const { return initialized; }
+
+    // Record culling for one view into the current command list
+    void cull(const CullView& view, float viewDistance)
+    {
+        if (!initialized) return;
+
+        auto cmdList = core->getCommandList();
+
+        // Constants go through the frame allocator, so in-flight frames keep their own copy
+        Frustum frustum(view.viewProj);
+        CullCB cb;
+        for (int i = 0; i < 6; i++)
+            cb.planes[i] = frustum.planes[i];
+        cb.cameraPos = Vec4(view.cameraPos.x, view.cameraPos.y, view.cameraPos.z, viewDistance);
+        float countBits;
+        memcpy(&countBits, &instanceCount, sizeof(float));
+        cb.params = Vec4(countBits, bladeHeight, 0.0f, 0.0f);
+        cb.chunkParams = quantizer.getChunkParams();
+        cb.heightParams = quantizer.getHeightParams();
+
+        // Occlusion against this frame's pyramid; without one, t1 gets any valid buffer and w = 0 skips it
+        bool occlusion = view.occlusion && view.occlusion->hasPyramid();
+        cb.viewProj = view.viewProj;
+        cb.hizParams = occlusion ? view.occlusion->getPyramidParams() : Vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        cb.hizParams.w = occlusion ? 1.0f : 0.0f;
+        memset(cb.hizOffsets, 0, sizeof(cb.hizOffsets));
+        if (occlusion)
+            memcpy(cb.hizOffsets, view.occlusion->getLevelOffsets(), sizeof(cb.hizOffsets));
+        cb.densityParams = densityParams;
+        float offsetBits;
+        memcpy(&offsetBits, &farDrawOffset, sizeof(float));
+        cb.farParams = Vec4(farMeshDistance, offsetBits, 0.0f, 0.0f);
+        D3D12_GPU_VIRTUAL_ADDRESS pyramid = occlusion ? view.occlusion->getPyramidAddress()
+            : instanceBuffer->GetGPUVirtualAddress();
+
+        D3D12_GPU_VIRTUAL_ADDRESS cullConstants = core->uploadConstants(&cb, sizeof(cb));
+
+        // Reset draw args (instance counts back to zero) from the static template
+        transition(drawArgsBuffer, drawArgsState, D3D12_RESOURCE_STATE_COPY_DEST);
+        cmdList->CopyBufferRegion(drawArgsBuffer, 0, drawArgsTemplate, 0, (UINT64)drawCount * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+
+        transition(drawArgsBuffer, drawArgsState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        transition(visibleBuffer, visibleState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        cmdList->SetComputeRootSignature(cullRootSignature);
+        cmdList->SetPipelineState(cullPSO);
+        cmdList->SetComputeRootConstantBufferView(0, cullConstants);
+        cmdList->SetComputeRootShaderResourceView(1, instanceBuffer->GetGPUVirtualAddress());
+        cmdList->SetComputeRootUnorderedAccessView(2, visibleBuffer->GetGPUVirtualAddress());
+        cmdList->SetComputeRootUnorderedAccessView(3, drawArgsBuffer->GetGPUVirtualAddress());
+        cmdList->SetComputeRootShaderResourceView(4, pyramid);
+        cmdList->Dispatch((instanceCount + 63) / 64, 1, 1);
+        core->countDispatch();
+
+        transition(drawArgsBuffer, drawArgsState, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        transition(visibleBuffer, visibleState, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    }
+
+    // Instance stream for the survivors (StartInstanceLocation selects each draw's range)
+    D3D12_VERTEX_BUFFER_VIEW getVisibleBufferView() const
+    {
+        D3D12_VERTEX_BUFFER_VIEW view;
+        view.BufferLocation = visibleBuffer->GetGPUVirtualAddress();
+        view.StrideInBytes = visibleStride;
+        view.SizeInBytes = visibleBufferSize;
+        return view;
+    }
+
+    // Issue one draw's indirect arguments (mesh VB/IB and texture must already be bound)
+    void drawIndirect(unsigned int drawIndex)
+    {
+        if (!initialized || drawIndex >= drawCount) return;
+
+        core->getCommandList()->ExecuteIndirect(commandSignature, 1, drawArgsBuffer,
+            (UINT64)drawIndex * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), nullptr, 0);
+        core->countDraw(0);   // Instance count is only known on the GPU
+    }
+
+    ~GrassGPUCuller()
+    {
+        if (instanceBuffer) instanceBuffer->Release();
+        if (visibleBuffer) visibleBuffer->Release();
+        if (drawArgsBuffer) drawArgsBuffer->Release();
+        if (drawArgsTemplate) drawArgsTemplate->Release();
+        if (commandSignature) commandSignature->Release();
+        if (cullPSO) cullPSO->Release();
+        if (cullRootSignature) cullRootSignature->Release();
+        if (csBlob) csBlob->Release();
+    }
+
+private:
+    Core* core = nullptr;
+    bool initialized = false;
+
+    unsigned int instanceCount = 0;
+    unsigned int drawCount = 0;
+    unsigned int visibleBufferSize = 0;
+
+    ID3D12Resource* instanceBuffer = nullptr;     // All instances (static, SRV)
+    ID3D12Resource* visibleBuffer = nullptr;      // Survivors (UAV -> vertex buffer)
+    ID3D12Resource* drawArgsBuffer = nullptr;     // Indirect args (UAV -> indirect argument)
+    ID3D12Resource* drawArgsTemplate = nullptr;   // Args with zero instance counts (copy source)
+
+    D3D12_RESOURCE_STATES visibleState = D3D12_RESOURCE_STATE_COMMON;
+    D3D12_RESOURCE_STATES drawArgsState = D3D12_RESOURCE_STATE_COMMON;
+
+    ID3D12RootSignature* cullRootSignature = nullptr;
+    ID3D12PipelineState* cullPSO = nullptr;
+    ID3D12CommandSignature* commandSignature = nullptr;
+    ID3DBlob* csBlob = nullptr;
+
+    static const unsigned int visibleStride = sizeof(PackedInstance);  // GrassInstanceGPU
+
+    struct CullCB
+    {
+        Vec4 planes[6];         // Frustum planes
+        Vec4 cameraPos;         // xyz=camera, w=view distance
+        Vec4 params;            // x=instance count (uint bits), y=blade height
+        Vec4 chunkParams;       // Quantizer chunk grid
+        Vec4 heightParams;      // Quantizer height range
+        Matrix viewProj;        // Hi-Z projection (same packing as the VS constants)
+        Vec4 hizParams;         // x=width, y=height, z=levels, w=1 when testing
+        unsigned int hizOffsets[HiZOcclusion::MAX_LEVELS];
+        Vec4 densityParams;     // x=falloff start, y=exponent, z=min density
+        Vec4 farParams;         // x=far mesh distance, y=far draw offset (uint bits)
+    };
+
+    void transition(ID3D12Resource* res, D3D12_RESOURCE_STATES& state, D3D12_RESOURCE_STATES target)
+    {
+        if (state == target) return;
+        Barrier::add(res, state, target, core->getCommandList());
+        state = target;
+    }
+
+    void createRootSignature()
+    {
+        // Root descriptors only, so the culler never touches the shared SRV heap
+        D3D12_ROOT_PARAMETER params[5] = {};
+
+        params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // b0
+        params[0].Descriptor.ShaderRegister = 0;
+        params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV; // t0 instances
+        params[1].Descriptor.ShaderRegister = 0;
+        params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV; // u0 visible instances
+        params[2].Descriptor.ShaderRegister = 0;
+        params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV; // u1 draw args
+        params[3].Descriptor.ShaderRegister = 1;
+        params[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV; // t1 Hi-Z pyramid
+        params[4].Descriptor.ShaderRegister = 1;
+        params[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
+        rsDesc.NumParameters = 5;
+        rsDesc.pParameters = params;
+
+        ID3DBlob* signature = nullptr;
+        ID3DBlob* error = nullptr;
+        D3D12SerializeRootSignature(&rsDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
+
+        if (error)
+        {
+            std::cout << "[GrassGPUCuller] Root signature error: " << (char*)error->GetBufferPointer() << "\n";
+            error->Release();
+        }
+
+        core->device->CreateRootSignature(0, signature->GetBufferPointer(),
+            signature->GetBufferSize(), IID_PPV_ARGS(&cullRootSignature));
+
+        if (signature) signature->Release();
+    }
+
+    bool loadShader()
+    {
+        std::ifstream file("Shaders/CSGrassCull.txt");
+        if (!file.is_open())
+        {
+            std::cout << "[GrassGPUCuller] ERROR: Cannot open shader file: Shaders/CSGrassCull.txt\n";
+            return false;
+        }
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string source = buffer.str();
+
+        ID3DBlob* error = nullptr;
+        HRESULT hr = ShaderCache::compile(source, "CSGrassCull", "main", "cs_5_0",
+            D3DCOMPILE_OPTIMIZATION_LEVEL3, &csBlob, &error);
+
+        if (FAILED(hr) || error)
+        {
+            std::cout << "[GrassGPUCuller] Shader compile error (CSGrassCull): "
+                << (error ? (char*)error->GetBufferPointer() : "Unknown") << "\n";
+            if (error) error->Release();
+            if (FAILED(hr)) return false;
+        }
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = cullRootSignature;
+        psoDesc.CS = { csBlob->GetBufferPointer(), csBlob->GetBufferSize() };
+
+        cullPSO = core->pipelineCache.createCompute("GrassCull", psoDesc);
+        if (cullPSO == nullptr)
+        {
+            std::cout << "[GrassGPUCuller] ERROR: Failed to create compute PSO\n";
+            return false;
+        }
+        return true;
+    }
+
+    void createCommandSignature()
+    {
+        // Plain DrawIndexed arguments; VB/IB/texture are bound per type before each ExecuteIndirect
+        D3D12_INDIRECT_ARGUMENT_DESC arg = {};
+        arg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+        D3D12_COMMAND_SIGNATURE_DESC desc = {};
+        desc.ByteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+        desc.NumArgumentDescs = 1;
+        desc.pArgumentDescs = &arg;
+
+        core->device->CreateCommandSignature(&desc, nullptr, IID_PPV_ARGS(&commandSignature));
+    }
+
+    ID3D12Resource* createBuffer(UINT64 size, D3D12_HEAP_TYPE heap, D3D12_RESOURCE_STATES state,
+        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
+    {
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = heap;
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        desc.Width = size;
+        desc.Height = 1;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.SampleDesc.Count = 1;
+        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        desc.Flags = flags;
+
+        ID3D12Resource* buffer = nullptr;
+        HRESULT hr = core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+            state, nullptr, IID_PPV_ARGS(&buffer));
+
+        if (FAILED(hr))
+        {
+            std::cout << "[GrassGPUCuller] ERROR: Failed to create buffer (" << size << " bytes)\n";
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    void createBuffers(const std::vector<GrassCullInstance>& instances,
+        const std::vector<GrassIndirectDraw>& draws, unsigned int visibleCapacity)
+    {
+        // Static instance data (uploaded once)
+        UINT64 instanceSize = (UINT64)instances.size() * sizeof(GrassCullInstance);
+        instanceBuffer = createBuffer(instanceSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST);
+        core->uploadResource(instanceBuffer, instances.data(), (unsigned int)instanceSize,
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        // Survivor buffer: each draw owns [firstInstance, firstInstance + maxInstances)
+        visibleBufferSize = visibleCapacity * visibleStride;
+        visibleBuffer = createBuffer(visibleBufferSize, D3D12_HEAP_TYPE_DEFAULT,
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+        // Draw args template: everything filled in except InstanceCount
+        std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> args(draws.size());
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            args[i].IndexCountPerInstance = draws[i].indexCount;
+            args[i].InstanceCount = 0;
+            args[i].StartIndexLocation = 0;
+            args[i].BaseVertexLocation = 0;
+            args[i].StartInstanceLocation = draws[i].firstInstance;
+        }
+
+        UINT64 argsSize = (UINT64)args.size() * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+        drawArgsTemplate = createBuffer(argsSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST);
+        core->uploadResource(drawArgsTemplate, args.data(), (unsigned int)argsSize,
+            D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+        drawArgsBuffer = createBuffer(argsSize, D3D12_HEAP_TYPE_DEFAULT,
+            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    }
+};
@@ -19,6 +19,12 @@ public:
     std::string shaderName = "AnimatedTextured";   // Shader key
     std::string psoName = "AnimatedTexturedPSO";   // PSO key
 
+    Shader* shader = nullptr;                      // Resolved once in load()
+    PSOHandle pso = INVALID_PSO;                   // Resolved once in load()
+    ConstantHandle worldConstant;                  // staticMeshBuffer.W
+    ConstantHandle vpConstant;                     // staticMeshBuffer.VP
+    ConstantHandle bonesConstant;                  // staticMeshBuffer.bones
+
     void load(Core* core, std::string modelFilename, std::string textureFilename,
         PSOManager* psos, Shaders* shaders)
     {
@@ -45,67 +51,32 @@ public:
         gunTexture = core->loadTexture(textureFilename); // GPU texture + SRV handle
 
         shaders->load(core, shaderName, "Shaders/VSAnim.txt", "Shaders/PSAnim.txt"); // Skinning VS + textured PS
+        shader = shaders->find(shaderName);
+        worldConstant = shader->getConstantVS("staticMeshBuffer", "W");
+        vpConstant = shader->getConstantVS("staticMeshBuffer", "VP");
+        bonesConstant = shader->getConstantVS("staticMeshBuffer", "bones");
 
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
             VertexLayoutCache::getAnimatedLayout()); // ANIMATED_VERTEX input layout
 
-        memcpy(&animation.skeleton.globalInverse, &gemanimation.globalInverse, 16 * sizeof(float)); // Importer root inverse
-
-        // Copy bone hierarchy + inverse bind offsets
-        for (int i = 0; i < gemanimation.bones.size(); i++)
-        {
-            Bone bone;
-            bone.name = gemanimation.bones[i].name;
-            memcpy(&bone.offset, &gemanimation.bones[i].offset, 16 * sizeof(float));
-            bone.parentIndex = gemanimation.bones[i].parentIndex;
-            animation.skeleton.bones.push_back(bone);
-        }
-
-        // Copy animation clips (per-frame per-bone TRS)
-        for (int i = 0; i < gemanimation.animations.size(); i++)
-        {
-            std::string name = gemanimation.animations[i].name;
-            AnimationSequence aseq;
-            aseq.ticksPerSecond = gemanimation.animations[i].ticksPerSecond;
-
-            for (int j = 0; j < gemanimation.animations[i].frames.size(); j++)
-            {
-                AnimationFrame frame;
-                for (int index = 0; index < gemanimation.animations[i].frames[j].positions.size(); index++)
-                {
-                    Vec3 p;
-                    Quaternion q;
-                    Vec3 s;
-                    memcpy(&p, &gemanimation.animations[i].frames[j].positions[index], sizeof(Vec3));
-                    frame.positions.push_back(p);
-                    memcpy(&q, &gemanimation.animations[i].frames[j].rotations[index], sizeof(Quaternion));
-                    frame.rotations.push_back(q);
-                    memcpy(&s, &gemanimation.animations[i].frames[j].scales[index], sizeof(Vec3));
-                    frame.scales.push_back(s);
-                }
-                aseq.frames.push_back(frame);
-            }
-            animation.animations.insert({ name, aseq }); // Register clip by name
-        }
+        animation.load(gemanimation); // Skeleton + clips, resolved to handles
     }
 
     void updateWorld(Shaders* shaders, Matrix& w)
     {
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", &w); // Update model transform
+        worldConstant.set(&w); // Update model transform
     }
 
     void draw(Core* core, PSOManager* psos, Shaders* shaders,
         AnimationInstance* instance, Matrix& vp, Matrix& w)
     {
-        psos->bind(core, psoName); // Bind pipeline state for skinned textured draw
+        psos->bind(core, pso); // Bind pipeline state for skinned textured draw
 
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", &w);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", &vp);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "bones", instance->matrices); // Bone palette
+        worldConstant.set(&w);
+        vpConstant.set(&vp);
+        bonesConstant.set(instance->matrices); // Bone palette
 
-        shaders->apply(core, shaderName); // Bind root signature + constant buffers
+        shader->apply(core); // Bind root signature + constant buffers
 
         core->getCommandList()->SetGraphicsRootDescriptorTable(2, gunTexture.srvHandle); // Bind texture SRV table
 
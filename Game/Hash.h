@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// 64-bit FNV-1a over a byte range; pass a previous result as hash to chain several ranges
+inline unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
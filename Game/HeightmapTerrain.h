@@ -5,12 +5,15 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <emmintrin.h>
 
 #include "Core.h"
 #include "Shaders.h"
 #include "PSO.h"
 #include "Mesh.h"
 #include "Maths.h"
+#include "Frustum.h"
+#include "CullView.h"
 #include "stb_image.h"
 
 // ============================================================================
@@ -19,6 +22,7 @@
 // - Loads height data from RAW / PNG heightmaps
 // - Converts height samples into world-space terrain heights
 // - Builds a grid mesh with computed normals and tangents
+// - Splits it into patches with distance LOD (geomipmapping, stitched edges)
 // - Renders terrain with simple lighting and height-based colour blending
 // - Provides CPU-side height sampling for camera, grass, collision, etc.
 // ============================================================================
@@ -77,10 +81,11 @@ public:
             return false;
         }
 
-        // Build terrain mesh from height samples
+        // Build terrain mesh from height samples (per-patch LOD index ranges)
         std::vector<STATIC_VERTEX> vertices;
         std::vector<unsigned int> indices;
         buildTerrainMesh(vertices, indices);
+        buildTiles();
 
         // Upload mesh to GPU
         mesh.init(core, vertices, indices);
@@ -93,9 +98,17 @@ public:
             "Shaders/VSTerrain.txt",
             "Shaders/PSTerrain.txt");
 
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("staticMeshBuffer", "VP");
+        worldConstant = shader->getConstantVS("staticMeshBuffer", "W");
+        lightConstant = shader->getConstantPS("terrainPSBuffer", "lightDir_ambient");
+        colorLowConstant = shader->getConstantPS("terrainPSBuffer", "baseColorLow");
+        colorHighConstant = shader->getConstantPS("terrainPSBuffer", "baseColorHigh");
+        heightParamsConstant = shader->getConstantPS("terrainPSBuffer", "heightParams");
+
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
+            VertexLayoutCache::getStaticLayout());
+        depthPso = psos->createDepthOnlyPSO(core, psoName + "Depth", shader->vs,
             VertexLayoutCache::getStaticLayout());
 
         return true;
@@ -104,39 +117,58 @@ public:
     // ------------------------------------------------------------------------
     // draw
     // ------------------------------------------------------------------------
+    // - Picks a LOD per patch from its distance to the camera (view.minLOD and
+    //   view.distanceScale make the reflection pass coarser)
     // - Updates VS constants (W, VP)
     // - Sends lighting and height-blending parameters to PS
-    // - Binds texture and draws terrain mesh
+    // - Binds texture and draws the patches that intersect the view frustum
     // ------------------------------------------------------------------------
     void draw(Core* core, PSOManager* psos, Shaders* shaders,
-        const Matrix& vp, const Matrix& world)
+        const CullView& view, const Matrix& world)
     {
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", (void*)&world);
+        drawPatches(core, psos, view, world, pso);
+    }
 
-        // Directional light + ambient term
-        Vec4 lightDirAmbient(0.3f, 0.9f, 0.2f, 0.25f);
-        Vec4 lowCol(0.10f, 0.35f, 0.10f, 1.0f);   // Low altitude colour
-        Vec4 highCol(0.45f, 0.45f, 0.45f, 1.0f);  // High altitude colour
-        Vec4 heightParams(minHeightWorld, maxHeightWorld, 0.0f, 0.0f);
+    // Same patches and LODs, depth only (occlusion prepass; the bound target must be D32)
+    void drawDepth(Core* core, PSOManager* psos, const CullView& view, const Matrix& world)
+    {
+        drawPatches(core, psos, view, world, depthPso);
+    }
 
-        shaders->updateConstantPS(shaderName, "terrainPSBuffer",
-            "lightDir_ambient", &lightDirAmbient);
-        shaders->updateConstantPS(shaderName, "terrainPSBuffer",
-            "baseColorLow", &lowCol);
-        shaders->updateConstantPS(shaderName, "terrainPSBuffer",
-            "baseColorHigh", &highCol);
-        shaders->updateConstantPS(shaderName, "terrainPSBuffer",
-            "heightParams", &heightParams);
+    // ------------------------------------------------------------------------
+    // getHeightRange
+    // ------------------------------------------------------------------------
+    // Min/max world height of all samples inside a world-space XZ rectangle.
+    // Used to build tight vertical bounds for culling chunks that sit on the terrain.
+    // ------------------------------------------------------------------------
+    void getHeightRange(float minX, float minZ, float maxX, float maxZ,
+        float& outMin, float& outMax) const
+    {
+        int x0, z0, x1, z1;
+        worldToSample(minX, minZ, x0, z0);
+        worldToSample(maxX, maxZ, x1, z1);
 
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        // Include the neighbouring samples so bilinear heights between them are covered
+        x0 = std::max(x0 - 1, 0); z0 = std::max(z0 - 1, 0);
+        x1 = std::min(x1 + 1, hmW - 1); z1 = std::min(z1 + 1, hmH - 1);
 
-        // Bind terrain texture SRV
-        core->getCommandList()->SetGraphicsRootDescriptorTable(
-            2, terrainTexture.srvHandle);
+        outMin = 1e9f;
+        outMax = -1e9f;
+        for (int z = z0; z <= z1; ++z)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                float h = heightAt(x, z);
+                outMin = std::min(outMin, h);
+                outMax = std::max(outMax, h);
+            }
+        }
 
-        mesh.draw(core);
+        if (outMin > outMax)
+        {
+            outMin = minHeightWorld;
+            outMax = maxHeightWorld;
+        }
     }
 
     // ------------------------------------------------------------------------
@@ -178,8 +210,74 @@ public:
         return (h0 * (1.0f - tz) + h1 * tz);
     }
 
+    // ------------------------------------------------------------------------
+    // sampleHeightWorld4
+    // ------------------------------------------------------------------------
+    // SSE version of sampleHeightWorld for 4 points (vegetation placement).
+    // Same operations in the same order, so each lane matches the scalar call
+    // exactly; only the 16 texel fetches are scalar.
+    // ------------------------------------------------------------------------
+    void sampleHeightWorld4(const float* worldPosX, const float* worldPosZ, float* outHeights) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        __m128 fx = _mm_div_ps(_mm_add_ps(_mm_loadu_ps(worldPosX), _mm_set1_ps(worldX * 0.5f)), _mm_set1_ps(worldX));
+        __m128 fz = _mm_div_ps(_mm_add_ps(_mm_loadu_ps(worldPosZ), _mm_set1_ps(worldZ * 0.5f)), _mm_set1_ps(worldZ));
+        fx = _mm_min_ps(_mm_max_ps(fx, zero), one);
+        fz = _mm_min_ps(_mm_max_ps(fz, zero), one);
+
+        __m128 x = _mm_mul_ps(fx, _mm_set1_ps((float)(hmW - 1)));
+        __m128 z = _mm_mul_ps(fz, _mm_set1_ps((float)(hmH - 1)));
+
+        // Both are >= 0 here, so truncation is floor
+        __m128i x0 = _mm_cvttps_epi32(x);
+        __m128i z0 = _mm_cvttps_epi32(z);
+        __m128 tx = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+        __m128 tz = _mm_sub_ps(z, _mm_cvtepi32_ps(z0));
+
+        alignas(16) int xi[4], zi[4];
+        _mm_store_si128((__m128i*)xi, x0);
+        _mm_store_si128((__m128i*)zi, z0);
+
+        alignas(16) float h00[4], h10[4], h01[4], h11[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int x1 = std::min(xi[i] + 1, hmW - 1);
+            int z1 = std::min(zi[i] + 1, hmH - 1);
+            h00[i] = heightAt(xi[i], zi[i]);
+            h10[i] = heightAt(x1, zi[i]);
+            h01[i] = heightAt(xi[i], z1);
+            h11[i] = heightAt(x1, z1);
+        }
+
+        __m128 itx = _mm_sub_ps(one, tx);
+        __m128 h0 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(h00), itx), _mm_mul_ps(_mm_load_ps(h10), tx));
+        __m128 h1 = _mm_add_ps(_mm_mul_ps(_mm_load_ps(h01), itx), _mm_mul_ps(_mm_load_ps(h11), tx));
+        __m128 itz = _mm_sub_ps(one, tz);
+        _mm_storeu_ps(outHeights, _mm_add_ps(_mm_mul_ps(h0, itz), _mm_mul_ps(h1, tz)));
+    }
+
+    // Raw world-space height samples (row-major, hmW x hmH), e.g. for hashing into cache keys
+    const std::vector<float>& getHeights() const { return heights; }
+
+    // Distance LOD: patches closer than lodDistance use every sample, each doubling of the
+    // distance beyond it halves the sample density (up to LOD_COUNT - 1)
+    float lodDistance = 40.0f;
+
 private:
-    Mesh mesh; // Terrain grid mesh
+    Mesh mesh; // Terrain grid mesh (full-resolution vertices, per-LOD index ranges)
+
+    // Shader, PSO and constants resolved once at init
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    PSOHandle depthPso = INVALID_PSO;         // Same VS, no PS (occluder prepass)
+    ConstantHandle vpConstant;
+    ConstantHandle worldConstant;
+    ConstantHandle lightConstant;
+    ConstantHandle colorLowConstant;
+    ConstantHandle colorHighConstant;
+    ConstantHandle heightParamsConstant;
 
     int hmW = 0;
     int hmH = 0;
@@ -195,6 +293,94 @@ private:
     float minHeightWorld = 0.0f;
     float maxHeightWorld = 1.0f;
 
+    // Geomipmapped patches: tileQuads x tileQuads grid cells each, culled and LOD'd individually.
+    // LOD l samples every (1 << l)th vertex; neighbouring patches differ by at most one LOD.
+    static const int tileQuads = 32;
+    static const int LOD_COUNT = 4;
+    static const int EDGE_VARIANTS = 16;
+
+    // Edge mask bits: that neighbour is one LOD coarser, so the edge is stitched to its spacing
+    static const int EDGE_NEG_X = 1;
+    static const int EDGE_POS_X = 2;
+    static const int EDGE_NEG_Z = 4;
+    static const int EDGE_POS_Z = 8;
+
+    // Index ranges shared by every patch with the same quad extent. Only the last column/row of
+    // patches can be smaller than tileQuads, so there are at most four shapes.
+    struct PatchShape
+    {
+        int quadsX = 0;
+        int quadsZ = 0;
+        unsigned int start[LOD_COUNT][EDGE_VARIANTS];
+        unsigned int count[LOD_COUNT][EDGE_VARIANTS];
+    };
+    std::vector<PatchShape> patchShapes;
+
+    int tilesX = 0;
+    int tilesZ = 0;
+    BoundsSoA tileBounds;
+    std::vector<int> tileShape;             // Index into patchShapes
+    std::vector<int> tileBaseVertex;        // Vertex of the patch's (minX, minZ) corner
+    std::vector<unsigned char> tileVisible;
+    std::vector<unsigned char> tileLOD;
+
+    // Shared by draw and drawDepth: cull + LOD select, constants, one draw per visible patch
+    void drawPatches(Core* core, PSOManager* psos, const CullView& view, const Matrix& world, PSOHandle patchPso)
+    {
+        // Frustum and camera in terrain-local space (patch bounds are local); WVP = world then VP
+        Matrix worldCopy = world;
+        Matrix vpCopy = view.viewProj;
+        Frustum frustum(worldCopy * vpCopy);
+        frustum.cullAABBs(tileBounds, tileVisible.data());
+
+        Matrix invWorld = worldCopy.invert();
+        selectLODs(invWorld.mulPoint(view.cameraPos), view.distanceScale, view.minLOD);
+
+        vpConstant.set(&view.viewProj);
+        worldConstant.set(&world);
+
+        // Directional light + ambient term
+        Vec4 lightDirAmbient(0.3f, 0.9f, 0.2f, 0.25f);
+        Vec4 lowCol(0.10f, 0.35f, 0.10f, 1.0f);   // Low altitude colour
+        Vec4 highCol(0.45f, 0.45f, 0.45f, 1.0f);  // High altitude colour
+        Vec4 heightParams(minHeightWorld, maxHeightWorld, 0.0f, 0.0f);
+
+        lightConstant.set(&lightDirAmbient);
+        colorLowConstant.set(&lowCol);
+        colorHighConstant.set(&highCol);
+        heightParamsConstant.set(&heightParams);
+
+        shader->apply(core);
+        psos->bind(core, patchPso);
+
+        // Bind terrain texture SRV
+        core->getCommandList()->SetGraphicsRootDescriptorTable(
+            2, terrainTexture.srvHandle);
+
+        // One draw per visible patch: the shared index range for its shape/LOD/edge mask,
+        // offset onto the patch's corner in the full-resolution vertex grid
+        mesh.bind(core);
+        for (int t = 0; t < tileBounds.count; t++)
+        {
+            if (!tileVisible[t])
+                continue;
+
+            const PatchShape& shape = patchShapes[tileShape[t]];
+            int lod = tileLOD[t];
+            int mask = edgeMask(t);
+            mesh.drawIndices(core, shape.start[lod][mask], shape.count[lod][mask], tileBaseVertex[t]);
+        }
+    }
+
+    // World XZ -> nearest-lower heightmap sample (clamped)
+    void worldToSample(float wx, float wz, int& sx, int& sz) const
+    {
+        float fx = std::clamp((wx + worldX * 0.5f) / worldX, 0.0f, 1.0f);
+        float fz = std::clamp((wz + worldZ * 0.5f) / worldZ, 0.0f, 1.0f);
+        sx = (int)floorf(fx * (hmW - 1));
+        sz = (int)floorf(fz * (hmH - 1));
+    }
+
     // Safe height lookup with clamping
     float heightAt(int x, int z) const
     {
@@ -423,25 +609,211 @@ private:
             }
         }
 
-        outI.reserve((size_t)(hmW - 1) * (size_t)(hmH - 1) * 6);
+        // Patch grid; every patch references its shape's index ranges through a base vertex
+        tilesX = (hmW - 2) / tileQuads + 1;
+        tilesZ = (hmH - 2) / tileQuads + 1;
+
+        patchShapes.clear();
+        tileShape.clear();
+        tileBaseVertex.clear();
 
-        for (int z = 0; z < hmH - 1; ++z)
+        for (int tz = 0; tz < hmH - 1; tz += tileQuads)
         {
-            for (int x = 0; x < hmW - 1; ++x)
+            for (int tx = 0; tx < hmW - 1; tx += tileQuads)
             {
-                unsigned int i0 = (unsigned int)(z * hmW + x);
-                unsigned int i1 = i0 + 1;
-                unsigned int i2 = (unsigned int)((z + 1) * hmW + x);
-                unsigned int i3 = i2 + 1;
-
-                outI.push_back(i0);
-                outI.push_back(i1);
-                outI.push_back(i2);
-
-                outI.push_back(i1);
-                outI.push_back(i3);
-                outI.push_back(i2);
+                int quadsX = std::min(tileQuads, hmW - 1 - tx);
+                int quadsZ = std::min(tileQuads, hmH - 1 - tz);
+
+                tileShape.push_back(findOrBuildShape(quadsX, quadsZ, outI));
+                tileBaseVertex.push_back(tz * hmW + tx);
             }
         }
     }
+
+    int findOrBuildShape(int quadsX, int quadsZ, std::vector<unsigned int>& outI)
+    {
+        for (size_t i = 0; i < patchShapes.size(); i++)
+        {
+            if (patchShapes[i].quadsX == quadsX && patchShapes[i].quadsZ == quadsZ)
+                return (int)i;
+        }
+
+        PatchShape shape;
+        shape.quadsX = quadsX;
+        shape.quadsZ = quadsZ;
+        for (int lod = 0; lod < LOD_COUNT; lod++)
+        {
+            for (int mask = 0; mask < EDGE_VARIANTS; mask++)
+            {
+                shape.start[lod][mask] = (unsigned int)outI.size();
+                buildPatchIndices(quadsX, quadsZ, 1 << lod, mask, outI);
+                shape.count[lod][mask] = (unsigned int)outI.size() - shape.start[lod][mask];
+            }
+        }
+
+        patchShapes.push_back(shape);
+        return (int)patchShapes.size() - 1;
+    }
+
+    // Sample positions along one patch axis at a given step; the far edge is always included
+    static void patchAxis(int quads, int step, std::vector<int>& out)
+    {
+        out.clear();
+        for (int p = 0; p < quads; p += step)
+            out.push_back(p);
+        out.push_back(quads);
+    }
+
+    // Snap an edge position onto the spacing of a neighbour one LOD coarser. The result is one of
+    // the neighbour's own edge samples, so both sides share vertices and no crack can open.
+    static int snapToCoarser(int p, int quads, int coarseStep)
+    {
+        return (p == quads) ? quads : (p / coarseStep) * coarseStep;
+    }
+
+    // Indices (relative to the patch corner vertex) for one patch at `step`, with the edges in
+    // `mask` stitched. Stitching collapses alternate edge vertices, leaving degenerate triangles
+    // that are dropped here.
+    void buildPatchIndices(int quadsX, int quadsZ, int step, int mask, std::vector<unsigned int>& outI) const
+    {
+        std::vector<int> xs, zs;
+        patchAxis(quadsX, step, xs);
+        patchAxis(quadsZ, step, zs);
+
+        int coarseStep = step * 2;
+        auto vertexIndex = [&](int x, int z)
+            {
+                if (z == 0 && (mask & EDGE_NEG_Z))      x = snapToCoarser(x, quadsX, coarseStep);
+                if (z == quadsZ && (mask & EDGE_POS_Z)) x = snapToCoarser(x, quadsX, coarseStep);
+                if (x == 0 && (mask & EDGE_NEG_X))      z = snapToCoarser(z, quadsZ, coarseStep);
+                if (x == quadsX && (mask & EDGE_POS_X)) z = snapToCoarser(z, quadsZ, coarseStep);
+                return (unsigned int)(z * hmW + x);
+            };
+
+        auto emit = [&](unsigned int a, unsigned int b, unsigned int c)
+            {
+                if (a == b || b == c || a == c)
+                    return;
+                outI.push_back(a);
+                outI.push_back(b);
+                outI.push_back(c);
+            };
+
+        for (size_t j = 0; j + 1 < zs.size(); ++j)
+        {
+            for (size_t i = 0; i + 1 < xs.size(); ++i)
+            {
+                unsigned int i0 = vertexIndex(xs[i], zs[j]);
+                unsigned int i1 = vertexIndex(xs[i + 1], zs[j]);
+                unsigned int i2 = vertexIndex(xs[i], zs[j + 1]);
+                unsigned int i3 = vertexIndex(xs[i + 1], zs[j + 1]);
+
+                emit(i0, i1, i2);
+                emit(i1, i3, i2);
+            }
+        }
+    }
+
+    // Per-patch LOD from the distance between the camera and the patch bounds, then limited so
+    // no patch is more than one LOD coarser than any neighbour (what the stitching supports)
+    void selectLODs(const Vec3& localCameraPos, float distanceScale, int minLOD)
+    {
+        float baseDistance = lodDistance * distanceScale;
+        int finest = std::clamp(minLOD, 0, LOD_COUNT - 1);
+
+        for (int t = 0; t < tileBounds.count; t++)
+        {
+            float cx = std::clamp(localCameraPos.x, tileBounds.minX[t], tileBounds.maxX[t]);
+            float cy = std::clamp(localCameraPos.y, tileBounds.minY[t], tileBounds.maxY[t]);
+            float cz = std::clamp(localCameraPos.z, tileBounds.minZ[t], tileBounds.maxZ[t]);
+            float dist = (Vec3(cx, cy, cz) - localCameraPos).length();
+
+            int lod = 0;
+            float limit = baseDistance;
+            while (lod < LOD_COUNT - 1 && dist >= limit)
+            {
+                lod++;
+                limit *= 2.0f;
+            }
+            tileLOD[t] = (unsigned char)std::max(lod, finest);
+        }
+
+        // Only ever lowers LODs, so this settles after a few passes
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (int tz = 0; tz < tilesZ; tz++)
+            {
+                for (int tx = 0; tx < tilesX; tx++)
+                {
+                    int t = tz * tilesX + tx;
+                    int limit = LOD_COUNT;
+                    if (tx > 0)          limit = std::min(limit, tileLOD[t - 1] + 1);
+                    if (tx < tilesX - 1) limit = std::min(limit, tileLOD[t + 1] + 1);
+                    if (tz > 0)          limit = std::min(limit, tileLOD[t - tilesX] + 1);
+                    if (tz < tilesZ - 1) limit = std::min(limit, tileLOD[t + tilesX] + 1);
+
+                    if (tileLOD[t] > limit)
+                    {
+                        tileLOD[t] = (unsigned char)limit;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Edges of patch t whose neighbour is one LOD coarser
+    int edgeMask(int t) const
+    {
+        int tx = t % tilesX;
+        int tz = t / tilesX;
+        int coarser = tileLOD[t] + 1;
+
+        int mask = 0;
+        if (tx > 0 && tileLOD[t - 1] == coarser)               mask |= EDGE_NEG_X;
+        if (tx < tilesX - 1 && tileLOD[t + 1] == coarser)      mask |= EDGE_POS_X;
+        if (tz > 0 && tileLOD[t - tilesX] == coarser)          mask |= EDGE_NEG_Z;
+        if (tz < tilesZ - 1 && tileLOD[t + tilesX] == coarser) mask |= EDGE_POS_Z;
+        return mask;
+    }
+
+    // Bounds for every patch, in tileShape order
+    void buildTiles()
+    {
+        tileBounds.clear();
+
+        float dx = worldX / (float)(hmW - 1);
+        float dz = worldZ / (float)(hmH - 1);
+        float halfX = worldX * 0.5f;
+        float halfZ = worldZ * 0.5f;
+
+        for (int tz = 0; tz < hmH - 1; tz += tileQuads)
+        {
+            for (int tx = 0; tx < hmW - 1; tx += tileQuads)
+            {
+                int zEnd = std::min(tz + tileQuads, hmH - 1);
+                int xEnd = std::min(tx + tileQuads, hmW - 1);
+
+                float hMin = 1e9f, hMax = -1e9f;
+                for (int z = tz; z <= zEnd; ++z)
+                {
+                    for (int x = tx; x <= xEnd; ++x)
+                    {
+                        float h = heightAt(x, z);
+                        hMin = std::min(hMin, h);
+                        hMax = std::max(hMax, h);
+                    }
+                }
+
+                tileBounds.add(
+                    Vec3((float)tx * dx - halfX, hMin, (float)tz * dz - halfZ),
+                    Vec3((float)xEnd * dx - halfX, hMax, (float)zEnd * dz - halfZ));
+            }
+        }
+
+        tileVisible.assign(tileBounds.paddedCount(), 1);
+        tileLOD.assign(tileBounds.count, 0);
+    }
 };
@@ -0,0 +1,515 @@
+#pragma once
+
+#include "Core.h"
+#include "Maths.h"
+#include "Frustum.h"
+#include "ShaderCache.h"
+#include <d3d12.h>
+#include <d3dcompiler.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+// ============================================================================
+// HiZOcclusion
+// ----------------------------------------------------------------------------
+// Occluders (terrain + large rocks) are drawn depth-only into a small target, then CSHiZBuild
+// reduces it to a max-depth pyramid in one structured buffer (level 0 first, row-major per level).
+//   - GPU: same frame, the grass culler tests every instance against the pyramid
+//   - CPU: the pyramid is copied to a per-frame-slot readback buffer; chunk culls test against the
+//     newest finished copy with the view-projection that produced it. That copy is framesInFlight
+//     frames old, so CPU tests are skipped while the camera moves or turns faster than the limits.
+// ============================================================================
+class HiZOcclusion
+{
+public:
+    static const int MAX_LEVELS = 16;
+
+    bool enabled = true;
+    float maxCameraMove = 0.5f;         // CPU readback trusted while the camera stays within this (metres)
+    float minForwardDot = 0.998f;       // ... and turns less than this (cosine, about 3.6 degrees)
+
+    bool init(Core* _core, int screenWidth, int screenHeight, int targetWidth = 320)
+    {
+        core = _core;
+        width = (std::max)(targetWidth, 16);
+        height = (std::max)((int)(width * (float)screenHeight / (float)screenWidth + 0.5f), 16);
+
+        // Level sizes halve (rounding up) down to 1x1
+        levelCount = 0;
+        unsigned int offset = 0;
+        int w = width, h = height;
+        while (levelCount < MAX_LEVELS)
+        {
+            levelWidth[levelCount] = w;
+            levelHeight[levelCount] = h;
+            levelOffset[levelCount] = offset;
+            offset += (unsigned int)(w * h);
+            levelCount++;
+            if (w == 1 && h == 1) break;
+            w = (std::max)((w + 1) / 2, 1);
+            h = (std::max)((h + 1) / 2, 1);
+        }
+        pyramidSize = offset;
+
+        createDepthTarget();
+        createRootSignature();
+        if (!loadShader())
+            return false;
+        if (!createBuffers())
+            return false;
+
+        cpuPyramid.assign(pyramidSize, 1.0f);
+        initialized = true;
+        std::cout << "[HiZOcclusion] " << width << "x" << height << " occluder depth, "
+            << levelCount << " levels (" << pyramidSize * sizeof(float) / 1024 << " KB)\n";
+        return true;
+    }
+
+    bool isReady() const { return initialized; }
+
+    // Call once per frame after Core::beginFrame: this frame slot's last pyramid is done on the GPU
+    void beginFrame(const Vec3& cameraPos, const Vec3& cameraForward)
+    {
+        builtThisFrame = false;
+        lastTested = tested.exchange(0);
+        lastOccluded = occluded.exchange(0);
+        if (!initialized) return;
+
+        unsigned int slot = core->frameIndex();
+        if (slots[slot].pending)
+        {
+            void* mapped = nullptr;
+            D3D12_RANGE readRange = { 0, (SIZE_T)pyramidSize * sizeof(float) };
+            if (SUCCEEDED(slots[slot].readback->Map(0, &readRange, &mapped)))
+            {
+                memcpy(cpuPyramid.data(), mapped, (size_t)pyramidSize * sizeof(float));
+                D3D12_RANGE writeRange = { 0, 0 };
+                slots[slot].readback->Unmap(0, &writeRange);
+
+                cpuViewProj = slots[slot].viewProj;
+                cpuCameraPos = slots[slot].cameraPos;
+                cpuCameraForward = slots[slot].cameraForward;
+                hasCPUPyramid = true;
+            }
+            slots[slot].pending = false;
+        }
+
+        frameCameraPos = cameraPos;
+        frameCameraForward = cameraForward;
+        Vec3 moved = cameraPos - cpuCameraPos;
+        cpuUsable = enabled && hasCPUPyramid && moved.length() <= maxCameraMove
+            && Dot(cameraForward, cpuCameraForward) >= minForwardDot;
+    }
+
+    // Bind the occluder depth target; draw occluders with depth-only PSOs until endPrepass
+    void beginPrepass()
+    {
+        if (!initialized) return;
+        auto cmdList = core->getCommandList();
+
+        transition(depthBuffer, depthState, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+        cmdList->OMSetRenderTargets(0, nullptr, FALSE, &depthDSV);
+        cmdList->ClearDepthStencilView(depthDSV, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+        D3D12_VIEWPORT vp = { 0, 0, (float)width, (float)height, 0, 1 };
+        D3D12_RECT scissor = { 0, 0, (LONG)width, (LONG)height };
+        cmdList->RSSetViewports(1, &vp);
+        cmdList->RSSetScissorRects(1, &scissor);
+    }
+
+    // Build the pyramid from the occluder depth and queue its readback. Render target and
+    // viewport are left on the occluder target; the caller restores its own.
+    void endPrepass(const Matrix& viewProj)
+    {
+        if (!initialized) return;
+        auto cmdList = core->getCommandList();
+
+        transition(depthBuffer, depthState, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        transition(pyramidBuffer, pyramidState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        cmdList->SetComputeRootSignature(rootSignature);
+        cmdList->SetPipelineState(buildPSO);
+        cmdList->SetComputeRootDescriptorTable(1, depthSRV.gpu);
+        cmdList->SetComputeRootUnorderedAccessView(2, pyramidBuffer->GetGPUVirtualAddress());
+
+        for (int level = 0; level < levelCount; level++)
+        {
+            // Level 0 reads the depth texture, every later level the one before it
+            int src = (level == 0) ? 0 : level - 1;
+            BuildCB cb;
+            cb.src[0] = (unsigned int)levelWidth[src];
+            cb.src[1] = (unsigned int)levelHeight[src];
+            cb.src[2] = levelOffset[src];
+            cb.src[3] = (unsigned int)level;
+            cb.dst[0] = (unsigned int)levelWidth[level];
+            cb.dst[1] = (unsigned int)levelHeight[level];
+            cb.dst[2] = levelOffset[level];
+            cb.dst[3] = 0;
+
+            cmdList->SetComputeRootConstantBufferView(0, core->uploadConstants(&cb, sizeof(cb)));
+            cmdList->Dispatch((levelWidth[level] + 7) / 8, (levelHeight[level] + 7) / 8, 1);
+            core->countDispatch();
+
+            D3D12_RESOURCE_BARRIER uavBarrier = {};
+            uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            uavBarrier.UAV.pResource = pyramidBuffer;
+            cmdList->ResourceBarrier(1, &uavBarrier);
+        }
+
+        unsigned int slot = core->frameIndex();
+        transition(pyramidBuffer, pyramidState, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        cmdList->CopyBufferRegion(slots[slot].readback, 0, pyramidBuffer, 0, (UINT64)pyramidSize * sizeof(float));
+        transition(pyramidBuffer, pyramidState, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        slots[slot].viewProj = viewProj;
+        slots[slot].cameraPos = frameCameraPos;
+        slots[slot].cameraForward = frameCameraForward;
+        slots[slot].pending = true;
+        builtThisFrame = true;
+    }
+
+    // CPU test against the readback pyramid. False (may be visible) whenever the data is not usable.
+    bool isOccluded(const Vec3& bmin, const Vec3& bmax) const
+    {
+        if (!cpuUsable) return false;
+        tested++;
+
+        float rect[4];
+        float nearest;
+        if (!projectBox(cpuViewProj, bmin, bmax, rect, nearest))
+            return false;
+
+        // Smallest level where the rect spans at most 2x2 texels
+        int x0 = (int)(rect[0] * width), y0 = (int)(rect[1] * height);
+        int x1 = (int)(rect[2] * width), y1 = (int)(rect[3] * height);
+        x0 = (std::min)(x0, width - 1); x1 = (std::min)(x1, width - 1);
+        y0 = (std::min)(y0, height - 1); y1 = (std::min)(y1, height - 1);
+
+        int level = 0;
+        while ((x1 - x0 > 1 || y1 - y0 > 1) && level + 1 < levelCount)
+        {
+            x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+            level++;
+        }
+
+        const float* texels = cpuPyramid.data() + levelOffset[level];
+        int rowWidth = levelWidth[level];
+        float farthest = (std::max)(
+            (std::max)(texels[y0 * rowWidth + x0], texels[y0 * rowWidth + x1]),
+            (std::max)(texels[y1 * rowWidth + x0], texels[y1 * rowWidth + x1]));
+
+        if (nearest <= farthest)
+            return false;
+
+        occluded++;
+        return true;
+    }
+
+    bool isOccluded(const BoundsSoA& bounds, int index) const
+    {
+        return isOccluded(Vec3(bounds.minX[index], bounds.minY[index], bounds.minZ[index]),
+            Vec3(bounds.maxX[index], bounds.maxY[index], bounds.maxZ[index]));
+    }
+
+    // GPU side: pyramid for this frame's culls (NON_PIXEL_SHADER_RESOURCE once endPrepass has run)
+    bool hasPyramid() const { return initialized && enabled && builtThisFrame; }
+    D3D12_GPU_VIRTUAL_ADDRESS getPyramidAddress() const { return pyramidBuffer->GetGPUVirtualAddress(); }
+
+    // x = width, y = height, z = level count (w is left for the caller); offsets per level
+    Vec4 getPyramidParams() const { return Vec4((float)width, (float)height, (float)levelCount, 0.0f); }
+    const unsigned int* getLevelOffsets() const { return levelOffset; }
+
+    void printStats() const
+    {
+        std::cout << "[HiZOcclusion] " << (enabled ? "on" : "off") << ", CPU readback "
+            << (cpuUsable ? "in use" : "skipped (camera moving or no data)") << ", last frame "
+            << lastOccluded << " / " << lastTested << " chunk bounds occluded\n";
+    }
+
+    ~HiZOcclusion()
+    {
+        for (auto& slot : slots)
+            if (slot.readback) slot.readback->Release();
+        if (pyramidBuffer) pyramidBuffer->Release();
+        if (depthBuffer) depthBuffer->Release();
+        if (dsvHeap) dsvHeap->Release();
+        if (buildPSO) buildPSO->Release();
+        if (rootSignature) rootSignature->Release();
+        if (csBlob) csBlob->Release();
+        if (core && depthSRV.valid()) core->descriptors.free(depthSRV);
+    }
+
+private:
+    Core* core = nullptr;
+    bool initialized = false;
+
+    int width = 0;
+    int height = 0;
+    int levelCount = 0;
+    int levelWidth[MAX_LEVELS] = {};
+    int levelHeight[MAX_LEVELS] = {};
+    unsigned int levelOffset[MAX_LEVELS] = {};
+    unsigned int pyramidSize = 0;         // Floats over all levels
+
+    ID3D12Resource* depthBuffer = nullptr;      // Occluder depth (R32_TYPELESS: D32 DSV + R32 SRV)
+    ID3D12Resource* pyramidBuffer = nullptr;    // Max-depth pyramid (UAV -> SRV / copy source)
+    ID3D12DescriptorHeap* dsvHeap = nullptr;
+    D3D12_CPU_DESCRIPTOR_HANDLE depthDSV = {};
+    DescriptorRange depthSRV;
+    D3D12_RESOURCE_STATES depthState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    D3D12_RESOURCE_STATES pyramidState = D3D12_RESOURCE_STATE_COMMON;
+
+    ID3D12RootSignature* rootSignature = nullptr;
+    ID3D12PipelineState* buildPSO = nullptr;
+    ID3DBlob* csBlob = nullptr;
+
+    // One readback per frame slot, with the camera that rendered it
+    struct ReadbackSlot
+    {
+        ID3D12Resource* readback = nullptr;
+        Matrix viewProj;
+        Vec3 cameraPos;
+        Vec3 cameraForward;
+        bool pending = false;
+    };
+    ReadbackSlot slots[MAX_FRAMES_IN_FLIGHT];
+
+    std::vector<float> cpuPyramid;
+    Matrix cpuViewProj;
+    Vec3 cpuCameraPos;
+    Vec3 cpuCameraForward;
+    Vec3 frameCameraPos;
+    Vec3 frameCameraForward;
+    bool hasCPUPyramid = false;
+    bool cpuUsable = false;
+    bool builtThisFrame = false;
+
+    // Chunk culls of different systems run on worker threads at the same time
+    mutable std::atomic<unsigned int> tested{ 0 };
+    mutable std::atomic<unsigned int> occluded{ 0 };
+    unsigned int lastTested = 0;
+    unsigned int lastOccluded = 0;
+
+    struct BuildCB
+    {
+        unsigned int src[4];    // width, height, offset, level being built (0 = from the depth texture)
+        unsigned int dst[4];    // width, height, offset
+    };
+
+    // Screen rect (uv, clamped) and nearest depth of a box; false when it reaches behind the camera
+    static bool projectBox(const Matrix& vp, const Vec3& bmin, const Vec3& bmax, float rect[4], float& nearest)
+    {
+        rect[0] = rect[1] = 1.0f;
+        rect[2] = rect[3] = 0.0f;
+        nearest = 1.0f;
+
+        for (int i = 0; i < 8; i++)
+        {
+            float x = (i & 1) ? bmax.x : bmin.x;
+            float y = (i & 2) ? bmax.y : bmin.y;
+            float z = (i & 4) ? bmax.z : bmin.z;
+
+            float cx = vp.a[0][0] * x + vp.a[0][1] * y + vp.a[0][2] * z + vp.a[0][3];
+            float cy = vp.a[1][0] * x + vp.a[1][1] * y + vp.a[1][2] * z + vp.a[1][3];
+            float cz = vp.a[2][0] * x + vp.a[2][1] * y + vp.a[2][2] * z + vp.a[2][3];
+            float cw = vp.a[3][0] * x + vp.a[3][1] * y + vp.a[3][2] * z + vp.a[3][3];
+            if (cw <= 1e-4f)
+                return false;
+
+            float invW = 1.0f / cw;
+            float u = cx * invW * 0.5f + 0.5f;
+            float v = 0.5f - cy * invW * 0.5f;
+            rect[0] = (std::min)(rect[0], u);
+            rect[1] = (std::min)(rect[1], v);
+            rect[2] = (std::max)(rect[2], u);
+            rect[3] = (std::max)(rect[3], v);
+            nearest = (std::min)(nearest, cz * invW);
+        }
+
+        for (int i = 0; i < 4; i++)
+            rect[i] = (std::min)((std::max)(rect[i], 0.0f), 1.0f);
+        return true;
+    }
+
+    void transition(ID3D12Resource* res, D3D12_RESOURCE_STATES& state, D3D12_RESOURCE_STATES target)
+    {
+        if (state == target) return;
+        Barrier::add(res, state, target, core->getCommandList());
+        state = target;
+    }
+
+    void createDepthTarget()
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC dsvDesc = {};
+        dsvDesc.NumDescriptors = 1;
+        dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+        core->device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&dsvHeap));
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        // Typeless so the build pass can read it as R32_FLOAT
+        D3D12_RESOURCE_DESC depthDesc = {};
+        depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        depthDesc.Width = width;
+        depthDesc.Height = height;
+        depthDesc.DepthOrArraySize = 1;
+        depthDesc.MipLevels = 1;
+        depthDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+        depthDesc.SampleDesc.Count = 1;
+        depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+        D3D12_CLEAR_VALUE depthClear = {};
+        depthClear.Format = DXGI_FORMAT_D32_FLOAT;
+        depthClear.DepthStencil.Depth = 1.0f;
+
+        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &depthDesc,
+            D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClear, IID_PPV_ARGS(&depthBuffer));
+
+        depthDSV = dsvHeap->GetCPUDescriptorHandleForHeapStart();
+        D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
+        viewDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        viewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+        core->device->CreateDepthStencilView(depthBuffer, &viewDesc, depthDSV);
+
+        depthSRV = core->descriptors.allocate(1);
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MipLevels = 1;
+        core->device->CreateShaderResourceView(depthBuffer, &srvDesc, depthSRV.cpuAt(0));
+    }
+
+    // b0 (level sizes), t0 table (occluder depth), u0 root UAV (pyramid)
+    void createRootSignature()
+    {
+        D3D12_DESCRIPTOR_RANGE srvRange = {};
+        srvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        srvRange.NumDescriptors = 1;
+        srvRange.BaseShaderRegister = 0;
+
+        D3D12_ROOT_PARAMETER params[3] = {};
+
+        params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // b0
+        params[0].Descriptor.ShaderRegister = 0;
+        params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // t0
+        params[1].DescriptorTable.NumDescriptorRanges = 1;
+        params[1].DescriptorTable.pDescriptorRanges = &srvRange;
+        params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV; // u0
+        params[2].Descriptor.ShaderRegister = 0;
+        params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
+        rsDesc.NumParameters = 3;
+        rsDesc.pParameters = params;
+
+        ID3DBlob* signature = nullptr;
+        ID3DBlob* error = nullptr;
+        D3D12SerializeRootSignature(&rsDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
+
+        if (error)
+        {
+            std::cout << "[HiZOcclusion] Root signature error: " << (char*)error->GetBufferPointer() << "\n";
+            error->Release();
+        }
+
+        core->device->CreateRootSignature(0, signature->GetBufferPointer(),
+            signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+
+        if (signature) signature->Release();
+    }
+
+    bool loadShader()
+    {
+        std::ifstream file("Shaders/CSHiZBuild.txt");
+        if (!file.is_open())
+        {
+            std::cout << "[HiZOcclusion] ERROR: Cannot open shader file: Shaders/CSHiZBuild.txt\n";
+            return false;
+        }
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string source = buffer.str();
+
+        ID3DBlob* error = nullptr;
+        HRESULT hr = ShaderCache::compile(source, "CSHiZBuild", "main", "cs_5_0",
+            D3DCOMPILE_OPTIMIZATION_LEVEL3, &csBlob, &error);
+
+        if (FAILED(hr) || error)
+        {
+            std::cout << "[HiZOcclusion] Shader compile error (CSHiZBuild): "
+                << (error ? (char*)error->GetBufferPointer() : "Unknown") << "\n";
+            if (error) error->Release();
+            if (FAILED(hr)) return false;
+        }
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.pRootSignature = rootSignature;
+        psoDesc.CS = { csBlob->GetBufferPointer(), csBlob->GetBufferSize() };
+
+        buildPSO = core->pipelineCache.createCompute("HiZBuild", psoDesc);
+        if (buildPSO == nullptr)
+        {
+            std::cout << "[HiZOcclusion] ERROR: Failed to create compute PSO\n";
+            return false;
+        }
+        return true;
+    }
+
+    ID3D12Resource* createBuffer(UINT64 size, D3D12_HEAP_TYPE heap, D3D12_RESOURCE_STATES state,
+        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
+    {
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = heap;
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        desc.Width = size;
+        desc.Height = 1;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.SampleDesc.Count = 1;
+        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        desc.Flags = flags;
+
+        ID3D12Resource* buffer = nullptr;
+        if (FAILED(core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
+            state, nullptr, IID_PPV_ARGS(&buffer))))
+        {
+            std::cout << "[HiZOcclusion] ERROR: Failed to create buffer (" << size << " bytes)\n";
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    bool createBuffers()
+    {
+        UINT64 bytes = (UINT64)pyramidSize * sizeof(float);
+        pyramidBuffer = createBuffer(bytes, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON,
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        if (pyramidBuffer == nullptr)
+            return false;
+
+        for (unsigned int i = 0; i < core->framesInFlight; i++)
+        {
+            slots[i].readback = createBuffer(bytes, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+            if (slots[i].readback == nullptr)
+                return false;
+        }
+        return true;
+    }
+};
@@ -7,9 +7,17 @@
 #include "GEMLoader.h"
 #include "HeightmapTerrain.h"
 #include "Maths.h"
+#include "CullView.h"
+#include "Frustum.h"
+#include "GrassGPUCuller.h"
+#include "InstanceQuantization.h"
+#include "HiZOcclusion.h"
+#include "RenderQueue.h"
+#include "LOD.h"
 #include <vector>
 #include <random>
 #include <string>
+#include <algorithm>
 
 struct GrassTypeConfig
 {
@@ -29,19 +37,19 @@ struct GrassGroupConfig
 struct GrassType
 {
     Mesh* mesh = nullptr;
+    Mesh* farMesh = nullptr;        // Simplified copy drawn beyond farMeshDistance (null: mesh is used)
     Texture texture;
     std::string name;
     int groupIndex = 0;
     int typeIndex = 0;
 };
 
-struct GrassInstanceGPU
-{
-    Vec3 position;
-    float rotationY;
-    float scale;
-    float windPhase;
-};
+// Vertex stream format: PackedInstance with param = wind phase (12 bytes)
+using GrassInstanceGPU = PackedInstance;
+
+// Instances stay submitted until their threshold passes density * band, shrinking to nothing over
+// the part above density (matches the 1.25 in VSGrass / CSGrassCull)
+static const float GRASS_DENSITY_FADE_BAND = 1.25f;
 
 struct GrassInstance
 {
@@ -57,10 +65,20 @@ struct GrassGroup
 {
     std::string name;
     std::vector<GrassType> types;
-    std::vector<std::vector<GrassInstance>> instancesByType;
-    std::vector<std::vector<GrassInstance>> visibleInstancesByType;
-    std::vector<ID3D12Resource*> instanceBuffers;
-    std::vector<D3D12_VERTEX_BUFFER_VIEW> instanceBufferViews;
+    std::vector<unsigned int> instanceCounts;   // Instances per type (all chunks)
+};
+
+// Result of culling one view, consumed by draw()
+struct GrassDrawPacket
+{
+    Vec3 cameraPos;
+    float viewDistance = 0.0f;
+    std::vector<std::vector<unsigned int>> counts;                  // Visible instances per [group][type]
+    std::vector<std::vector<D3D12_GPU_VIRTUAL_ADDRESS>> instances;  // Frame allocator stream per [group][type]
+    std::vector<std::vector<unsigned int>> farCounts;               // Same for chunks drawn with the far meshes
+    std::vector<std::vector<D3D12_GPU_VIRTUAL_ADDRESS>> farInstances;
+    unsigned int totalVisible = 0;
+    bool gpuDriven = false;                          // Counts live on the GPU, draw via ExecuteIndirect
 };
 
 class HybridGrassField
@@ -97,6 +115,7 @@ public:
 
         // Normalize group/type weights for stable weighted selection
         normalizeWeights(groupConfigs);
+        buildDrawSlots();
 
         // Generate random instances across the terrain, stored per chunk
         generateWeightedGrassChunks(minDistance);
@@ -131,95 +150,219 @@ public:
 
         // Normalize weights (still useful for distribution logic and validation)
         normalizeWeights(groupConfigs);
+        buildDrawSlots();
 
-        // Copy instances and clamp indices to current group/type ranges
-        allInstances = preGeneratedInstances;
+        // Pack into chunk lists (indices clamped to the loaded groups/types) so culling works the
+        // same way as random generation
+        organizeIntoChunks(preGeneratedInstances);
 
-        for (auto& inst : allInstances)
-        {
-            if (inst.groupIndex < 0 || inst.groupIndex >= (int)groups.size())
-            {
-                inst.groupIndex = inst.groupIndex % (int)groups.size();
-                if (inst.groupIndex < 0) inst.groupIndex = 0;
-            }
+        // Build per-type lists, create GPU instance buffers, then setup shaders/PSO
+        finishInit(core, psos, shaders);
+    }
 
-            int maxType = (int)groups[inst.groupIndex].types.size();
-            if (maxType > 0 && (inst.typeIndex < 0 || inst.typeIndex >= maxType))
-            {
-                inst.typeIndex = inst.typeIndex % maxType;
-                if (inst.typeIndex < 0) inst.typeIndex = 0;
-            }
+    // Streaming: load the grass types and an empty chunk grid over terrainSizeX x terrainSizeZ (chunkSize
+    // must match the VegetationStreamer's). Chunk contents arrive through setChunkInstances/clearChunk.
+    // Culling stays on the CPU, since the GPU culler needs every instance in one static buffer.
+    void initStreaming(Core* core, PSOManager* psos, Shaders* shaders,
+        HeightmapTerrain* terrain,
+        const std::vector<GrassGroupConfig>& groupConfigs,
+        float viewDistance = 50.0f,
+        float chunkSize = 32.0f)
+    {
+        this->terrain = terrain;
+        this->viewDistance = viewDistance;
+        this->chunkSize = chunkSize;
+        streaming = true;
+        gpuCulling = false;
+
+        loadGrassGroups(core, groupConfigs);
+
+        if (groups.empty())
+        {
+            std::cout << "[HybridGrassField] Error: No grass groups loaded!\n";
+            return;
         }
 
-        // Build chunk lists so culling can work the same way as random generation
-        organizeIntoChunks();
+        normalizeWeights(groupConfigs);
+        buildDrawSlots();
 
-        // Build per-type lists, create GPU instance buffers, then setup shaders/PSO
+        organizeIntoChunks(std::vector<GrassInstance>());
         finishInit(core, psos, shaders);
     }
 
+    // Streaming: replace one chunk's instances (index = cz * chunksX + cx, as in organizeIntoChunks)
+    void setChunkInstances(int chunkIndex, std::vector<GrassInstance>&& instances)
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size()) return;
+
+        storeChunk(chunkIndex, instances);
+        updateChunkBounds(chunkIndex);
+    }
+
+    // Streaming: drop one chunk's instances and give the memory back
+    void clearChunk(int chunkIndex)
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size()) return;
+
+        instanceCount -= chunks[chunkIndex].instances.size();
+        std::vector<GrassInstanceGPU>().swap(chunks[chunkIndex].instances);
+        std::vector<unsigned short>().swap(chunks[chunkIndex].drawSlots);
+        chunks[chunkIndex].maxScale = 0.0f;
+        updateChunkBounds(chunkIndex);
+    }
+
+    // CPU memory held by one chunk's instance data
+    size_t getChunkBytes(int chunkIndex) const
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size()) return 0;
+        return chunks[chunkIndex].instances.capacity() * sizeof(GrassInstanceGPU)
+            + chunks[chunkIndex].drawSlots.capacity() * sizeof(unsigned short);
+    }
+
     void update(float deltaTime)
     {
         // Advance wind animation time
         windTime += deltaTime;
     }
 
-    void draw(Core* core, PSOManager* psos, Shaders* shaders,
-        const Matrix& vp, const Vec3& cameraPos)
+    GrassDrawPacket cull(Core* core, const CullView& view)
     {
-        if (groups.empty()) return;
+        // Culling step: mark visible chunks and write this view's instances into frame memory
+        GrassDrawPacket packet;
+        packet.cameraPos = view.cameraPos;
+        packet.viewDistance = viewDistance * view.distanceScale;
+        packet.counts.resize(groups.size());
+        packet.instances.resize(groups.size());
+        packet.farCounts.resize(groups.size());
+        packet.farInstances.resize(groups.size());
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            packet.counts[g].assign(groups[g].types.size(), 0);
+            packet.instances[g].assign(groups[g].types.size(), 0);
+            packet.farCounts[g].assign(groups[g].types.size(), 0);
+            packet.farInstances[g].assign(groups[g].types.size(), 0);
+        }
 
-        // Culling step: mark visible chunks, rebuild visible instance lists, update buffers
-        performChunkCulling(cameraPos);
+        if (groups.empty()) return packet;
+
+        // GPU path: record the compute cull, survivors and counts never come back to the CPU
+        if (gpuCulling && gpuCuller.isReady())
+        {
+            gpuCuller.bladeHeight = bladeHeight * getScaleCompensationLimit();
+            gpuCuller.densityParams = getDensityParams();
+            gpuCuller.farMeshDistance = hasFarMeshes ? farMeshDistance : 1e30f;
+            gpuCuller.cull(view, packet.viewDistance);
+            packet.gpuDriven = true;
+            return packet;
+        }
+
+        performChunkCulling(core, view, packet);
+        return packet;
+    }
+
+    void draw(Core* core, PSOManager* psos, Shaders* shaders,
+        const Matrix& vp, const GrassDrawPacket& packet)
+    {
+        if (groups.empty() || (packet.totalVisible == 0 && !packet.gpuDriven)) return;
 
         // Update shared shader constants (VP, wind, camera, lighting, colours)
         Matrix world;
-        shaders->updateConstantVS(shaderName, "grassBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shaderName, "grassBuffer", "W", (void*)&world);
+        vpConstant.set(&vp);
+        worldConstant.set(&world);
 
         Vec4 windData(windDirection.x, windDirection.y, windStrength, windTime);
-        shaders->updateConstantVS(shaderName, "grassBuffer", "windParams", &windData);
+        windConstant.set(&windData);
+
+        Vec4 cameraData(packet.cameraPos.x, packet.cameraPos.y, packet.cameraPos.z, packet.viewDistance);
+        cameraConstant.set(&cameraData);
 
-        Vec4 cameraData(cameraPos.x, cameraPos.y, cameraPos.z, viewDistance);
-        shaders->updateConstantVS(shaderName, "grassBuffer", "cameraPos", &cameraData);
+        Vec4 chunkParams = quantizer.getChunkParams();
+        Vec4 heightParams = quantizer.getHeightParams();
+        chunkParamsConstant.set(&chunkParams);
+        heightParamsConstant.set(&heightParams);
+
+        Vec4 densityParams = getDensityParams();
+        densityConstant.set(&densityParams);
 
         Vec4 lightDir(0.5f, 1.0f, -0.5f, 0.3f);
-        shaders->updateConstantPS(shaderName, "grassPSBuffer", "lightDir_ambient", &lightDir);
+        lightConstant.set(&lightDir);
 
-        shaders->updateConstantPS(shaderName, "grassPSBuffer", "grassColorTop", &colorTop);
-        shaders->updateConstantPS(shaderName, "grassPSBuffer", "grassColorBottom", &colorBottom);
+        colorTopConstant.set(&colorTop);
+        colorBottomConstant.set(&colorBottom);
 
         // Bind shaders + PSO once, then draw each group/type with instancing
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
 
-        for (auto& group : groups)
+        for (size_t g = 0; g < groups.size(); g++)
         {
-            drawGroup(core, group);
+            if (packet.gpuDriven)
+                drawGroupIndirect(core, (int)g);
+            else
+            {
+                queueGroup(groups[g], packet.counts[g], packet.instances[g], false);
+                queueGroup(groups[g], packet.farCounts[g], packet.farInstances[g], true);
+            }
         }
+
+        // CPU path: every group/type sorted by texture and geometry page, rebinding only what changes
+        renderQueue.flush(core, psos);
+    }
+
+    // Cull + draw the main view in one call
+    void draw(Core* core, PSOManager* psos, Shaders* shaders,
+        const Matrix& vp, const Vec3& cameraPos)
+    {
+        draw(core, psos, shaders, vp, cull(core, CullView::main(vp, cameraPos)));
     }
 
     Vec2 windDirection = Vec2(1.0f, 0.5f);
     float windStrength = 1.5f;
     float windSpeed = 1.0f;
 
+    float bladeHeight = 1.5f;   // Per-unit-scale blade height + sway, used for culling bounds
+
+    // Distance thinning: full density out to densityFalloffStart, then (start / distance)^exponent of the
+    // instances are kept (never below minDensity), picked by their stable instanceThreshold(). The cut
+    // happens in culling (per chunk on the CPU, per instance on the GPU); the VS shrinks blades out over
+    // the fade band and scales survivors by 1/sqrt(density), capped at maxScaleCompensation.
+    bool densityFalloff = true;
+    float densityFalloffStart = 12.0f;
+    float densityFalloffExponent = 2.0f;
+    float minDensity = 0.08f;
+    float maxScaleCompensation = 2.0f;
+
+    // Chunks (CPU) or instances (GPU) beyond farMeshDistance draw each type's simplified mesh, built
+    // at load with farMeshRatio of the triangles; set before init
+    float farMeshDistance = 25.0f;
+    float farMeshRatio = 0.4f;
+
+    // Fraction of instances kept at a ground-plane distance from the camera
+    float getDensityAt(float distance) const
+    {
+        if (!densityFalloff || distance <= densityFalloffStart) return 1.0f;
+        return (std::max)(minDensity, std::pow(densityFalloffStart / distance, densityFalloffExponent));
+    }
+
+    // Cull on the GPU (compute + ExecuteIndirect) instead of per chunk on the CPU; set before init.
+    // Falls back to the CPU path if the compute shader or buffers cannot be created.
+    bool gpuCulling = false;
+
     Vec4 colorTop = Vec4(0.6f, 0.9f, 0.5f, 1.0f);
     Vec4 colorBottom = Vec4(0.3f, 0.5f, 0.2f, 1.0f);
 
-    size_t getInstanceCount() const { return allInstances.size(); }
+    size_t getInstanceCount() const { return instanceCount; }
+    bool isStreaming() const { return streaming; }
 
     ~HybridGrassField()
     {
-        // Release meshes and per-type instance buffers
+        // Release meshes (instance data lives in Core's frame allocator)
         for (auto& group : groups)
         {
             for (auto& type : group.types)
             {
                 if (type.mesh) delete type.mesh;
-            }
-            for (auto& buffer : group.instanceBuffers)
-            {
-                if (buffer) buffer->Release();
+                if (type.farMesh) delete type.farMesh;
             }
         }
     }
@@ -228,15 +371,56 @@ private:
     HeightmapTerrain* terrain = nullptr;
     std::vector<GrassGroup> groups;
 
+    // Instances are stored packed, SoA next to the draw each one belongs to: culling counts from
+    // drawSlots alone, then copies the 12-byte records straight into frame memory
     struct GrassChunk
     {
         Vec3 centerPos;
-        std::vector<GrassInstance> instances;
+        std::vector<GrassInstanceGPU> instances;
+        std::vector<unsigned short> drawSlots;      // firstDrawIndex[group] + type
+        float maxScale = 0.0f;
         bool isVisible = false;
     };
 
     std::vector<GrassChunk> chunks;
-    std::vector<GrassInstance> allInstances;
+    int chunksX = 1;
+    InstanceQuantizer quantizer;                // Chunk grid + height range the instances are packed against
+    size_t instanceCount = 0;                   // Packed instances across all chunks
+
+    // Chunk AABBs in SoA form for the SIMD frustum test (index = chunk index)
+    BoundsSoA chunkBounds;
+    std::vector<unsigned char> chunkInFrustum;
+    // Visible chunk of one CPU cull: how many of its (threshold-sorted) instances survive thinning
+    struct VisibleChunk
+    {
+        int index;
+        unsigned int keep;
+        unsigned int slotOffset;                // 0, or drawSlotCount for the far-mesh slots
+    };
+    std::vector<VisibleChunk> visibleChunks;    // Scratch for one CPU cull
+    std::vector<unsigned int> slotCounts;       // Scratch: visible instances per draw slot (near, then far)
+    std::vector<GrassInstanceGPU*> slotWrite;   // Scratch: write cursor per draw slot
+    RenderQueue renderQueue;                    // Scratch: CPU-path draws of one view
+
+    // Shader, PSO and constants resolved once at init
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    ConstantHandle vpConstant;
+    ConstantHandle worldConstant;
+    ConstantHandle windConstant;
+    ConstantHandle cameraConstant;
+    ConstantHandle chunkParamsConstant;
+    ConstantHandle heightParamsConstant;
+    ConstantHandle densityConstant;
+    ConstantHandle lightConstant;
+    ConstantHandle colorTopConstant;
+    ConstantHandle colorBottomConstant;
+
+    // GPU culling backend; draw index = draw slot = flattened [group][type]
+    GrassGPUCuller gpuCuller;
+    std::vector<unsigned int> firstDrawIndex;   // Per group
+    unsigned int drawSlotCount = 0;
+    bool hasFarMeshes = false;                  // Any type got a simplified far mesh
 
     std::vector<float> normalizedGroupWeights;
     std::vector<std::vector<float>> normalizedTypeWeights;
@@ -246,38 +430,87 @@ private:
     float chunkSize = 16.0f;
     float windTime = 0.0f;
 
+    // Streaming mode: chunks are filled and emptied at runtime
+    bool streaming = false;
+
     void finishInit(Core* core, PSOManager* psos, Shaders* shaders)
     {
-        // Organize instances into per-group/per-type containers
-        separateInstancesByGroupAndType();
+        // Per-group/per-type totals (GPU culler ranges, statistics)
+        countInstancesByType();
 
-        // Allocate one GPU instance buffer per type (updated during culling)
-        createInstanceBuffers(core);
+        // Chunk AABBs (footprint + terrain height range) for frustum culling
+        buildChunkBounds();
+
+        // GPU-driven mode keeps every instance on the GPU; CPU culling writes into Core's frame allocator
+        if (gpuCulling && !createGPUCuller(core))
+        {
+            std::cout << "[HybridGrassField] WARNING: GPU culling unavailable, using CPU culling\n";
+            gpuCulling = false;
+        }
 
         // Load shared grass shaders and build instanced PSO
         shaders->load(core, shaderName, "Shaders/VSGrass.txt", "Shaders/PSGrass.txt");
-
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("grassBuffer", "VP");
+        worldConstant = shader->getConstantVS("grassBuffer", "W");
+        windConstant = shader->getConstantVS("grassBuffer", "windParams");
+        cameraConstant = shader->getConstantVS("grassBuffer", "cameraPos");
+        chunkParamsConstant = shader->getConstantVS("grassBuffer", "chunkParams");
+        heightParamsConstant = shader->getConstantVS("grassBuffer", "heightParams");
+        densityConstant = shader->getConstantVS("grassBuffer", "densityParams");
+        lightConstant = shader->getConstantPS("grassPSBuffer", "lightDir_ambient");
+        colorTopConstant = shader->getConstantPS("grassPSBuffer", "grassColorTop");
+        colorBottomConstant = shader->getConstantPS("grassPSBuffer", "grassColorBottom");
+
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
             VertexLayoutCache::getGrassInstancedLayout());
 
         // Print a quick breakdown of distribution and draw call count
         printStatistics();
     }
 
-    void organizeIntoChunks()
+    void organizeIntoChunks(const std::vector<GrassInstance>& instances)
     {
         // Build an empty chunk grid covering the terrain bounds
-        chunks.clear();
+        int numChunksX = (int)std::ceil(terrainSizeX / chunkSize);
+        int numChunksZ = (int)std::ceil(terrainSizeZ / chunkSize);
+        createChunkGrid(numChunksX, numChunksZ);
 
         float halfX = terrainSizeX * 0.5f;
         float halfZ = terrainSizeZ * 0.5f;
 
-        int numChunksX = (int)std::ceil(terrainSizeX / chunkSize);
-        int numChunksZ = (int)std::ceil(terrainSizeZ / chunkSize);
+        // Assign each instance to a chunk based on its x/z position, then pack per chunk
+        std::vector<std::vector<GrassInstance>> byChunk(chunks.size());
+        for (const auto& inst : instances)
+        {
+            int cx = (int)((inst.position.x + halfX) / chunkSize);
+            int cz = (int)((inst.position.z + halfZ) / chunkSize);
+
+            cx = std::clamp(cx, 0, numChunksX - 1);
+            cz = std::clamp(cz, 0, numChunksZ - 1);
+
+            int chunkIdx = cz * numChunksX + cx;
+            byChunk[chunkIdx].push_back(inst);
+        }
+
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            storeChunk((int)c, byChunk[c]);
+        }
 
+        std::cout << "[HybridGrassField] Organized " << instanceCount
+            << " instances into " << chunks.size() << " chunks\n";
+    }
+
+    void createChunkGrid(int numChunksX, int numChunksZ)
+    {
+        chunks.clear();
         chunks.resize(numChunksX * numChunksZ);
+        chunksX = std::max(numChunksX, 1);
+        instanceCount = 0;
+
+        float halfX = terrainSizeX * 0.5f;
+        float halfZ = terrainSizeZ * 0.5f;
 
         for (int cz = 0; cz < numChunksZ; cz++)
         {
@@ -296,21 +529,108 @@ private:
             }
         }
 
-        // Assign each instance to a chunk based on its x/z position
-        for (const auto& inst : allInstances)
+        if (!InstanceQuantizer::fitsChunkCount(chunks.size()))
+            std::cout << "[HybridGrassField] WARNING: " << chunks.size() << " chunks exceed the packed chunk index, raise chunkSize\n";
+
+        // Packed heights cover the terrain under the grid (blades sit on the ground)
+        float minY = -100.0f, maxY = 100.0f;
+        if (terrain)
+            terrain->getHeightRange(-halfX, -halfZ, numChunksX * chunkSize - halfX, numChunksZ * chunkSize - halfZ, minY, maxY);
+        quantizer.init(-halfX, -halfZ, chunkSize, chunksX, minY - 1.0f, maxY + 1.0f);
+    }
+
+    // Pack one chunk's instances; group/type indices out of range wrap into the loaded groups
+    void storeChunk(int chunkIndex, const std::vector<GrassInstance>& instances)
+    {
+        GrassChunk& chunk = chunks[chunkIndex];
+        instanceCount -= chunk.instances.size();
+
+        chunk.instances.clear();
+        chunk.drawSlots.clear();
+        chunk.instances.reserve(instances.size());
+        chunk.drawSlots.reserve(instances.size());
+        chunk.maxScale = 0.0f;
+
+        for (const auto& inst : instances)
         {
-            int cx = (int)((inst.position.x + halfX) / chunkSize);
-            int cz = (int)((inst.position.z + halfZ) / chunkSize);
+            int g = wrapIndex(inst.groupIndex, (int)groups.size());
+            int typeCount = (int)groups[g].types.size();
+            if (typeCount == 0) continue;
+            int t = wrapIndex(inst.typeIndex, typeCount);
+
+            chunk.instances.push_back(quantizer.pack(inst.position, chunkIndex, inst.scale, inst.rotationY,
+                packAngle(inst.windPhase)));
+            chunk.drawSlots.push_back((unsigned short)(firstDrawIndex[g] + t));
+            chunk.maxScale = std::max(chunk.maxScale, inst.scale);
+        }
 
-            cx = std::clamp(cx, 0, numChunksX - 1);
-            cz = std::clamp(cz, 0, numChunksZ - 1);
+        sortByThreshold(chunk);
 
-            int chunkIdx = cz * numChunksX + cx;
-            chunks[chunkIdx].instances.push_back(inst);
+        chunk.instances.shrink_to_fit();
+        chunk.drawSlots.shrink_to_fit();
+        instanceCount += chunk.instances.size();
+    }
+
+    // Order a chunk by instanceThreshold(), so the instances kept at any density are a prefix
+    static void sortByThreshold(GrassChunk& chunk)
+    {
+        std::vector<std::pair<float, unsigned int>> order(chunk.instances.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = { instanceThreshold(chunk.instances[i]), (unsigned int)i };
+        std::sort(order.begin(), order.end());
+
+        std::vector<GrassInstanceGPU> instances(order.size());
+        std::vector<unsigned short> drawSlots(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            instances[i] = chunk.instances[order[i].second];
+            drawSlots[i] = chunk.drawSlots[order[i].second];
         }
+        chunk.instances.swap(instances);
+        chunk.drawSlots.swap(drawSlots);
+    }
 
-        std::cout << "[HybridGrassField] Organized " << allInstances.size()
-            << " instances into " << chunks.size() << " chunks\n";
+    // Instances of a sorted chunk still submitted at this density (the fade band included)
+    static unsigned int getKeepCount(const GrassChunk& chunk, float density)
+    {
+        float limit = density * GRASS_DENSITY_FADE_BAND;
+        if (limit >= 1.0f) return (unsigned int)chunk.instances.size();
+
+        auto end = std::partition_point(chunk.instances.begin(), chunk.instances.end(),
+            [limit](const GrassInstanceGPU& inst) { return instanceThreshold(inst) < limit; });
+        return (unsigned int)(end - chunk.instances.begin());
+    }
+
+    // VS density constants: x = falloff start, y = exponent, z = min density, w = max scale compensation
+    Vec4 getDensityParams() const
+    {
+        if (!densityFalloff) return Vec4(1e30f, 1.0f, 1.0f, 1.0f);
+        return Vec4(densityFalloffStart, densityFalloffExponent, minDensity, maxScaleCompensation);
+    }
+
+    // Largest factor the VS may scale a blade by (grows the culling bounds)
+    float getScaleCompensationLimit() const
+    {
+        return densityFalloff ? (std::max)(maxScaleCompensation, 1.0f) : 1.0f;
+    }
+
+    static int wrapIndex(int index, int count)
+    {
+        if (index >= 0 && index < count) return index;
+        index = index % count;
+        return index < 0 ? 0 : index;
+    }
+
+    // Draw slot per [group][type], the order the GPU culler lays out its indirect draws
+    void buildDrawSlots()
+    {
+        firstDrawIndex.assign(groups.size(), 0);
+        drawSlotCount = 0;
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            firstDrawIndex[g] = drawSlotCount;
+            drawSlotCount += (unsigned int)groups[g].types.size();
+        }
     }
 
     void loadGrassGroups(Core* core, const std::vector<GrassGroupConfig>& configs)
@@ -332,7 +652,7 @@ private:
                 type.groupIndex = (int)g;
                 type.typeIndex = (int)t;
 
-                type.mesh = loadGrassModel(core, typeConfig.modelPath);
+                type.mesh = loadGrassModel(core, typeConfig.modelPath, &type.farMesh);
                 if (!type.mesh)
                 {
                     std::cout << "[HybridGrassField] Failed to load: "
@@ -341,6 +661,7 @@ private:
                 }
 
                 type.texture = core->loadTexture(typeConfig.texturePath);
+                if (type.farMesh) hasFarMeshes = true;
 
                 group.types.push_back(type);
             }
@@ -352,7 +673,8 @@ private:
         }
     }
 
-    Mesh* loadGrassModel(Core* core, const std::string& path)
+    // Also builds the far mesh when simplification removes a worthwhile share of the triangles
+    Mesh* loadGrassModel(Core* core, const std::string& path, Mesh** outFarMesh)
     {
         // Load GEM mesh and upload to Mesh class
         GEMLoader::GEMModelLoader loader;
@@ -370,6 +692,17 @@ private:
             vertices.push_back(vert);
         }
         mesh->init(core, vertices, gemmeshes[0].indices);
+
+        *outFarMesh = nullptr;
+        std::vector<STATIC_VERTEX> farVertices;
+        std::vector<unsigned int> farIndices;
+        if (farMeshRatio < 1.0f &&
+            MeshSimplifier::simplifyGeometry(vertices, gemmeshes[0].indices, farMeshRatio, farVertices, farIndices) &&
+            farIndices.size() < gemmeshes[0].indices.size() * 9 / 10)
+        {
+            *outFarMesh = new Mesh();
+            (*outFarMesh)->init(core, farVertices, farIndices);
+        }
         return mesh;
     }
 
@@ -425,25 +758,21 @@ private:
 
         int numChunksX = (int)(terrainSizeX / chunkSize);
         int numChunksZ = (int)(terrainSizeZ / chunkSize);
+        createChunkGrid(numChunksX, numChunksZ);
 
         // Convert density into approximate grid spacing
         float spacing = 1.0f / std::sqrt(density);
 
+        std::vector<GrassInstance> chunkInstances;
         for (int cz = 0; cz < numChunksZ; cz++)
         {
             for (int cx = 0; cx < numChunksX; cx++)
             {
-                GrassChunk chunk;
+                chunkInstances.clear();
 
                 float chunkMinX = cx * chunkSize - halfX;
                 float chunkMinZ = cz * chunkSize - halfZ;
 
-                chunk.centerPos = Vec3(
-                    chunkMinX + chunkSize * 0.5f,
-                    0.0f,
-                    chunkMinZ + chunkSize * 0.5f
-                );
-
                 int gridCount = (int)(chunkSize / spacing);
 
                 // Place one instance per grid cell with a small random offset
@@ -467,12 +796,11 @@ private:
                         inst.groupIndex = selectedGroup;
                         inst.typeIndex = selectedType;
 
-                        chunk.instances.push_back(inst);
-                        allInstances.push_back(inst);
+                        chunkInstances.push_back(inst);
                     }
                 }
 
-                chunks.push_back(chunk);
+                storeChunk(cz * numChunksX + cx, chunkInstances);
             }
         }
     }
@@ -511,187 +839,262 @@ private:
         return (int)weights.size() - 1;
     }
 
-    void separateInstancesByGroupAndType()
+    void countInstancesByType()
     {
-        // Allocate per-type arrays so we can batch by mesh/texture
-        for (auto& group : groups)
+        std::vector<unsigned int> perSlot(drawSlotCount, 0);
+        for (const auto& chunk : chunks)
         {
-            group.instancesByType.resize(group.types.size());
-            group.visibleInstancesByType.resize(group.types.size());
+            for (unsigned short slot : chunk.drawSlots)
+                perSlot[slot]++;
         }
 
-        // Distribute all instances into their group/type buckets
-        for (const auto& inst : allInstances)
+        for (size_t g = 0; g < groups.size(); g++)
         {
-            if (inst.groupIndex >= 0 && inst.groupIndex < (int)groups.size())
-            {
-                auto& group = groups[inst.groupIndex];
-                if (inst.typeIndex >= 0 && inst.typeIndex < (int)group.instancesByType.size())
-                {
-                    group.instancesByType[inst.typeIndex].push_back(inst);
-                }
-            }
+            groups[g].instanceCounts.assign(groups[g].types.size(), 0);
+            for (size_t t = 0; t < groups[g].types.size(); t++)
+                groups[g].instanceCounts[t] = perSlot[firstDrawIndex[g] + t];
         }
     }
 
-    void createInstanceBuffers(Core* core)
+    void buildChunkBounds()
     {
-        // Create one upload buffer per type; later we map and overwrite visible instances
-        for (auto& group : groups)
+        chunkBounds.clear();
+
+        for (const auto& chunk : chunks)
         {
-            group.instanceBuffers.resize(group.types.size(), nullptr);
-            group.instanceBufferViews.resize(group.types.size());
+            Vec3 bmin, bmax;
+            computeChunkBounds(chunk, bmin, bmax);
+            chunkBounds.add(bmin, bmax);
+        }
 
-            size_t totalGroupInstances = 0;
-            for (size_t t = 0; t < group.types.size(); t++)
+        chunkInFrustum.assign(chunkBounds.paddedCount(), 0);
+    }
+
+    void computeChunkBounds(const GrassChunk& chunk, Vec3& bmin, Vec3& bmax) const
+    {
+        // An empty streamed chunk gets an inverted box, which fails every frustum plane
+        if (streaming && chunk.instances.empty())
+        {
+            bmin = Vec3(1e30f, 1e30f, 1e30f);
+            bmax = Vec3(-1e30f, -1e30f, -1e30f);
+            return;
+        }
+
+        float half = chunkSize * 0.5f;
+        float minX = chunk.centerPos.x - half, maxX = chunk.centerPos.x + half;
+        float minZ = chunk.centerPos.z - half, maxZ = chunk.centerPos.z + half;
+
+        float minY = 0.0f, maxY = 0.0f;
+        if (terrain)
+            terrain->getHeightRange(minX, minZ, maxX, maxZ, minY, maxY);
+
+        // Grass extends upwards from the ground and sways sideways in the wind
+        float reach = chunk.maxScale * bladeHeight * getScaleCompensationLimit();
+        bmin = Vec3(minX - reach, minY, minZ - reach);
+        bmax = Vec3(maxX + reach, maxY + reach, maxZ + reach);
+    }
+
+    void updateChunkBounds(int chunkIndex)
+    {
+        Vec3 bmin, bmax;
+        computeChunkBounds(chunks[chunkIndex], bmin, bmax);
+        chunkBounds.set(chunkIndex, bmin, bmax);
+    }
+
+    bool createGPUCuller(Core* core)
+    {
+        // One indirect draw per type (in draw slot order); each owns a range sized to that type's instance count
+        std::vector<GrassIndirectDraw> draws;
+
+        unsigned int firstInstance = 0;
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            for (size_t t = 0; t < groups[g].types.size(); t++)
             {
-                totalGroupInstances += group.instancesByType[t].size();
+                GrassIndirectDraw draw;
+                draw.indexCount = groups[g].types[t].mesh ? groups[g].types[t].mesh->getIndexCount() : 0;
+                draw.firstInstance = firstInstance;
+                draw.maxInstances = groups[g].instanceCounts[t];
+                firstInstance += draw.maxInstances;
+                draws.push_back(draw);
             }
+        }
 
-            for (size_t t = 0; t < group.types.size(); t++)
+        // Far draws follow the near ones in the same slot order, each with its own range
+        if (hasFarMeshes)
+        {
+            for (size_t g = 0; g < groups.size(); g++)
             {
-                size_t maxInstances = totalGroupInstances;
-                if (maxInstances == 0) maxInstances = 1000;
-
-                UINT bufferSize = (UINT)(maxInstances * sizeof(GrassInstanceGPU));
-
-                D3D12_HEAP_PROPERTIES heapProps = {};
-                heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-                D3D12_RESOURCE_DESC bufferDesc = {};
-                bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-                bufferDesc.Width = bufferSize;
-                bufferDesc.Height = 1;
-                bufferDesc.DepthOrArraySize = 1;
-                bufferDesc.MipLevels = 1;
-                bufferDesc.SampleDesc.Count = 1;
-                bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-                HRESULT hr = core->device->CreateCommittedResource(
-                    &heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-                    IID_PPV_ARGS(&group.instanceBuffers[t])
-                );
-
-                if (FAILED(hr) || group.instanceBuffers[t] == nullptr)
+                for (size_t t = 0; t < groups[g].types.size(); t++)
                 {
-                    std::cout << "[HybridGrassField] ERROR: Failed to create buffer for group "
-                        << group.name << " type " << t << "\n";
-                    continue;
+                    const GrassType& type = groups[g].types[t];
+                    const Mesh* mesh = type.farMesh ? type.farMesh : type.mesh;
+                    GrassIndirectDraw draw;
+                    draw.indexCount = mesh ? mesh->getIndexCount() : 0;
+                    draw.firstInstance = firstInstance;
+                    draw.maxInstances = groups[g].instanceCounts[t];
+                    firstInstance += draw.maxInstances;
+                    draws.push_back(draw);
                 }
-
-                group.instanceBufferViews[t].BufferLocation =
-                    group.instanceBuffers[t]->GetGPUVirtualAddress();
-                group.instanceBufferViews[t].StrideInBytes = sizeof(GrassInstanceGPU);
-                group.instanceBufferViews[t].SizeInBytes = bufferSize;
             }
         }
-    }
 
-    void performChunkCulling(const Vec3& cameraPos)
-    {
-        // Clear visible lists so we can rebuild them for this frame
-        for (auto& group : groups)
+        std::vector<GrassCullInstance> cullInstances;
+        cullInstances.reserve(instanceCount);
+        for (const auto& chunk : chunks)
         {
-            for (auto& list : group.visibleInstancesByType)
+            for (size_t i = 0; i < chunk.instances.size(); i++)
             {
-                list.clear();
+                GrassCullInstance c;
+                c.instance = chunk.instances[i];
+                c.drawIndex = chunk.drawSlots[i];
+                cullInstances.push_back(c);
             }
         }
 
-        // Coarse distance test against chunk centers
-        float maxDist = viewDistance + chunkSize * 0.5f;
+        gpuCuller.bladeHeight = bladeHeight * getScaleCompensationLimit();
+        gpuCuller.quantizer = quantizer;
+        gpuCuller.farDrawOffset = hasFarMeshes ? drawSlotCount : 0;
+        return gpuCuller.init(core, cullInstances, draws);
+    }
+
+    void performChunkCulling(Core* core, const CullView& view, GrassDrawPacket& packet)
+    {
+        // Frustum test all chunk bounds at once (SSE), then the coarse distance and occlusion tests
+        Frustum frustum(view.viewProj);
+        frustum.cullAABBs(chunkBounds, chunkInFrustum.data());
+
+        float maxDist = packet.viewDistance + chunkSize * 0.5f;
         float maxDistSq = maxDist * maxDist;
+        const Vec3& cameraPos = view.cameraPos;
 
-        for (auto& chunk : chunks)
+        bool useFarMeshes = hasFarMeshes && farMeshDistance < packet.viewDistance + chunkSize;
+        float half = chunkSize * 0.5f;
+
+        // Pass 1: visible chunks, how much of each survives thinning, and the count per draw slot
+        // (only the slot array is touched)
+        visibleChunks.clear();
+        slotCounts.assign(drawSlotCount * 2, 0);
+        for (size_t c = 0; c < chunks.size(); c++)
         {
+            auto& chunk = chunks[c];
             float dx = chunk.centerPos.x - cameraPos.x;
             float dz = chunk.centerPos.z - cameraPos.z;
             float distSq = dx * dx + dz * dz;
+            bool visible = chunkInFrustum[c] && (distSq <= maxDistSq);
+            if (visible && view.occlusion && view.occlusion->isOccluded(chunkBounds, (int)c))
+                visible = false;
+
+            // Only the main view drives chunk visibility stats
+            if (view.viewId == CULL_VIEW_MAIN)
+                chunk.isVisible = visible;
+
+            if (!visible || chunk.instances.empty()) continue;
+
+            // Density at the chunk's nearest point bounds every instance in it, so the kept prefix is
+            // conservative; the VS fades the blades past their own cut
+            float nearX = (std::max)(std::fabs(dx) - half, 0.0f);
+            float nearZ = (std::max)(std::fabs(dz) - half, 0.0f);
+            float nearest = std::sqrt(nearX * nearX + nearZ * nearZ);
+
+            VisibleChunk vc;
+            vc.index = (int)c;
+            vc.keep = getKeepCount(chunk, getDensityAt(nearest));
+            vc.slotOffset = (useFarMeshes && nearest > farMeshDistance) ? drawSlotCount : 0;
+            if (vc.keep == 0) continue;
+            visibleChunks.push_back(vc);
+
+            for (unsigned int i = 0; i < vc.keep; i++)
+                slotCounts[chunk.drawSlots[i] + vc.slotOffset]++;
+        }
 
-            chunk.isVisible = (distSq <= maxDistSq);
-
-            if (chunk.isVisible)
+        // Pass 2: one frame allocation per non-empty type and mesh
+        slotWrite.assign(drawSlotCount * 2, nullptr);
+        for (size_t g = 0; g < groups.size(); g++)
+        {
+            for (size_t t = 0; t < groups[g].types.size(); t++)
             {
-                // Append chunk instances into per-group/per-type visible buckets
-                for (const auto& inst : chunk.instances)
-                {
-                    if (inst.groupIndex >= 0 && inst.groupIndex < (int)groups.size())
-                    {
-                        auto& group = groups[inst.groupIndex];
-                        if (inst.typeIndex >= 0 && inst.typeIndex < (int)group.visibleInstancesByType.size())
-                        {
-                            group.visibleInstancesByType[inst.typeIndex].push_back(inst);
-                        }
-                    }
-                }
+                unsigned int slot = firstDrawIndex[g] + (unsigned int)t;
+                packet.counts[g][t] = allocateSlot(core, slot, packet.instances[g][t]);
+                packet.farCounts[g][t] = allocateSlot(core, slot + drawSlotCount, packet.farInstances[g][t]);
+                packet.totalVisible += packet.counts[g][t] + packet.farCounts[g][t];
             }
         }
 
-        // For each type, convert to GPU layout and upload visible instances
-        for (auto& group : groups)
+        // Pass 3: copy the surviving packed records sequentially into their stream
+        for (const VisibleChunk& vc : visibleChunks)
         {
-            for (size_t t = 0; t < group.types.size(); t++)
+            const auto& chunk = chunks[vc.index];
+            for (unsigned int i = 0; i < vc.keep; i++)
             {
-                if (group.visibleInstancesByType[t].empty()) continue;
-                if (group.instanceBuffers[t] == nullptr) continue;
+                *slotWrite[chunk.drawSlots[i] + vc.slotOffset]++ = chunk.instances[i];
+            }
+        }
+    }
 
-                std::vector<GrassInstanceGPU> gpuInstances;
-                gpuInstances.reserve(group.visibleInstancesByType[t].size());
+    // Frame memory for one draw slot's survivors; returns the count
+    unsigned int allocateSlot(Core* core, unsigned int slot, D3D12_GPU_VIRTUAL_ADDRESS& outInstances)
+    {
+        unsigned int count = slotCounts[slot];
+        if (count == 0) return 0;
 
-                for (const auto& inst : group.visibleInstancesByType[t])
-                {
-                    GrassInstanceGPU gpuInst;
-                    gpuInst.position = inst.position;
-                    gpuInst.rotationY = inst.rotationY;
-                    gpuInst.scale = inst.scale;
-                    gpuInst.windPhase = inst.windPhase;
-                    gpuInstances.push_back(gpuInst);
-                }
+        FrameAllocation alloc = core->frameAllocator.allocate(count * sizeof(GrassInstanceGPU), 16);
+        slotWrite[slot] = (GrassInstanceGPU*)alloc.cpuAddress;
+        outInstances = alloc.gpuAddress;
+        return count;
+    }
+
+    void queueGroup(GrassGroup& group, const std::vector<unsigned int>& counts,
+        const std::vector<D3D12_GPU_VIRTUAL_ADDRESS>& instances, bool far)
+    {
+        // One packet per visible type; the queue sorts and binds (texture + geometry + instance VB)
+        for (size_t t = 0; t < group.types.size(); t++)
+        {
+            if (counts[t] == 0) continue;
 
-                void* mappedData = nullptr;
-                D3D12_RANGE readRange = { 0, 0 };
-                HRESULT hr = group.instanceBuffers[t]->Map(0, &readRange, &mappedData);
+            auto& type = group.types[t];
+            if (type.mesh == nullptr) continue;
 
-                if (SUCCEEDED(hr) && mappedData)
-                {
-                    size_t copySize = gpuInstances.size() * sizeof(GrassInstanceGPU);
-                    memcpy(mappedData, gpuInstances.data(), copySize);
-                    group.instanceBuffers[t]->Unmap(0, nullptr);
-                }
-            }
+            RenderPacket packet;
+            packet.pso = pso;
+            packet.texture = type.texture.srvHandle;
+            packet.mesh = (far && type.farMesh) ? type.farMesh : type.mesh;
+            packet.instances = instances[t];
+            packet.instanceStride = sizeof(GrassInstanceGPU);
+            packet.instanceCount = counts[t];
+            renderQueue.add(packet);
         }
     }
 
-    void drawGroup(Core* core, GrassGroup& group)
+    void drawGroupIndirect(Core* core, int groupIndex)
     {
-        // Draw each type separately (bind texture + mesh VB + instance VB, then instanced draw)
+        // Same bindings as drawGroup, but counts and instance ranges come from the GPU args buffer
+        auto& group = groups[groupIndex];
         for (size_t t = 0; t < group.types.size(); t++)
         {
-            int visibleCount = (int)group.visibleInstancesByType[t].size();
-            if (visibleCount == 0) continue;
-
-            if (group.instanceBuffers[t] == nullptr) continue;
-
             auto& type = group.types[t];
-            if (type.mesh == nullptr) continue;
+            if (type.mesh == nullptr || group.instanceCounts[t] == 0) continue;
 
             core->getCommandList()->SetGraphicsRootDescriptorTable(2, type.texture.srvHandle);
 
-            D3D12_VERTEX_BUFFER_VIEW views[2];
-            views[0] = type.mesh->getVertexBufferView();
-            views[1] = group.instanceBufferViews[t];
-            core->getCommandList()->IASetVertexBuffers(0, 2, views);
+            unsigned int slot = firstDrawIndex[groupIndex] + (unsigned int)t;
+            drawSlotIndirect(core, type.mesh, slot);
+            if (hasFarMeshes)
+                drawSlotIndirect(core, type.farMesh ? type.farMesh : type.mesh, slot + drawSlotCount);
+        }
+    }
 
-            D3D12_INDEX_BUFFER_VIEW ibView = type.mesh->getIndexBufferView();
-            core->getCommandList()->IASetIndexBuffer(&ibView);
+    void drawSlotIndirect(Core* core, const Mesh* mesh, unsigned int drawIndex)
+    {
+        D3D12_VERTEX_BUFFER_VIEW views[2];
+        views[0] = mesh->getVertexBufferView();
+        views[1] = gpuCuller.getVisibleBufferView();
+        core->getCommandList()->IASetVertexBuffers(0, 2, views);
 
-            core->getCommandList()->DrawIndexedInstanced(
-                type.mesh->getIndexCount(),
-                visibleCount,
-                0, 0, 0
-            );
-        }
+        D3D12_INDEX_BUFFER_VIEW ibView = mesh->getIndexBufferView();
+        core->getCommandList()->IASetIndexBuffer(&ibView);
+
+        gpuCuller.drawIndirect(drawIndex);
     }
 
     void printStatistics()
@@ -699,7 +1102,7 @@ private:
         // Debug overview of distribution across groups/types and expected draw calls
         std::cout << "\n[HybridGrassField] Statistics:\n";
         std::cout << "================================\n";
-        std::cout << "Total Instances: " << allInstances.size() << "\n";
+        std::cout << "Total Instances: " << instanceCount << " (" << sizeof(GrassInstanceGPU) << " bytes each)\n";
         std::cout << "Chunks: " << chunks.size() << "\n\n";
 
         int totalDrawCalls = 0;
@@ -711,24 +1114,27 @@ private:
             std::cout << "Group: " << group.name << "\n";
             for (size_t t = 0; t < group.types.size(); t++)
             {
-                int count = (int)group.instancesByType[t].size();
+                int count = (int)group.instanceCounts[t];
                 groupTotal += count;
                 totalDrawCalls++;
 
-                float percentage = allInstances.empty() ? 0.0f :
-                    (float)count / (float)allInstances.size() * 100.0f;
+                float percentage = instanceCount == 0 ? 0.0f :
+                    (float)count / (float)instanceCount * 100.0f;
 
                 std::cout << "  - " << group.types[t].name << ": "
                     << count << " (" << percentage << "%)\n";
             }
 
-            float groupPercentage = allInstances.empty() ? 0.0f :
-                (float)groupTotal / (float)allInstances.size() * 100.0f;
+            float groupPercentage = instanceCount == 0 ? 0.0f :
+                (float)groupTotal / (float)instanceCount * 100.0f;
 
             std::cout << "  Total: " << groupTotal << " (" << groupPercentage << "%)\n\n";
         }
 
-        std::cout << "Total Draw Calls: " << totalDrawCalls << "\n";
+        std::cout << "Total Draw Calls: " << totalDrawCalls << (hasFarMeshes ? " (x2 with far meshes)" : "") << "\n";
+        if (densityFalloff)
+            std::cout << "Density falloff: full to " << densityFalloffStart << "m, (start/d)^" << densityFalloffExponent
+                << ", min " << minDensity << "\n";
         std::cout << "================================\n\n";
     }
 };
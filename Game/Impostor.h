@@ -0,0 +1,317 @@
+#pragma once
+
+#include "Core.h"
+#include "Shaders.h"
+#include "PSO.h"
+#include "Mesh.h"
+#include "Maths.h"
+#include <vector>
+#include <string>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+// ============================================================================
+// ImpostorInstance - per-instance stream for impostor quads and instanced trees
+// ----------------------------------------------------------------------------
+// MUST match INSTANCEORIGIN / INSTANCETRANSFORM in VertexLayoutCache::getImpostorLayout and
+// getTreeInstancedLayout.
+// ============================================================================
+struct ImpostorInstance
+{
+    Vec3 position;      // 12 bytes - instance origin (ground point)
+    float scale;        // 4 bytes
+    float rotationY;    // 4 bytes - radians, same turn direction as Matrix::rotateY
+    float fade;         // 4 bytes - 0 = mesh only, 1 = impostor only; both draw (dithered) in between
+    // Total: 24 bytes
+};
+
+static_assert(sizeof(ImpostorInstance) == 24, "ImpostorInstance must stay 24 bytes");
+
+// Mesh crossfade weight for one instance: 0 before fadeStart, 1 after fadeStart + fadeRange
+inline float impostorFade(float distance, float fadeStart, float fadeRange)
+{
+    if (fadeRange <= 0.0f) return (distance >= fadeStart) ? 1.0f : 0.0f;
+    return (std::min)((std::max)((distance - fadeStart) / fadeRange, 0.0f), 1.0f);
+}
+
+// One mesh drawn into the atlas. The shader pairs VSImpostorBake with the object's own pixel shader,
+// whose PS constants the caller sets before bake().
+struct ImpostorBakePart
+{
+    Mesh* mesh = nullptr;
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;                    // RGBA8 + D32, like every scene PSO
+    D3D12_GPU_DESCRIPTOR_HANDLE texture = {};       // Root parameter 2 (t0)
+    D3D12_GPU_DESCRIPTOR_HANDLE textureTable = {};  // Optional bindless table (root parameter 4) ...
+    unsigned int textureIndex = 0;                  // ... and the slot the pixel shader reads
+    Matrix world;                                   // Part placement in object space
+    float uvScale = 1.0f;                           // Matches the VS the mesh normally draws with
+};
+
+// ============================================================================
+// ImpostorAtlas
+// ----------------------------------------------------------------------------
+// VIEW_COUNT orthographic side views of an object, one CELL_SIZE square cell each, left to right.
+// View i looks at the object from azimuth 2pi * i / VIEW_COUNT (direction (sin, 0, cos) in object
+// space). Baked once at load time with a blocking submission; coverage is in alpha.
+// ============================================================================
+class ImpostorAtlas
+{
+public:
+    static const int VIEW_COUNT = 8;
+    static const int CELL_SIZE = 128;
+
+    bool bake(Core* _core, PSOManager* psos, const std::vector<ImpostorBakePart>& parts,
+        const Vec3& localMin, const Vec3& localMax, const std::string& name)
+    {
+        core = _core;
+
+        // Quad extents: the XZ circle around the box centre, so every view fits its cell
+        centerX = (localMin.x + localMax.x) * 0.5f;
+        centerZ = (localMin.z + localMax.z) * 0.5f;
+        float rx = (std::max)(localMax.x - centerX, centerX - localMin.x);
+        float rz = (std::max)(localMax.z - centerZ, centerZ - localMin.z);
+        halfWidth = (std::max)(sqrtf(rx * rx + rz * rz), 1e-3f);
+        bottom = localMin.y;
+        top = (std::max)(localMax.y, localMin.y + 1e-3f);
+
+        if (!createTargets())
+        {
+            std::cout << "[Impostor] ERROR: Failed to create atlas for " << name << "\n";
+            return false;
+        }
+
+        core->resetCommandList();
+        auto cmdList = core->getCommandList();
+        ID3D12DescriptorHeap* heaps[] = { core->descriptors.getHeap() };
+        cmdList->SetDescriptorHeaps(1, heaps);
+        cmdList->SetGraphicsRootSignature(core->rootSignature);
+
+        float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        cmdList->OMSetRenderTargets(1, &atlasRTV, FALSE, &atlasDSV);
+        cmdList->ClearRenderTargetView(atlasRTV, clearColor, 0, nullptr);
+        cmdList->ClearDepthStencilView(atlasDSV, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+        for (int view = 0; view < VIEW_COUNT; view++)
+        {
+            D3D12_VIEWPORT vp = { (float)(view * CELL_SIZE), 0, (float)CELL_SIZE, (float)CELL_SIZE, 0, 1 };
+            D3D12_RECT scissor = { (LONG)(view * CELL_SIZE), 0, (LONG)((view + 1) * CELL_SIZE), (LONG)CELL_SIZE };
+            cmdList->RSSetViewports(1, &vp);
+            cmdList->RSSetScissorRects(1, &scissor);
+
+            Matrix viewProj = bakeViewProj(view);
+            for (const auto& part : parts)
+            {
+                if (part.mesh == nullptr || part.shader == nullptr) continue;
+
+                Vec4 bakeParams(part.uvScale, (float)part.textureIndex, 0.0f, 0.0f);
+                part.shader->getConstantVS("staticMeshBuffer", "W").set(&part.world);
+                part.shader->getConstantVS("staticMeshBuffer", "VP").set(&viewProj);
+                part.shader->getConstantVS("staticMeshBuffer", "bakeParams").set(&bakeParams);
+                part.shader->apply(core);
+                psos->bind(core, part.pso);
+
+                cmdList->SetGraphicsRootDescriptorTable(2, part.texture);
+                if (part.textureTable.ptr != 0)
+                    cmdList->SetGraphicsRootDescriptorTable(4, part.textureTable);
+                part.mesh->draw(core);
+            }
+        }
+
+        Barrier::add(atlasTexture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, cmdList);
+        core->runCommandList();
+        core->flushGraphicsQueue();
+
+        // The depth target and both view heaps were only needed for the bake
+        depthTexture->Release();
+        depthTexture = nullptr;
+        rtvHeap->Release();
+        rtvHeap = nullptr;
+        dsvHeap->Release();
+        dsvHeap = nullptr;
+
+        ready = true;
+        std::cout << "[Impostor] Baked " << name << ": " << VIEW_COUNT << " views, "
+            << VIEW_COUNT * CELL_SIZE << "x" << CELL_SIZE << " atlas\n";
+        return true;
+    }
+
+    bool isReady() const { return ready; }
+    D3D12_GPU_DESCRIPTOR_HANDLE getSRV() const { return srv.gpu; }
+
+    // Object space, per unit instance scale: x = quad half width, y = bottom, z = top, w = view count
+    Vec4 getQuadParams() const { return Vec4(halfWidth, bottom, top, (float)VIEW_COUNT); }
+
+    // Object-space XZ of the quad's axis (the box centre the views were baked around)
+    Vec4 getQuadCenter() const { return Vec4(centerX, 0.0f, centerZ, 0.0f); }
+
+    ~ImpostorAtlas()
+    {
+        if (depthTexture) depthTexture->Release();
+        if (rtvHeap) rtvHeap->Release();
+        if (dsvHeap) dsvHeap->Release();
+        if (atlasTexture) atlasTexture->Release();
+        if (core && srv.valid()) core->descriptors.free(srv);
+    }
+
+private:
+    Core* core = nullptr;
+    bool ready = false;
+
+    float centerX = 0.0f;
+    float centerZ = 0.0f;
+    float halfWidth = 1.0f;
+    float bottom = 0.0f;
+    float top = 1.0f;
+
+    ID3D12Resource* atlasTexture = nullptr;
+    ID3D12Resource* depthTexture = nullptr;
+    ID3D12DescriptorHeap* rtvHeap = nullptr;
+    ID3D12DescriptorHeap* dsvHeap = nullptr;
+    D3D12_CPU_DESCRIPTOR_HANDLE atlasRTV = {};
+    D3D12_CPU_DESCRIPTOR_HANDLE atlasDSV = {};
+    DescriptorRange srv;
+
+    // Orthographic view from azimuth `view`. Screen right is (-cos, 0, sin), the same axis VSImpostor
+    // spans the quad along, so texels land where the quad puts them whatever the camera handedness.
+    Matrix bakeViewProj(int view) const
+    {
+        float theta = 6.28318531f * (float)view / (float)VIEW_COUNT;
+        float dx = sinf(theta), dz = cosf(theta);
+        float rightX = -dz, rightZ = dx;
+
+        float halfHeight = (top - bottom) * 0.5f;
+        float midY = (top + bottom) * 0.5f;
+        float depthRange = 2.0f * sqrtf(halfWidth * halfWidth + halfHeight * halfHeight);
+
+        Matrix m;
+        m.a[0][0] = rightX / halfWidth; m.a[0][1] = 0.0f; m.a[0][2] = rightZ / halfWidth;
+        m.a[0][3] = -(rightX * centerX + rightZ * centerZ) / halfWidth;
+        m.a[1][0] = 0.0f; m.a[1][1] = 1.0f / halfHeight; m.a[1][2] = 0.0f; m.a[1][3] = -midY / halfHeight;
+        m.a[2][0] = -dx / depthRange; m.a[2][1] = 0.0f; m.a[2][2] = -dz / depthRange;
+        m.a[2][3] = 0.5f + (dx * centerX + dz * centerZ) / depthRange;
+        m.a[3][0] = 0.0f; m.a[3][1] = 0.0f; m.a[3][2] = 0.0f; m.a[3][3] = 1.0f;
+        return m;
+    }
+
+    bool createTargets()
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC rtvDesc = {};
+        rtvDesc.NumDescriptors = 1;
+        rtvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        core->device->CreateDescriptorHeap(&rtvDesc, IID_PPV_ARGS(&rtvHeap));
+
+        D3D12_DESCRIPTOR_HEAP_DESC dsvDesc = {};
+        dsvDesc.NumDescriptors = 1;
+        dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+        core->device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&dsvHeap));
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC texDesc = {};
+        texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        texDesc.Width = VIEW_COUNT * CELL_SIZE;
+        texDesc.Height = CELL_SIZE;
+        texDesc.DepthOrArraySize = 1;
+        texDesc.MipLevels = 1;
+        texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texDesc.SampleDesc.Count = 1;
+        texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+        D3D12_CLEAR_VALUE colorClear = {};
+        colorClear.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (FAILED(core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, &colorClear, IID_PPV_ARGS(&atlasTexture))))
+            return false;
+
+        texDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        D3D12_CLEAR_VALUE depthClear = {};
+        depthClear.Format = DXGI_FORMAT_D32_FLOAT;
+        depthClear.DepthStencil.Depth = 1.0f;
+        if (FAILED(core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+            D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClear, IID_PPV_ARGS(&depthTexture))))
+            return false;
+
+        atlasRTV = rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        core->device->CreateRenderTargetView(atlasTexture, nullptr, atlasRTV);
+
+        atlasDSV = dsvHeap->GetCPUDescriptorHandleForHeapStart();
+        D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
+        viewDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        viewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+        core->device->CreateDepthStencilView(depthTexture, &viewDesc, atlasDSV);
+
+        srv = core->descriptors.allocate(1);
+        if (!srv.valid())
+            return false;
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MipLevels = 1;
+        core->device->CreateShaderResourceView(atlasTexture, &srvDesc, srv.cpuAt(0));
+        return true;
+    }
+};
+
+// ============================================================================
+// ImpostorRenderer
+// ----------------------------------------------------------------------------
+// Camera-facing (about Y) quads, one instanced draw per atlas. VSImpostor picks the two baked views
+// closest to the camera direction in each instance's object space and PSImpostor blends them.
+// Constants are staged in the Shader, so each owner passes its own shaderName: systems recorded on
+// parallel jobs must not share one (the PSO is immutable and is shared).
+// ============================================================================
+class ImpostorRenderer
+{
+public:
+    void init(Core* core, Shaders* shaders, PSOManager* psos, const std::string& shaderName)
+    {
+        shaders->load(core, shaderName, "Shaders/VSImpostor.txt", "Shaders/PSImpostor.txt");
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("impostorBuffer", "VP");
+        cameraConstant = shader->getConstantVS("impostorBuffer", "cameraPos");
+        quadConstant = shader->getConstantVS("impostorBuffer", "quadParams");
+        centerConstant = shader->getConstantVS("impostorBuffer", "quadCenter");
+        pso = psos->createPSO(core, "ImpostorPSO", shader->vs, shader->ps, VertexLayoutCache::getImpostorLayout());
+    }
+
+    void draw(Core* core, PSOManager* psos, const ImpostorAtlas& atlas, const Matrix& vp, const Vec3& cameraPos,
+        D3D12_GPU_VIRTUAL_ADDRESS instances, unsigned int count)
+    {
+        if (shader == nullptr || !atlas.isReady() || count == 0) return;
+
+        Vec4 camera(cameraPos.x, cameraPos.y, cameraPos.z, 0.0f);
+        Vec4 quadParams = atlas.getQuadParams();
+        Vec4 quadCenter = atlas.getQuadCenter();
+        vpConstant.set(&vp);
+        cameraConstant.set(&camera);
+        quadConstant.set(&quadParams);
+        centerConstant.set(&quadCenter);
+        shader->apply(core);
+        psos->bind(core, pso);
+
+        auto cmdList = core->getCommandList();
+        cmdList->SetGraphicsRootDescriptorTable(2, atlas.getSRV());
+
+        // Instance stream only: the six corners come from SV_VertexID
+        D3D12_VERTEX_BUFFER_VIEW instanceView;
+        instanceView.BufferLocation = instances;
+        instanceView.StrideInBytes = sizeof(ImpostorInstance);
+        instanceView.SizeInBytes = count * sizeof(ImpostorInstance);
+        cmdList->IASetVertexBuffers(0, 1, &instanceView);
+        cmdList->DrawInstanced(6, count, 0, 0);
+        core->countDraw(count);
+    }
+
+private:
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    ConstantHandle vpConstant;
+    ConstantHandle cameraConstant;
+    ConstantHandle quadConstant;
+    ConstantHandle centerConstant;
+};
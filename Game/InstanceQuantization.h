@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Maths.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// ============================================================================
+// PackedInstance - 12-byte per-instance vertex stream shared by grass and rocks
+// ----------------------------------------------------------------------------
+// Position is chunk-relative: x/z are 16-bit fractions of the chunk named by `chunk`, y is a
+// 16-bit fraction of the field's height range. MUST match INSTANCEPOS / INSTANCESCALE /
+// INSTANCEPARAMS in VertexLayoutCache and the VS/CS decoders.
+// ============================================================================
+struct PackedInstance
+{
+    unsigned short position[3];     // 6 bytes - INSTANCEPOS.xyz (R16G16B16A16_UINT)
+    unsigned short chunk;           // 2 bytes - INSTANCEPOS.w, chunk index (cz * chunksX + cx)
+    unsigned short scale;           // 2 bytes - INSTANCESCALE (R16_FLOAT)
+    unsigned char rotationY;        // 1 byte  - INSTANCEPARAMS.x, 2pi / 256 steps
+    unsigned char param;            // 1 byte  - INSTANCEPARAMS.y, grass: wind phase, rocks: type index
+    // Total: 12 bytes
+};
+
+static_assert(sizeof(PackedInstance) == 12, "PackedInstance must stay 12 bytes");
+
+// Float to IEEE half, round to nearest; out-of-range values clamp (scales are always small positives)
+inline unsigned short floatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    unsigned int mantissa = bits & 0x7FFFFF;
+
+    if (exponent <= 0) return (unsigned short)sign;
+    if (exponent >= 31) return (unsigned short)(sign | 0x7BFF);
+
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    half += (mantissa >> 12) & 1;   // A carry rolls into the exponent, which is still correct
+    if (half >= 0x7C00) half = 0x7BFF;
+    return (unsigned short)(sign | half);
+}
+
+inline float halfToFloat(unsigned short half)
+{
+    unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+    unsigned int exponent = (half >> 10) & 0x1F;
+    unsigned int mantissa = half & 0x3FF;
+
+    unsigned int bits = sign;
+    if (exponent != 0)
+        bits |= ((exponent - 15 + 127) << 23) | (mantissa << 13);   // floatToHalf never makes denormals
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Angle in radians to 1/256 of a turn (wraps)
+inline unsigned char packAngle(float radians)
+{
+    float turns = radians * (1.0f / 6.28318531f);
+    turns -= std::floor(turns);
+    return (unsigned char)((int)(turns * 256.0f + 0.5f) & 255);
+}
+
+// Stable per-instance random value in [0, 1) hashed from the packed position words, so it survives
+// streaming/re-packing unchanged. Distance thinning keeps an instance while this is below the density
+// curve. MUST match instanceThreshold() in VSGrass / CSGrassCull.
+inline float instanceThreshold(const PackedInstance& p)
+{
+    unsigned int posXY = p.position[0] | ((unsigned int)p.position[1] << 16);
+    unsigned int posZChunk = p.position[2] | ((unsigned int)p.chunk << 16);
+
+    unsigned int h = (posXY * 0x9E3779B1u) ^ (posZChunk * 0x85EBCA77u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return (float)(h >> 8) * (1.0f / 16777216.0f);
+}
+
+// ============================================================================
+// InstanceQuantizer
+// ----------------------------------------------------------------------------
+// Chunk grid + height range one field packs against; the same values go to the shaders as
+// chunkParams / heightParams so they can rebuild world positions.
+// ============================================================================
+struct InstanceQuantizer
+{
+    float originX = 0.0f;       // World XZ of chunk (0, 0)'s min corner
+    float originZ = 0.0f;
+    float chunkSize = 32.0f;
+    int chunksX = 1;
+    float minY = 0.0f;
+    float rangeY = 1.0f;
+
+    void init(float _originX, float _originZ, float _chunkSize, int _chunksX, float _minY, float _maxY)
+    {
+        originX = _originX;
+        originZ = _originZ;
+        chunkSize = _chunkSize;
+        chunksX = (std::max)(_chunksX, 1);
+        minY = _minY;
+        rangeY = (std::max)(_maxY - _minY, 1e-3f);
+    }
+
+    // Instances outside their chunk (map edge) or the height range are clamped onto it
+    PackedInstance pack(const Vec3& position, int chunkIndex, float scale, float rotationY, unsigned char param) const
+    {
+        float chunkMinX = originX + (chunkIndex % chunksX) * chunkSize;
+        float chunkMinZ = originZ + (chunkIndex / chunksX) * chunkSize;
+
+        PackedInstance p;
+        p.position[0] = quantize((position.x - chunkMinX) / chunkSize);
+        p.position[1] = quantize((position.y - minY) / rangeY);
+        p.position[2] = quantize((position.z - chunkMinZ) / chunkSize);
+        p.chunk = (unsigned short)chunkIndex;
+        p.scale = floatToHalf(scale);
+        p.rotationY = packAngle(rotationY);
+        p.param = param;
+        return p;
+    }
+
+    Vec3 unpackPosition(const PackedInstance& p) const
+    {
+        float chunkMinX = originX + (p.chunk % chunksX) * chunkSize;
+        float chunkMinZ = originZ + (p.chunk / chunksX) * chunkSize;
+        return Vec3(
+            chunkMinX + p.position[0] * (chunkSize / 65535.0f),
+            minY + p.position[1] * (rangeY / 65535.0f),
+            chunkMinZ + p.position[2] * (chunkSize / 65535.0f));
+    }
+
+    // xy = origin, z = chunk size, w = chunks per row
+    Vec4 getChunkParams() const { return Vec4(originX, originZ, chunkSize, (float)chunksX); }
+
+    // x = min height, y = metres per height step
+    Vec4 getHeightParams() const { return Vec4(minY, rangeY / 65535.0f, 0.0f, 0.0f); }
+
+    // Chunk indices live in 16 bits
+    static bool fitsChunkCount(size_t chunkCount) { return chunkCount <= 65536; }
+
+private:
+    static unsigned short quantize(float t)
+    {
+        t = (std::min)((std::max)(t, 0.0f), 1.0f);
+        return (unsigned short)(t * 65535.0f + 0.5f);
+    }
+};
@@ -17,29 +17,47 @@ public:
         const std::vector<STATIC_VERTEX>& originalVertices,
         const std::vector<unsigned int>& originalIndices,
         float ratio)
+    {
+        std::vector<STATIC_VERTEX> verts;
+        std::vector<unsigned int> indices;
+        if (!simplifyGeometry(originalVertices, originalIndices, ratio, verts, indices))
+            return nullptr;
+
+        // Create new mesh
+        Mesh* mesh = new Mesh();
+        mesh->init(core, verts, indices);
+        return mesh;
+    }
+
+    // CPU-only simplification (no GPU access, safe to run on worker threads / offline cooking)
+    // Falls back to a copy of the original when ratio >= 1 or simplification degenerates
+    static bool simplifyGeometry(
+        const std::vector<STATIC_VERTEX>& originalVertices,
+        const std::vector<unsigned int>& originalIndices,
+        float ratio,
+        std::vector<STATIC_VERTEX>& outVertices,
+        std::vector<unsigned int>& outIndices)
     {
         // VALIDATION: Check for empty input
         if (originalVertices.empty() || originalIndices.empty())
         {
             std::cout << "[LOD] ERROR: Empty input mesh - cannot simplify!\n";
-            return nullptr;
+            return false;
         }
 
         // VALIDATION: Check for minimum triangle count
         if (originalIndices.size() < 3)
         {
             std::cout << "[LOD] ERROR: Mesh has less than 1 triangle!\n";
-            return nullptr;
+            return false;
         }
 
         if (ratio >= 1.0f)
         {
             // No simplification needed, return copy of original
-            Mesh* mesh = new Mesh();
-            std::vector<STATIC_VERTEX> verts = originalVertices;
-            std::vector<unsigned int> indices = originalIndices;
-            mesh->init(core, verts, indices);
-            return mesh;
+            outVertices = originalVertices;
+            outIndices = originalIndices;
+            return true;
         }
 
         int targetTriangleCount = (int)(originalIndices.size() / 3 * ratio);
@@ -48,34 +66,23 @@ public:
         std::cout << "[LOD] Simplifying: " << originalIndices.size() / 3
             << " tris -> " << targetTriangleCount << " tris (ratio: " << ratio << ")\n";
 
-        // Simple decimation approach: remove vertices based on importance
-        std::vector<STATIC_VERTEX> simplifiedVerts;
-        std::vector<unsigned int> simplifiedIndices;
-
         // Calculate vertex importance (based on local curvature/position)
         std::vector<float> vertexImportance = calculateVertexImportance(originalVertices, originalIndices);
 
         // Cluster-based simplification
         clusterBasedSimplification(originalVertices, originalIndices, vertexImportance,
-            targetTriangleCount, simplifiedVerts, simplifiedIndices);
+            targetTriangleCount, outVertices, outIndices);
 
         // VALIDATION: Check if simplification produced valid output
-        if (simplifiedVerts.empty() || simplifiedIndices.empty() || simplifiedIndices.size() < 3)
+        if (outVertices.empty() || outIndices.empty() || outIndices.size() < 3)
         {
             std::cout << "[LOD] WARNING: Simplification produced empty/invalid mesh - using original!\n";
             // Fall back to original mesh
-            Mesh* mesh = new Mesh();
-            std::vector<STATIC_VERTEX> verts = originalVertices;
-            std::vector<unsigned int> indices = originalIndices;
-            mesh->init(core, verts, indices);
-            return mesh;
+            outVertices = originalVertices;
+            outIndices = originalIndices;
         }
 
-        // Create new mesh
-        Mesh* simplifiedMesh = new Mesh();
-        simplifiedMesh->init(core, simplifiedVerts, simplifiedIndices);
-
-        return simplifiedMesh;
+        return true;
     }
 
 private:
@@ -347,6 +354,12 @@ private:
 class LODGenerator
 {
 public:
+    // Triangle ratios for [High, Medium, Low]; also the key for cooked LOD caches
+    static std::vector<float> getRatios()
+    {
+        return { 1.0f, 0.4f, 0.1f };
+    }
+
     // Generate 3 LOD levels from one mesh
     // Returns: [High, Medium, Low]
     static void generateLODLevels(Core* core,
@@ -372,8 +385,10 @@ public:
             << originalIndices.size() / 3 << " triangles, "
             << originalVertices.size() << " vertices\n";
 
+        std::vector<float> ratios = getRatios();
+
         // High detail: 100% of original
-        *outHigh = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, 1.0f);
+        *outHigh = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, ratios[0]);
 
         if (*outHigh == nullptr)
         {
@@ -382,10 +397,10 @@ public:
         }
 
         // Medium detail: 40% of original
-        *outMedium = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, 0.4f);
+        *outMedium = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, ratios[1]);
 
         // Low detail: 10% of original  
-        *outLow = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, 0.1f);
+        *outLow = MeshSimplifier::simplifyMesh(core, originalVertices, originalIndices, ratios[2]);
 
         // FALLBACK: If any LOD failed, use the high-detail mesh
         if (*outMedium == nullptr)
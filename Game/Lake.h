@@ -4,6 +4,8 @@
 #include "Maths.h"
 #include "Shaders.h"
 #include "PSO.h"
+#include "CullView.h"
+#include "Frustum.h"
 #include <d3d12.h>
 #include <vector>
 #include <iostream>
@@ -13,6 +15,8 @@
 // Typical frame order:
 // 1) beginReflectionPass(...) before main scene draw (renders scene into reflection RT)
 // 2) render(...) after main scene draw (draws water surface sampling reflection RT)
+// The reflection is skipped while the lake is off-screen or far away, can be refreshed every N
+// frames, and uses an oblique near plane at the water surface so geometry below it is clipped.
 
 struct LakeConfig
 {
@@ -40,6 +44,14 @@ struct LakeConfig
     float reflectionStrength = 0.8f;
     float reflectionDistortion = 0.03f;
 
+    // Reflection cost controls
+    float reflectionResolutionScale = 0.5f;   // Reflection RT size relative to the screen (fixed at init)
+    int reflectionUpdateInterval = 1;         // Re-render every N frames (1 = every frame)
+    float reflectionMaxDistance = 250.0f;     // Skip when the camera is further than this from the shore (0 = never)
+    float reflectionCullDistanceScale = 0.5f; // Passed to the scene callback as CullView::distanceScale
+    int reflectionMinLOD = 1;                 // Passed to the scene callback as CullView::minLOD
+    bool reflectionObliqueClip = true;        // Clip everything below the water plane on the GPU
+
     // Sun lighting parameters for specular highlight on the water surface
     Vec3 sunDirection = Vec3(0.4f, 0.7f, -0.5f);
     Vec3 sunColor = Vec3(1.0f, 0.95f, 0.8f);
@@ -47,8 +59,10 @@ struct LakeConfig
     float specularIntensity = 2.0f;
 };
 
-// Callback to render the reflected scene (sky/terrain/props), excluding the lake itself
-typedef void (*SceneRenderCallback)(void* userData, const Matrix& view, const Matrix& proj);
+// Callback to render the reflected scene (sky/terrain/props), excluding the lake itself.
+// view.viewProj is the mirrored (and obliquely clipped) view-projection, view.cameraPos the mirrored
+// camera, and distanceScale/minLOD come from LakeConfig.
+typedef void (*SceneRenderCallback)(void* userData, const CullView& view);
 
 class Lake
 {
@@ -67,10 +81,15 @@ public:
         std::cout << "  Radius: " << config.radius << "\n";
         std::cout << "  Water level: " << config.waterLevel << "\n";
 
-        // Create heaps used by reflection RT (RTV/DSV) and reflection SRV (shader-visible)
+        // Create heaps used by reflection RT (RTV/DSV) and the reflection SRV slot (shared heap)
         createDescriptorHeaps();
+        if (!reflectionDescriptor.valid())
+        {
+            std::cout << "[Lake] ERROR: No space for the reflection SRV, lake disabled\n";
+            return;
+        }
 
-        // Allocate half-resolution reflection colour + depth surfaces and create RTV/DSV/SRV views
+        // Allocate reflection colour + depth surfaces (reflectionResolutionScale) and create RTV/DSV/SRV views
         createReflectionRenderTarget();
 
         // Generate a circular, triangulated mesh (center + rings) and upload VB/IB to GPU
@@ -83,16 +102,34 @@ public:
         createPSO(psos, shaders);
 
         // Create upload constant buffer that stores wave/lighting/reflection parameters
-        createConstantBuffers();
 
         initialized = true;
         std::cout << "[Lake] Ready!\n\n";
     }
 
-    void beginReflectionPass(const Matrix& view, const Matrix& proj, const Vec3& cameraPos,
+    // Returns false when the reflection was not re-rendered this frame (lake not visible, too far,
+    // or between updates); the water then keeps sampling the last reflection.
+    bool beginReflectionPass(const Matrix& view, const Matrix& proj, const Vec3& cameraPos,
         SceneRenderCallback renderScene, void* userData)
     {
-        if (!initialized) return;
+        if (!initialized) return false;
+
+        Matrix viewCopy = view;
+        Matrix projCopy = proj;
+        if (!isVisible(viewCopy * projCopy) || isBeyondReflectionDistance(cameraPos))
+        {
+            // Stale once the lake comes back, so refresh on the first visible frame
+            reflectionValid = false;
+            return false;
+        }
+
+        int interval = (std::max)(config.reflectionUpdateInterval, 1);
+        if (reflectionValid && ++framesSinceReflection < interval)
+        {
+            return false;
+        }
+        framesSinceReflection = 0;
+        reflectionValid = true;
 
         auto cmdList = core->getCommandList();
 
@@ -104,10 +141,15 @@ public:
         // Build a reflected view matrix from the current view (mirror over water plane)
         Matrix reflectedView = createReflectedViewMatrix(view, waterY);
 
-        // Store reflection matrices for sampling during the later water render
+        // Store reflection matrices for sampling during the later water render. The oblique clip
+        // only changes the depth row, so sampling keeps the plain projection.
         this->reflectionView = reflectedView;
         this->reflectionProj = proj;
 
+        Matrix clipProj = config.reflectionObliqueClip ? createObliqueProjection(proj, reflectedView, waterY) : proj;
+        CullView reflectionCull = CullView::reflection(reflectedView * clipProj, reflectedCamPos,
+            config.reflectionCullDistanceScale, config.reflectionMinLOD);
+
         // Switch reflection texture into RT state, render into it, then switch back to SRV state
         transitionResource(reflectionTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
             D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -126,32 +168,31 @@ public:
         // User callback renders the scene using reflected view/projection into reflection RT
         if (renderScene)
         {
-            renderScene(userData, reflectedView, proj);
+            renderScene(userData, reflectionCull);
         }
 
         transitionResource(reflectionTexture, D3D12_RESOURCE_STATE_RENDER_TARGET,
             D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        return true;
     }
 
     void render(Core* core, PSOManager* psos, Shaders* shaders,
         const Matrix& viewProj, const Vec3& cameraPos, float totalTime)
     {
         if (!initialized || vertexCount == 0) return;
+        if (!isVisible(viewProj)) return;
 
         auto cmdList = core->getCommandList();
 
         // Update all water parameters (matrices, colours, waves, reflection sampling settings)
-        updateConstantBuffer(viewProj, cameraPos, totalTime);
+        D3D12_GPU_VIRTUAL_ADDRESS waterConstants = updateConstantBuffer(viewProj, cameraPos, totalTime);
 
-        // Bind lake PSO and required descriptor heap (reflection SRV is stored here)
-        psos->bind(core, "LakeWaterPSO");
-
-        ID3D12DescriptorHeap* heaps[] = { srvHeap };
-        cmdList->SetDescriptorHeaps(1, heaps);
+        // Bind lake PSO (the reflection SRV lives in Core's shared heap, which is already bound)
+        psos->bind(core, waterPSO);
 
         // Root parameter usage follows your engine root signature convention:
         // 0 = constant buffer view, 2 = texture SRV table
-        cmdList->SetGraphicsRootConstantBufferView(0, waterConstantBuffer->GetGPUVirtualAddress());
+        cmdList->SetGraphicsRootConstantBufferView(0, waterConstants);
         cmdList->SetGraphicsRootDescriptorTable(2, reflectionSRV);
 
         // Draw the uploaded circular lake mesh
@@ -160,6 +201,7 @@ public:
         cmdList->IASetIndexBuffer(&indexBufferView);
 
         cmdList->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+        core->countDraw(1);
     }
 
     bool isPointInLake(float x, float z) const
@@ -172,22 +214,38 @@ public:
 
     float getWaterLevel() const { return config.waterLevel; }
 
+    // World bounds of the water surface including wave displacement
+    void getBounds(Vec3& bmin, Vec3& bmax) const
+    {
+        // Sum of the Gerstner amplitudes in updateConstantBuffer
+        float waveHeight = 0.8f * config.waveScale;
+        bmin = Vec3(config.center.x - config.radius, config.waterLevel - waveHeight, config.center.z - config.radius);
+        bmax = Vec3(config.center.x + config.radius, config.waterLevel + waveHeight, config.center.z + config.radius);
+    }
+
+    bool isVisible(const Matrix& viewProj) const
+    {
+        Vec3 bmin, bmax;
+        getBounds(bmin, bmax);
+        return Frustum(viewProj).testAABB(bmin, bmax);
+    }
+
     ~Lake()
     {
         // Release all owned GPU resources and heaps
         if (vertexBuffer) vertexBuffer->Release();
         if (indexBuffer) indexBuffer->Release();
-        if (waterConstantBuffer) waterConstantBuffer->Release();
         if (reflectionTexture) reflectionTexture->Release();
         if (reflectionDepth) reflectionDepth->Release();
         if (rtvHeap) rtvHeap->Release();
         if (dsvHeap) dsvHeap->Release();
-        if (srvHeap) srvHeap->Release();
+        if (core) core->descriptors.free(reflectionDescriptor);
     }
 
 private:
     Core* core = nullptr;
     bool initialized = false;
+    PSOHandle waterPSO = INVALID_PSO;
 
     int screenWidth, screenHeight;
     int reflectionWidth, reflectionHeight;
@@ -199,14 +257,13 @@ private:
     UINT vertexCount = 0;
     UINT indexCount = 0;
 
-    ID3D12Resource* waterConstantBuffer = nullptr;
 
     ID3D12Resource* reflectionTexture = nullptr;
     ID3D12Resource* reflectionDepth = nullptr;
 
     ID3D12DescriptorHeap* rtvHeap = nullptr;
     ID3D12DescriptorHeap* dsvHeap = nullptr;
-    ID3D12DescriptorHeap* srvHeap = nullptr;
+    DescriptorRange reflectionDescriptor;   // Slot in Core's shared heap
 
     D3D12_CPU_DESCRIPTOR_HANDLE reflectionRTV;
     D3D12_CPU_DESCRIPTOR_HANDLE reflectionDSV;
@@ -214,6 +271,8 @@ private:
 
     Matrix reflectionView;
     Matrix reflectionProj;
+    bool reflectionValid = false;       // Reflection RT holds a usable image
+    int framesSinceReflection = 0;      // For reflectionUpdateInterval
 
     struct WaterVertex
     {
@@ -254,19 +313,16 @@ private:
         dsvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
         core->device->CreateDescriptorHeap(&dsvDesc, IID_PPV_ARGS(&dsvHeap));
 
-        // Create shader-visible SRV heap (reflection texture SRV is bound when drawing water)
-        D3D12_DESCRIPTOR_HEAP_DESC srvDesc = {};
-        srvDesc.NumDescriptors = 2;
-        srvDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        srvDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        core->device->CreateDescriptorHeap(&srvDesc, IID_PPV_ARGS(&srvHeap));
+        // Reflection texture SRV is bound from Core's shared heap when drawing water
+        reflectionDescriptor = core->descriptors.allocate(1);
     }
 
     void createReflectionRenderTarget()
     {
-        // Allocate reflection at half resolution to reduce fill cost
-        reflectionWidth = screenWidth / 2;
-        reflectionHeight = screenHeight / 2;
+        // Allocate reflection at reduced resolution to reduce fill cost
+        float scale = (std::min)((std::max)(config.reflectionResolutionScale, 0.1f), 1.0f);
+        reflectionWidth = (std::max)((int)(screenWidth * scale), 1);
+        reflectionHeight = (std::max)((int)(screenHeight * scale), 1);
 
         D3D12_HEAP_PROPERTIES heapProps = {};
         heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
@@ -296,8 +352,8 @@ private:
         core->device->CreateRenderTargetView(reflectionTexture, nullptr, reflectionRTV);
 
         // Create SRV so the water shader can sample the reflection texture
-        D3D12_CPU_DESCRIPTOR_HANDLE srvCpu = srvHeap->GetCPUDescriptorHandleForHeapStart();
-        reflectionSRV = srvHeap->GetGPUDescriptorHandleForHeapStart();
+        D3D12_CPU_DESCRIPTOR_HANDLE srvCpu = reflectionDescriptor.cpu;
+        reflectionSRV = reflectionDescriptor.gpu;
 
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -506,39 +562,17 @@ private:
         psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
         psoDesc.SampleDesc.Count = 1;
 
-        ID3D12PipelineState* pso = nullptr;
-        HRESULT hr = core->device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso));
-
-        if (FAILED(hr))
+        waterPSO = psos->createFromDesc(core, "LakeWaterPSO", psoDesc);
+        if (waterPSO == INVALID_PSO)
         {
             std::cout << "[Lake] ERROR: Failed to create water PSO\n";
             return;
         }
 
-        psos->add("LakeWaterPSO", pso);
         std::cout << "[Lake] PSO created\n";
     }
 
-    void createConstantBuffers()
-    {
-        // Allocate an upload heap buffer large enough for the WaterCB struct
-        D3D12_HEAP_PROPERTIES heapProps = {};
-        heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-        D3D12_RESOURCE_DESC desc = {};
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = 512;
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-        core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&waterConstantBuffer));
-    }
-
-    void updateConstantBuffer(const Matrix& viewProj, const Vec3& cameraPos, float time)
+    D3D12_GPU_VIRTUAL_ADDRESS updateConstantBuffer(const Matrix& viewProj, const Vec3& cameraPos, float time)
     {
         // Pack all runtime parameters and animation state into the constant buffer for the shaders
         Matrix world;
@@ -570,10 +604,8 @@ private:
         cb.waveDirections[3] = Vec4(-0.4f, 0.8f, 0, 0);
         cb.waveParams2[3] = Vec4(3.0f, 0.05f, 0.2f, 1.5f);
 
-        void* data;
-        waterConstantBuffer->Map(0, nullptr, &data);
-        memcpy(data, &cb, sizeof(cb));
-        waterConstantBuffer->Unmap(0, nullptr);
+        // Fresh per-frame copy; the previous frame's constants may still be in use on the GPU
+        return core->uploadConstants(&cb, sizeof(cb));
     }
 
     Matrix createReflectedViewMatrix(const Matrix& view, float waterY)
@@ -587,6 +619,49 @@ private:
         return reflection * viewCopy;
     }
 
+    // Replace the projection's near plane with the water plane (Lengyel's oblique frustum, D3D depth
+    // range), so the GPU clips everything under the surface that would otherwise show up mirrored
+    Matrix createObliqueProjection(const Matrix& proj, const Matrix& reflectedView, float waterY)
+    {
+        // World plane y = waterY (keeping the side above it) moved into reflected view space
+        Matrix viewCopy = reflectedView;
+        Matrix invView = viewCopy.invert();
+        float worldPlane[4] = { 0.0f, 1.0f, 0.0f, -waterY };
+        float c[4];
+        for (int j = 0; j < 4; j++)
+        {
+            c[j] = 0.0f;
+            for (int i = 0; i < 4; i++)
+                c[j] += worldPlane[i] * invView.a[i][j];
+        }
+
+        // The mirrored camera must be behind the plane, which fails when the camera is underwater
+        if (c[3] >= 0.0f)
+            return proj;
+
+        Matrix oblique = proj;
+        float q[4] = {
+            ((c[0] > 0.0f) - (c[0] < 0.0f)) / oblique.a[0][0],
+            ((c[1] > 0.0f) - (c[1] < 0.0f)) / oblique.a[1][1],
+            1.0f,
+            (1.0f - oblique.a[2][2]) / oblique.a[2][3]
+        };
+        float d = c[0] * q[0] + c[1] * q[1] + c[2] * q[2] + c[3] * q[3];
+        for (int j = 0; j < 4; j++)
+            oblique.a[2][j] = c[j] / d;
+        return oblique;
+    }
+
+    bool isBeyondReflectionDistance(const Vec3& cameraPos) const
+    {
+        if (config.reflectionMaxDistance <= 0.0f) return false;
+
+        float dx = cameraPos.x - config.center.x;
+        float dz = cameraPos.z - config.center.z;
+        float shoreDistance = sqrtf(dx * dx + dz * dz) - config.radius;
+        return shoreDistance > config.reflectionMaxDistance;
+    }
+
     void transitionResource(ID3D12Resource* res, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
     {
         // Standard D3D12 resource barrier for switching between render target and shader resource usage
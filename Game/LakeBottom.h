@@ -43,11 +43,12 @@ public:
 
         // Load shaders dedicated to the lake bottom surface shading
         shaders->load(core, shaderName, "Shaders/VSLakeBottom.txt", "Shaders/PSLakeBottom.txt");
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("staticMeshBuffer", "VP");
+        worldConstant = shader->getConstantVS("staticMeshBuffer", "W");
 
         // Create PSO using the standard static mesh input layout (pos/normal/tangent/uv)
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
             VertexLayoutCache::getStaticLayout());
 
         initialized = true;
@@ -61,12 +62,12 @@ public:
 
         // Use identity world matrix because the vertices were generated directly in world space
         Matrix world;
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", (void*)&world);
+        vpConstant.set(&vp);
+        worldConstant.set(&world);
 
         // Apply shaders / bind PSO, then bind the texture SRV and draw the mesh
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
 
         core->getCommandList()->SetGraphicsRootDescriptorTable(2, bottomTexture.srvHandle);
 
@@ -78,6 +79,12 @@ private:
     Texture bottomTexture;
     bool initialized = false;
 
+    // Shader, PSO and VP/W constants resolved once at init
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    ConstantHandle vpConstant;
+    ConstantHandle worldConstant;
+
     Vec3 lakeCenter = Vec3(0, 0, 0);
     float lakeRadius = 25.0f;
     float depth = 8.0f;
@@ -7,6 +7,14 @@
 #include <algorithm>
 #include <string.h> 
 
+// SSE is always available on the x86/x64 targets; AVX only when built with /arch:AVX
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MATHS_SSE 1
+#include <immintrin.h>
+#else
+#define MATHS_SSE 0
+#endif
+
 
 #define SQ(x) ((x) * (x))
 
@@ -352,7 +360,40 @@ public:
 	Matrix mul(const Matrix& matrix) const
 	{
 		Matrix ret;
-
+#if MATHS_SSE
+		// ret.m[4j..4j+3] = sum over k of m[4k..4k+3] * matrix.m[4j + k]
+		__m128 r0 = _mm_loadu_ps(&m[0]);
+		__m128 r1 = _mm_loadu_ps(&m[4]);
+		__m128 r2 = _mm_loadu_ps(&m[8]);
+		__m128 r3 = _mm_loadu_ps(&m[12]);
+#if defined(__AVX__)
+		// Two output groups per iteration
+		__m256 r0x2 = _mm256_set_m128(r0, r0);
+		__m256 r1x2 = _mm256_set_m128(r1, r1);
+		__m256 r2x2 = _mm256_set_m128(r2, r2);
+		__m256 r3x2 = _mm256_set_m128(r3, r3);
+		for (int j = 0; j < 4; j += 2)
+		{
+			const float* lo = &matrix.m[4 * j];
+			const float* hi = &matrix.m[4 * j + 4];
+			__m256 v = _mm256_mul_ps(r0x2, _mm256_set_m128(_mm_set1_ps(hi[0]), _mm_set1_ps(lo[0])));
+			v = _mm256_add_ps(v, _mm256_mul_ps(r1x2, _mm256_set_m128(_mm_set1_ps(hi[1]), _mm_set1_ps(lo[1]))));
+			v = _mm256_add_ps(v, _mm256_mul_ps(r2x2, _mm256_set_m128(_mm_set1_ps(hi[2]), _mm_set1_ps(lo[2]))));
+			v = _mm256_add_ps(v, _mm256_mul_ps(r3x2, _mm256_set_m128(_mm_set1_ps(hi[3]), _mm_set1_ps(lo[3]))));
+			_mm256_storeu_ps(&ret.m[4 * j], v);
+		}
+#else
+		for (int j = 0; j < 4; j++)
+		{
+			const float* w = &matrix.m[4 * j];
+			__m128 v = _mm_mul_ps(r0, _mm_set1_ps(w[0]));
+			v = _mm_add_ps(v, _mm_mul_ps(r1, _mm_set1_ps(w[1])));
+			v = _mm_add_ps(v, _mm_mul_ps(r2, _mm_set1_ps(w[2])));
+			v = _mm_add_ps(v, _mm_mul_ps(r3, _mm_set1_ps(w[3])));
+			_mm_storeu_ps(&ret.m[4 * j], v);
+		}
+#endif
+#else
 		ret.m[0] = m[0] * matrix.m[0] + m[4] * matrix.m[1] + m[8] * matrix.m[2] + m[12] * matrix.m[3];
 		ret.m[1] = m[1] * matrix.m[0] + m[5] * matrix.m[1] + m[9] * matrix.m[2] + m[13] * matrix.m[3];
 		ret.m[2] = m[2] * matrix.m[0] + m[6] * matrix.m[1] + m[10] * matrix.m[2] + m[14] * matrix.m[3];
@@ -372,10 +413,10 @@ public:
 		ret.m[13] = m[1] * matrix.m[12] + m[5] * matrix.m[13] + m[9] * matrix.m[14] + m[13] * matrix.m[15];
 		ret.m[14] = m[2] * matrix.m[12] + m[6] * matrix.m[13] + m[10] * matrix.m[14] + m[14] * matrix.m[15];
 		ret.m[15] = m[3] * matrix.m[12] + m[7] * matrix.m[13] + m[11] * matrix.m[14] + m[15] * matrix.m[15];
-
+#endif
 		return ret;
 	}
-	Matrix operator*(const Matrix& matrix)
+	Matrix operator*(const Matrix& matrix) const
 	{
 		return mul(matrix);
 	}
@@ -673,6 +714,31 @@ public:
 	static Quaternion slerp(Quaternion q1, Quaternion q2, float t)
 	{
 		Quaternion qr;
+#if MATHS_SSE
+		__m128 v1 = _mm_loadu_ps(q1.q);
+		__m128 v2 = _mm_loadu_ps(q2.q);
+		__m128 dpv = dot4(v1, v2);
+		float dp = _mm_cvtss_f32(dpv);
+
+		// Take the shorter arc: negate q1 when the quaternions lie in opposite hemispheres
+		if (dp < 0)
+		{
+			v1 = _mm_sub_ps(_mm_setzero_ps(), v1);
+			dp = -dp;
+		}
+		float theta = acosf(clamp(dp, -1.0f, 1.0f));
+		if (theta == 0)
+		{
+			return q1;
+		}
+		float d = sinf(theta);
+		float coeff1 = sinf((1 - t) * theta) / d;
+		float coeff2 = sinf(t * theta) / d;
+
+		__m128 r = _mm_add_ps(_mm_mul_ps(v1, _mm_set1_ps(coeff1)), _mm_mul_ps(v2, _mm_set1_ps(coeff2)));
+		r = _mm_div_ps(r, _mm_sqrt_ps(dot4(r, r)));
+		_mm_storeu_ps(qr.q, r);
+#else
 		float dp = q1.a * q2.a + q1.b * q2.b + q1.c * q2.c + q1.d * q2.d;
 		Quaternion q11 = dp < 0 ? -q1 : q1;
 		dp = dp > 0 ? dp : -dp;
@@ -691,8 +757,18 @@ public:
 		qr.c = coeff1 * q11.c + coeff2 * q2.c;
 		qr.d = coeff1 * q11.d + coeff2 * q2.d;
 		qr.Normalize();
+#endif
 		return qr;
 	}
+#if MATHS_SSE
+	// Dot product of two 4-vectors, broadcast to every lane
+	static __m128 dot4(__m128 x, __m128 y)
+	{
+		__m128 p = _mm_mul_ps(x, y);
+		__m128 s = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+#endif
 	Quaternion operator-()
 	{
 		return Quaternion(-a, -b, -c, -d);
@@ -63,6 +63,30 @@ public:
         return desc;
     }
 
+    static D3D12_INPUT_LAYOUT_DESC getAnimatedInstancedLayout()
+    {
+        static D3D12_INPUT_ELEMENT_DESC layout[] = {
+            // Slot 0: Per-vertex data (ANIMATED_VERTEX)
+            { "POSITION",     0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "NORMAL",       0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TANGENT",      0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD",     0, DXGI_FORMAT_R32G32_FLOAT,       0, 36, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "BONEIDS",      0, DXGI_FORMAT_R32G32B32A32_UINT,  0, 44, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "BONEWEIGHTS",  0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 60, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+
+            // Slot 1: Per-instance data (world matrix rows, clip, time)
+            { "INSTANCEWORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCEWORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCEWORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCECLIP",  0, DXGI_FORMAT_R32_UINT,           1, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCETIME",  0, DXGI_FORMAT_R32_FLOAT,          1, 52, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        };
+        D3D12_INPUT_LAYOUT_DESC desc;
+        desc.pInputElementDescs = layout;
+        desc.NumElements = _countof(layout);
+        return desc;
+    }
+
     static D3D12_INPUT_LAYOUT_DESC getGrassInstancedLayout()
     {
         static D3D12_INPUT_ELEMENT_DESC layout[] = {
@@ -72,11 +96,10 @@ public:
             { "TANGENT",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
             { "TEXCOORD",  0, DXGI_FORMAT_R32G32_FLOAT,    0, 36, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 
-            // Slot 1: Per-instance data (from instance buffer)
-            { "INSTANCEPOS",       0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-            { "INSTANCEROT",       0, DXGI_FORMAT_R32_FLOAT,       1, 12, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-            { "INSTANCESCALE",     0, DXGI_FORMAT_R32_FLOAT,       1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-            { "INSTANCEWINDPHASE", 0, DXGI_FORMAT_R32_FLOAT,       1, 20, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            // Slot 1: Per-instance data (PackedInstance: chunk-relative position, half scale, rotation + wind phase)
+            { "INSTANCEPOS",    0, DXGI_FORMAT_R16G16B16A16_UINT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCESCALE",  0, DXGI_FORMAT_R16_FLOAT,         1, 8,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCEPARAMS", 0, DXGI_FORMAT_R8G8_UINT,         1, 10, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
         };
 
         D3D12_INPUT_LAYOUT_DESC desc;
@@ -94,10 +117,44 @@ public:
             { "TANGENT",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
             { "TEXCOORD",  0, DXGI_FORMAT_R32G32_FLOAT,    0, 36, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 
-            // Slot 1: Per-instance data (rocks: position, rotation, scale only)
-            { "INSTANCEPOS",   0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-            { "INSTANCEROT",   0, DXGI_FORMAT_R32_FLOAT,       1, 12, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-            { "INSTANCESCALE", 0, DXGI_FORMAT_R32_FLOAT,       1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            // Slot 1: Per-instance data (PackedInstance: chunk-relative position, half scale, rotation + type)
+            { "INSTANCEPOS",    0, DXGI_FORMAT_R16G16B16A16_UINT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCESCALE",  0, DXGI_FORMAT_R16_FLOAT,         1, 8,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCEPARAMS", 0, DXGI_FORMAT_R8G8_UINT,         1, 10, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        };
+
+        D3D12_INPUT_LAYOUT_DESC desc;
+        desc.pInputElementDescs = layout;
+        desc.NumElements = _countof(layout);
+        return desc;
+    }
+
+    static D3D12_INPUT_LAYOUT_DESC getImpostorLayout()
+    {
+        static D3D12_INPUT_ELEMENT_DESC layout[] = {
+            // Slot 0: Per-instance data only (ImpostorInstance: origin, scale + rotation + fade); corners come from SV_VertexID
+            { "INSTANCEORIGIN",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCETRANSFORM", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        };
+
+        D3D12_INPUT_LAYOUT_DESC desc;
+        desc.pInputElementDescs = layout;
+        desc.NumElements = _countof(layout);
+        return desc;
+    }
+
+    static D3D12_INPUT_LAYOUT_DESC getTreeInstancedLayout()
+    {
+        static D3D12_INPUT_ELEMENT_DESC layout[] = {
+            // Slot 0: Per-vertex data (from mesh)
+            { "POSITION",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "NORMAL",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TANGENT",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD",  0, DXGI_FORMAT_R32G32_FLOAT,    0, 36, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+
+            // Slot 1: Per-instance data (ImpostorInstance: origin, scale + rotation + fade)
+            { "INSTANCEORIGIN",    0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+            { "INSTANCETRANSFORM", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 12, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
         };
 
         D3D12_INPUT_LAYOUT_DESC desc;
@@ -125,8 +182,7 @@ public:
         vertexBufferSize = vertexCount * vertexStride;
         indexBufferSize = indexCount * sizeof(unsigned int);
 
-        createVertexBuffer(core, vertices.data(), vertexBufferSize);
-        createIndexBuffer(core, indices.data(), indexBufferSize);
+        createBuffers(core, vertices.data(), indices.data());
     }
 
     // Initialize with animated vertices
@@ -138,8 +194,20 @@ public:
         vertexBufferSize = vertexCount * vertexStride;
         indexBufferSize = indexCount * sizeof(unsigned int);
 
-        createVertexBuffer(core, vertices.data(), vertexBufferSize);
-        createIndexBuffer(core, indices.data(), indexBufferSize);
+        createBuffers(core, vertices.data(), indices.data());
+    }
+
+    // Initialize from raw vertex/index blobs (e.g. a memory-mapped cooked mesh) without staging copies
+    void init(Core* core, const void* vertices, unsigned int stride, unsigned int numVertices,
+        const unsigned int* indices, unsigned int numIndices)
+    {
+        vertexCount = numVertices;
+        indexCount = numIndices;
+        vertexStride = stride;
+        vertexBufferSize = vertexCount * vertexStride;
+        indexBufferSize = indexCount * sizeof(unsigned int);
+
+        createBuffers(core, vertices, indices);
     }
 
     // Draw the mesh
@@ -152,13 +220,32 @@ public:
         core->getCommandList()->IASetVertexBuffers(0, 1, &vbView);
         core->getCommandList()->IASetIndexBuffer(&ibView);
         core->getCommandList()->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+        core->countDraw(1);
     }
 
-    // Getters for instanced rendering
+    // Bind VB/IB only, for callers that issue several partial draws
+    void bind(Core* core)
+    {
+        D3D12_VERTEX_BUFFER_VIEW vbView = getVertexBufferView();
+        D3D12_INDEX_BUFFER_VIEW ibView = getIndexBufferView();
+
+        core->getCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        core->getCommandList()->IASetVertexBuffers(0, 1, &vbView);
+        core->getCommandList()->IASetIndexBuffer(&ibView);
+    }
+
+    // Draw a sub-range of the index buffer (requires bind() first); baseVertex is added to every index
+    void drawIndices(Core* core, unsigned int startIndex, unsigned int count, int baseVertex = 0)
+    {
+        core->getCommandList()->DrawIndexedInstanced(count, 1, startIndex, baseVertex, 0);
+        core->countDraw(1);
+    }
+
+    // Getters for instanced rendering (views cover just this mesh, pooled or not)
     D3D12_VERTEX_BUFFER_VIEW getVertexBufferView() const
     {
         D3D12_VERTEX_BUFFER_VIEW view;
-        view.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
+        view.BufferLocation = vertexBuffer->GetGPUVirtualAddress() + geometry.vertexOffset;
         view.StrideInBytes = vertexStride;
         view.SizeInBytes = vertexBufferSize;
         return view;
@@ -167,7 +254,7 @@ public:
     D3D12_INDEX_BUFFER_VIEW getIndexBufferView() const
     {
         D3D12_INDEX_BUFFER_VIEW view;
-        view.BufferLocation = indexBuffer->GetGPUVirtualAddress();
+        view.BufferLocation = indexBuffer->GetGPUVirtualAddress() + geometry.indexOffset;
         view.Format = DXGI_FORMAT_R32_UINT;
         view.SizeInBytes = indexBufferSize;
         return view;
@@ -175,16 +262,30 @@ public:
 
     unsigned int getIndexCount() const { return indexCount; }
     unsigned int getVertexCount() const { return vertexCount; }
+    unsigned int getVertexStride() const { return vertexStride; }
+
+    // GeometryPool placement: meshes on the same page (and stride) can share one VB/IB binding,
+    // drawn with getStartIndex() / getBaseVertex(); page is -1 when the mesh owns its buffers
+    int getGeometryPage() const { return geometry.page; }
+    unsigned int getStartIndex() const { return (unsigned int)(geometry.indexOffset / sizeof(unsigned int)); }
+    int getBaseVertex() const { return (int)(geometry.vertexOffset / vertexStride); }
 
     ~Mesh()
     {
+        if (geometry.valid())
+        {
+            pool->free(geometry);
+            return;
+        }
         if (vertexBuffer) vertexBuffer->Release();
         if (indexBuffer) indexBuffer->Release();
     }
 
 private:
-    ID3D12Resource* vertexBuffer;
+    ID3D12Resource* vertexBuffer;       // Pool page or owned buffer (owned only when geometry is invalid)
     ID3D12Resource* indexBuffer;
+    GeometryAllocation geometry;
+    GeometryPool* pool = nullptr;
 
     unsigned int vertexCount;
     unsigned int indexCount;
@@ -192,7 +293,25 @@ private:
     unsigned int vertexBufferSize;
     unsigned int indexBufferSize;
 
-    void createVertexBuffer(Core* core, void* data, unsigned int size)
+    // Suballocate from Core's GeometryPool; meshes too large for a page get their own buffers
+    void createBuffers(Core* core, const void* vertices, const void* indices)
+    {
+        pool = &core->geometry;
+        geometry = pool->allocate(vertexBufferSize, vertexStride, indexBufferSize);
+        if (geometry.valid())
+        {
+            vertexBuffer = pool->getVertexBuffer(geometry.page);
+            indexBuffer = pool->getIndexBuffer(geometry.page);
+            core->uploadBufferRegion(vertexBuffer, geometry.vertexOffset, vertices, vertexBufferSize);
+            core->uploadBufferRegion(indexBuffer, geometry.indexOffset, indices, indexBufferSize);
+            return;
+        }
+
+        createVertexBuffer(core, vertices, vertexBufferSize);
+        createIndexBuffer(core, indices, indexBufferSize);
+    }
+
+    void createVertexBuffer(Core* core, const void* data, unsigned int size)
     {
         D3D12_HEAP_PROPERTIES heapProps = {};
         heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
@@ -218,7 +337,7 @@ private:
         core->uploadResource(vertexBuffer, data, size, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
     }
 
-    void createIndexBuffer(Core* core, void* data, unsigned int size)
+    void createIndexBuffer(Core* core, const void* data, unsigned int size)
     {
         D3D12_HEAP_PROPERTIES heapProps = {};
         heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
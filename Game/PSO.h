@@ -2,17 +2,24 @@
 
 #include <d3d12.h>
 #include <unordered_map>
+#include <vector>
 #include <string>
 
+// Index into PSOManager's pipeline table; resolve once at init and bind by handle every draw
+typedef int PSOHandle;
+static const PSOHandle INVALID_PSO = -1;
+
 class PSOManager
 {
 public:
-	std::unordered_map<std::string, ID3D12PipelineState *> psos;
-    void createPSO(Core* core, std::string name, ID3DBlob *vs, ID3DBlob *ps, D3D12_INPUT_LAYOUT_DESC layout)
+	std::unordered_map<std::string, PSOHandle> handles;
+	std::vector<ID3D12PipelineState*> states;
+    PSOHandle createPSO(Core* core, std::string name, ID3DBlob *vs, ID3DBlob *ps, D3D12_INPUT_LAYOUT_DESC layout)
     {
-        if (psos.find(name) != psos.end())
+        PSOHandle existing = find(name);
+        if (existing != INVALID_PSO)
         {
-            return;
+            return existing;
         }
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
         desc.InputLayout = layout;
@@ -64,15 +71,14 @@ public:
         desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
         desc.SampleDesc.Count = 1;
 
-        ID3D12PipelineState* pso;
-        HRESULT hr = core->device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso));
-        psos.insert({ name, pso });
+        return createFromDesc(core, name, desc);
     }
-    void createBlendedPSO(Core* core, std::string name, ID3DBlob* vs, ID3DBlob* ps, D3D12_INPUT_LAYOUT_DESC layout)
+    PSOHandle createBlendedPSO(Core* core, std::string name, ID3DBlob* vs, ID3DBlob* ps, D3D12_INPUT_LAYOUT_DESC layout)
     {
-        if (psos.find(name) != psos.end())
+        PSOHandle existing = find(name);
+        if (existing != INVALID_PSO)
         {
-            return;
+            return existing;
         }
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
@@ -124,37 +130,110 @@ public:
         desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
         desc.SampleDesc.Count = 1;
 
-        ID3D12PipelineState* pso;
-        HRESULT hr = core->device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso));
-
-        if (SUCCEEDED(hr))
+        PSOHandle handle = createFromDesc(core, name, desc);
+        if (handle != INVALID_PSO)
         {
-            psos.insert({ name, pso });
             std::cout << "[PSO] Created blended PSO: " << name << "\n";
         }
-        else
+        return handle;
+    }
+    // Depth only (no pixel shader, no render target), for occluder prepasses into a D32 target
+    PSOHandle createDepthOnlyPSO(Core* core, std::string name, ID3DBlob* vs, D3D12_INPUT_LAYOUT_DESC layout)
+    {
+        PSOHandle existing = find(name);
+        if (existing != INVALID_PSO)
+        {
+            return existing;
+        }
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+        desc.InputLayout = layout;
+        desc.pRootSignature = core->rootSignature;
+        desc.VS = { vs->GetBufferPointer(), vs->GetBufferSize() };
+
+        D3D12_RASTERIZER_DESC rasterDesc = {};
+        rasterDesc.FillMode = D3D12_FILL_MODE_SOLID;
+        rasterDesc.CullMode = D3D12_CULL_MODE_NONE;
+        rasterDesc.FrontCounterClockwise = FALSE;
+        rasterDesc.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+        rasterDesc.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+        rasterDesc.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+        rasterDesc.DepthClipEnable = TRUE;
+        rasterDesc.MultisampleEnable = FALSE;
+        rasterDesc.AntialiasedLineEnable = FALSE;
+        rasterDesc.ForcedSampleCount = 0;
+        rasterDesc.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+        desc.RasterizerState = rasterDesc;
+
+        D3D12_BLEND_DESC blendDesc = {};
+        blendDesc.RenderTarget[0].RenderTargetWriteMask = 0;
+        desc.BlendState = blendDesc;
+
+        D3D12_DEPTH_STENCIL_DESC depthStencilDesc = {};
+        depthStencilDesc.DepthEnable = TRUE;
+        depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+        depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+        depthStencilDesc.StencilEnable = FALSE;
+        desc.DepthStencilState = depthStencilDesc;
+
+        desc.SampleMask = UINT_MAX;
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        desc.NumRenderTargets = 0;
+        desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+        desc.SampleDesc.Count = 1;
+
+        return createFromDesc(core, name, desc);
+    }
+    // Create (or load from Core's pipeline library) a PSO from a full description
+    PSOHandle createFromDesc(Core* core, const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+    {
+        PSOHandle existing = find(name);
+        if (existing != INVALID_PSO)
+        {
+            return existing;
+        }
+        ID3D12PipelineState* pso = core->pipelineCache.createGraphics(name, desc);
+        if (pso == nullptr)
+        {
+            std::cout << "[PSO] ERROR: Failed to create PSO: " << name << "\n";
+            return INVALID_PSO;
+        }
+        return add(name, pso);
+    }
+    PSOHandle find(const std::string& name) const
+    {
+        auto it = handles.find(name);
+        return (it != handles.end()) ? it->second : INVALID_PSO;
+    }
+    void bind(Core* core, PSOHandle handle)
+    {
+        if (handle != INVALID_PSO)
         {
-            std::cout << "[PSO] ERROR: Failed to create blended PSO: " << name << "\n";
+            core->getCommandList()->SetPipelineState(states[handle]);
         }
     }
     void bind(Core* core, std::string name)
     {
-        core->getCommandList()->SetPipelineState(psos[name]);
+        bind(core, find(name));
     }
-    void add(const std::string& name, ID3D12PipelineState* pso)
+    PSOHandle add(const std::string& name, ID3D12PipelineState* pso)
     {
-        if (psos.find(name) != psos.end())
+        PSOHandle existing = find(name);
+        if (existing != INVALID_PSO)
         {
             std::cout << "[PSO] Warning: PSO already exists: " << name << "\n";
-            return;
+            return existing;
         }
-        psos[name] = pso;
+        PSOHandle handle = (PSOHandle)states.size();
+        states.push_back(pso);
+        handles.insert({ name, handle });
+        return handle;
     }
     ~PSOManager()
     {
-        for (auto& pso : psos)
+        for (auto pso : states)
         {
-            pso.second->Release();
+            pso->Release();
         }
     }
 };
\ No newline at end of file
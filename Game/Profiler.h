@@ -0,0 +1,487 @@
+#pragma once
+
+#include "Core.h"
+#include "Shaders.h"
+#include "PSO.h"
+#include "Mesh.h"
+#include <vector>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+
+// One timed scope of a resolved frame
+struct ProfileSample
+{
+    std::string name;
+    int depth = 0;              // Nesting on the thread that recorded it
+    int thread = 0;             // 0 = main thread, then workers in first-use order
+    double cpuStartMs = 0.0;    // From the clock calibration in Profiler::init
+    float cpuMs = 0.0f;
+    double gpuStartMs = -1.0;   // On the CPU clock (calibrated at init); < 0 when no GPU time was taken
+    float gpuMs = -1.0f;
+};
+
+struct ProfileFrame
+{
+    unsigned long long frame = 0;
+    float cpuMs = 0.0f;         // beginFrame to endFrame (recording, excludes the present wait)
+    float gpuMs = 0.0f;         // First GPU timestamp to last
+    std::vector<ProfileSample> samples;
+};
+
+// ============================================================================
+// Profiler
+// ----------------------------------------------------------------------------
+// Scoped CPU markers plus a pair of GPU timestamp queries per scope on whichever command list the
+// scope records into (so scopes inside RenderJobs time that job's list). Each frame in flight owns a
+// range of the query heap and of a readback buffer; ResolveQueryData runs at the end of the frame and
+// the results are read in beginFrame once Core has waited on that frame's fence, so nothing stalls.
+// Scopes outside init() or while disabled cost one branch.
+// ============================================================================
+class Profiler
+{
+public:
+    bool enabled = true;
+    bool showOverlay = false;
+    float overlayBudgetMs = 16.67f;     // Bar length of the full overlay width
+    int historyFrames = 600;            // Frames kept for writeCSV/writeChromeTrace
+
+    static Profiler& get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void init(Core* _core, Shaders* shaders, PSOManager* psos, unsigned int _maxScopes = 128)
+    {
+        core = _core;
+        maxScopes = _maxScopes;
+        framesInFlight = core->framesInFlight;
+        frames.assign(framesInFlight, {});
+
+        D3D12_QUERY_HEAP_DESC queryDesc = {};
+        queryDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryDesc.Count = maxScopes * 2 * framesInFlight;
+        if (FAILED(core->device->CreateQueryHeap(&queryDesc, IID_PPV_ARGS(&queryHeap))))
+        {
+            std::cout << "[Profiler] WARNING: No timestamp query heap, GPU times disabled\n";
+            queryHeap = nullptr;
+        }
+
+        D3D12_HEAP_PROPERTIES heapProps = {};
+        heapProps.Type = D3D12_HEAP_TYPE_READBACK;
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Width = (UINT64)queryDesc.Count * sizeof(UINT64);
+        bufferDesc.Height = 1;
+        bufferDesc.DepthOrArraySize = 1;
+        bufferDesc.MipLevels = 1;
+        bufferDesc.SampleDesc.Count = 1;
+        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        if (queryHeap && FAILED(core->device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readback))))
+        {
+            readback = nullptr;
+        }
+
+        // CPU and GPU clocks are tied together once; drift over a capture is well under a scope's length
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        cpuFrequency = (double)freq.QuadPart;
+        core->graphicsQueue->GetTimestampFrequency(&gpuFrequency);
+        core->graphicsQueue->GetClockCalibration(&gpuCalibration, &cpuCalibration);
+
+        shaders->load(core, "ProfilerOverlay", "Shaders/VSProfilerOverlay.txt", "Shaders/PSProfilerOverlay.txt");
+        overlayShader = shaders->find("ProfilerOverlay");
+        overlayPSO = psos->createBlendedPSO(core, "ProfilerOverlayPSO", overlayShader->vs, overlayShader->ps,
+            VertexLayoutCache::getStaticLayout());
+
+        initialized = true;
+        std::cout << "[Profiler] " << maxScopes << " scopes per frame, GPU timestamps "
+            << (readback ? "on" : "off") << "\n";
+    }
+
+    // Call straight after Core::beginFrame: this frame index's previous results are complete on the GPU
+    void beginFrame()
+    {
+        if (!initialized)
+            return;
+
+        unsigned int frameIndex = core->frameIndex();
+        collect(frameIndex);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        currentFrame = frameIndex;
+        Frame& frame = frames[currentFrame];
+        frame.scopes.clear();
+        frame.frameNumber = frameCounter++;
+        frame.startMs = cpuNowMs();
+        recording = enabled;
+    }
+
+    // Call right before Core::finishFrame, on the serial list (it executes after every job list)
+    void endFrame()
+    {
+        if (!initialized || !recording)
+            return;
+
+        Frame& frame = frames[currentFrame];
+        UINT count = (UINT)(std::min)(frame.scopes.size(), (size_t)maxScopes);
+        if (readback && count > 0)
+        {
+            UINT base = currentFrame * maxScopes * 2;
+            core->getCommandList()->ResolveQueryData(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, base, count * 2,
+                readback, (UINT64)base * sizeof(UINT64));
+        }
+        frame.endMs = cpuNowMs();
+        frame.resolved = true;
+        recording = false;
+    }
+
+    int beginScope(const char* name)
+    {
+        if (!recording)
+            return -1;
+
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Frame& frame = frames[currentFrame];
+            id = (int)frame.scopes.size();
+            Scope scope;
+            scope.name = name;
+            scope.depth = threadDepth()++;
+            scope.thread = threadIndex();
+            scope.cpuStartMs = cpuNowMs();
+            frame.scopes.push_back(scope);
+        }
+
+        if (readback && id < (int)maxScopes)
+            core->getCommandList()->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, queryIndex(id, 0));
+        return id;
+    }
+
+    void endScope(int id)
+    {
+        if (id < 0)
+            return;
+
+        if (readback && id < (int)maxScopes)
+            core->getCommandList()->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, queryIndex(id, 1));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        frames[currentFrame].scopes[id].cpuEndMs = cpuNowMs();
+        threadDepth()--;
+    }
+
+    // Last frame whose GPU results have been read back
+    const ProfileFrame& getLastFrame() const { return lastFrame; }
+
+    // Timings of the last resolved frame; overlay rows are drawn in this order
+    void printReport() const
+    {
+        std::cout << "[Profiler] Frame " << lastFrame.frame << ": CPU " << lastFrame.cpuMs << " ms, GPU "
+            << lastFrame.gpuMs << " ms\n";
+        for (const auto& s : lastFrame.samples)
+        {
+            std::cout << "  " << std::string(s.depth * 2, ' ') << s.name << "  CPU " << s.cpuMs << " ms";
+            if (s.gpuMs >= 0.0f)
+                std::cout << "  GPU " << s.gpuMs << " ms";
+            std::cout << "  (thread " << s.thread << ")\n";
+        }
+    }
+
+    // One row per sample of every kept frame
+    bool writeCSV(const std::string& filename) const
+    {
+        std::ofstream file(filename);
+        if (!file)
+        {
+            std::cout << "[Profiler] ERROR: Cannot write " << filename << "\n";
+            return false;
+        }
+
+        file << "frame,scope,depth,thread,cpu_start_ms,cpu_ms,gpu_start_ms,gpu_ms\n";
+        for (const auto& frame : history)
+        {
+            file << frame.frame << ",Frame,0,0,0," << frame.cpuMs << ",," << frame.gpuMs << "\n";
+            for (const auto& s : frame.samples)
+            {
+                file << frame.frame << "," << s.name << "," << s.depth << "," << s.thread << ","
+                    << s.cpuStartMs << "," << s.cpuMs << ",";
+                if (s.gpuMs >= 0.0f)
+                    file << s.gpuStartMs << "," << s.gpuMs;
+                else
+                    file << ",";
+                file << "\n";
+            }
+        }
+        std::cout << "[Profiler] Wrote " << history.size() << " frames to " << filename << "\n";
+        return true;
+    }
+
+    // chrome://tracing / Perfetto JSON: CPU scopes per thread under pid 1, GPU scopes under pid 2
+    bool writeChromeTrace(const std::string& filename) const
+    {
+        std::ofstream file(filename);
+        if (!file)
+        {
+            std::cout << "[Profiler] ERROR: Cannot write " << filename << "\n";
+            return false;
+        }
+
+        file << "{\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}";
+        for (const auto& frame : history)
+        {
+            for (const auto& s : frame.samples)
+            {
+                file << ",\n{\"name\":\"" << s.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << s.thread
+                    << ",\"ts\":" << (s.cpuStartMs * 1000.0) << ",\"dur\":" << (s.cpuMs * 1000.0)
+                    << ",\"args\":{\"frame\":" << frame.frame << "}}";
+                if (s.gpuMs >= 0.0f)
+                {
+                    file << ",\n{\"name\":\"" << s.name << "\",\"ph\":\"X\",\"pid\":2,\"tid\":" << s.depth
+                        << ",\"ts\":" << (s.gpuStartMs * 1000.0) << ",\"dur\":" << (s.gpuMs * 1000.0)
+                        << ",\"args\":{\"frame\":" << frame.frame << "}}";
+                }
+            }
+        }
+        file << "\n]}\n";
+        std::cout << "[Profiler] Wrote Chrome trace of " << history.size() << " frames to " << filename << "\n";
+        return true;
+    }
+
+    // Bar per sample (GPU bar with a thin CPU bar under it), longest allowed bar = overlayBudgetMs.
+    // There is no font, so rows follow printReport's order.
+    void drawOverlay(PSOManager* psos)
+    {
+        if (!initialized || !showOverlay || lastFrame.samples.empty())
+            return;
+
+        const float left = -0.98f, top = 0.95f, width = 0.6f;
+        const float rowHeight = 0.03f, gpuHeight = 0.018f, cpuHeight = 0.007f;
+        int rows = (int)lastFrame.samples.size() + 1;
+
+        std::vector<STATIC_VERTEX> vertices;
+        vertices.reserve((rows * 2 + 2) * 6);
+
+        float bottom = top - rows * rowHeight;
+        addQuad(vertices, left - 0.01f, bottom - 0.01f, left + width + 0.01f, top + 0.01f, Vec3(0.0f, 0.0f, 0.0f), 0.6f);
+        addQuad(vertices, left + width, bottom, left + width + 0.003f, top, Vec3(1.0f, 1.0f, 1.0f), 0.8f);
+
+        auto barLength = [&](float ms) { return width * (std::min)(ms / overlayBudgetMs, 1.0f); };
+
+        // Whole frame first, then every scope
+        float y = top;
+        addQuad(vertices, left, y - gpuHeight, left + barLength(lastFrame.gpuMs), y, Vec3(1.0f, 1.0f, 1.0f), 0.9f);
+        addQuad(vertices, left, y - gpuHeight - cpuHeight, left + barLength(lastFrame.cpuMs), y - gpuHeight,
+            Vec3(0.6f, 0.6f, 0.6f), 0.9f);
+        for (const auto& s : lastFrame.samples)
+        {
+            y -= rowHeight;
+            float indent = s.depth * 0.01f;
+            Vec3 color = colorFor(s.name);
+            if (s.gpuMs >= 0.0f)
+                addQuad(vertices, left + indent, y - gpuHeight, left + indent + barLength(s.gpuMs), y, color, 0.9f);
+            addQuad(vertices, left + indent, y - gpuHeight - cpuHeight, left + indent + barLength(s.cpuMs),
+                y - gpuHeight, color * 0.5f, 0.9f);
+        }
+
+        UINT bytes = (UINT)(vertices.size() * sizeof(STATIC_VERTEX));
+        FrameAllocation alloc = core->frameAllocator.upload(vertices.data(), bytes, 16);
+
+        D3D12_VERTEX_BUFFER_VIEW view;
+        view.BufferLocation = alloc.gpuAddress;
+        view.StrideInBytes = sizeof(STATIC_VERTEX);
+        view.SizeInBytes = bytes;
+
+        overlayShader->apply(core);
+        psos->bind(core, overlayPSO);
+        core->getCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        core->getCommandList()->IASetVertexBuffers(0, 1, &view);
+        core->getCommandList()->DrawInstanced((UINT)vertices.size(), 1, 0, 0);
+    }
+
+    void release()
+    {
+        if (readback) readback->Release();
+        if (queryHeap) queryHeap->Release();
+        readback = nullptr;
+        queryHeap = nullptr;
+        initialized = false;
+        recording = false;
+    }
+
+private:
+    struct Scope
+    {
+        std::string name;
+        int depth = 0;
+        int thread = 0;
+        double cpuStartMs = 0.0;
+        double cpuEndMs = -1.0;
+    };
+
+    struct Frame
+    {
+        std::vector<Scope> scopes;
+        unsigned long long frameNumber = 0;
+        double startMs = 0.0;
+        double endMs = 0.0;
+        bool resolved = false;
+    };
+
+    Core* core = nullptr;
+    bool initialized = false;
+    bool recording = false;
+    unsigned int maxScopes = 0;
+    unsigned int framesInFlight = 0;
+    unsigned int currentFrame = 0;
+    unsigned long long frameCounter = 0;
+    std::vector<Frame> frames;
+    std::mutex mutex;
+
+    ID3D12QueryHeap* queryHeap = nullptr;
+    ID3D12Resource* readback = nullptr;
+    UINT64 gpuFrequency = 1;
+    UINT64 gpuCalibration = 0;
+    UINT64 cpuCalibration = 0;
+    double cpuFrequency = 1.0;
+
+    ProfileFrame lastFrame;
+    std::deque<ProfileFrame> history;
+
+    Shader* overlayShader = nullptr;
+    PSOHandle overlayPSO = INVALID_PSO;
+
+    UINT queryIndex(int id, int end) const
+    {
+        return currentFrame * maxScopes * 2 + id * 2 + end;
+    }
+
+    double cpuNowMs() const
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return ((double)now.QuadPart - (double)cpuCalibration) * 1000.0 / cpuFrequency;
+    }
+
+    // Both clocks read zero at the calibration point
+    double gpuToCpuMs(UINT64 ticks) const
+    {
+        return ((double)ticks - (double)gpuCalibration) * 1000.0 / (double)gpuFrequency;
+    }
+
+    static int& threadDepth()
+    {
+        static thread_local int depth = 0;
+        return depth;
+    }
+
+    static int threadIndex()
+    {
+        static std::atomic<int> nextIndex{ 0 };
+        static thread_local int index = nextIndex.fetch_add(1);
+        return index;
+    }
+
+    // Turn the finished frame stored at frameIndex into lastFrame (+ history)
+    void collect(unsigned int frameIndex)
+    {
+        Frame& frame = frames[frameIndex];
+        if (!frame.resolved)
+            return;
+        frame.resolved = false;
+
+        ProfileFrame result;
+        result.frame = frame.frameNumber;
+        result.cpuMs = (float)(frame.endMs - frame.startMs);
+
+        const UINT64* ticks = nullptr;
+        UINT count = (UINT)(std::min)(frame.scopes.size(), (size_t)maxScopes);
+        D3D12_RANGE readRange = { (SIZE_T)frameIndex * maxScopes * 2 * sizeof(UINT64),
+            (SIZE_T)(frameIndex * maxScopes * 2 + count * 2) * sizeof(UINT64) };
+        void* mapped = nullptr;
+        if (readback && count > 0 && SUCCEEDED(readback->Map(0, &readRange, &mapped)))
+            ticks = (const UINT64*)mapped + (size_t)frameIndex * maxScopes * 2;
+
+        double gpuFirst = 1e30, gpuLast = -1e30;
+        for (size_t i = 0; i < frame.scopes.size(); i++)
+        {
+            const Scope& scope = frame.scopes[i];
+            ProfileSample sample;
+            sample.name = scope.name;
+            sample.depth = scope.depth;
+            sample.thread = scope.thread;
+            sample.cpuStartMs = scope.cpuStartMs;
+            sample.cpuMs = (float)((scope.cpuEndMs >= 0.0 ? scope.cpuEndMs : scope.cpuStartMs) - scope.cpuStartMs);
+            if (ticks && i < count && ticks[i * 2 + 1] >= ticks[i * 2])
+            {
+                sample.gpuStartMs = gpuToCpuMs(ticks[i * 2]);
+                sample.gpuMs = (float)((double)(ticks[i * 2 + 1] - ticks[i * 2]) * 1000.0 / (double)gpuFrequency);
+                gpuFirst = (std::min)(gpuFirst, sample.gpuStartMs);
+                gpuLast = (std::max)(gpuLast, sample.gpuStartMs + sample.gpuMs);
+            }
+            result.samples.push_back(sample);
+        }
+        if (mapped)
+        {
+            D3D12_RANGE writeRange = { 0, 0 };
+            readback->Unmap(0, &writeRange);
+        }
+        result.gpuMs = (gpuLast > gpuFirst) ? (float)(gpuLast - gpuFirst) : 0.0f;
+
+        lastFrame = result;
+        history.push_back(std::move(result));
+        while ((int)history.size() > historyFrames)
+            history.pop_front();
+    }
+
+    // Stable colour per scope name
+    static Vec3 colorFor(const std::string& name)
+    {
+        unsigned int h = 2166136261u;
+        for (char c : name)
+            h = (h ^ (unsigned char)c) * 16777619u;
+        return Vec3(0.3f + 0.7f * ((h & 0xFF) / 255.0f), 0.3f + 0.7f * (((h >> 8) & 0xFF) / 255.0f),
+            0.3f + 0.7f * (((h >> 16) & 0xFF) / 255.0f));
+    }
+
+    // NDC quad as two triangles; colour travels in the normal, alpha in tu
+    static void addQuad(std::vector<STATIC_VERTEX>& vertices, float x1, float y1, float x2, float y2,
+        const Vec3& color, float alpha)
+    {
+        STATIC_VERTEX v;
+        v.normal = color;
+        v.tangent = Vec3(1, 0, 0);
+        v.tu = alpha;
+        v.tv = 0.0f;
+
+        const float xs[6] = { x1, x2, x1, x2, x2, x1 };
+        const float ys[6] = { y1, y1, y2, y1, y2, y2 };
+        for (int i = 0; i < 6; i++)
+        {
+            v.pos = Vec3(xs[i], ys[i], 0.0f);
+            vertices.push_back(v);
+        }
+    }
+};
+
+// RAII marker: CPU time of the enclosing block and GPU time of what it records on core->getCommandList()
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) : id(Profiler::get().beginScope(name)) {}
+    ~ProfileScope() { Profiler::get().endScope(id); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int id;
+};
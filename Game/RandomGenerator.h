@@ -4,16 +4,23 @@
 #include "Mesh.h"
 #include "Maths.h"
 #include "HeightmapTerrain.h"
+#include "ThreadPool.h"
+#include "Hash.h"
 #include <vector>
 #include <random>
 #include <cmath>
 #include <algorithm>
 #include <unordered_set>
 #include <functional>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <emmintrin.h>
 
 // Vegetation generator using grid-based spawn points with jitter to guarantee coverage.
 // Uses noise to bias rock vs grass, optional clustering for natural patches,
 // and a spatial hash grid to enforce minimum spacing / avoid overlaps.
+// Full-map generation is tile-parallel and cached on disk; noise and terrain sampling run 4 points per SSE call.
 
 enum class VegetationType
 {
@@ -91,12 +98,12 @@ struct VegetationConfig
 class SpatialHashGrid
 {
 public:
-    // Build a 2D grid covering [-worldSize/2, +worldSize/2] with given cell size.
-    void init(float worldSizeX, float worldSizeZ, float cellSize)
+    // Build a 2D grid covering [center - worldSize/2, center + worldSize/2] with given cell size.
+    void init(float worldSizeX, float worldSizeZ, float cellSize, float centerX = 0.0f, float centerZ = 0.0f)
     {
         this->cellSize = cellSize;
-        this->offsetX = worldSizeX * 0.5f;
-        this->offsetZ = worldSizeZ * 0.5f;
+        this->offsetX = worldSizeX * 0.5f - centerX;
+        this->offsetZ = worldSizeZ * 0.5f - centerZ;
         this->gridWidth = (int)std::ceil(worldSizeX / cellSize) + 1;
         this->gridHeight = (int)std::ceil(worldSizeZ / cellSize) + 1;
 
@@ -235,6 +242,51 @@ public:
         return total / maxValue;
     }
 
+    // SSE noise2D for 4 points; each lane matches the scalar call exactly (permutation lookups are scalar)
+    void noise2D4(const float* xs, const float* ys, float* out) const
+    {
+        _mm_storeu_ps(out, noise2D4(_mm_loadu_ps(xs), _mm_loadu_ps(ys)));
+    }
+
+    // SSE fbm for 4 points
+    void fbm4(const float* xs, const float* ys, float* out, int octaves = 4, float persistence = 0.5f) const
+    {
+        __m128 x = _mm_loadu_ps(xs);
+        __m128 y = _mm_loadu_ps(ys);
+        __m128 total = _mm_setzero_ps();
+        float amplitude = 1.0f;
+        float frequency = 1.0f;
+        float maxValue = 0.0f;
+
+        for (int i = 0; i < octaves; i++)
+        {
+            __m128 f = _mm_set1_ps(frequency);
+            __m128 n = noise2D4(_mm_mul_ps(x, f), _mm_mul_ps(y, f));
+            total = _mm_add_ps(total, _mm_mul_ps(n, _mm_set1_ps(amplitude)));
+            maxValue += amplitude;
+            amplitude *= persistence;
+            frequency *= 2.0f;
+        }
+
+        _mm_storeu_ps(out, _mm_div_ps(total, _mm_set1_ps(maxValue)));
+    }
+
+    // fbm over count points, 4 at a time
+    void fbmArray(const float* xs, const float* ys, float* out, int count, int octaves = 4, float persistence = 0.5f) const
+    {
+        int i = 0;
+        for (; i + 4 <= count; i += 4)
+            fbm4(xs + i, ys + i, out + i, octaves, persistence);
+
+        if (i < count)
+        {
+            float tx[4] = {}, ty[4] = {}, tout[4];
+            for (int j = 0; i + j < count; j++) { tx[j] = xs[i + j]; ty[j] = ys[i + j]; }
+            fbm4(tx, ty, tout, octaves, persistence);
+            for (int j = 0; i + j < count; j++) out[i + j] = tout[j];
+        }
+    }
+
 private:
     float fade(float t) const { return t * t * t * (t * (t * 6 - 15) + 10); }
     float lerp(float t, float a, float b) const { return a + t * (b - a); }
@@ -248,14 +300,100 @@ private:
         return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f * v : 2.0f * v);
     }
 
+    // floor for |v| < 2^31: truncate, then step down where that rounded up
+    static __m128 floor4(__m128 v)
+    {
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1.0f)));
+    }
+
+    static __m128 fade4(__m128 t)
+    {
+        __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+        return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+    }
+
+    static __m128 lerp4(__m128 t, __m128 a, __m128 b)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+    }
+
+    // grad() with selects: bit 1 swaps x/y and negates v, bit 0 negates u
+    static __m128 grad4(__m128i hash, __m128 x, __m128 y)
+    {
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(hash, two), two));
+        __m128 negU = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(hash, one), one));
+
+        __m128 u = _mm_or_ps(_mm_and_ps(swap, y), _mm_andnot_ps(swap, x));
+        __m128 v = _mm_or_ps(_mm_and_ps(swap, x), _mm_andnot_ps(swap, y));
+        u = _mm_xor_ps(u, _mm_and_ps(negU, sign));
+        v = _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(2.0f), v), _mm_and_ps(swap, sign));
+        return _mm_add_ps(u, v);
+    }
+
+    __m128 noise2D4(__m128 x, __m128 y) const
+    {
+        __m128 fx = floor4(x);
+        __m128 fy = floor4(y);
+
+        alignas(16) int X[4], Y[4];
+        _mm_store_si128((__m128i*)X, _mm_and_si128(_mm_cvttps_epi32(fx), _mm_set1_epi32(255)));
+        _mm_store_si128((__m128i*)Y, _mm_and_si128(_mm_cvttps_epi32(fy), _mm_set1_epi32(255)));
+
+        alignas(16) int hAA[4], hBA[4], hAB[4], hBB[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int A = perm[X[i]] + Y[i];
+            int B = perm[X[i] + 1] + Y[i];
+            hAA[i] = perm[perm[A]];
+            hAB[i] = perm[perm[A + 1]];
+            hBA[i] = perm[perm[B]];
+            hBB[i] = perm[perm[B + 1]];
+        }
+
+        x = _mm_sub_ps(x, fx);
+        y = _mm_sub_ps(y, fy);
+        __m128 u = fade4(x);
+        __m128 v = fade4(y);
+
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 x1 = _mm_sub_ps(x, one);
+        __m128 y1 = _mm_sub_ps(y, one);
+
+        __m128 g00 = grad4(_mm_load_si128((const __m128i*)hAA), x, y);
+        __m128 g10 = grad4(_mm_load_si128((const __m128i*)hBA), x1, y);
+        __m128 g01 = grad4(_mm_load_si128((const __m128i*)hAB), x, y1);
+        __m128 g11 = grad4(_mm_load_si128((const __m128i*)hBB), x1, y1);
+
+        return lerp4(v, lerp4(u, g00, g10), lerp4(u, g01, g11));
+    }
+
     int perm[512];
 };
 
+// Disk cache of a full generate() result: header + raw VegetationItem arrays
+static const unsigned int VEG_LAYOUT_MAGIC = 0x4E474756; // 'VGGN'
+static const unsigned int VEG_LAYOUT_VERSION = 1;
+
 class VegetationGenerator
 {
 public:
+    // generate() splits the terrain into tileSize x tileSize tiles built in parallel; the same size
+    // as the streaming chunks gives the same per-tile layout either way
+    float tileSize = 32.0f;
+
+    // Non-empty: generate() loads/stores its result here, keyed by seed, config, terrain size and heights
+    std::string cacheDirectory;
+
     // Main entry: generates grass + rocks over a rectangular terrain area centered at origin.
-    // Uses a deterministic seed if provided (seed=0 picks a random seed via random_device).
+    // Uses a deterministic seed if provided (seed=0 picks a random seed via random_device and skips the cache).
+    // Tiles are generated on the ThreadPool with generateTile(), each from its own (seed, tile) RNG
+    // stream, then merged in tile order with a seam pass that enforces spacing across tile edges -
+    // the result does not depend on the thread count.
     void generate(
         HeightmapTerrain* terrain,
         const VegetationConfig& config,
@@ -266,56 +404,143 @@ public:
         std::cout << "\n[VegetationGenerator] Starting generation...\n";
         std::cout << "  Terrain size: " << terrainSizeX << " x " << terrainSizeZ << "\n";
 
+        bool useCache = !cacheDirectory.empty() && seed != 0;
         if (seed == 0)
         {
             std::random_device rd;
             seed = rd();
         }
 
-        rng.seed(seed);
+        this->terrain = terrain;
+        this->config = config;
+        this->terrainSizeX = terrainSizeX;
+        this->terrainSizeZ = terrainSizeZ;
+
+        grassItems.clear();
+        rockItems.clear();
+        clusterCount = 0;
+
+        unsigned long long cacheKey = useCache ? makeCacheKey(seed) : 0;
+        if (useCache && loadFromCache(cacheKey))
+        {
+            std::cout << "[VegetationGenerator] Loaded from cache (" << cachePath() << ")\n";
+            printSummary();
+            return;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+
+        int tilesX = (std::max)(1, (int)std::ceil(terrainSizeX / tileSize));
+        int tilesZ = (std::max)(1, (int)std::ceil(terrainSizeZ / tileSize));
+        std::cout << "[VegetationGenerator] Placing vegetation in " << tilesX << " x " << tilesZ << " tiles ("
+            << tileSize << "m, " << (ThreadPool::get().getThreadCount() + 1) << " threads)...\n";
+
+        std::vector<VegetationGenerator> tiles(tilesX * tilesZ);
+        ThreadPool::get().parallelFor(tilesX * tilesZ, [&](int index)
+        {
+            tiles[index].generateTile(terrain, config, terrainSizeX, terrainSizeZ,
+                index % tilesX, index / tilesX, tileSize, seed);
+        });
+
+        int seamRejects = mergeTiles(tiles);
+
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "[VegetationGenerator] Generation complete! (" << ms << " ms)\n";
+        std::cout << "  Removed at tile seams: " << seamRejects << "\n";
+        printSummary();
+
+        if (useCache)
+            saveToCache(cacheKey);
+    }
+
+    // Generate a single tile [minX, minX + tileSize) x [minZ, minZ + tileSize) of a terrainSizeX x terrainSizeZ
+    // world, for streaming. The RNG is seeded from (seed, tileX, tileZ), so a tile comes out the same
+    // whichever thread builds it and in whatever order; the noise uses the world seed so biomes stay
+    // continuous across tiles. Items are clipped to the tile, so neighbours never duplicate one
+    // (spacing is only enforced inside a tile; generate() adds the seam pass). Quiet: no logging.
+    void generateTile(
+        HeightmapTerrain* terrain,
+        const VegetationConfig& config,
+        float terrainSizeX,
+        float terrainSizeZ,
+        int tileX,
+        int tileZ,
+        float tileSize,
+        unsigned int seed)
+    {
+        unsigned int tileSeed = seed ^ (0x9E3779B9u * (unsigned int)(tileX + 1)) ^ (0x85EBCA6Bu * (unsigned int)(tileZ + 1));
+        rng.seed(tileSeed);
         noise = NoiseGenerator(seed);
 
         this->terrain = terrain;
         this->config = config;
         this->terrainSizeX = terrainSizeX;
         this->terrainSizeZ = terrainSizeZ;
+        setupDistributions();
 
-        // Reset output lists and rebuild the spatial grid for this terrain size.
         grassItems.clear();
         rockItems.clear();
+        clusterCount = 0;
+
+        getTileBounds(tileX, tileZ, tileSize, tileMinX, tileMinZ, tileMaxX, tileMaxZ);
+        clipToTile = true;
 
-        float cellSize = std::max(config.rockRadius, config.grassRadius) * 4.0f;
-        spatialGrid.init(terrainSizeX, terrainSizeZ, cellSize);
+        // Clusters can reach past the tile edge before clipping, so the grid covers that margin too.
+        // Cells are at least two max-scaled radii wide so the 3x3 overlap lookup sees every neighbour.
+        float cellSize = (std::max)(std::max(config.rockRadius, config.grassRadius) * 4.0f, getMaxItemRadius() * 2.0f);
+        float margin = std::max(config.rockCluster.radius, config.grassCluster.radius);
+        spatialGrid.init(tileSize + margin * 2.0f, tileSize + margin * 2.0f, cellSize,
+            tileMinX + tileSize * 0.5f, tileMinZ + tileSize * 0.5f);
 
-        // Generate candidate points on a regular grid, then jitter and optionally skip to avoid visible patterns.
-        std::cout << "[VegetationGenerator] Generating spawn points (grid-based)...\n";
-        std::vector<Vec2> spawnPoints = generateSpawnPointsGrid();
-        std::cout << "  Generated " << spawnPoints.size() << " spawn points\n";
+        // Cells of the world lattice whose centres fall inside this tile
+        float halfX = terrainSizeX * 0.5f;
+        float halfZ = terrainSizeZ * 0.5f;
+        float spacing = getSpawnSpacing();
+        int gxBegin = (std::max)(0, (int)std::ceil((tileMinX + halfX) / spacing - 0.5f));
+        int gxEnd = (std::min)((int)std::ceil(terrainSizeX / spacing), (int)std::ceil((tileMaxX + halfX) / spacing - 0.5f));
+        int gzBegin = (std::max)(0, (int)std::ceil((tileMinZ + halfZ) / spacing - 0.5f));
+        int gzEnd = (std::min)((int)std::ceil(terrainSizeZ / spacing), (int)std::ceil((tileMaxZ + halfZ) / spacing - 0.5f));
 
-        // For each candidate point, choose rock/grass by noise-biased probability and spawn either a single item or a cluster.
-        std::cout << "[VegetationGenerator] Placing vegetation...\n";
-        int clusterCount = 0;
+        std::vector<SpawnPoint> spawnPoints = generateSpawnPoints(gxBegin, gxEnd, gzBegin, gzEnd, spacing);
 
-        for (const auto& point : spawnPoints)
+        // Biome noise for every spawn point up front, 4 per call
+        std::vector<float> xs(spawnPoints.size()), zs(spawnPoints.size()), noiseValues(spawnPoints.size());
+        for (size_t i = 0; i < spawnPoints.size(); i++)
         {
-            VegetationType type = determineType(point.x, point.y);
-            bool isCluster = shouldGenerateCluster(type);
+            xs[i] = spawnPoints[i].x * config.noiseScale;
+            zs[i] = spawnPoints[i].z * config.noiseScale;
+        }
+        noise.fbmArray(xs.data(), zs.data(), noiseValues.data(), (int)spawnPoints.size(), 4, 0.5f);
 
-            if (isCluster)
-            {
-                clusterCount++;
-                generateCluster(point.x, point.y, type);
-            }
+        for (size_t i = 0; i < spawnPoints.size(); i++)
+        {
+            const SpawnPoint& point = spawnPoints[i];
+            VegetationType type = determineType(noiseValues[i]);
+            if (shouldGenerateCluster(type))
+                generateCluster(point, type);
             else
-            {
-                tryPlaceItem(point.x, point.y, type);
-            }
+                tryPlaceItem(point.x, point.z, point.height, type);
         }
 
-        std::cout << "[VegetationGenerator] Generation complete!\n";
-        std::cout << "  Grass items: " << grassItems.size() << "\n";
-        std::cout << "  Rock items: " << rockItems.size() << "\n";
-        std::cout << "  Clusters generated: " << clusterCount << "\n";
+        clipToTile = false;
+    }
+
+    // Everything a generated layout depends on: config, seed, terrain size, tile size and heightmap.
+    // Also keys the VegetationStreamer's chunk cache (tileSize = chunk size there).
+    static unsigned long long makeCacheKey(const HeightmapTerrain* terrain, const VegetationConfig& config,
+        float terrainSizeX, float terrainSizeZ, float tileSize, unsigned int seed)
+    {
+        unsigned long long key = hashBytes(&config, sizeof(config));
+        key = hashBytes(&seed, sizeof(seed), key);
+        key = hashBytes(&terrainSizeX, sizeof(terrainSizeX), key);
+        key = hashBytes(&terrainSizeZ, sizeof(terrainSizeZ), key);
+        key = hashBytes(&tileSize, sizeof(tileSize), key);
+        if (terrain)
+        {
+            const std::vector<float>& heights = terrain->getHeights();
+            key = hashBytes(heights.data(), heights.size() * sizeof(float), key);
+        }
+        return key;
     }
 
     // Access the generated vegetation lists (use these to feed your instancing systems).
@@ -335,8 +560,6 @@ public:
             inst.rotationY = item.rotationY;
             inst.scale = item.scale;
             inst.typeIndex = item.typeIndex;
-            inst.distanceToCamera = 0.0f;
-            inst.lodLevel = 2;
             instances.push_back(inst);
         }
 
@@ -344,97 +567,184 @@ public:
     }
 
 private:
-    // Build spawn points covering the full map using grid spacing derived from density/minPointSpacing.
-    // Points are jittered within each cell and optionally skipped to create a more organic distribution.
-    std::vector<Vec2> generateSpawnPointsGrid()
+    // Validated spawn candidate (height already sampled)
+    struct SpawnPoint
     {
-        std::vector<Vec2> points;
+        float x, z;
+        float height;
+    };
 
+    // World-space bounds of tile (tileX, tileZ), clamped to the terrain
+    void getTileBounds(int tileX, int tileZ, float size, float& minX, float& minZ, float& maxX, float& maxZ) const
+    {
         float halfX = terrainSizeX * 0.5f;
         float halfZ = terrainSizeZ * 0.5f;
+        minX = -halfX + tileX * size;
+        minZ = -halfZ + tileZ * size;
+        maxX = (std::min)(minX + size, halfX);
+        maxZ = (std::min)(minZ + size, halfZ);
+    }
 
+    // Grid spacing from density, never below minPointSpacing
+    float getSpawnSpacing() const
+    {
         float spacing = config.minPointSpacing;
         if (config.density > 0)
         {
             spacing = std::max(spacing, 1.0f / std::sqrt(config.density));
         }
+        return spacing;
+    }
+
+    // Largest collision radius any item can get
+    float getMaxItemRadius() const
+    {
+        return (std::max)(config.rockRadius * config.rockMaxScale, config.grassRadius * config.grassMaxScale);
+    }
+
+    // Config-dependent distributions, built once per run instead of per call
+    void setupDistributions()
+    {
+        randRockScale = std::uniform_real_distribution<float>(config.rockMinScale, config.rockMaxScale);
+        randGrassScale = std::uniform_real_distribution<float>(config.grassMinScale, config.grassMaxScale);
+        randRockCount = std::uniform_int_distribution<int>(config.rockCluster.minItems, config.rockCluster.maxItems);
+        randGrassCount = std::uniform_int_distribution<int>(config.grassCluster.minItems, config.grassCluster.maxItems);
+
+        // Slope limits as squared gradients, so the batch filter needs no atan
+        const float degToRad = 3.14159265f / 180.0f;
+        minSlopeGradSq = (config.minSlope > 0.0f) ? std::tan(config.minSlope * degToRad) : -1.0f;
+        minSlopeGradSq = (minSlopeGradSq > 0.0f) ? minSlopeGradSq * minSlopeGradSq : -1.0f;
+        maxSlopeGradSq = (config.maxSlope < 90.0f) ? std::tan(config.maxSlope * degToRad) : 1e30f;
+        maxSlopeGradSq = (maxSlopeGradSq < 1e15f) ? maxSlopeGradSq * maxSlopeGradSq : 1e30f;
+    }
 
-        int gridCountX = (int)std::ceil(terrainSizeX / spacing);
-        int gridCountZ = (int)std::ceil(terrainSizeZ / spacing);
+    // Jittered, shuffled spawn points for lattice cells [gxBegin, gxEnd) x [gzBegin, gzEnd).
+    // Candidates are drawn first, then filtered against the terrain in batches of 4.
+    std::vector<SpawnPoint> generateSpawnPoints(int gxBegin, int gxEnd, int gzBegin, int gzEnd, float spacing)
+    {
+        std::vector<float> xs, zs;
 
-        std::cout << "  Grid: " << gridCountX << " x " << gridCountZ
-            << " (spacing: " << spacing << "m)\n";
+        float halfX = terrainSizeX * 0.5f;
+        float halfZ = terrainSizeZ * 0.5f;
 
         float jitterAmount = spacing * 0.4f;
-        std::uniform_real_distribution<float> jitterX(-jitterAmount, jitterAmount);
-        std::uniform_real_distribution<float> jitterZ(-jitterAmount, jitterAmount);
-        std::uniform_real_distribution<float> skipChance(0.0f, 1.0f);
+        std::uniform_real_distribution<float> jitter(-jitterAmount, jitterAmount);
 
-        for (int gz = 0; gz < gridCountZ; gz++)
+        for (int gz = gzBegin; gz < gzEnd; gz++)
         {
-            for (int gx = 0; gx < gridCountX; gx++)
+            for (int gx = gxBegin; gx < gxEnd; gx++)
             {
                 float baseX = -halfX + (gx + 0.5f) * spacing;
                 float baseZ = -halfZ + (gz + 0.5f) * spacing;
 
-                float x = baseX + jitterX(rng);
-                float z = baseZ + jitterZ(rng);
+                float x = baseX + jitter(rng);
+                float z = baseZ + jitter(rng);
 
                 x = std::clamp(x, -halfX + 1.0f, halfX - 1.0f);
                 z = std::clamp(z, -halfZ + 1.0f, halfZ - 1.0f);
 
-                if (skipChance(rng) < 0.1f)
-                    continue;
-
-                if (!isValidTerrainLocation(x, z))
+                if (rand01(rng) < 0.1f)
                     continue;
 
-                points.push_back(Vec2(x, z));
+                xs.push_back(x);
+                zs.push_back(z);
             }
         }
 
+        std::vector<float> heights(xs.size());
+        std::vector<unsigned char> valid(xs.size());
+        filterTerrainLocations(xs.data(), zs.data(), (int)xs.size(), heights.data(), valid.data());
+
+        std::vector<SpawnPoint> points;
+        points.reserve(xs.size());
+        for (size_t i = 0; i < xs.size(); i++)
+        {
+            if (valid[i])
+                points.push_back({ xs[i], zs[i], heights[i] });
+        }
+
         std::shuffle(points.begin(), points.end(), rng);
         return points;
     }
 
-    // Validate placement against height and slope constraints by sampling the heightmap.
-    bool isValidTerrainLocation(float x, float z)
+    // Height and slope filter for count points, 4 per SSE pass (centre plus the 4 slope taps).
+    // Writes the centre height of every point and valid = 1 where it passes.
+    void filterTerrainLocations(const float* xs, const float* zs, int count, float* outHeights, unsigned char* outValid) const
     {
-        if (!terrain) return true;
-
-        float height = terrain->sampleHeightWorld(x, z);
-
-        if (height < config.minHeight || height > config.maxHeight)
-            return false;
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = (std::min)(4, count - i);
+            alignas(16) float x[4], z[4];
+            for (int j = 0; j < 4; j++)
+            {
+                x[j] = xs[i + (std::min)(j, n - 1)];
+                z[j] = zs[i + (std::min)(j, n - 1)];
+            }
 
-        float delta = 0.5f;
-        float h1 = terrain->sampleHeightWorld(x + delta, z);
-        float h2 = terrain->sampleHeightWorld(x - delta, z);
-        float h3 = terrain->sampleHeightWorld(x, z + delta);
-        float h4 = terrain->sampleHeightWorld(x, z - delta);
+            alignas(16) float heights[4];
+            unsigned char valid[4];
+            filterTerrainLocations4(x, z, heights, valid);
 
-        float slopeX = (h1 - h2) / (2.0f * delta);
-        float slopeZ = (h3 - h4) / (2.0f * delta);
-        float slopeAngle = std::atan(std::sqrt(slopeX * slopeX + slopeZ * slopeZ)) * 180.0f / 3.14159265f;
+            for (int j = 0; j < n; j++)
+            {
+                outHeights[i + j] = heights[j];
+                outValid[i + j] = valid[j];
+            }
+        }
+    }
 
-        if (slopeAngle < config.minSlope || slopeAngle > config.maxSlope)
-            return false;
+    void filterTerrainLocations4(const float* xs, const float* zs, float* outHeights, unsigned char* outValid) const
+    {
+        if (!terrain)
+        {
+            for (int j = 0; j < 4; j++) { outHeights[j] = 0.0f; outValid[j] = 0; }
+            return;
+        }
 
-        return true;
+        const float delta = 0.5f;
+        __m128 x = _mm_loadu_ps(xs);
+        __m128 z = _mm_loadu_ps(zs);
+        __m128 d = _mm_set1_ps(delta);
+
+        alignas(16) float xp[4], xn[4], zp[4], zn[4];
+        _mm_store_ps(xp, _mm_add_ps(x, d));
+        _mm_store_ps(xn, _mm_sub_ps(x, d));
+        _mm_store_ps(zp, _mm_add_ps(z, d));
+        _mm_store_ps(zn, _mm_sub_ps(z, d));
+
+        alignas(16) float h[4], h1[4], h2[4], h3[4], h4[4];
+        terrain->sampleHeightWorld4(xs, zs, h);
+        terrain->sampleHeightWorld4(xp, zs, h1);
+        terrain->sampleHeightWorld4(xn, zs, h2);
+        terrain->sampleHeightWorld4(xs, zp, h3);
+        terrain->sampleHeightWorld4(xs, zn, h4);
+
+        __m128 height = _mm_load_ps(h);
+        __m128 inv = _mm_set1_ps(1.0f / (2.0f * delta));
+        __m128 slopeX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h1), _mm_load_ps(h2)), inv);
+        __m128 slopeZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h3), _mm_load_ps(h4)), inv);
+        __m128 gradSq = _mm_add_ps(_mm_mul_ps(slopeX, slopeX), _mm_mul_ps(slopeZ, slopeZ));
+
+        __m128 ok = _mm_and_ps(_mm_cmpge_ps(height, _mm_set1_ps(config.minHeight)), _mm_cmple_ps(height, _mm_set1_ps(config.maxHeight)));
+        ok = _mm_and_ps(ok, _mm_cmpge_ps(gradSq, _mm_set1_ps(minSlopeGradSq)));
+        ok = _mm_and_ps(ok, _mm_cmple_ps(gradSq, _mm_set1_ps(maxSlopeGradSq)));
+
+        int mask = _mm_movemask_ps(ok);
+        _mm_storeu_ps(outHeights, height);
+        for (int j = 0; j < 4; j++)
+            outValid[j] = (mask >> j) & 1;
     }
 
-    // Decide grass vs rock using a baseline probability plus FBM noise for spatial variation.
-    VegetationType determineType(float x, float z)
+    // Decide grass vs rock using a baseline probability plus FBM noise (precomputed in [-1, 1]) for spatial variation.
+    VegetationType determineType(float noiseValue)
     {
         float rockChance = config.rockProbability;
 
-        float noiseValue = noise.fbm(x * config.noiseScale, z * config.noiseScale, 4, 0.5f);
         noiseValue = (noiseValue + 1.0f) * 0.5f;
 
         rockChance += (noiseValue - 0.5f) * config.noiseInfluence * 2.0f;
         rockChance = std::clamp(rockChance, 0.05f, 0.95f);
 
-        std::uniform_real_distribution<float> rand01(0.0f, 1.0f);
         return (rand01(rng) < rockChance) ? VegetationType::Rock : VegetationType::Grass;
     }
 
@@ -445,25 +755,25 @@ private:
             ? config.rockCluster
             : config.grassCluster;
 
-        std::uniform_real_distribution<float> rand01(0.0f, 1.0f);
         return rand01(rng) < clusterConfig.probability;
     }
 
-    // Spawn a cluster: place the center item first, then scatter remaining items with falloff from the center.
-    void generateCluster(float centerX, float centerZ, VegetationType type)
+    // Spawn a cluster: the center item first, then the remaining items scattered with falloff from the center.
+    // All member positions are drawn before any is placed so they can be terrain-filtered in one batch.
+    void generateCluster(const SpawnPoint& center, VegetationType type)
     {
         const ClusterConfig& clusterConfig = (type == VegetationType::Rock)
             ? config.rockCluster
             : config.grassCluster;
 
-        std::uniform_int_distribution<int> randCount(clusterConfig.minItems, clusterConfig.maxItems);
-        int itemCount = randCount(rng);
-
-        std::uniform_real_distribution<float> randAngle(0.0f, 2.0f * 3.14159265f);
-        std::uniform_real_distribution<float> rand01(0.0f, 1.0f);
+        int itemCount = (type == VegetationType::Rock) ? randRockCount(rng) : randGrassCount(rng);
+        clusterCount++;
 
-        tryPlaceItem(centerX, centerZ, type);
+        float halfX = terrainSizeX * 0.5f;
+        float halfZ = terrainSizeZ * 0.5f;
 
+        clusterXs.clear();
+        clusterZs.clear();
         for (int i = 1; i < itemCount; i++)
         {
             float t = rand01(rng);
@@ -473,50 +783,49 @@ private:
             distance *= jitter;
 
             float angle = randAngle(rng);
-            float x = centerX + std::cos(angle) * distance;
-            float z = centerZ + std::sin(angle) * distance;
+            float x = center.x + std::cos(angle) * distance;
+            float z = center.z + std::sin(angle) * distance;
 
-            float halfX = terrainSizeX * 0.5f;
-            float halfZ = terrainSizeZ * 0.5f;
             if (x < -halfX || x > halfX || z < -halfZ || z > halfZ)
                 continue;
 
-            tryPlaceItem(x, z, type);
+            clusterXs.push_back(x);
+            clusterZs.push_back(z);
+        }
+
+        int count = (int)clusterXs.size();
+        clusterHeights.resize(count);
+        clusterValid.resize(count);
+        filterTerrainLocations(clusterXs.data(), clusterZs.data(), count, clusterHeights.data(), clusterValid.data());
+
+        tryPlaceItem(center.x, center.z, center.height, type);
+        for (int i = 0; i < count; i++)
+        {
+            if (clusterValid[i])
+                tryPlaceItem(clusterXs[i], clusterZs[i], clusterHeights[i], type);
         }
     }
 
-    // Attempt to place a single item by sampling height, randomizing scale/rotation/typeIndex, and enforcing overlap rules.
-    bool tryPlaceItem(float x, float z, VegetationType type)
+    // Attempt to place a single terrain-validated item: randomize scale/rotation/typeIndex and enforce overlap rules.
+    bool tryPlaceItem(float x, float z, float y, VegetationType type)
     {
-        if (!terrain) return false;
-
-        if (!isValidTerrainLocation(x, z))
+        if (clipToTile && (x < tileMinX || x >= tileMaxX || z < tileMinZ || z >= tileMaxZ))
             return false;
 
-        float y = terrain->sampleHeightWorld(x, z);
-
         float radius, scale;
         int typeIndex;
 
-        std::uniform_real_distribution<float> randRotation(0.0f, 2.0f * 3.14159265f);
-
         if (type == VegetationType::Rock)
         {
-            std::uniform_real_distribution<float> randScale(config.rockMinScale, config.rockMaxScale);
-            scale = randScale(rng);
+            scale = randRockScale(rng);
             radius = config.rockRadius * scale;
-
-            std::uniform_int_distribution<int> randType(0, 2);
-            typeIndex = randType(rng);
+            typeIndex = randRockType(rng);
         }
         else
         {
-            std::uniform_real_distribution<float> randScale(config.grassMinScale, config.grassMaxScale);
-            scale = randScale(rng);
+            scale = randGrassScale(rng);
             radius = config.grassRadius * scale;
-
-            std::uniform_int_distribution<int> randType(0, 8);
-            typeIndex = randType(rng);
+            typeIndex = randGrassType(rng);
         }
 
         if (spatialGrid.checkOverlap(x, z, radius))
@@ -524,7 +833,7 @@ private:
 
         VegetationItem item;
         item.position = Vec3(x, y, z);
-        item.rotationY = randRotation(rng);
+        item.rotationY = randAngle(rng);
         item.scale = scale;
         item.typeIndex = typeIndex;
         item.type = type;
@@ -539,6 +848,147 @@ private:
         return true;
     }
 
+    // Concatenate tile results in tile order. Items further than two max radii from their tile's edge
+    // cannot touch another tile, so only the rest go through a shared grid, where an item overlapping
+    // one from an earlier tile is dropped. Returns the number dropped.
+    int mergeTiles(std::vector<VegetationGenerator>& tiles)
+    {
+        int tilesX = (std::max)(1, (int)std::ceil(terrainSizeX / tileSize));
+
+        float band = getMaxItemRadius() * 2.0f;
+
+        // Cells at least as wide as the largest possible pair distance, so the 3x3 lookup is exact
+        SpatialHashGrid seamGrid;
+        seamGrid.init(terrainSizeX, terrainSizeZ, (std::max)(band, 0.5f));
+
+        size_t grassTotal = 0, rockTotal = 0;
+        for (const auto& tile : tiles)
+        {
+            grassTotal += tile.grassItems.size();
+            rockTotal += tile.rockItems.size();
+        }
+        grassItems.reserve(grassTotal);
+        rockItems.reserve(rockTotal);
+
+        int rejected = 0;
+        for (int index = 0; index < (int)tiles.size(); index++)
+        {
+            float minX, minZ, maxX, maxZ;
+            getTileBounds(index % tilesX, index / tilesX, tileSize, minX, minZ, maxX, maxZ);
+
+            auto merge = [&](const std::vector<VegetationItem>& items, std::vector<VegetationItem>& out)
+            {
+                for (const auto& item : items)
+                {
+                    float edge = (std::min)((std::min)(item.position.x - minX, maxX - item.position.x),
+                        (std::min)(item.position.z - minZ, maxZ - item.position.z));
+                    if (edge < band)
+                    {
+                        if (seamGrid.checkOverlap(item.position.x, item.position.z, item.radius))
+                        {
+                            rejected++;
+                            continue;
+                        }
+                        seamGrid.insert(item);
+                    }
+                    out.push_back(item);
+                }
+            };
+
+            merge(tiles[index].rockItems, rockItems);
+            merge(tiles[index].grassItems, grassItems);
+            clusterCount += tiles[index].clusterCount;
+        }
+
+        return rejected;
+    }
+
+    void printSummary() const
+    {
+        std::cout << "  Grass items: " << grassItems.size() << "\n";
+        std::cout << "  Rock items: " << rockItems.size() << "\n";
+        std::cout << "  Clusters generated: " << clusterCount << "\n";
+    }
+
+    // ------------------------------------------------------------------------
+    // Disk cache
+    // ------------------------------------------------------------------------
+    struct CacheHeader
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long key;
+        unsigned int grassCount;
+        unsigned int rockCount;
+        unsigned int clusterCount;
+    };
+
+    std::string cachePath() const { return cacheDirectory + "/layout.veg"; }
+
+    unsigned long long makeCacheKey(unsigned int seed) const
+    {
+        return makeCacheKey(terrain, config, terrainSizeX, terrainSizeZ, tileSize, seed);
+    }
+
+    bool loadFromCache(unsigned long long key)
+    {
+        std::ifstream in(cachePath(), std::ios::binary);
+        if (!in) return false;
+
+        CacheHeader header = {};
+        in.read((char*)&header, sizeof(header));
+        if (!in || header.magic != VEG_LAYOUT_MAGIC || header.version != VEG_LAYOUT_VERSION || header.key != key)
+            return false;
+
+        grassItems.resize(header.grassCount);
+        rockItems.resize(header.rockCount);
+        in.read((char*)grassItems.data(), (std::streamsize)grassItems.size() * sizeof(VegetationItem));
+        in.read((char*)rockItems.data(), (std::streamsize)rockItems.size() * sizeof(VegetationItem));
+        if (!in)
+        {
+            grassItems.clear();
+            rockItems.clear();
+            return false;
+        }
+        clusterCount = (int)header.clusterCount;
+        return true;
+    }
+
+    void saveToCache(unsigned long long key) const
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDirectory, ec);
+
+        // Written to a temp file and renamed, so an interrupted write never leaves a truncated layout
+        std::string tempPath = cachePath() + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                std::cout << "[VegetationGenerator] WARNING: Cannot write " << cachePath() << "\n";
+                return;
+            }
+
+            CacheHeader header = {};
+            header.magic = VEG_LAYOUT_MAGIC;
+            header.version = VEG_LAYOUT_VERSION;
+            header.key = key;
+            header.grassCount = (unsigned int)grassItems.size();
+            header.rockCount = (unsigned int)rockItems.size();
+            header.clusterCount = (unsigned int)clusterCount;
+            out.write((const char*)&header, sizeof(header));
+            out.write((const char*)grassItems.data(), (std::streamsize)grassItems.size() * sizeof(VegetationItem));
+            out.write((const char*)rockItems.data(), (std::streamsize)rockItems.size() * sizeof(VegetationItem));
+            if (!out)
+            {
+                out.close();
+                std::filesystem::remove(tempPath, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, cachePath(), ec);
+    }
+
     HeightmapTerrain* terrain = nullptr;
     VegetationConfig config;
     float terrainSizeX = 0.0f;
@@ -548,6 +998,28 @@ private:
     NoiseGenerator noise;
     SpatialHashGrid spatialGrid;
 
+    std::uniform_real_distribution<float> rand01{ 0.0f, 1.0f };
+    std::uniform_real_distribution<float> randAngle{ 0.0f, 2.0f * 3.14159265f };
+    std::uniform_real_distribution<float> randRockScale;
+    std::uniform_real_distribution<float> randGrassScale;
+    std::uniform_int_distribution<int> randRockType{ 0, 2 };
+    std::uniform_int_distribution<int> randGrassType{ 0, 8 };
+    std::uniform_int_distribution<int> randRockCount;
+    std::uniform_int_distribution<int> randGrassCount;
+
+    // generateCluster scratch, reused across clusters
+    std::vector<float> clusterXs, clusterZs, clusterHeights;
+    std::vector<unsigned char> clusterValid;
+
+    float minSlopeGradSq = -1.0f;
+    float maxSlopeGradSq = 1e30f;
+
+    // generateTile: items outside [tileMin, tileMax) are rejected
+    bool clipToTile = false;
+    float tileMinX = 0.0f, tileMinZ = 0.0f;
+    float tileMaxX = 0.0f, tileMaxZ = 0.0f;
+
+    int clusterCount = 0;
     std::vector<VegetationItem> grassItems;
     std::vector<VegetationItem> rockItems;
 };
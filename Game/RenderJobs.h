@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <iostream>
+
+// ============================================================================
+// RenderJobs
+// ----------------------------------------------------------------------------
+// Ordered list of subsystem recording jobs for one section of the frame. record() hands them to
+// Core::recordParallel, so every job records into its own command list on a worker thread while the
+// lists still execute in the order the jobs were added, in the frame's single ExecuteCommandLists.
+// Jobs draw through the usual core->getCommandList(), so subsystems need no changes; each job starts
+// from the render targets/viewport Core had bound when record() was called, and is timed as a
+// Profiler scope of the same name.
+// ============================================================================
+class RenderJobs
+{
+public:
+    bool parallel = true;   // false records the jobs in order on the serial list (debugging, A/B timing)
+
+    void clear()
+    {
+        jobs.clear();
+    }
+
+    void add(const std::string& name, std::function<void()> fn)
+    {
+        Job job;
+        job.name = name;
+        job.fn = std::move(fn);
+        jobs.push_back(std::move(job));
+    }
+
+    void record(Core* core)
+    {
+        auto run = [&](int i)
+            {
+                ProfileScope scope(jobs[i].name.c_str());
+                auto start = std::chrono::high_resolution_clock::now();
+                jobs[i].fn();
+                auto end = std::chrono::high_resolution_clock::now();
+                jobs[i].recordMs = std::chrono::duration<float, std::milli>(end - start).count();
+            };
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (parallel)
+        {
+            core->recordParallel((int)jobs.size(), run);
+        }
+        else
+        {
+            for (int i = 0; i < (int)jobs.size(); i++)
+                run(i);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        wallMs = std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    // Per-job CPU recording time of the last record(), against the wall time of the whole section
+    void printTimings() const
+    {
+        float sum = 0.0f;
+        std::cout << "[RenderJobs] " << jobs.size() << " jobs (" << (parallel ? "parallel" : "serial") << "):\n";
+        for (const auto& job : jobs)
+        {
+            std::cout << "  " << job.name << ": " << job.recordMs << " ms\n";
+            sum += job.recordMs;
+        }
+        std::cout << "  Sum " << sum << " ms, wall " << wallMs << " ms\n";
+    }
+
+    size_t size() const { return jobs.size(); }
+    const std::string& getName(int i) const { return jobs[i].name; }
+    float getRecordMs(int i) const { return jobs[i].recordMs; }
+    float getWallMs() const { return wallMs; }
+
+private:
+    struct Job
+    {
+        std::string name;
+        std::function<void()> fn;
+        float recordMs = 0.0f;
+    };
+
+    std::vector<Job> jobs;
+    float wallMs = 0.0f;
+};
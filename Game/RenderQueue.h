@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Core.h"
+#include "PSO.h"
+#include "Mesh.h"
+#include <vector>
+#include <algorithm>
+
+// ============================================================================
+// RenderPacket - one instanced mesh draw
+// ----------------------------------------------------------------------------
+// Shader constants are not part of the packet: everything queued together must share the constants
+// already applied, and only PSO, texture (root parameter 2), geometry and instance stream vary.
+// ============================================================================
+struct RenderPacket
+{
+    PSOHandle pso = INVALID_PSO;
+    D3D12_GPU_DESCRIPTOR_HANDLE texture = {};
+    const Mesh* mesh = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS instances = 0;    // Bound to vertex slot 1
+    unsigned int instanceStride = 0;
+    unsigned int instanceCount = 0;
+};
+
+// ============================================================================
+// RenderQueue
+// ----------------------------------------------------------------------------
+// Collects packets, sorts them by PSO, then texture, then GeometryPool page and mesh, and issues them
+// binding only what changed. Pooled meshes on one page share a single VB/IB binding and draw with
+// their base vertex / start index, so a page switch is the only geometry rebind.
+// Not thread-safe: fill and flush one queue from one recording thread.
+// ============================================================================
+class RenderQueue
+{
+public:
+    struct Stats
+    {
+        unsigned int draws = 0;
+        unsigned int psoBinds = 0;
+        unsigned int textureBinds = 0;
+        unsigned int geometryBinds = 0;
+    };
+
+    void clear() { packets.clear(); }
+
+    void add(const RenderPacket& packet)
+    {
+        if (packet.mesh == nullptr || packet.instanceCount == 0) return;
+        packets.push_back(packet);
+    }
+
+    size_t size() const { return packets.size(); }
+
+    // Sort and record every packet into the current command list, then empty the queue
+    void flush(Core* core, PSOManager* psos)
+    {
+        lastStats = Stats();
+        if (packets.empty()) return;
+
+        std::sort(packets.begin(), packets.end(), [](const RenderPacket& a, const RenderPacket& b)
+        {
+            if (a.pso != b.pso) return a.pso < b.pso;
+            if (a.texture.ptr != b.texture.ptr) return a.texture.ptr < b.texture.ptr;
+            int pageA = a.mesh->getGeometryPage(), pageB = b.mesh->getGeometryPage();
+            if (pageA != pageB) return pageA < pageB;
+            return a.mesh < b.mesh;
+        });
+
+        auto cmdList = core->getCommandList();
+        cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        PSOHandle boundPso = INVALID_PSO;
+        UINT64 boundTexture = 0;
+        const Mesh* boundMesh = nullptr;    // Unpooled mesh whose own buffers are bound
+        int boundPage = -1;
+        unsigned int boundStride = 0;
+
+        for (const auto& packet : packets)
+        {
+            if (packet.pso != boundPso)
+            {
+                psos->bind(core, packet.pso);
+                boundPso = packet.pso;
+                lastStats.psoBinds++;
+            }
+
+            if (packet.texture.ptr != 0 && packet.texture.ptr != boundTexture)
+            {
+                cmdList->SetGraphicsRootDescriptorTable(2, packet.texture);
+                boundTexture = packet.texture.ptr;
+                lastStats.textureBinds++;
+            }
+
+            const Mesh* mesh = packet.mesh;
+            int page = mesh->getGeometryPage();
+            unsigned int stride = mesh->getVertexStride();
+            if (page >= 0)
+            {
+                if (page != boundPage || stride != boundStride)
+                {
+                    D3D12_VERTEX_BUFFER_VIEW vbView = core->geometry.getVertexBufferView(page, stride);
+                    D3D12_INDEX_BUFFER_VIEW ibView = core->geometry.getIndexBufferView(page);
+                    cmdList->IASetVertexBuffers(0, 1, &vbView);
+                    cmdList->IASetIndexBuffer(&ibView);
+                    boundPage = page;
+                    boundStride = stride;
+                    boundMesh = nullptr;
+                    lastStats.geometryBinds++;
+                }
+            }
+            else if (mesh != boundMesh)
+            {
+                D3D12_VERTEX_BUFFER_VIEW vbView = mesh->getVertexBufferView();
+                D3D12_INDEX_BUFFER_VIEW ibView = mesh->getIndexBufferView();
+                cmdList->IASetVertexBuffers(0, 1, &vbView);
+                cmdList->IASetIndexBuffer(&ibView);
+                boundMesh = mesh;
+                boundPage = -1;
+                lastStats.geometryBinds++;
+            }
+
+            D3D12_VERTEX_BUFFER_VIEW instanceView;
+            instanceView.BufferLocation = packet.instances;
+            instanceView.StrideInBytes = packet.instanceStride;
+            instanceView.SizeInBytes = packet.instanceCount * packet.instanceStride;
+            cmdList->IASetVertexBuffers(1, 1, &instanceView);
+
+            // Own-buffer meshes draw from 0; pooled ones from their place on the page
+            unsigned int startIndex = (page >= 0) ? mesh->getStartIndex() : 0;
+            int baseVertex = (page >= 0) ? mesh->getBaseVertex() : 0;
+            cmdList->DrawIndexedInstanced(mesh->getIndexCount(), packet.instanceCount, startIndex, baseVertex, 0);
+            core->countDraw(packet.instanceCount);
+            lastStats.draws++;
+        }
+
+        packets.clear();
+    }
+
+    // Bind counts of the last flush
+    const Stats& getLastStats() const { return lastStats; }
+
+private:
+    std::vector<RenderPacket> packets;
+    Stats lastStats;
+};
@@ -8,6 +8,15 @@
 #include "HeightmapTerrain.h"
 #include "Maths.h"
 #include "LOD.h"  
+#include "CookedMesh.h"
+#include "ThreadPool.h"
+#include "CullView.h"
+#include "Frustum.h"
+#include "SpatialIndex.h"
+#include "InstanceQuantization.h"
+#include "HiZOcclusion.h"
+#include "Impostor.h"
+#include "TextureTable.h"
 #include <vector>
 #include <random>
 #include <string>
@@ -17,18 +26,12 @@
 #pragma comment(lib, "d3dcompiler.lib")
 
 // ============================================================================
-// GPU Instance Data - MUST match shader input layout exactly!
+// GPU Instance Data - PackedInstance with param = type index (12 bytes)
 // ============================================================================
-struct RockInstanceGPU
-{
-    Vec3 position;      // 12 bytes - INSTANCEPOS
-    float rotationY;    // 4 bytes  - INSTANCEROT
-    float scale;        // 4 bytes  - INSTANCESCALE
-    // Total: 20 bytes
-};
+using RockInstanceGPU = PackedInstance;
 
 // ============================================================================
-// CPU Instance Data - Contains extra fields for culling/LOD
+// CPU Instance Data - Generation/query format (chunks keep the packed form)
 // ============================================================================
 struct RockInstance
 {
@@ -36,8 +39,6 @@ struct RockInstance
     float rotationY;
     float scale;
     int typeIndex;
-    float distanceToCamera;
-    int lodLevel;
 };
 
 // ============================================================================
@@ -50,6 +51,7 @@ struct RockType
     Mesh* meshMedium = nullptr;
     Mesh* meshLow = nullptr;
     Texture texture;
+    ImpostorAtlas* impostor = nullptr;      // Baked in finishInit, drawn past impostorDistance
     int typeIndex = 0;
 };
 
@@ -59,8 +61,27 @@ struct RockType
 struct RockChunk
 {
     Vec3 centerPos;
-    std::vector<RockInstance> instances;
+    std::vector<RockInstanceGPU> instances;     // Packed, copied straight into the frame's streams
     bool isVisible = false;
+    Vec3 boundsMin;                 // World AABB: chunk footprint + terrain height range + rock extents
+    Vec3 boundsMax;
+};
+
+// ============================================================================
+// Draw Packet - Result of culling one view, consumed by draw()
+// ============================================================================
+struct RockDrawPacket
+{
+    Vec3 cameraPos;
+    float viewDistance = 0.0f;
+    std::vector<unsigned int> counts;                   // Visible instances per [type * 3 + lod]
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> instances;   // Frame allocator stream per [type * 3 + lod]
+    std::vector<unsigned int> firstInstance;            // Where each [type * 3 + lod] stream starts in meshInstances
+    D3D12_GPU_VIRTUAL_ADDRESS meshInstances = 0;        // Every mesh stream back to back, in slot order
+    unsigned int meshInstanceCount = 0;
+    std::vector<unsigned int> impostorCounts;           // Visible impostors per type
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> impostors;   // ImpostorInstance stream per type
+    unsigned int totalVisible = 0;
 };
 
 // ============================================================================
@@ -140,15 +161,7 @@ public:
         allInstances = preGeneratedInstances;
 
         // Clamp typeIndex to valid range
-        int numTypes = (int)rockTypes.size();
-        for (auto& inst : allInstances)
-        {
-            if (inst.typeIndex < 0 || inst.typeIndex >= numTypes)
-            {
-                inst.typeIndex = inst.typeIndex % numTypes;
-                if (inst.typeIndex < 0) inst.typeIndex = 0;
-            }
-        }
+        clampTypeIndices(allInstances);
 
         // 3. Organize into chunks
         organizeIntoChunks();
@@ -158,53 +171,207 @@ public:
     }
 
     // ========================================================================
-    // UPDATE - Call each frame
+    // INIT METHOD 3: Streaming - empty chunk grid filled by VegetationStreamer
     // ========================================================================
-    void update(const Vec3& cameraPos)
+    // chunkSize must match the streamer's; chunk index = cz * chunksX + cx as in organizeIntoChunks
+    void initStreaming(Core* core, PSOManager* psos, Shaders* shaders,
+        HeightmapTerrain* terrain,
+        const std::vector<std::string>& rockModelPaths,
+        const std::vector<std::string>& rockTexturePaths,
+        float viewDistance = 100.0f,
+        float chunkSize = 32.0f)
     {
-        updateLODLevels(cameraPos);
+        this->terrain = terrain;
+        this->viewDistance = viewDistance;
+        this->chunkSize = chunkSize;
+        streaming = true;
+
+        loadRockTypesWithAutoLOD(core, rockModelPaths, rockTexturePaths);
+
+        if (rockTypes.empty())
+        {
+            std::cout << "[Rocks] Error: No rock types loaded!\n";
+            return;
+        }
+
+        allInstances.clear();
+        organizeIntoChunks();
+        finishInit(core, psos, shaders);
+    }
+
+    // Streaming: replace one chunk's rocks. The collision grid is rebuilt by rebuildStreamedIndex().
+    void setChunkInstances(int chunkIndex, std::vector<RockInstance>&& instances)
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size() || rockTypes.empty()) return;
+
+        clampTypeIndices(instances);
+        chunkSources[chunkIndex] = std::move(instances);
+        storeChunk(chunkIndex);
+        updateChunkBounds(chunkIndex);
+        spatialIndexDirty = true;
+    }
+
+    // Streaming: drop one chunk's rocks
+    void clearChunk(int chunkIndex)
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size()) return;
+
+        std::vector<RockInstance>().swap(chunkSources[chunkIndex]);
+        std::vector<RockInstanceGPU>().swap(chunks[chunkIndex].instances);
+        updateChunkBounds(chunkIndex);
+        spatialIndexDirty = true;
+    }
+
+    // CPU memory held by one chunk (packed stream + the unpacked copy the collision grid uses)
+    size_t getChunkBytes(int chunkIndex) const
+    {
+        if (chunkIndex < 0 || chunkIndex >= (int)chunks.size()) return 0;
+        return chunks[chunkIndex].instances.capacity() * sizeof(RockInstanceGPU)
+            + chunkSources[chunkIndex].capacity() * sizeof(RockInstance);
+    }
+
+    // Streaming: after a batch of chunk changes, gather the resident rocks and rebuild the collision grid
+    void rebuildStreamedIndex()
+    {
+        if (!spatialIndexDirty) return;
+        spatialIndexDirty = false;
+
+        allInstances.clear();
+        for (const auto& source : chunkSources)
+        {
+            allInstances.insert(allInstances.end(), source.begin(), source.end());
+        }
+        buildSpatialIndex();
     }
 
     // ========================================================================
-    // DRAW - Call each frame after update
+    // CULL - Call once per view per frame; writes this view's instances into frame memory
     // ========================================================================
-    void draw(Core* core, PSOManager* psos, Shaders* shaders,
-        const Matrix& vp, const Vec3& cameraPos)
+    RockDrawPacket cull(Core* core, const CullView& view)
     {
-        if (rockTypes.empty()) return;
+        RockDrawPacket packet;
+        packet.cameraPos = view.cameraPos;
+        packet.viewDistance = viewDistance * view.distanceScale;
+        packet.counts.assign(rockTypes.size() * 3, 0);
+        packet.instances.assign(rockTypes.size() * 3, 0);
+        packet.firstInstance.assign(rockTypes.size() * 3, 0);
+        packet.impostorCounts.assign(rockTypes.size(), 0);
+        packet.impostors.assign(rockTypes.size(), 0);
+
+        if (rockTypes.empty()) return packet;
+
+        performChunkCulling(core, view, packet, 0.0f);
+        return packet;
+    }
 
-        performChunkCulling(cameraPos);
+    // Occluder cull for the Hi-Z prepass: only rocks of at least occluderMinScale within occluderDistance
+    RockDrawPacket cullOccluders(Core* core, const CullView& view)
+    {
+        RockDrawPacket packet;
+        packet.cameraPos = view.cameraPos;
+        packet.viewDistance = (std::min)(occluderDistance, viewDistance) * view.distanceScale;
+        packet.counts.assign(rockTypes.size() * 3, 0);
+        packet.instances.assign(rockTypes.size() * 3, 0);
+        packet.firstInstance.assign(rockTypes.size() * 3, 0);
+        packet.impostorCounts.assign(rockTypes.size(), 0);
+        packet.impostors.assign(rockTypes.size(), 0);
+
+        if (rockTypes.empty()) return packet;
+
+        performChunkCulling(core, view, packet, occluderMinScale);
+        return packet;
+    }
+
+    // ========================================================================
+    // DRAW - Draw a previously culled view
+    // ========================================================================
+    void draw(Core* core, PSOManager* psos, Shaders* shaders,
+        const Matrix& vp, const RockDrawPacket& packet)
+    {
+        if (rockTypes.empty() || packet.totalVisible == 0) return;
 
         Matrix world;
-        shaders->updateConstantVS(shaderName, "rockBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shaderName, "rockBuffer", "W", (void*)&world);
+        vpConstant.set(&vp);
+        worldConstant.set(&world);
+
+        Vec4 cameraData(packet.cameraPos.x, packet.cameraPos.y, packet.cameraPos.z, packet.viewDistance);
+        cameraConstant.set(&cameraData);
 
-        Vec4 cameraData(cameraPos.x, cameraPos.y, cameraPos.z, viewDistance);
-        shaders->updateConstantVS(shaderName, "rockBuffer", "cameraPos", &cameraData);
+        Vec4 chunkParams = quantizer.getChunkParams();
+        Vec4 heightParams = quantizer.getHeightParams();
+        chunkParamsConstant.set(&chunkParams);
+        heightParamsConstant.set(&heightParams);
+
+        Vec4 impostorParams = getImpostorParams();
+        impostorParamsConstant.set(&impostorParams);
 
         Vec4 lightDir(0.5f, 1.0f, -0.5f, 0.2f);
-        shaders->updateConstantPS(shaderName, "rockPSBuffer", "lightDir_ambient", &lightDir);
-        shaders->updateConstantPS(shaderName, "rockPSBuffer", "rockColor", &rockColor);
+        lightConstant.set(&lightDir);
+        colorConstant.set(&rockColor);
 
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
+        drawMeshes(core, packet);
 
+        // Far band: one quad draw per type (rebinds its own shader and PSO)
         for (auto& type : rockTypes)
         {
-            drawRockType(core, type);
+            unsigned int count = packet.impostorCounts[type.typeIndex];
+            if (count > 0 && type.impostor)
+                impostorRenderer.draw(core, psos, *type.impostor, vp, packet.cameraPos, packet.impostors[type.typeIndex], count);
         }
     }
 
+    // Depth only into the bound D32 target (occluder prepass)
+    void drawDepth(Core* core, PSOManager* psos, const Matrix& vp, const RockDrawPacket& packet)
+    {
+        if (rockTypes.empty() || packet.totalVisible == 0) return;
+
+        Matrix world;
+        vpConstant.set(&vp);
+        worldConstant.set(&world);
+
+        Vec4 cameraData(packet.cameraPos.x, packet.cameraPos.y, packet.cameraPos.z, packet.viewDistance);
+        cameraConstant.set(&cameraData);
+
+        Vec4 chunkParams = quantizer.getChunkParams();
+        Vec4 heightParams = quantizer.getHeightParams();
+        chunkParamsConstant.set(&chunkParams);
+        heightParamsConstant.set(&heightParams);
+
+        shader->apply(core);
+        psos->bind(core, depthPso);
+        drawMeshes(core, packet);
+    }
+
+    // Cull + draw the main view in one call
+    void draw(Core* core, PSOManager* psos, Shaders* shaders,
+        const Matrix& vp, const Vec3& cameraPos)
+    {
+        draw(core, psos, shaders, vp, cull(core, CullView::main(vp, cameraPos)));
+    }
+
     // ========================================================================
     // PUBLIC PROPERTIES
     // ========================================================================
     Vec4 rockColor = Vec4(0.7f, 0.7f, 0.7f, 1.0f);
     float lodDistanceHigh = 20.0f;
     float lodDistanceMedium = 50.0f;
+    float impostorDistance = 70.0f;     // Meshes start dithering into their impostor here
+    float impostorFadeRange = 8.0f;     // Width of the crossfade band; impostors only beyond it
+    bool useImpostors = true;
+    float occluderMinScale = 1.2f;      // Smaller rocks hide too little to be worth the prepass
+    float occluderDistance = 60.0f;
+    float boundsRadius = 2.0f;      // Per-unit-scale rock extent used for culling bounds
+    float collisionRadius = 1.5f;   // Per-unit-scale rock radius for collision and hit tests (set before init)
 
     // Get instance count
     size_t getInstanceCount() const { return allInstances.size(); }
 
+    // Static grid over every rock for collision, raycast and overlap queries; item i = getInstance(i)
+    const SpatialIndex& getSpatialIndex() const { return spatialIndex; }
+    const RockInstance& getInstance(int item) const { return allInstances[item]; }
+
     // ========================================================================
     // DESTRUCTOR
     // ========================================================================
@@ -228,14 +395,9 @@ public:
                 delete type.meshLow;
                 deletedMeshes.insert(type.meshLow);
             }
+            delete type.impostor;
         }
-        for (auto& buffers : instanceBuffersByType)
-        {
-            for (auto& buffer : buffers)
-            {
-                if (buffer) buffer->Release();
-            }
-        }
+        if (commandSignature) commandSignature->Release();
     }
 
 private:
@@ -243,46 +405,213 @@ private:
     std::vector<RockType> rockTypes;
     std::vector<RockChunk> chunks;
     std::vector<RockInstance> allInstances;
-
-    std::vector<std::vector<std::vector<RockInstance>>> instancesByTypeLOD;
-    std::vector<std::vector<std::vector<RockInstance>>> visibleInstancesByTypeLOD;
-    std::vector<std::vector<ID3D12Resource*>> instanceBuffersByType;
-    std::vector<std::vector<D3D12_VERTEX_BUFFER_VIEW>> instanceBufferViewsByType;
+    std::vector<int> instanceCountByType;
+
+    // Streaming: unpacked instances per chunk, gathered into allInstances for the collision grid
+    std::vector<std::vector<RockInstance>> chunkSources;
+
+    int chunksX = 1;
+    InstanceQuantizer quantizer;    // Chunk grid + height range the packed instances use
+
+    // Chunk AABBs in SoA form for the SIMD frustum test (index = chunk index)
+    BoundsSoA chunkBounds;
+    std::vector<unsigned char> chunkInFrustum;
+
+    // Collision / query grid over allInstances
+    SpatialIndex spatialIndex;
+
+    // Scratch for one cull: chunks that passed, and the LOD picked per visible instance
+    std::vector<int> visibleChunks;
+    std::vector<unsigned char> visibleLODs;
+    static const unsigned char SKIPPED_LOD = 255;       // Instance in a visible chunk but filtered out
+    static const unsigned char MESH_NONE = 3;           // No mesh LOD: impostor only
+    static const unsigned char IMPOSTOR_FLAG = 4;       // OR'd into the LOD: also drawn as an impostor
+
+    // Shader, PSO and constants resolved once at init
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    PSOHandle depthPso = INVALID_PSO;
+    ConstantHandle vpConstant;
+    ConstantHandle worldConstant;
+    ConstantHandle cameraConstant;
+    ConstantHandle chunkParamsConstant;
+    ConstantHandle heightParamsConstant;
+    ConstantHandle impostorParamsConstant;
+    ConstantHandle lightConstant;
+    ConstantHandle colorConstant;
+
+    // Bindless rock textures (index = type index, read per instance in PSRock)
+    TextureTable textureTable;
+
+    // One ExecuteIndirect over every [type][lod] when all LOD meshes share a GeometryPool page
+    ID3D12CommandSignature* commandSignature = nullptr;
+    bool indirectReady = false;
+
+    // Far-band rendering; impostorsReady once every type has an atlas
+    ImpostorRenderer impostorRenderer;
+    bool impostorsReady = false;
+
+    int geometryPage = -1;
+    unsigned int geometryStride = 0;
 
     float density = 0.5f;
     float viewDistance = 100.0f;
     float chunkSize = 32.0f;
 
+    // Streaming mode: allInstances mirrors the resident chunks (for the spatial index)
+    bool streaming = false;
+    bool spatialIndexDirty = false;
+
     // ========================================================================
     // COMMON INITIALIZATION (shared between both init methods)
     // ========================================================================
     void finishInit(Core* core, PSOManager* psos, Shaders* shaders)
     {
-        // Separate by type and LOD
-        separateInstancesByTypeAndLOD();
+        // Per-type totals for the statistics
+        countInstancesByType();
+
+        // Culling bounds
+        buildChunkBounds();
+
+        // Collision / hit-test grid
+        buildSpatialIndex();
 
-        // Create buffers
-        createInstanceBuffers(core);
+        // Instance streams are written into Core's frame allocator at cull time, no buffers to create
 
         // Load shaders
         shaders->load(core, shaderName, "Shaders/VSRock.txt", "Shaders/PSRock.txt");
+        shader = shaders->find(shaderName);
+        vpConstant = shader->getConstantVS("rockBuffer", "VP");
+        worldConstant = shader->getConstantVS("rockBuffer", "W");
+        cameraConstant = shader->getConstantVS("rockBuffer", "cameraPos");
+        chunkParamsConstant = shader->getConstantVS("rockBuffer", "chunkParams");
+        heightParamsConstant = shader->getConstantVS("rockBuffer", "heightParams");
+        impostorParamsConstant = shader->getConstantVS("rockBuffer", "impostorParams");
+        lightConstant = shader->getConstantPS("rockPSBuffer", "lightDir_ambient");
+        colorConstant = shader->getConstantPS("rockPSBuffer", "rockColor");
 
         // Create PSO
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
             VertexLayoutCache::getRockInstancedLayout());
+        depthPso = psos->createDepthOnlyPSO(core, psoName + "Depth", shader->vs,
+            VertexLayoutCache::getRockInstancedLayout());
+
+        buildTextureTable(core);
+        setupIndirect(core);
+
+        bakeImpostors(core, psos, shaders);
 
         printStatistics();
     }
 
+    // Table slot i = rock type i, so PSRock indexes it with the instance's type
+    void buildTextureTable(Core* core)
+    {
+        if (!textureTable.init(core)) return;
+        for (auto& type : rockTypes)
+        {
+            if (textureTable.add(type.texture) != type.typeIndex)
+                std::cout << "[Rocks] ERROR: No bindless slot for " << type.name << "\n";
+        }
+    }
+
+    // Indirect draws need every LOD on one page with one stride: one VB/IB binding for all of them
+    void setupIndirect(Core* core)
+    {
+        indirectReady = false;
+        if (rockTypes.empty()) return;
+
+        int page = rockTypes[0].meshHigh ? rockTypes[0].meshHigh->getGeometryPage() : -1;
+        unsigned int stride = rockTypes[0].meshHigh ? rockTypes[0].meshHigh->getVertexStride() : 0;
+        for (const auto& type : rockTypes)
+        {
+            for (const Mesh* mesh : { type.meshHigh, type.meshMedium, type.meshLow })
+            {
+                if (mesh == nullptr || mesh->getGeometryPage() != page || mesh->getVertexStride() != stride)
+                    page = -1;
+            }
+        }
+        if (page < 0)
+        {
+            std::cout << "[Rocks] LOD meshes span several geometry pages, drawing per type and LOD\n";
+            return;
+        }
+
+        // Plain DrawIndexed arguments; mesh placement comes from StartIndex/BaseVertex, streams from StartInstance
+        D3D12_INDIRECT_ARGUMENT_DESC arg = {};
+        arg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+        D3D12_COMMAND_SIGNATURE_DESC desc = {};
+        desc.ByteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+        desc.NumArgumentDescs = 1;
+        desc.pArgumentDescs = &arg;
+
+        if (FAILED(core->device->CreateCommandSignature(&desc, nullptr, IID_PPV_ARGS(&commandSignature))))
+        {
+            std::cout << "[Rocks] WARNING: Failed to create command signature, drawing per type and LOD\n";
+            commandSignature = nullptr;
+            return;
+        }
+        geometryPage = page;
+        geometryStride = stride;
+        indirectReady = true;
+    }
+
+    // ========================================================================
+    // IMPOSTOR BAKE - One atlas per type from its high LOD, lit like the instanced rocks
+    // ========================================================================
+    void bakeImpostors(Core* core, PSOManager* psos, Shaders* shaders)
+    {
+        impostorRenderer.init(core, shaders, psos, "Impostor_Rocks");
+
+        shaders->load(core, "ImpostorBakeRock", "Shaders/VSImpostorBake.txt", "Shaders/PSRock.txt");
+        Shader* bakeShader = shaders->find("ImpostorBakeRock");
+        PSOHandle bakePso = psos->createPSO(core, "ImpostorBakeRockPSO", bakeShader->vs, bakeShader->ps,
+            VertexLayoutCache::getStaticLayout());
+
+        Vec4 lightDir(0.5f, 1.0f, -0.5f, 0.2f);
+        bakeShader->getConstantPS("rockPSBuffer", "lightDir_ambient").set(&lightDir);
+        bakeShader->getConstantPS("rockPSBuffer", "rockColor").set(&rockColor);
+
+        // Mesh has no CPU bounds; boundsRadius already bounds every rock for culling
+        Vec3 localMin(-boundsRadius, -boundsRadius, -boundsRadius);
+        Vec3 localMax(boundsRadius, boundsRadius, boundsRadius);
+
+        impostorsReady = !rockTypes.empty();
+        for (auto& type : rockTypes)
+        {
+            ImpostorBakePart part;
+            part.mesh = type.meshHigh;
+            part.shader = bakeShader;
+            part.pso = bakePso;
+            part.texture = type.texture.srvHandle;
+            part.textureTable = textureTable.getGPUHandle();
+            part.textureIndex = (unsigned int)type.typeIndex;
+            part.uvScale = 2.0f;    // VSRock tiles the rock texture twice
+
+            type.impostor = new ImpostorAtlas();
+            if (!type.impostor->bake(core, psos, { part }, localMin, localMax, type.name))
+            {
+                delete type.impostor;
+                type.impostor = nullptr;
+                impostorsReady = false;
+            }
+        }
+    }
+
+    // VSRock impostorParams: x = crossfade start, y = 1 / range; pushed out of reach when impostors are off
+    Vec4 getImpostorParams() const
+    {
+        if (!useImpostors || !impostorsReady)
+            return Vec4(1e30f, 0.0f, 0.0f, 0.0f);
+        return Vec4(impostorDistance, 1.0f / (std::max)(impostorFadeRange, 1e-3f), 0.0f, 0.0f);
+    }
+
     // ========================================================================
     // ORGANIZE INSTANCES INTO SPATIAL CHUNKS
     // ========================================================================
     void organizeIntoChunks()
     {
-        chunks.clear();
-
         float halfX = terrainSizeX * 0.5f;
         float halfZ = terrainSizeZ * 0.5f;
 
@@ -290,7 +619,45 @@ private:
         int numChunksZ = (int)std::ceil(terrainSizeZ / chunkSize);
 
         // Create empty chunks
+        createChunkGrid(numChunksX, numChunksZ);
+
+        // Assign instances to chunks based on position
+        for (const auto& inst : allInstances)
+        {
+            int cx = (int)((inst.position.x + halfX) / chunkSize);
+            int cz = (int)((inst.position.z + halfZ) / chunkSize);
+
+            cx = std::clamp(cx, 0, numChunksX - 1);
+            cz = std::clamp(cz, 0, numChunksZ - 1);
+
+            int chunkIdx = cz * numChunksX + cx;
+            chunkSources[chunkIdx].push_back(inst);
+        }
+
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            storeChunk((int)c);
+        }
+
+        // Static fields keep allInstances for the collision grid, so drop the per-chunk copies
+        if (!streaming)
+        {
+            std::vector<std::vector<RockInstance>>(chunks.size()).swap(chunkSources);
+        }
+
+        std::cout << "[Rocks] Organized " << allInstances.size()
+            << " instances into " << chunks.size() << " chunks\n";
+    }
+
+    void createChunkGrid(int numChunksX, int numChunksZ)
+    {
+        chunks.clear();
         chunks.resize(numChunksX * numChunksZ);
+        chunkSources.assign(chunks.size(), std::vector<RockInstance>());
+        chunksX = std::max(numChunksX, 1);
+
+        float halfX = terrainSizeX * 0.5f;
+        float halfZ = terrainSizeZ * 0.5f;
 
         for (int cz = 0; cz < numChunksZ; cz++)
         {
@@ -308,21 +675,44 @@ private:
             }
         }
 
-        // Assign instances to chunks based on position
-        for (const auto& inst : allInstances)
-        {
-            int cx = (int)((inst.position.x + halfX) / chunkSize);
-            int cz = (int)((inst.position.z + halfZ) / chunkSize);
+        if (!InstanceQuantizer::fitsChunkCount(chunks.size()))
+            std::cout << "[Rocks] WARNING: " << chunks.size() << " chunks exceed the packed chunk index, raise chunkSize\n";
 
-            cx = std::clamp(cx, 0, numChunksX - 1);
-            cz = std::clamp(cz, 0, numChunksZ - 1);
+        // Rocks sit on the terrain; the margin covers any that are sunk or raised a little
+        float minY = -100.0f, maxY = 100.0f;
+        if (terrain)
+            terrain->getHeightRange(-halfX, -halfZ, numChunksX * chunkSize - halfX, numChunksZ * chunkSize - halfZ, minY, maxY);
+        quantizer.init(-halfX, -halfZ, chunkSize, chunksX, minY - 4.0f, maxY + 4.0f);
+    }
 
-            int chunkIdx = cz * numChunksX + cx;
-            chunks[chunkIdx].instances.push_back(inst);
+    // Pack chunkSources[chunkIndex] into the chunk's GPU-format stream
+    void storeChunk(int chunkIndex)
+    {
+        RockChunk& chunk = chunks[chunkIndex];
+        const auto& source = chunkSources[chunkIndex];
+
+        chunk.instances.clear();
+        chunk.instances.reserve(source.size());
+        for (const auto& inst : source)
+        {
+            chunk.instances.push_back(quantizer.pack(inst.position, chunkIndex, inst.scale, inst.rotationY,
+                (unsigned char)inst.typeIndex));
         }
+        chunk.instances.shrink_to_fit();
+    }
 
-        std::cout << "[Rocks] Organized " << allInstances.size()
-            << " instances into " << chunks.size() << " chunks\n";
+    void clampTypeIndices(std::vector<RockInstance>& instances) const
+    {
+        // Packed instances hold the type in 8 bits
+        int numTypes = std::min((int)rockTypes.size(), 256);
+        for (auto& inst : instances)
+        {
+            if (inst.typeIndex < 0 || inst.typeIndex >= numTypes)
+            {
+                inst.typeIndex = inst.typeIndex % numTypes;
+                if (inst.typeIndex < 0) inst.typeIndex = 0;
+            }
+        }
     }
 
     // ========================================================================
@@ -333,11 +723,41 @@ private:
         const std::vector<std::string>& texturePaths)
     {
         size_t numTypes = std::min(modelPaths.size(), texturePaths.size());
+        std::vector<float> ratios = LODGenerator::getRatios();
+
+        // Validate each distinct model's LOD cache (source hash + ratios); stale ones are re-simplified
+        // in parallel. Types sharing a model must not race on the same .cmesh, so paths are deduped first.
+        std::vector<std::string> uniquePaths;
+        std::vector<int> pathIndex(numTypes, 0);
+        for (size_t i = 0; i < numTypes; i++)
+        {
+            auto it = std::find(uniquePaths.begin(), uniquePaths.end(), modelPaths[i]);
+            pathIndex[i] = (int)(it - uniquePaths.begin());
+            if (it == uniquePaths.end())
+                uniquePaths.push_back(modelPaths[i]);
+        }
+
+        std::vector<char> pathReady(uniquePaths.size(), 0);
+        ThreadPool::get().parallelFor((int)uniquePaths.size(), [&](int i)
+        {
+            pathReady[i] = ensureLODCache(uniquePaths[i], ratios) ? 1 : 0;
+        });
+
+        std::vector<char> cacheReady(numTypes, 0);
+        for (size_t i = 0; i < numTypes; i++)
+            cacheReady[i] = pathReady[pathIndex[i]];
+
+        // Record every LOD mesh and texture upload into a single copy batch
+        core->beginUploadBatch();
 
         for (size_t i = 0; i < numTypes; i++)
         {
             std::cout << "\n[Rocks] Loading rock type " << i << ": " << modelPaths[i] << "\n";
 
+            // Prefer the cached .cmesh LOD chain (memory-mapped, no simplification)
+            if (cacheReady[i] && loadCookedRockType(core, modelPaths[i], texturePaths[i], i))
+                continue;
+
             // Load original mesh data
             GEMLoader::GEMModelLoader loader;
             std::vector<GEMLoader::GEMMesh> gemmeshes;
@@ -394,9 +814,67 @@ private:
             std::cout << "[Rocks] Successfully created type " << rockTypes.size() - 1 << " with auto-LOD\n";
         }
 
+        core->endUploadBatch();
+
         std::cout << "[Rocks] Total rock types loaded: " << rockTypes.size() << "\n";
     }
 
+    // Cache is valid when it was built from this exact source file with these exact LOD ratios
+    static bool isLODCacheValid(const CookedMeshFile& cached, unsigned long long sourceHash, const std::vector<float>& ratios)
+    {
+        if (!CookedMeshWriter::isUpToDate(cached, sourceHash) || cached.isAnimated() || cached.getLODCount() != ratios.size())
+            return false;
+
+        for (unsigned int i = 0; i < cached.getLODCount(); i++)
+        {
+            if (cached.getLOD(i).ratio != ratios[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Make sure the .cmesh next to the model matches it; otherwise simplify and rewrite it (CPU only, worker-safe)
+    static bool ensureLODCache(const std::string& modelPath, const std::vector<float>& ratios)
+    {
+        unsigned long long sourceHash = hashFile(modelPath);
+        if (sourceHash == 0)
+            return false;
+
+        std::string cachePath = CookedMeshWriter::cookedPathFor(modelPath);
+        {
+            CookedMeshFile cached;
+            if (cached.open(cachePath) && isLODCacheValid(cached, sourceHash, ratios))
+                return true;
+        }
+
+        return CookedMeshWriter::cookGEM(modelPath, cachePath, ratios, sourceHash);
+    }
+
+    // Create a rock type from a cooked mesh holding at least 3 static LODs (High/Medium/Low)
+    bool loadCookedRockType(Core* core, const std::string& modelPath, const std::string& texturePath, size_t index)
+    {
+        std::string cookedPath = CookedMeshWriter::cookedPathFor(modelPath);
+
+        CookedMeshFile cooked;
+        if (!cooked.open(cookedPath) || cooked.isAnimated() || cooked.getLODCount() < 3)
+            return false;
+
+        RockType type;
+        type.name = "Rock_" + std::to_string(index);
+        type.typeIndex = (int)rockTypes.size();
+        type.meshHigh = cooked.createMesh(core, 0);
+        type.meshMedium = cooked.createMesh(core, 1);
+        type.meshLow = cooked.createMesh(core, 2);
+        type.texture = core->loadTexture(texturePath);
+
+        rockTypes.push_back(type);
+
+        std::cout << "[Rocks] Loaded cooked type " << rockTypes.size() - 1 << " ("
+            << cooked.getLOD(0).indexCount / 3 << " / " << cooked.getLOD(1).indexCount / 3 << " / "
+            << cooked.getLOD(2).indexCount / 3 << " tris)\n";
+        return true;
+    }
+
     // ========================================================================
     // RANDOM GENERATION (Original method)
     // ========================================================================
@@ -413,6 +891,7 @@ private:
 
         int numChunksX = (int)(terrainSizeX / chunkSize);
         int numChunksZ = (int)(terrainSizeZ / chunkSize);
+        createChunkGrid(numChunksX, numChunksZ);
 
         float chunkArea = chunkSize * chunkSize;
         float rocksPerChunk = (density / 100.0f) * chunkArea;
@@ -421,10 +900,9 @@ private:
         {
             for (int cx = 0; cx < numChunksX; cx++)
             {
-                RockChunk chunk;
+                int chunkIdx = cz * numChunksX + cx;
                 float chunkMinX = cx * chunkSize - halfX;
                 float chunkMinZ = cz * chunkSize - halfZ;
-                chunk.centerPos = Vec3(chunkMinX + chunkSize * 0.5f, 0.0f, chunkMinZ + chunkSize * 0.5f);
 
                 std::vector<Vec2> rockPositions = poissonDiskSampling(
                     chunkMinX, chunkMinZ, chunkSize, chunkSize,
@@ -438,12 +916,11 @@ private:
                     inst.rotationY = randRot(gen);
                     inst.scale = randScale(gen);
                     inst.typeIndex = randType(gen);
-                    inst.distanceToCamera = 0.0f;
-                    inst.lodLevel = 2;
-                    chunk.instances.push_back(inst);
+                    chunkSources[chunkIdx].push_back(inst);
                     allInstances.push_back(inst);
                 }
-                chunks.push_back(chunk);
+                storeChunk(chunkIdx);
+                std::vector<RockInstance>().swap(chunkSources[chunkIdx]);
             }
         }
     }
@@ -484,209 +961,319 @@ private:
     }
 
     // ========================================================================
-    // LOD UPDATE
+    // INSTANCE COUNTS PER TYPE
     // ========================================================================
-    void updateLODLevels(const Vec3& cameraPos)
+    void countInstancesByType()
     {
-        for (auto& chunk : chunks)
+        instanceCountByType.assign(rockTypes.size(), 0);
+
+        for (const auto& chunk : chunks)
         {
-            for (auto& inst : chunk.instances)
+            for (const auto& inst : chunk.instances)
             {
-                float dx = inst.position.x - cameraPos.x;
-                float dz = inst.position.z - cameraPos.z;
-                inst.distanceToCamera = sqrtf(dx * dx + dz * dz);
-
-                if (inst.distanceToCamera < lodDistanceHigh)
-                    inst.lodLevel = 0;
-                else if (inst.distanceToCamera < lodDistanceMedium)
-                    inst.lodLevel = 1;
-                else
-                    inst.lodLevel = 2;
+                if (inst.param < rockTypes.size())
+                    instanceCountByType[inst.param]++;
             }
         }
     }
 
     // ========================================================================
-    // SEPARATE INSTANCES BY TYPE AND LOD
+    // SPATIAL INDEX
     // ========================================================================
-    void separateInstancesByTypeAndLOD()
+    void buildSpatialIndex()
     {
-        instancesByTypeLOD.resize(rockTypes.size());
-        visibleInstancesByTypeLOD.resize(rockTypes.size());
-
-        for (size_t i = 0; i < rockTypes.size(); i++)
-        {
-            instancesByTypeLOD[i].resize(3);
-            visibleInstancesByTypeLOD[i].resize(3);
-        }
-
+        spatialIndex.clear();
         for (const auto& inst : allInstances)
         {
-            if (inst.typeIndex >= 0 && inst.typeIndex < (int)rockTypes.size())
-                instancesByTypeLOD[inst.typeIndex][inst.lodLevel].push_back(inst);
+            spatialIndex.add(inst.position, inst.scale * collisionRadius);
         }
+        spatialIndex.build(8.0f);
     }
 
     // ========================================================================
-    // CREATE GPU BUFFERS
+    // CHUNK BOUNDS
     // ========================================================================
-    void createInstanceBuffers(Core* core)
+    void buildChunkBounds()
     {
-        instanceBuffersByType.resize(rockTypes.size());
-        instanceBufferViewsByType.resize(rockTypes.size());
+        chunkBounds.clear();
 
-        for (size_t t = 0; t < rockTypes.size(); t++)
+        for (auto& chunk : chunks)
         {
-            instanceBuffersByType[t].resize(3, nullptr);
-            instanceBufferViewsByType[t].resize(3);
+            computeChunkBounds(chunk);
+            chunkBounds.add(chunk.boundsMin, chunk.boundsMax);
+        }
 
-            // Count TOTAL instances for this type (across all LODs)
-            size_t totalInstances = 0;
-            for (int lod = 0; lod < 3; lod++)
-            {
-                totalInstances += instancesByTypeLOD[t][lod].size();
-            }
+        chunkInFrustum.assign(chunkBounds.paddedCount(), 0);
+    }
 
-            if (totalInstances == 0) continue;
+    void updateChunkBounds(int chunkIndex)
+    {
+        computeChunkBounds(chunks[chunkIndex]);
+        chunkBounds.set(chunkIndex, chunks[chunkIndex].boundsMin, chunks[chunkIndex].boundsMax);
+    }
 
-            // Create buffer for EACH LOD with enough space for ALL instances
-            // (because instances can move between LOD levels at runtime)
-            for (int lod = 0; lod < 3; lod++)
-            {
-                // USE RockInstanceGPU size (20 bytes), not RockInstance (32 bytes)!
-                UINT bufferSize = (UINT)(totalInstances * sizeof(RockInstanceGPU));
-
-                D3D12_HEAP_PROPERTIES heapProps = {};
-                heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-
-                D3D12_RESOURCE_DESC bufferDesc = {};
-                bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-                bufferDesc.Width = bufferSize;
-                bufferDesc.Height = 1;
-                bufferDesc.DepthOrArraySize = 1;
-                bufferDesc.MipLevels = 1;
-                bufferDesc.SampleDesc.Count = 1;
-                bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-                HRESULT hr = core->device->CreateCommittedResource(
-                    &heapProps,
-                    D3D12_HEAP_FLAG_NONE,
-                    &bufferDesc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ,
-                    nullptr,
-                    IID_PPV_ARGS(&instanceBuffersByType[t][lod]));
-
-                if (FAILED(hr) || instanceBuffersByType[t][lod] == nullptr)
-                {
-                    std::cout << "[Rocks] ERROR: Failed to create instance buffer for type "
-                        << t << " LOD " << lod << "\n";
-                    continue;
-                }
+    void computeChunkBounds(RockChunk& chunk)
+    {
+        // An empty streamed chunk gets an inverted box, which fails every frustum plane
+        if (streaming && chunk.instances.empty())
+        {
+            chunk.boundsMin = Vec3(1e30f, 1e30f, 1e30f);
+            chunk.boundsMax = Vec3(-1e30f, -1e30f, -1e30f);
+            return;
+        }
 
-                instanceBufferViewsByType[t][lod].BufferLocation =
-                    instanceBuffersByType[t][lod]->GetGPUVirtualAddress();
-                instanceBufferViewsByType[t][lod].StrideInBytes = sizeof(RockInstanceGPU);
-                instanceBufferViewsByType[t][lod].SizeInBytes = bufferSize;
-            }
+        float half = chunkSize * 0.5f;
+        float minX = chunk.centerPos.x - half, maxX = chunk.centerPos.x + half;
+        float minZ = chunk.centerPos.z - half, maxZ = chunk.centerPos.z + half;
+
+        float minY = 0.0f, maxY = 0.0f;
+        if (terrain)
+            terrain->getHeightRange(minX, minZ, maxX, maxZ, minY, maxY);
+
+        Vec3 bmin(minX, minY, minZ);
+        Vec3 bmax(maxX, maxY, maxZ);
+
+        // Rocks near the edge can overhang the footprint
+        for (const auto& inst : chunk.instances)
+        {
+            Vec3 p = quantizer.unpackPosition(inst);
+            float r = halfToFloat(inst.scale) * boundsRadius;
+            bmin = Vec3(std::min(bmin.x, p.x - r), std::min(bmin.y, p.y - r), std::min(bmin.z, p.z - r));
+            bmax = Vec3(std::max(bmax.x, p.x + r), std::max(bmax.y, p.y + r), std::max(bmax.z, p.z + r));
         }
+
+        chunk.boundsMin = bmin;
+        chunk.boundsMax = bmax;
     }
 
     // ========================================================================
-    // CHUNK CULLING AND BUFFER UPDATE
+    // CHUNK CULLING AND BUFFER FILL (one view)
     // ========================================================================
-    void performChunkCulling(const Vec3& cameraPos)
+    // minScale > 0 keeps only instances at least that large (occluder cull)
+    void performChunkCulling(Core* core, const CullView& view, RockDrawPacket& packet, float minScale)
     {
-        // Clear visible lists
-        for (auto& typeLODs : visibleInstancesByTypeLOD)
-        {
-            for (auto& lodList : typeLODs)
-                lodList.clear();
-        }
+        // Frustum test all chunk bounds at once, then the distance and occlusion tests per chunk
+        Frustum frustum(view.viewProj);
+        frustum.cullAABBs(chunkBounds, chunkInFrustum.data());
 
-        // Determine which chunks are visible
-        float maxDist = viewDistance + chunkSize * 0.5f;
+        float maxDist = packet.viewDistance + chunkSize * 0.5f;
         float maxDistSq = maxDist * maxDist;
+        const Vec3& cameraPos = view.cameraPos;
 
-        for (auto& chunk : chunks)
+        // Impostors are for the colour views only, never for occluders
+        bool impostors = useImpostors && impostorsReady && minScale <= 0.0f;
+        float impostorStartSq = impostorDistance * impostorDistance;
+        float impostorEndSq = (impostorDistance + impostorFadeRange) * (impostorDistance + impostorFadeRange);
+
+        // Pass 1: visible chunks, per-instance LOD and the count per [type][lod] and per impostor type
+        visibleChunks.clear();
+        visibleLODs.clear();
+
+        for (size_t c = 0; c < chunks.size(); c++)
         {
+            auto& chunk = chunks[c];
             float dx = chunk.centerPos.x - cameraPos.x;
             float dz = chunk.centerPos.z - cameraPos.z;
-            chunk.isVisible = (dx * dx + dz * dz <= maxDistSq);
+            bool visible = chunkInFrustum[c] && (dx * dx + dz * dz <= maxDistSq);
+            if (visible && view.occlusion && view.occlusion->isOccluded(chunkBounds, (int)c))
+                visible = false;
+
+            if (view.viewId == CULL_VIEW_MAIN)
+                chunk.isVisible = visible;
+
+            if (!visible) continue;
+            visibleChunks.push_back((int)c);
 
-            if (chunk.isVisible)
+            // Instance x/z relative to the camera, straight from the chunk-relative packed position
+            float step = chunkSize / 65535.0f;
+            float baseX = chunk.centerPos.x - chunkSize * 0.5f - cameraPos.x;
+            float baseZ = chunk.centerPos.z - chunkSize * 0.5f - cameraPos.z;
+
+            for (const auto& inst : chunk.instances)
             {
-                for (const auto& inst : chunk.instances)
+                if (minScale > 0.0f && halfToFloat(inst.scale) < minScale)
                 {
-                    if (inst.typeIndex >= 0 && inst.typeIndex < (int)rockTypes.size() &&
-                        inst.lodLevel >= 0 && inst.lodLevel < 3)
-                    {
-                        visibleInstancesByTypeLOD[inst.typeIndex][inst.lodLevel].push_back(inst);
-                    }
+                    visibleLODs.push_back(SKIPPED_LOD);
+                    continue;
                 }
+
+                // Per-view LOD selection (reflection clamps to coarser meshes)
+                float ix = baseX + inst.position[0] * step;
+                float iz = baseZ + inst.position[2] * step;
+                float distSq = ix * ix + iz * iz;
+
+                int lod = 2;
+                if (distSq < lodDistanceHigh * lodDistanceHigh)
+                    lod = 0;
+                else if (distSq < lodDistanceMedium * lodDistanceMedium)
+                    lod = 1;
+                lod = std::max(lod, view.minLOD);
+
+                // Crossfade band draws both; past it only the impostor
+                unsigned char code = (unsigned char)lod;
+                if (impostors && distSq > impostorStartSq)
+                {
+                    code = (distSq >= impostorEndSq) ? (MESH_NONE | IMPOSTOR_FLAG) : (unsigned char)(lod | IMPOSTOR_FLAG);
+                    packet.impostorCounts[inst.param]++;
+                }
+
+                visibleLODs.push_back(code);
+                if ((code & 3) != MESH_NONE)
+                    packet.counts[inst.param * 3 + lod]++;
             }
         }
 
-        // Upload visible instances to GPU (converting to GPU format)
-        for (size_t t = 0; t < rockTypes.size(); t++)
+        // Pass 2: one frame allocation holding every [type][lod] stream back to back
+        unsigned int meshTotal = 0;
+        for (size_t slot = 0; slot < packet.counts.size(); slot++)
         {
-            for (int lod = 0; lod < 3; lod++)
+            packet.firstInstance[slot] = meshTotal;
+            meshTotal += packet.counts[slot];
+        }
+
+        std::vector<RockInstanceGPU*> writePtr(packet.counts.size(), nullptr);
+        if (meshTotal > 0)
+        {
+            FrameAllocation alloc = core->frameAllocator.allocate(meshTotal * sizeof(RockInstanceGPU), 16);
+            packet.meshInstances = alloc.gpuAddress;
+            packet.meshInstanceCount = meshTotal;
+            packet.totalVisible += meshTotal;
+            for (size_t slot = 0; slot < packet.counts.size(); slot++)
             {
-                if (visibleInstancesByTypeLOD[t][lod].empty()) continue;
-                if (instanceBuffersByType[t][lod] == nullptr) continue;
+                if (packet.counts[slot] == 0) continue;
+                writePtr[slot] = (RockInstanceGPU*)alloc.cpuAddress + packet.firstInstance[slot];
+                packet.instances[slot] = alloc.gpuAddress + packet.firstInstance[slot] * sizeof(RockInstanceGPU);
+            }
+        }
 
-                // Convert to GPU format (strip CPU-only fields)
-                std::vector<RockInstanceGPU> gpuInstances;
-                gpuInstances.reserve(visibleInstancesByTypeLOD[t][lod].size());
+        std::vector<ImpostorInstance*> impostorPtr(packet.impostorCounts.size(), nullptr);
+        for (size_t type = 0; type < packet.impostorCounts.size(); type++)
+        {
+            if (packet.impostorCounts[type] == 0) continue;
+            FrameAllocation alloc = core->frameAllocator.allocate(packet.impostorCounts[type] * sizeof(ImpostorInstance), 16);
+            impostorPtr[type] = (ImpostorInstance*)alloc.cpuAddress;
+            packet.impostors[type] = alloc.gpuAddress;
+            packet.totalVisible += packet.impostorCounts[type];
+        }
 
-                for (const auto& inst : visibleInstancesByTypeLOD[t][lod])
-                {
-                    RockInstanceGPU gpuInst;
-                    gpuInst.position = inst.position;
-                    gpuInst.rotationY = inst.rotationY;
-                    gpuInst.scale = inst.scale;
-                    gpuInstances.push_back(gpuInst);
-                }
+        // Pass 3: copy the packed records sequentially into the write-combined memory
+        size_t lodIndex = 0;
+        for (int c : visibleChunks)
+        {
+            for (const auto& inst : chunks[c].instances)
+            {
+                int code = visibleLODs[lodIndex++];
+                if (code == SKIPPED_LOD) continue;
 
-                // Upload to GPU
-                void* mappedData = nullptr;
-                D3D12_RANGE readRange = { 0, 0 };
-                HRESULT hr = instanceBuffersByType[t][lod]->Map(0, &readRange, &mappedData);
+                int lod = code & 3;
+                if (lod != MESH_NONE)
+                    *writePtr[inst.param * 3 + lod]++ = inst;
 
-                if (SUCCEEDED(hr) && mappedData)
+                if (code & IMPOSTOR_FLAG)
                 {
-                    size_t copySize = gpuInstances.size() * sizeof(RockInstanceGPU);
-                    memcpy(mappedData, gpuInstances.data(), copySize);
-                    instanceBuffersByType[t][lod]->Unmap(0, nullptr);
+                    // Same fade VSRock derives from the packed position, so the dither patterns complement
+                    ImpostorInstance impostor;
+                    impostor.position = quantizer.unpackPosition(inst);
+                    impostor.scale = halfToFloat(inst.scale);
+                    impostor.rotationY = inst.rotationY * (6.28318531f / 256.0f);
+                    float dx = impostor.position.x - cameraPos.x;
+                    float dz = impostor.position.z - cameraPos.z;
+                    impostor.fade = impostorFade(sqrtf(dx * dx + dz * dz), impostorDistance, impostorFadeRange);
+                    *impostorPtr[inst.param]++ = impostor;
                 }
             }
         }
     }
 
     // ========================================================================
-    // DRAW A SINGLE ROCK TYPE
+    // DRAW ALL MESH LODS - shader constants and PSO already applied
     // ========================================================================
-    int drawRockType(Core* core, RockType& type)
+    void drawMeshes(Core* core, const RockDrawPacket& packet)
+    {
+        if (packet.meshInstanceCount == 0) return;
+
+        // PSRock picks the texture per instance, so nothing is rebound between types
+        if (textureTable.isValid())
+            textureTable.bind(core);
+
+        if (!indirectReady)
+        {
+            for (auto& type : rockTypes)
+            {
+                drawRockType(core, type, packet);
+            }
+            return;
+        }
+
+        // One argument record per non-empty [type][lod]
+        std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> args;
+        args.reserve(packet.counts.size());
+        for (const auto& type : rockTypes)
+        {
+            for (int lod = 0; lod < 3; lod++)
+            {
+                unsigned int slot = type.typeIndex * 3 + lod;
+                if (packet.counts[slot] == 0) continue;
+
+                const Mesh* mesh = (lod == 0) ? type.meshHigh : (lod == 1) ? type.meshMedium : type.meshLow;
+                if (mesh == nullptr) continue;
+
+                D3D12_DRAW_INDEXED_ARGUMENTS arg;
+                arg.IndexCountPerInstance = mesh->getIndexCount();
+                arg.InstanceCount = packet.counts[slot];
+                arg.StartIndexLocation = mesh->getStartIndex();
+                arg.BaseVertexLocation = mesh->getBaseVertex();
+                arg.StartInstanceLocation = packet.firstInstance[slot];
+                args.push_back(arg);
+            }
+        }
+        if (args.empty())
+            return;
+
+        // Upload heap memory is GENERIC_READ, which includes INDIRECT_ARGUMENT
+        FrameAllocation argsAlloc = core->frameAllocator.upload(args.data(),
+            args.size() * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), 16);
+
+        D3D12_VERTEX_BUFFER_VIEW views[2];
+        views[0] = core->geometry.getVertexBufferView(geometryPage, geometryStride);
+        views[1].BufferLocation = packet.meshInstances;
+        views[1].StrideInBytes = sizeof(RockInstanceGPU);
+        views[1].SizeInBytes = packet.meshInstanceCount * sizeof(RockInstanceGPU);
+
+        auto cmdList = core->getCommandList();
+        cmdList->IASetVertexBuffers(0, 2, views);
+        D3D12_INDEX_BUFFER_VIEW ibView = core->geometry.getIndexBufferView(geometryPage);
+        cmdList->IASetIndexBuffer(&ibView);
+
+        cmdList->ExecuteIndirect(commandSignature, (UINT)args.size(), argsAlloc.resource, argsAlloc.offset, nullptr, 0);
+        core->countDraw(packet.meshInstanceCount);
+    }
+
+    // ========================================================================
+    // DRAW A SINGLE ROCK TYPE (fallback when the LODs are not on one geometry page)
+    // ========================================================================
+    int drawRockType(Core* core, RockType& type, const RockDrawPacket& packet)
     {
         int totalDrawn = 0;
 
         for (int lod = 0; lod < 3; lod++)
         {
-            int visibleCount = (int)visibleInstancesByTypeLOD[type.typeIndex][lod].size();
+            int visibleCount = (int)packet.counts[type.typeIndex * 3 + lod];
             if (visibleCount == 0) continue;
 
-            // Null checks
-            if (instanceBuffersByType[type.typeIndex][lod] == nullptr) continue;
-
             Mesh* mesh = (lod == 0) ? type.meshHigh : (lod == 1) ? type.meshMedium : type.meshLow;
             if (mesh == nullptr) continue;
 
-            // Set texture
-            core->getCommandList()->SetGraphicsRootDescriptorTable(2, type.texture.srvHandle);
+            // Instance view over this packet's frame allocation
+            D3D12_VERTEX_BUFFER_VIEW instanceView;
+            instanceView.BufferLocation = packet.instances[type.typeIndex * 3 + lod];
+            instanceView.StrideInBytes = sizeof(RockInstanceGPU);
+            instanceView.SizeInBytes = visibleCount * sizeof(RockInstanceGPU);
 
             // Set vertex buffers (mesh + instance data)
             D3D12_VERTEX_BUFFER_VIEW views[2];
             views[0] = mesh->getVertexBufferView();
-            views[1] = instanceBufferViewsByType[type.typeIndex][lod];
+            views[1] = instanceView;
             core->getCommandList()->IASetVertexBuffers(0, 2, views);
 
             // Set index buffer
@@ -695,6 +1282,7 @@ private:
 
             // Draw!
             core->getCommandList()->DrawIndexedInstanced(mesh->getIndexCount(), visibleCount, 0, 0, 0);
+            core->countDraw(visibleCount);
 
             totalDrawn += visibleCount;
         }
@@ -709,23 +1297,13 @@ private:
     {
         std::cout << "\n[Rocks] Statistics:\n";
         std::cout << "================================\n";
-        std::cout << "Total Rocks: " << allInstances.size() << "\n";
+        std::cout << "Total Rocks: " << allInstances.size() << " (" << sizeof(RockInstanceGPU) << " bytes each packed)\n";
         std::cout << "Chunks: " << chunks.size() << "\n\n";
 
+        // LOD is chosen per view at cull time
         for (size_t t = 0; t < rockTypes.size(); t++)
         {
-            int totalForType = 0;
-            std::cout << "Type " << t << " (" << rockTypes[t].name << "):\n";
-
-            for (int lod = 0; lod < 3; lod++)
-            {
-                int count = (int)instancesByTypeLOD[t][lod].size();
-                totalForType += count;
-                std::string lodName = (lod == 0) ? "High" : (lod == 1) ? "Medium" : "Low";
-                std::cout << "  LOD " << lodName << ": " << count << "\n";
-            }
-
-            std::cout << "  Total: " << totalForType << "\n";
+            std::cout << "Type " << t << " (" << rockTypes[t].name << "): " << instanceCountByType[t] << "\n";
         }
 
         std::cout << "================================\n\n";
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <d3d12.h>
+#include <d3dcompiler.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <iostream>
+#include "Hash.h"
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+// On-disk cache of compiled shader bytecode (ShaderCache/<key>.cso).
+// The key hashes the HLSL source together with entry point, target and compile flags, so editing a
+// shader or changing how it is compiled produces a new key; a warm launch never calls D3DCompile.
+// Stale blobs are simply never looked up again - delete the directory to clear them.
+class ShaderCache
+{
+public:
+    // Bump when the compiler or the cache layout changes, to invalidate every cached blob
+    static const unsigned int CACHE_VERSION = 1;
+
+    // Drop-in replacement for D3DCompile (no defines/includes). errors is only set on a cache miss
+    // that fails to compile; the caller releases both blobs.
+    static HRESULT compile(const std::string& source, const std::string& sourceName,
+        const std::string& entryPoint, const std::string& target, UINT flags,
+        ID3DBlob** blob, ID3DBlob** errors)
+    {
+        *blob = nullptr;
+        if (errors) *errors = nullptr;
+
+        std::string path = getPath(source, entryPoint, target, flags);
+        if (load(path, blob))
+            return S_OK;
+
+        HRESULT hr = D3DCompile(source.c_str(), source.length(), sourceName.c_str(),
+            nullptr, nullptr, entryPoint.c_str(), target.c_str(), flags, 0, blob, errors);
+
+        if (SUCCEEDED(hr) && *blob != nullptr)
+            store(path, *blob);
+
+        return hr;
+    }
+
+    static std::string readSource(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    static const char* getDirectory() { return "ShaderCache"; }
+
+private:
+    static std::string getPath(const std::string& source, const std::string& entryPoint,
+        const std::string& target, UINT flags)
+    {
+        unsigned long long key = hashBytes(source.data(), source.size());
+        key = hashBytes(entryPoint.data(), entryPoint.size(), key);
+        key = hashBytes(target.data(), target.size(), key);
+        key = hashBytes(&flags, sizeof(flags), key);
+        key = hashBytes(&CACHE_VERSION, sizeof(CACHE_VERSION), key);
+
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.cso", key);
+        return std::string(getDirectory()) + "/" + name;
+    }
+
+    static bool load(const std::string& path, ID3DBlob** blob)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+
+        std::streamsize size = file.tellg();
+        if (size <= 0)
+            return false;
+        file.seekg(0, std::ios::beg);
+
+        if (FAILED(D3DCreateBlob((SIZE_T)size, blob)))
+            return false;
+
+        if (!file.read((char*)(*blob)->GetBufferPointer(), size))
+        {
+            (*blob)->Release();
+            *blob = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    static void store(const std::string& path, ID3DBlob* blob)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(getDirectory(), ec);
+
+        // Write to a temporary file first so a crash mid-write never leaves a truncated blob behind
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary);
+            if (!file.is_open())
+            {
+                std::cout << "[ShaderCache] WARNING: Cannot write " << path << "\n";
+                return;
+            }
+            file.write((const char*)blob->GetBufferPointer(), (std::streamsize)blob->GetBufferSize());
+        }
+        std::filesystem::rename(tempPath, path, ec);
+    }
+};
@@ -7,8 +7,10 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 
 #include "Core.h"
+#include "ShaderCache.h"
 
 #pragma comment(lib, "dxguid.lib")
 
@@ -18,64 +20,63 @@ struct ConstantBufferVariable
 	unsigned int size;
 };
 
+// A constant resolved once to its place in a shader's staging memory, so per-draw updates are a
+// straight copy instead of a buffer-name scan and variable-name map lookup.
+// Stays valid for the lifetime of the Shaders instance the handle came from.
+struct ConstantHandle
+{
+	unsigned char* data = nullptr;
+	unsigned int size = 0;
+	bool isValid() const { return data != nullptr; }
+	void set(const void* value) const
+	{
+		if (data != nullptr)
+		{
+			memcpy(data, value, size);
+		}
+	}
+};
+
+// Reflection-driven constant buffer. Values are staged on the CPU and copied into Core's
+// frame allocator on every apply(), so each draw gets its own fenced copy of the data.
 class ConstantBuffer
 {
 public:
 	std::string name;
 	std::map<std::string, ConstantBufferVariable> constantBufferData;
-	ID3D12Resource* constantBuffer;
-	unsigned char *buffer;
+	std::vector<unsigned char> staging;
 	unsigned int cbSizeInBytes;
-	unsigned int numInstances;
-	unsigned int offsetIndex;
-	void init(Core* core, unsigned int sizeInBytes, unsigned int maxDrawCalls = 1024)
+	void init(Core* core, unsigned int sizeInBytes)
 	{
 		cbSizeInBytes = (sizeInBytes + 255) & ~255;
-		unsigned int cbSizeInBytesAligned = cbSizeInBytes * maxDrawCalls;
-		numInstances = maxDrawCalls;
-		offsetIndex = 0;
-		HRESULT hr;
-		D3D12_HEAP_PROPERTIES heapprops;
-		memset(&heapprops, 0, sizeof(D3D12_HEAP_PROPERTIES));
-		heapprops.Type = D3D12_HEAP_TYPE_UPLOAD;
-		heapprops.CreationNodeMask = 1;
-		heapprops.VisibleNodeMask = 1;
-		D3D12_RESOURCE_DESC cbDesc;
-		memset(&cbDesc, 0, sizeof(D3D12_RESOURCE_DESC));
-		cbDesc.Width = cbSizeInBytesAligned;
-		cbDesc.Height = 1;
-		cbDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		cbDesc.DepthOrArraySize = 1;
-		cbDesc.MipLevels = 1;
-		cbDesc.SampleDesc.Count = 1;
-		cbDesc.SampleDesc.Quality = 0;
-		cbDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		hr = core->device->CreateCommittedResource(&heapprops, D3D12_HEAP_FLAG_NONE, &cbDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, __uuidof(ID3D12Resource), (void**)&constantBuffer);
-		D3D12_RANGE readRange = {0, 0};
-		hr = constantBuffer->Map(0, &readRange, (void**)&buffer);
-	}
-	void update(std::string name, void* data) // Data is immediatly visible
-	{
-		ConstantBufferVariable cbVariable = constantBufferData[name];
-		unsigned int offset = offsetIndex * cbSizeInBytes;
-		memcpy(&buffer[offset + cbVariable.offset], data, cbVariable.size);
-	}
-	D3D12_GPU_VIRTUAL_ADDRESS getGPUAddress() const
-	{
-		return (constantBuffer->GetGPUVirtualAddress() + (offsetIndex * cbSizeInBytes));
-	}
-	void next()
-	{
-		offsetIndex++;
-		if (offsetIndex >= numInstances)
+		staging.assign(cbSizeInBytes, 0);
+	}
+	void update(const std::string& name, void* data) // Staged; reaches the GPU on the next upload()
+	{
+		auto it = constantBufferData.find(name);
+		if (it != constantBufferData.end())
 		{
-			offsetIndex = 0;
+			memcpy(&staging[it->second.offset], data, it->second.size);
 		}
 	}
+	ConstantHandle getHandle(const std::string& name)
+	{
+		ConstantHandle handle;
+		auto it = constantBufferData.find(name);
+		if (it != constantBufferData.end())
+		{
+			handle.data = &staging[it->second.offset];
+			handle.size = it->second.size;
+		}
+		return handle;
+	}
+	D3D12_GPU_VIRTUAL_ADDRESS upload(Core* core)
+	{
+		return core->uploadConstants(staging.data(), cbSizeInBytes);
+	}
 	void free()
 	{
-		constantBuffer->Unmap(0, NULL);
-		constantBuffer->Release();
+		staging.clear();
 	}
 };
 
@@ -100,6 +101,10 @@ public:
 			ID3D12ShaderReflectionConstantBuffer* constantBuffer = reflection->GetConstantBufferByIndex(i);
 			D3D12_SHADER_BUFFER_DESC cbDesc;
 			constantBuffer->GetDesc(&cbDesc);
+			if (cbDesc.Type != D3D_CT_CBUFFER)
+			{
+				continue; // Structured buffers are reflected here too; they are bound as SRVs, not CBVs
+			}
 			buffer.name = cbDesc.Name;
 			unsigned int totalSize = 0;
 			for (int j = 0; j < cbDesc.Variables; j++)
@@ -113,7 +118,8 @@ public:
 				buffer.constantBufferData.insert({vDesc.Name, bufferVariable});
 				totalSize += bufferVariable.size;
 			}
-			buffer.init(core, totalSize);
+			// cbDesc.Size includes HLSL packing padding, the sum of variable sizes does not
+			buffer.init(core, (std::max)(totalSize, (unsigned int)cbDesc.Size));
 			buffers.push_back(buffer);
 		}
 		for (int i = 0; i < desc.BoundResources; i++)
@@ -130,7 +136,8 @@ public:
 	void loadPS(Core *core, std::string hlsl)
 	{
 		ID3DBlob* status;
-		HRESULT hr = D3DCompile(hlsl.c_str(), strlen(hlsl.c_str()), NULL, NULL, NULL, "PS", "ps_5_0", 0, 0, &ps, &status);
+		// Shader model 5.1 for register spaces and dynamic indexing into the bindless texture table
+		HRESULT hr = ShaderCache::compile(hlsl, "PS", "PS", "ps_5_1", 0, &ps, &status);
 		if (FAILED(hr))
 		{
 			printf("%s\n", (char*)status->GetBufferPointer());
@@ -141,7 +148,7 @@ public:
 	void loadVS(Core* core, std::string hlsl)
 	{
 		ID3DBlob* status;
-		HRESULT hr = D3DCompile(hlsl.c_str(), strlen(hlsl.c_str()), NULL, NULL, NULL, "VS", "vs_5_0", 0, 0, &vs, &status);
+		HRESULT hr = ShaderCache::compile(hlsl, "VS", "VS", "vs_5_1", 0, &vs, &status);
 		if (FAILED(hr))
 		{
 			printf("%s\n", (char*)status->GetBufferPointer());
@@ -149,6 +156,31 @@ public:
 		}
 		initConstantBuffers(core, vs, vsConstantBuffers);
 	}
+	ConstantHandle getConstant(const std::string& constantBufferName, const std::string& variableName, std::vector<ConstantBuffer>& buffers)
+	{
+		for (int i = 0; i < buffers.size(); i++)
+		{
+			if (buffers[i].name == constantBufferName)
+			{
+				ConstantHandle handle = buffers[i].getHandle(variableName);
+				if (!handle.isValid())
+				{
+					std::cout << "[Shaders] WARNING: No constant " << variableName << " in " << constantBufferName << "\n";
+				}
+				return handle;
+			}
+		}
+		std::cout << "[Shaders] WARNING: No constant buffer " << constantBufferName << "\n";
+		return ConstantHandle();
+	}
+	ConstantHandle getConstantVS(const std::string& constantBufferName, const std::string& variableName)
+	{
+		return getConstant(constantBufferName, variableName, vsConstantBuffers);
+	}
+	ConstantHandle getConstantPS(const std::string& constantBufferName, const std::string& variableName)
+	{
+		return getConstant(constantBufferName, variableName, psConstantBuffers);
+	}
 	void updateConstant(std::string constantBufferName, std::string variableName, void* data, std::vector<ConstantBuffer>& buffers)
 	{
 		for (int i = 0; i < buffers.size(); i++)
@@ -172,13 +204,11 @@ public:
 	{
 		for (int i = 0; i < vsConstantBuffers.size(); i++)
 		{
-			core->getCommandList()->SetGraphicsRootConstantBufferView(0, vsConstantBuffers[i].getGPUAddress());
-			vsConstantBuffers[i].next();
+			core->getCommandList()->SetGraphicsRootConstantBufferView(0, vsConstantBuffers[i].upload(core));
 		}
 		for (int i = 0; i < psConstantBuffers.size(); i++)
 		{
-			core->getCommandList()->SetGraphicsRootConstantBufferView(1, psConstantBuffers[i].getGPUAddress());
-			psConstantBuffers[i].next();
+			core->getCommandList()->SetGraphicsRootConstantBufferView(1, psConstantBuffers[i].upload(core));
 		}
 	}
 	void free()
@@ -202,10 +232,7 @@ public:
 	std::map<std::string, Shader> shaders;
 	std::string readFile(std::string filename)
 	{
-		std::ifstream file(filename);
-		std::stringstream buffer;
-		buffer << file.rdbuf();
-		return buffer.str();
+		return ShaderCache::readSource(filename);
 	}
 	void load(Core* core, std::string shadername, std::string vsfilename, std::string psfilename)
 	{
@@ -231,6 +258,15 @@ public:
 	{
 		return &shaders[name];
 	}
+	// Resolve once after load(), then set() the handle every draw
+	ConstantHandle getConstantVS(std::string name, std::string constantBufferName, std::string variableName)
+	{
+		return shaders[name].getConstantVS(constantBufferName, variableName);
+	}
+	ConstantHandle getConstantPS(std::string name, std::string constantBufferName, std::string variableName)
+	{
+		return shaders[name].getConstantPS(constantBufferName, variableName);
+	}
 	void apply(Core* core, std::string name)
 	{
 		shaders[name].apply(core);
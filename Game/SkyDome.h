@@ -38,9 +38,13 @@ public:
 
         // Load sky shaders and create a standard PSO using the same static vertex layout as other meshes.
         shaders->load(core, shaderName, "Shaders/VSSky.txt", "Shaders/PSSky.txt");
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
+        shader = shaders->find(shaderName);
+        worldConstant = shader->getConstantVS("staticMeshBuffer", "W");
+        vpConstant = shader->getConstantVS("staticMeshBuffer", "VP");
+        zenithConstant = shader->getConstantPS("skyPSBuffer", "zenithColor");
+        horizonConstant = shader->getConstantPS("skyPSBuffer", "horizonColor");
+
+        pso = psos->createPSO(core, psoName, shader->vs, shader->ps,
             VertexLayoutCache::getStaticLayout());
     }
 
@@ -53,19 +57,19 @@ public:
             * Matrix::translation(cameraPos);
 
         // Provide W and VP to the vertex shader so the sky dome renders correctly in clip space.
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", (void*)&W);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", (void*)&vp);
+        worldConstant.set(&W);
+        vpConstant.set(&vp);
 
         // Provide simple gradient controls (top and horizon colors) to the pixel shader.
         // If your sky pixel shader blends these, it helps reduce banding and supports stylized skies.
         Vec4 zenith(0.2f, 0.4f, 0.8f, 1.0f);
         Vec4 horizon(0.8f, 0.7f, 0.5f, 1.0f);
-        shaders->updateConstantPS(shaderName, "skyPSBuffer", "zenithColor", &zenith);
-        shaders->updateConstantPS(shaderName, "skyPSBuffer", "horizonColor", &horizon);
+        zenithConstant.set(&zenith);
+        horizonConstant.set(&horizon);
 
         // Bind shader + PSO, then bind the sky texture SRV and draw the sphere mesh.
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
 
         core->getCommandList()->SetGraphicsRootDescriptorTable(2, skyTexture.srvHandle);
         mesh.draw(core);
@@ -75,6 +79,14 @@ private:
     Mesh  mesh;
     float radius = 5000.0f;
 
+    // Shader, PSO and constants resolved once at init so per-frame updates skip the name lookups.
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
+    ConstantHandle worldConstant;
+    ConstantHandle vpConstant;
+    ConstantHandle zenithConstant;
+    ConstantHandle horizonConstant;
+
     // Build a STATIC_VERTEX using only the fields your engine already supports.
     // Tangent is derived from the normal using a simple shading frame for consistency.
     STATIC_VERTEX makeVertex(const Vec3& p, const Vec3& n, float u, float v)
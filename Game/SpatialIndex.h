@@ -0,0 +1,329 @@
+#pragma once
+
+#include "Maths.h"
+#include <vector>
+#include <cmath>
+
+// Result of SpatialIndex::raycast
+struct SpatialHit
+{
+    int item = -1;          // Index returned by add()
+    float distance = 0.0f;  // Along the (normalised) ray direction
+    Vec3 point;
+};
+
+// Static uniform grid over the XZ plane for world obstacles (bounding spheres).
+// Items are added once, then build() packs them into per-cell ranges (cellStart/cellItems), so a
+// query only touches the cells it overlaps. An item spanning several cells is stored in each of them;
+// collecting queries report it once by only accepting it in the first cell shared with the query.
+class SpatialIndex
+{
+public:
+    void clear()
+    {
+        centers.clear();
+        radii.clear();
+        cellStart.clear();
+        cellItems.clear();
+        gridWidth = gridHeight = 0;
+    }
+
+    // Register an obstacle; returns its item index (stable, in insertion order)
+    int add(const Vec3& center, float radius)
+    {
+        centers.push_back(center);
+        radii.push_back(radius);
+        return (int)centers.size() - 1;
+    }
+
+    // Pack items into the grid. cellSize should be around the typical query size (player radius,
+    // rock spacing); very small cells make large items span many cells.
+    void build(float _cellSize)
+    {
+        cellSize = _cellSize;
+        invCellSize = 1.0f / cellSize;
+        cellStart.clear();
+        cellItems.clear();
+
+        if (centers.empty())
+        {
+            gridWidth = gridHeight = 0;
+            return;
+        }
+
+        // Grid covers the XZ extent of every item
+        float minX = 1e30f, minZ = 1e30f, maxX = -1e30f, maxZ = -1e30f;
+        for (size_t i = 0; i < centers.size(); i++)
+        {
+            minX = std::min(minX, centers[i].x - radii[i]);
+            minZ = std::min(minZ, centers[i].z - radii[i]);
+            maxX = std::max(maxX, centers[i].x + radii[i]);
+            maxZ = std::max(maxZ, centers[i].z + radii[i]);
+        }
+        originX = minX;
+        originZ = minZ;
+        gridWidth = (int)std::floor((maxX - minX) * invCellSize) + 1;
+        gridHeight = (int)std::floor((maxZ - minZ) * invCellSize) + 1;
+
+        // Counting pass, prefix sum, then fill (cellStart has one extra entry for the end)
+        cellStart.assign(gridWidth * gridHeight + 1, 0);
+        for (size_t i = 0; i < centers.size(); i++)
+        {
+            int x0, z0, x1, z1;
+            itemCells((int)i, x0, z0, x1, z1);
+            for (int z = z0; z <= z1; z++)
+                for (int x = x0; x <= x1; x++)
+                    cellStart[z * gridWidth + x + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); c++)
+            cellStart[c] += cellStart[c - 1];
+
+        cellItems.resize(cellStart.back());
+        std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < centers.size(); i++)
+        {
+            int x0, z0, x1, z1;
+            itemCells((int)i, x0, z0, x1, z1);
+            for (int z = z0; z <= z1; z++)
+                for (int x = x0; x <= x1; x++)
+                    cellItems[cursor[z * gridWidth + x]++] = (int)i;
+        }
+    }
+
+    // Any item whose XZ circle overlaps the given circle (player collision)
+    bool overlapsCircleXZ(float x, float z, float radius) const
+    {
+        int x0, z0, x1, z1;
+        if (!rangeCells(x - radius, z - radius, x + radius, z + radius, x0, z0, x1, z1))
+            return false;
+
+        for (int cz = z0; cz <= z1; cz++)
+        {
+            for (int cx = x0; cx <= x1; cx++)
+            {
+                int cell = cz * gridWidth + cx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+                {
+                    int i = cellItems[k];
+                    float dx = centers[i].x - x;
+                    float dz = centers[i].z - z;
+                    float minDist = radii[i] + radius;
+                    if (dx * dx + dz * dz < minDist * minDist)
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // All items whose XZ circle overlaps the given circle; returns how many were appended to out
+    int queryCircleXZ(float x, float z, float radius, std::vector<int>& out) const
+    {
+        return query(x, z, radius, out, [&](int i)
+            {
+                float dx = centers[i].x - x;
+                float dz = centers[i].z - z;
+                float minDist = radii[i] + radius;
+                return dx * dx + dz * dz < minDist * minDist;
+            });
+    }
+
+    // All items whose bounding sphere overlaps the given sphere
+    int querySphere(const Vec3& center, float radius, std::vector<int>& out) const
+    {
+        return query(center.x, center.z, radius, out, [&](int i)
+            {
+                float minDist = radii[i] + radius;
+                return (centers[i] - center).lengthSq() < minDist * minDist;
+            });
+    }
+
+    // Nearest bounding-sphere hit along a ray (e.g. a gun hit test). Walks the XZ cells the ray
+    // crosses in order (2D DDA) and stops as soon as a hit lies before the current cell's exit.
+    bool raycast(const Vec3& origin, const Vec3& direction, float maxDistance, SpatialHit& hit) const
+    {
+        if (gridWidth == 0)
+            return false;
+
+        Vec3 dir = direction.normalize();
+        float best = maxDistance;
+        int bestItem = -1;
+
+        // Clip the ray's XZ projection to the grid rectangle
+        float tEnter = 0.0f, tExit = maxDistance;
+        if (!clipAxis(origin.x, dir.x, originX, originX + gridWidth * cellSize, tEnter, tExit) ||
+            !clipAxis(origin.z, dir.z, originZ, originZ + gridHeight * cellSize, tEnter, tExit))
+            return false;
+
+        float startX = origin.x + dir.x * tEnter;
+        float startZ = origin.z + dir.z * tEnter;
+        int cx = clampCell((int)std::floor((startX - originX) * invCellSize), gridWidth);
+        int cz = clampCell((int)std::floor((startZ - originZ) * invCellSize), gridHeight);
+
+        int stepX = (dir.x > 0.0f) ? 1 : -1;
+        int stepZ = (dir.z > 0.0f) ? 1 : -1;
+        float tDeltaX = (dir.x != 0.0f) ? std::fabs(cellSize / dir.x) : 1e30f;
+        float tDeltaZ = (dir.z != 0.0f) ? std::fabs(cellSize / dir.z) : 1e30f;
+        float nextX = originX + (cx + (stepX > 0 ? 1 : 0)) * cellSize;
+        float nextZ = originZ + (cz + (stepZ > 0 ? 1 : 0)) * cellSize;
+        float tMaxX = (dir.x != 0.0f) ? (nextX - origin.x) / dir.x : 1e30f;
+        float tMaxZ = (dir.z != 0.0f) ? (nextZ - origin.z) / dir.z : 1e30f;
+
+        while (cx >= 0 && cx < gridWidth && cz >= 0 && cz < gridHeight)
+        {
+            int cell = cz * gridWidth + cx;
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+            {
+                int i = cellItems[k];
+                float t;
+                if (raySphere(origin, dir, centers[i], radii[i], t) && t < best)
+                {
+                    best = t;
+                    bestItem = i;
+                }
+            }
+
+            // Later cells can only hold hits further along the ray
+            float cellExit = std::min(tMaxX, tMaxZ);
+            if (bestItem >= 0 && best <= cellExit)
+                break;
+            if (cellExit > tExit)
+                break;
+
+            if (tMaxX < tMaxZ)
+            {
+                cx += stepX;
+                tMaxX += tDeltaX;
+            }
+            else
+            {
+                cz += stepZ;
+                tMaxZ += tDeltaZ;
+            }
+        }
+
+        if (bestItem < 0)
+            return false;
+
+        hit.item = bestItem;
+        hit.distance = best;
+        hit.point = origin + dir * best;
+        return true;
+    }
+
+    size_t getItemCount() const { return centers.size(); }
+    const Vec3& getCenter(int item) const { return centers[item]; }
+    float getRadius(int item) const { return radii[item]; }
+
+private:
+    std::vector<Vec3> centers;
+    std::vector<float> radii;
+
+    std::vector<int> cellStart;     // Per cell: first entry in cellItems (size = cells + 1)
+    std::vector<int> cellItems;     // Item indices, grouped by cell
+
+    float cellSize = 8.0f;
+    float invCellSize = 1.0f / 8.0f;
+    float originX = 0.0f;
+    float originZ = 0.0f;
+    int gridWidth = 0;
+    int gridHeight = 0;
+
+    static int clampCell(int c, int count)
+    {
+        return (c < 0) ? 0 : (c >= count ? count - 1 : c);
+    }
+
+    // Clamped cell rectangle covered by an XZ box; false if it misses the grid entirely
+    bool rangeCells(float minX, float minZ, float maxX, float maxZ, int& x0, int& z0, int& x1, int& z1) const
+    {
+        if (gridWidth == 0)
+            return false;
+
+        x0 = (int)std::floor((minX - originX) * invCellSize);
+        z0 = (int)std::floor((minZ - originZ) * invCellSize);
+        x1 = (int)std::floor((maxX - originX) * invCellSize);
+        z1 = (int)std::floor((maxZ - originZ) * invCellSize);
+        if (x1 < 0 || z1 < 0 || x0 >= gridWidth || z0 >= gridHeight)
+            return false;
+
+        x0 = clampCell(x0, gridWidth);
+        z0 = clampCell(z0, gridHeight);
+        x1 = clampCell(x1, gridWidth);
+        z1 = clampCell(z1, gridHeight);
+        return true;
+    }
+
+    void itemCells(int i, int& x0, int& z0, int& x1, int& z1) const
+    {
+        rangeCells(centers[i].x - radii[i], centers[i].z - radii[i],
+            centers[i].x + radii[i], centers[i].z + radii[i], x0, z0, x1, z1);
+    }
+
+    template<typename Test>
+    int query(float x, float z, float radius, std::vector<int>& out, Test test) const
+    {
+        int x0, z0, x1, z1;
+        if (!rangeCells(x - radius, z - radius, x + radius, z + radius, x0, z0, x1, z1))
+            return 0;
+
+        int found = 0;
+        for (int cz = z0; cz <= z1; cz++)
+        {
+            for (int cx = x0; cx <= x1; cx++)
+            {
+                int cell = cz * gridWidth + cx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+                {
+                    int i = cellItems[k];
+
+                    // Report each item only from the first cell it shares with the query
+                    int ix0, iz0, ix1, iz1;
+                    itemCells(i, ix0, iz0, ix1, iz1);
+                    if (cx != std::max(ix0, x0) || cz != std::max(iz0, z0))
+                        continue;
+
+                    if (test(i))
+                    {
+                        out.push_back(i);
+                        found++;
+                    }
+                }
+            }
+        }
+        return found;
+    }
+
+    // Slab clip of one axis against [lo, hi]
+    static bool clipAxis(float o, float d, float lo, float hi, float& tEnter, float& tExit)
+    {
+        if (d == 0.0f)
+            return o >= lo && o <= hi;
+
+        float t0 = (lo - o) / d;
+        float t1 = (hi - o) / d;
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+        return tEnter <= tExit;
+    }
+
+    // dir must be normalised; t is the entry distance (0 if the origin is inside the sphere)
+    static bool raySphere(const Vec3& origin, const Vec3& dir, const Vec3& center, float radius, float& t)
+    {
+        Vec3 oc = origin - center;
+        float b = Dot(oc, dir);
+        float c = oc.lengthSq() - radius * radius;
+        if (c > 0.0f && b > 0.0f)
+            return false;
+
+        float disc = b * b - c;
+        if (disc < 0.0f)
+            return false;
+
+        t = -b - sqrtf(disc);
+        if (t < 0.0f)
+            t = 0.0f;
+        return true;
+    }
+};
@@ -39,11 +39,17 @@ public:
         createFullscreenQuad(core);
 
         // Use standard blended PSO
-        psos->createBlendedPSO(core, psoName,
+        pso = psos->createBlendedPSO(core, psoName,
             shaders->find(shaderName)->vs,
             shaders->find(shaderName)->ps,
             VertexLayoutCache::getStaticLayout());
 
+        // Screen-space quad: W and VP never change, so stage them once
+        shader = shaders->find(shaderName);
+        Matrix identity;
+        shader->getConstantVS("staticMeshBuffer", "W").set(&identity);
+        shader->getConstantVS("staticMeshBuffer", "VP").set(&identity);
+
         initialized = true;
         std::cout << "[StartMenu] Initialized with texture: " << menuImagePath << "\n";
     }
@@ -66,12 +72,8 @@ public:
     {
         if (!isActive || !initialized) return;
 
-        Matrix identity;
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", &identity);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", &identity);
-
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        shader->apply(core);
+        psos->bind(core, pso);
 
         // Bind the menu texture (same pattern as SkyDome)
         core->getCommandList()->SetGraphicsRootDescriptorTable(2, menuTexture.srvHandle);
@@ -80,7 +82,16 @@ public:
         fullscreenQuad.draw(core);
     }
 
+    // The menu is never shown again once gameplay starts; hand its texture and SRV slot back
+    void release(Core* core)
+    {
+        core->releaseTexture(menuTexture);
+        initialized = false;
+    }
+
 private:
+    Shader* shader = nullptr;
+    PSOHandle pso = INVALID_PSO;
     int screenWidth = 1920;
     int screenHeight = 1080;
     bool initialized = false;
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <d3d12.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "stb_image.h"
+
+// One mip level inside TextureImage::data, tightly packed (rowBytes * rowCount bytes)
+struct TextureMip
+{
+    size_t offset = 0;
+    int width = 0;
+    int height = 0;
+    int rowBytes = 0;       // Bytes per row of pixels, or per row of 4x4 blocks for BC formats
+    int rowCount = 0;       // Pixel rows, or block rows for BC formats
+};
+
+// CPU-side texture with its full mip chain: RGBA8 mips generated from a decoded image, or
+// block-compressed mips read from a precompressed .dds. Built on worker threads (no device access),
+// then handed to Core::createTexture.
+struct TextureImage
+{
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    int width = 0;
+    int height = 0;
+    std::vector<TextureMip> mips;
+    std::vector<unsigned char> data;
+
+    bool valid() const { return !mips.empty(); }
+    int mipCount() const { return (int)mips.size(); }
+    const unsigned char* mipData(int mip) const { return data.data() + mips[mip].offset; }
+};
+
+// Texture decoding for Core::loadTexture and AssetManager.
+// "Name.png" is served from "Name.dds" when that file exists (any BC1/BC3/BC5/BC7 or RGBA8 DDS with
+// pre-built mips, e.g. from texconv); otherwise the image is decoded and its mips are box-filtered here.
+class TextureImageLoader
+{
+public:
+    // Alpha value the alpha-tested shaders clip against; mips are rescaled so the fraction of texels
+    // passing this test matches mip 0's
+    static constexpr float ALPHA_TEST_REFERENCE = 0.5f;
+
+    static bool load(const std::string& filename, TextureImage& image)
+    {
+        std::string ddsPath = ddsPathFor(filename);
+        std::error_code ec;
+        if (std::filesystem::exists(ddsPath, ec) && loadDDS(ddsPath, image))
+            return true;
+
+        int w, h, channels;
+        unsigned char* pixels = stbi_load(filename.c_str(), &w, &h, &channels, 4);
+        if (!pixels)
+            return false;
+
+        fromRGBA(pixels, w, h, image);
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    static std::string ddsPathFor(const std::string& filename)
+    {
+        return std::filesystem::path(filename).replace_extension(".dds").string();
+    }
+
+    // Build an RGBA8 image with a full mip chain from tightly packed pixels
+    static void fromRGBA(const unsigned char* pixels, int w, int h, TextureImage& image)
+    {
+        image = {};
+        image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        image.width = w;
+        image.height = h;
+
+        // Lay out every level first so data is allocated once
+        size_t total = 0;
+        for (int mw = w, mh = h;; mw = (std::max)(mw / 2, 1), mh = (std::max)(mh / 2, 1))
+        {
+            TextureMip mip;
+            mip.offset = total;
+            mip.width = mw;
+            mip.height = mh;
+            mip.rowBytes = mw * 4;
+            mip.rowCount = mh;
+            image.mips.push_back(mip);
+            total += (size_t)mip.rowBytes * mip.rowCount;
+            if (mw == 1 && mh == 1)
+                break;
+        }
+        image.data.resize(total);
+        memcpy(image.data.data(), pixels, (size_t)w * h * 4);
+
+        float coverage = alphaCoverage(image.data.data(), w, h, ALPHA_TEST_REFERENCE);
+        bool alphaTested = coverage > 0.0f && coverage < 1.0f;
+
+        for (int m = 1; m < image.mipCount(); m++)
+        {
+            const TextureMip& src = image.mips[m - 1];
+            const TextureMip& dst = image.mips[m];
+            downsample(image.data.data() + src.offset, src.width, src.height, image.data.data() + dst.offset);
+
+            // Plain averaging makes cutout foliage thin out and vanish with distance
+            if (alphaTested)
+                preserveCoverage(image.data.data() + dst.offset, dst.width, dst.height, coverage);
+        }
+    }
+
+    static bool isBlockCompressed(DXGI_FORMAT format)
+    {
+        return blockBytes(format) != 0;
+    }
+
+    // Bytes per 4x4 block, 0 for uncompressed formats
+    static int blockBytes(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM: return 8;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC7_UNORM: return 16;
+        default: return 0;
+        }
+    }
+
+    static const char* formatName(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM: return "RGBA8";
+        case DXGI_FORMAT_BC1_UNORM: return "BC1";
+        case DXGI_FORMAT_BC3_UNORM: return "BC3";
+        case DXGI_FORMAT_BC5_UNORM: return "BC5";
+        case DXGI_FORMAT_BC7_UNORM: return "BC7";
+        default: return "?";
+        }
+    }
+
+private:
+    // 2x2 box filter; odd edges reuse the last row/column
+    static void downsample(const unsigned char* src, int sw, int sh, unsigned char* dst)
+    {
+        int dw = (std::max)(sw / 2, 1);
+        int dh = (std::max)(sh / 2, 1);
+        for (int y = 0; y < dh; y++)
+        {
+            int y0 = (std::min)(y * 2, sh - 1);
+            int y1 = (std::min)(y * 2 + 1, sh - 1);
+            for (int x = 0; x < dw; x++)
+            {
+                int x0 = (std::min)(x * 2, sw - 1);
+                int x1 = (std::min)(x * 2 + 1, sw - 1);
+                const unsigned char* a = src + ((size_t)y0 * sw + x0) * 4;
+                const unsigned char* b = src + ((size_t)y0 * sw + x1) * 4;
+                const unsigned char* c = src + ((size_t)y1 * sw + x0) * 4;
+                const unsigned char* d = src + ((size_t)y1 * sw + x1) * 4;
+                unsigned char* out = dst + ((size_t)y * dw + x) * 4;
+                for (int k = 0; k < 4; k++)
+                    out[k] = (unsigned char)((a[k] + b[k] + c[k] + d[k] + 2) / 4);
+            }
+        }
+    }
+
+    static float alphaCoverage(const unsigned char* rgba, int w, int h, float reference, float scale = 1.0f)
+    {
+        size_t count = (size_t)w * h;
+        size_t passed = 0;
+        float threshold = reference * 255.0f;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (rgba[i * 4 + 3] * scale > threshold)
+                passed++;
+        }
+        return (float)passed / (float)count;
+    }
+
+    // Scale mip alpha so the fraction above the reference matches the top level (binary search on scale)
+    static void preserveCoverage(unsigned char* rgba, int w, int h, float targetCoverage)
+    {
+        float lo = 0.0f, hi = 4.0f;
+        for (int i = 0; i < 10; i++)
+        {
+            float mid = 0.5f * (lo + hi);
+            if (alphaCoverage(rgba, w, h, ALPHA_TEST_REFERENCE, mid) < targetCoverage)
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        size_t count = (size_t)w * h;
+        for (size_t i = 0; i < count; i++)
+        {
+            float a = rgba[i * 4 + 3] * hi;
+            rgba[i * 4 + 3] = (unsigned char)(std::min)(a + 0.5f, 255.0f);
+        }
+    }
+
+    // DDS_PIXELFORMAT / DDS_HEADER / DDS_HEADER_DXT10 as laid out on disk
+    struct DDSPixelFormat
+    {
+        unsigned int size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+    };
+
+    struct DDSHeader
+    {
+        unsigned int size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+        unsigned int reserved1[11];
+        DDSPixelFormat format;
+        unsigned int caps, caps2, caps3, caps4, reserved2;
+    };
+
+    struct DDSHeaderDX10
+    {
+        unsigned int dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+    };
+
+    static constexpr unsigned int fourCC(char a, char b, char c, char d)
+    {
+        return (unsigned int)a | ((unsigned int)b << 8) | ((unsigned int)c << 16) | ((unsigned int)d << 24);
+    }
+
+    // sRGB variants load as UNORM: every texture in the engine is sampled as UNORM
+    static DXGI_FORMAT supportedFormat(unsigned int dxgiFormat)
+    {
+        switch ((DXGI_FORMAT)dxgiFormat)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB: return DXGI_FORMAT_BC1_UNORM;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB: return DXGI_FORMAT_BC3_UNORM;
+        case DXGI_FORMAT_BC5_UNORM: return DXGI_FORMAT_BC5_UNORM;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB: return DXGI_FORMAT_BC7_UNORM;
+        default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    // 2D, single-surface DDS only (no arrays, cubes or volumes)
+    static bool loadDDS(const std::string& path, TextureImage& image)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        unsigned int magic = 0;
+        DDSHeader header = {};
+        file.read((char*)&magic, sizeof(magic));
+        file.read((char*)&header, sizeof(header));
+        if (!file || magic != fourCC('D', 'D', 'S', ' ') || header.size != sizeof(DDSHeader))
+        {
+            std::cout << "[Texture] WARNING: " << path << " is not a DDS file\n";
+            return false;
+        }
+
+        const unsigned int DDPF_FOURCC = 0x4;
+        const unsigned int DDPF_RGB = 0x40;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        if (header.format.flags & DDPF_FOURCC)
+        {
+            unsigned int cc = header.format.fourCC;
+            if (cc == fourCC('D', 'X', '1', '0'))
+            {
+                DDSHeaderDX10 dx10 = {};
+                file.read((char*)&dx10, sizeof(dx10));
+                if (dx10.arraySize > 1)
+                {
+                    std::cout << "[Texture] WARNING: " << path << " is a texture array (unsupported)\n";
+                    return false;
+                }
+                format = supportedFormat(dx10.dxgiFormat);
+            }
+            else if (cc == fourCC('D', 'X', 'T', '1')) format = DXGI_FORMAT_BC1_UNORM;
+            else if (cc == fourCC('D', 'X', 'T', '5')) format = DXGI_FORMAT_BC3_UNORM;
+            else if (cc == fourCC('A', 'T', 'I', '2') || cc == fourCC('B', 'C', '5', 'U')) format = DXGI_FORMAT_BC5_UNORM;
+        }
+        else if ((header.format.flags & DDPF_RGB) && header.format.rgbBitCount == 32 &&
+            header.format.rMask == 0x000000ff && header.format.aMask == 0xff000000)
+        {
+            format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+
+        if (format == DXGI_FORMAT_UNKNOWN)
+        {
+            std::cout << "[Texture] WARNING: " << path << " has an unsupported pixel format\n";
+            return false;
+        }
+
+        int block = blockBytes(format);
+        if (block != 0 && (header.width % 4 != 0 || header.height % 4 != 0))
+        {
+            std::cout << "[Texture] WARNING: " << path << " is block-compressed but not a multiple of 4 in size\n";
+            return false;
+        }
+
+        image = {};
+        image.format = format;
+        image.width = (int)header.width;
+        image.height = (int)header.height;
+
+        int mipCount = (std::max)((int)header.mipMapCount, 1);
+        size_t total = 0;
+        int mw = image.width, mh = image.height;
+        for (int m = 0; m < mipCount; m++)
+        {
+            TextureMip mip;
+            mip.offset = total;
+            mip.width = mw;
+            mip.height = mh;
+            if (block != 0)
+            {
+                mip.rowBytes = (std::max)((mw + 3) / 4, 1) * block;
+                mip.rowCount = (std::max)((mh + 3) / 4, 1);
+            }
+            else
+            {
+                mip.rowBytes = mw * 4;
+                mip.rowCount = mh;
+            }
+            image.mips.push_back(mip);
+            total += (size_t)mip.rowBytes * mip.rowCount;
+            mw = (std::max)(mw / 2, 1);
+            mh = (std::max)(mh / 2, 1);
+        }
+
+        image.data.resize(total);
+        file.read((char*)image.data.data(), (std::streamsize)total);
+        if (!file)
+        {
+            std::cout << "[Texture] WARNING: " << path << " is truncated\n";
+            image = {};
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Core.h"
+#include <iostream>
+
+// ============================================================================
+// TextureTable
+// ----------------------------------------------------------------------------
+// A contiguous run of BINDLESS_TEXTURE_COUNT SRVs bound to root parameter 4 (t0, space1), so a
+// shader picks its texture by index (per draw or per instance) instead of the caller rebinding
+// parameter 2 between draws. Unused slots hold null SRVs (required on resource binding tier 1).
+// The table gets its own view of each texture; the Texture keeps its usual srvHandle.
+// ============================================================================
+class TextureTable
+{
+public:
+    bool init(Core* _core)
+    {
+        core = _core;
+        range = core->descriptors.allocate(BINDLESS_TEXTURE_COUNT);
+        if (!range.valid())
+        {
+            std::cout << "[TextureTable] ERROR: No room for " << BINDLESS_TEXTURE_COUNT << " descriptors\n";
+            return false;
+        }
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC nullDesc = {};
+        nullDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        nullDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        nullDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        nullDesc.Texture2D.MipLevels = 1;
+        for (unsigned int i = 0; i < BINDLESS_TEXTURE_COUNT; i++)
+        {
+            core->device->CreateShaderResourceView(nullptr, &nullDesc, range.cpuAt(i));
+        }
+        count = 0;
+        return true;
+    }
+
+    // Append a texture; returns its index or -1 when the table is full / not initialised
+    int add(const Texture& texture)
+    {
+        if (!range.valid() || texture.resource == nullptr)
+            return -1;
+        if (count >= BINDLESS_TEXTURE_COUNT)
+        {
+            std::cout << "[TextureTable] WARNING: Table full (" << BINDLESS_TEXTURE_COUNT << " textures)\n";
+            return -1;
+        }
+
+        // Default view of the resource: every mip, the resource's own format
+        core->device->CreateShaderResourceView(texture.resource, nullptr, range.cpuAt(count));
+        return (int)count++;
+    }
+
+    bool isValid() const { return range.valid(); }
+    unsigned int size() const { return count; }
+    D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle() const { return range.gpu; }
+
+    void bind(Core* core) const
+    {
+        core->getCommandList()->SetGraphicsRootDescriptorTable(4, range.gpu);
+    }
+
+    ~TextureTable()
+    {
+        if (core && range.valid()) core->descriptors.free(range);
+    }
+
+private:
+    Core* core = nullptr;
+    DescriptorRange range;
+    unsigned int count = 0;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+// Fixed-size worker pool for CPU-side jobs (asset decode, mesh simplification, culling, ...).
+// Inside Core::recordParallel, jobs record into the command list getCommandList returns for their
+// thread (one per job, opened and submitted by the main thread) and take upload memory from the
+// locked FrameAllocator. Everything else on the D3D12 side (queues, fences, resource creation, the
+// upload batch) stays on the main thread; other jobs hand their results back to the caller.
+class ThreadPool
+{
+public:
+    // Shared engine-wide pool (hardware threads minus one, leaving the calling thread free)
+    static ThreadPool& get()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ThreadPool()
+    {
+        unsigned int hw = std::thread::hardware_concurrency();
+        unsigned int count = (hw > 1) ? hw - 1 : 1;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    // Queue a fire-and-forget job
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            jobs.push_back(std::move(job));
+        }
+        queueCondition.notify_one();
+    }
+
+    // Run fn(0..count-1) across the workers and the calling thread; returns when every index is done
+    void parallelFor(int count, const std::function<void(int)>& fn)
+    {
+        if (count <= 0)
+            return;
+
+        if (count == 1 || workers.empty())
+        {
+            for (int i = 0; i < count; i++)
+                fn(i);
+            return;
+        }
+
+        auto state = std::make_shared<ForState>();
+        state->count = count;
+
+        int helpers = (std::min)(count - 1, (int)workers.size());
+        for (int i = 0; i < helpers; i++)
+        {
+            submit([state, &fn]() { runFor(*state, fn); });
+        }
+
+        runFor(*state, fn);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->condition.wait(lock, [&]() { return state->done.load() == state->count; });
+    }
+
+    unsigned int getThreadCount() const { return (unsigned int)workers.size(); }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCondition.notify_all();
+
+        for (auto& worker : workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+private:
+    // Shared progress for one parallelFor call
+    struct ForState
+    {
+        std::atomic<int> next{ 0 };
+        std::atomic<int> done{ 0 };
+        int count = 0;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping = false;
+
+    // Pull indices until the range is exhausted; the last finisher wakes the caller
+    static void runFor(ForState& state, const std::function<void(int)>& fn)
+    {
+        int i;
+        while ((i = state.next.fetch_add(1)) < state.count)
+        {
+            fn(i);
+            if (state.done.fetch_add(1) + 1 == state.count)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.condition.notify_all();
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
@@ -6,12 +6,25 @@
 #include "Mesh.h"
 #include "GEMLoader.h"
 #include "Maths.h"
+#include "Frustum.h"
+#include "Impostor.h"
 #include <vector>
+#include <algorithm>
+
+// One placed tree; the mesh parts are shared by every instance
+struct TreeInstance
+{
+    Vec3 position;
+    float scale = 1.0f;
+    float rotationY = 0.0f;
+};
 
 // A simple tree actor composed of three draw parts: a canopy mesh, a cylinder trunk, and a flat ground shadow.
 // The canopy is loaded from a GEM model and rendered with its own texture.
 // The trunk is procedurally generated as a low-poly cylinder and rendered with a separate trunk texture.
 // The shadow is a simple blended disc that is drawn first so it sits under the tree.
+// Every instance is drawn with one instanced draw per part; beyond impostorDistance the canopy and trunk
+// crossfade into a billboard baked from both at init (trunk/shadow settings must be set before init).
 class Tree
 {
 public:
@@ -30,9 +43,8 @@ public:
         float scale = 1.0f,
         float rotationY = 0.0f)
     {
-        this->position = position;
-        this->scale = scale;
-        this->rotationY = rotationY;
+        instances.clear();
+        addInstance(position, scale, rotationY);
 
         std::cout << "[Tree] Initializing at (" << position.x << ", " << position.y << ", " << position.z << ")\n";
 
@@ -58,6 +70,15 @@ public:
                 vertices.push_back(v);
             }
 
+            // Local canopy extents for frustum culling
+            canopyMin = Vec3(1e9f, 1e9f, 1e9f);
+            canopyMax = Vec3(-1e9f, -1e9f, -1e9f);
+            for (const auto& v : vertices)
+            {
+                canopyMin = Vec3(std::min(canopyMin.x, v.pos.x), std::min(canopyMin.y, v.pos.y), std::min(canopyMin.z, v.pos.z));
+                canopyMax = Vec3(std::max(canopyMax.x, v.pos.x), std::max(canopyMax.y, v.pos.y), std::max(canopyMax.z, v.pos.z));
+            }
+
             indices = meshes[0].indices;
             treeMesh.init(core, vertices, indices);
             std::cout << "[Tree] Loaded model: " << vertices.size() << " vertices\n";
@@ -72,60 +93,88 @@ public:
         createShadowMesh(core);
 
         // Load three shader variants: main tree, blended shadow, and trunk shading.
-        // They can share the same vertex shader if your VS just transforms STATIC_VERTEX and passes UV/normal.
-        shaders->load(core, shaderName, "Shaders/VSTree.txt", "Shaders/PSTree.txt");
-        shaders->load(core, shadowShaderName, "Shaders/VSTree.txt", "Shaders/PSTreeShadow.txt");
-        shaders->load(core, trunkShaderName, "Shaders/VSTree.txt", "Shaders/PSTreeTrunk.txt");
+        // They share the instanced vertex shader, which places each part per instance from the part scale.
+        shaders->load(core, shaderName, "Shaders/VSTreeInstanced.txt", "Shaders/PSTree.txt");
+        shaders->load(core, shadowShaderName, "Shaders/VSTreeInstanced.txt", "Shaders/PSTreeShadow.txt");
+        shaders->load(core, trunkShaderName, "Shaders/VSTreeInstanced.txt", "Shaders/PSTreeTrunk.txt");
+        canopyPass.init(shaders, shaderName);
+        shadowPass.init(shaders, shadowShaderName);
+        trunkPass.init(shaders, trunkShaderName);
 
         // Create PSOs: normal opaque for canopy and trunk, and alpha blended PSO for the shadow disc.
-        psos->createPSO(core, psoName,
-            shaders->find(shaderName)->vs,
-            shaders->find(shaderName)->ps,
-            VertexLayoutCache::getStaticLayout());
+        canopyPass.pso = psos->createPSO(core, psoName, canopyPass.shader->vs, canopyPass.shader->ps,
+            VertexLayoutCache::getTreeInstancedLayout());
 
-        psos->createBlendedPSO(core, shadowPsoName,
-            shaders->find(shadowShaderName)->vs,
-            shaders->find(shadowShaderName)->ps,
-            VertexLayoutCache::getStaticLayout());
+        shadowPass.pso = psos->createBlendedPSO(core, shadowPsoName, shadowPass.shader->vs, shadowPass.shader->ps,
+            VertexLayoutCache::getTreeInstancedLayout());
 
-        psos->createPSO(core, trunkPsoName,
-            shaders->find(trunkShaderName)->vs,
-            shaders->find(trunkShaderName)->ps,
-            VertexLayoutCache::getStaticLayout());
+        trunkPass.pso = psos->createPSO(core, trunkPsoName, trunkPass.shader->vs, trunkPass.shader->ps,
+            VertexLayoutCache::getTreeInstancedLayout());
+
+        bakeImpostor(core, shaders, psos);
 
         initialized = true;
         std::cout << "[Tree] Ready!\n";
     }
 
-    void draw(Core* core, PSOManager* psos, Shaders* shaders, const Matrix& vp)
+    // Add a tree sharing this actor's meshes; call any number of times, before or after init
+    void addInstance(const Vec3& position, float scale = 1.0f, float rotationY = 0.0f)
     {
-        if (!initialized) return;
+        TreeInstance inst;
+        inst.position = position;
+        inst.scale = scale;
+        inst.rotationY = rotationY;
+        instances.push_back(inst);
+    }
 
-        // Draw shadow first so it blends onto the ground before the solid trunk/canopy are rendered.
-        drawShadow(core, psos, shaders, vp);
+    size_t getInstanceCount() const { return instances.size(); }
 
-        // Draw trunk next so the canopy can visually sit on top without sorting issues.
-        drawTrunk(core, psos, shaders, vp);
+    void draw(Core* core, PSOManager* psos, Shaders* shaders, const Matrix& vp, const Vec3& cameraPos)
+    {
+        if (!initialized || instances.empty()) return;
 
-        // Draw canopy using the loaded mesh, with a standard S*R*T transform in world space.
-        Matrix S = Matrix::scaling(Vec3(scale, scale, scale));
-        Matrix R = Matrix::rotateY(rotationY);
-        Matrix T = Matrix::translation(position);
-        Matrix world = S * R * T;
+        gatherVisible(vp, cameraPos);
+        unsigned int meshOnly = (unsigned int)meshOnlyScratch.size();
+        unsigned int band = (unsigned int)bandScratch.size();
+        unsigned int total = meshOnly + band + (unsigned int)impostorOnlyScratch.size();
+        if (total == 0) return;
 
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shaderName, "staticMeshBuffer", "W", (void*)&world);
+        // One stream ordered mesh-only | crossfade band | impostor-only, so every pass draws a contiguous range
+        FrameAllocation alloc = core->frameAllocator.allocate(total * sizeof(ImpostorInstance), 16);
+        ImpostorInstance* dst = (ImpostorInstance*)alloc.cpuAddress;
+        memcpy(dst, meshOnlyScratch.data(), meshOnly * sizeof(ImpostorInstance));
+        memcpy(dst + meshOnly, bandScratch.data(), band * sizeof(ImpostorInstance));
+        memcpy(dst + meshOnly + band, impostorOnlyScratch.data(), impostorOnlyScratch.size() * sizeof(ImpostorInstance));
 
-        shaders->apply(core, shaderName);
-        psos->bind(core, psoName);
+        // Draw shadow first so it blends onto the ground before the solid trunk/canopy are rendered.
+        // Impostor trees keep their shadow disc.
+        shadowPass.apply(core, vp, Vec4(shadowRadius, 1.0f, shadowRadius, 0.05f));
+        psos->bind(core, shadowPass.pso);
+        drawInstanced(core, shadowMesh, alloc.gpuAddress, total);
+
+        unsigned int meshCount = meshOnly + band;
+        if (meshCount > 0)
+        {
+            // Draw trunk next so the canopy can visually sit on top without sorting issues.
+            trunkPass.apply(core, vp, Vec4(trunkRadius, trunkHeight, trunkRadius, trunkOffsetY));
+            psos->bind(core, trunkPass.pso);
+            core->getCommandList()->SetGraphicsRootDescriptorTable(2, trunkTexture.srvHandle);
+            drawInstanced(core, trunkMesh, alloc.gpuAddress, meshCount);
+
+            canopyPass.apply(core, vp, Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+            psos->bind(core, canopyPass.pso);
+            core->getCommandList()->SetGraphicsRootDescriptorTable(2, treeTexture.srvHandle);
+            drawInstanced(core, treeMesh, alloc.gpuAddress, meshCount);
+        }
 
-        core->getCommandList()->SetGraphicsRootDescriptorTable(2, treeTexture.srvHandle);
-        treeMesh.draw(core);
+        unsigned int impostorCount = total - meshOnly;
+        if (impostorCount > 0)
+        {
+            impostorRenderer.draw(core, psos, impostor, vp, cameraPos,
+                alloc.gpuAddress + meshOnly * sizeof(ImpostorInstance), impostorCount);
+        }
     }
 
-    Vec3 position = Vec3(0, 0, 0);
-    float scale = 1.0f;
-    float rotationY = 0.0f;
     float shadowRadius = 3.0f;
     float shadowOpacity = 0.5f;
 
@@ -133,7 +182,58 @@ public:
     float trunkHeight = 4.0f;
     float trunkOffsetY = 0.0f;
 
+    float impostorDistance = 45.0f;     // Canopy and trunk start dithering into the impostor here
+    float impostorFadeRange = 8.0f;
+    float viewDistance = 250.0f;        // Instances further away are not drawn at all
+    bool useImpostors = true;
+
+    // World AABB of one instance covering canopy, trunk and shadow disc (rotation-safe: uses the XZ radius)
+    void getBounds(size_t index, Vec3& outMin, Vec3& outMax) const
+    {
+        const float scale = instances[index].scale;
+        const Vec3& position = instances[index].position;
+        float canopyR = std::max(std::max(fabsf(canopyMin.x), fabsf(canopyMax.x)),
+            std::max(fabsf(canopyMin.z), fabsf(canopyMax.z))) * 1.4143f;
+        float r = std::max(std::max(canopyR, shadowRadius), trunkRadius) * scale;
+
+        float bottom = std::min(canopyMin.y, std::min(trunkOffsetY, 0.0f)) * scale;
+        float top = std::max(canopyMax.y, trunkOffsetY + trunkHeight) * scale;
+
+        outMin = Vec3(position.x - r, position.y + bottom, position.z - r);
+        outMax = Vec3(position.x + r, position.y + top, position.z + r);
+    }
+
 private:
+    // One shader variant, its PSO and its VP/part constants, resolved once at init
+    struct ShaderPass
+    {
+        Shader* shader = nullptr;
+        PSOHandle pso = INVALID_PSO;
+        ConstantHandle vpConstant;
+        ConstantHandle partConstant;
+
+        void init(Shaders* shaders, const std::string& name)
+        {
+            shader = shaders->find(name);
+            vpConstant = shader->getConstantVS("treeBuffer", "VP");
+            partConstant = shader->getConstantVS("treeBuffer", "partScale");
+        }
+
+        // partScale: xyz = unit mesh scale, w = height offset, both before the instance scale
+        void apply(Core* core, const Matrix& vp, const Vec4& partScale)
+        {
+            vpConstant.set(&vp);
+            partConstant.set(&partScale);
+            shader->apply(core);
+        }
+    };
+
+    ShaderPass canopyPass;
+    ShaderPass shadowPass;
+    ShaderPass trunkPass;
+
+    Vec3 canopyMin = Vec3(0, 0, 0);
+    Vec3 canopyMax = Vec3(0, 0, 0);
     Mesh treeMesh;
     Mesh trunkMesh;
     Mesh shadowMesh;
@@ -141,13 +241,107 @@ private:
     Texture trunkTexture;
     bool initialized = false;
 
+    std::vector<TreeInstance> instances;
+
+    // Far LOD: canopy + trunk baked into one atlas
+    ImpostorAtlas impostor;
+    ImpostorRenderer impostorRenderer;
+
+    // Per-draw scratch, split by crossfade state
+    std::vector<ImpostorInstance> meshOnlyScratch;
+    std::vector<ImpostorInstance> bandScratch;
+    std::vector<ImpostorInstance> impostorOnlyScratch;
+
+    void gatherVisible(const Matrix& vp, const Vec3& cameraPos)
+    {
+        meshOnlyScratch.clear();
+        bandScratch.clear();
+        impostorOnlyScratch.clear();
+
+        Frustum frustum(vp);
+        bool impostors = useImpostors && impostor.isReady();
+
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            const TreeInstance& tree = instances[i];
+            float dx = tree.position.x - cameraPos.x;
+            float dz = tree.position.z - cameraPos.z;
+            float dist = sqrtf(dx * dx + dz * dz);
+            if (dist > viewDistance) continue;
+
+            Vec3 bmin, bmax;
+            getBounds(i, bmin, bmax);
+            if (!frustum.testAABB(bmin, bmax)) continue;
+
+            ImpostorInstance inst;
+            inst.position = tree.position;
+            inst.scale = tree.scale;
+            inst.rotationY = tree.rotationY;
+            inst.fade = impostors ? impostorFade(dist, impostorDistance, impostorFadeRange) : 0.0f;
+
+            if (inst.fade <= 0.0f)
+                meshOnlyScratch.push_back(inst);
+            else if (inst.fade < 1.0f)
+                bandScratch.push_back(inst);
+            else
+                impostorOnlyScratch.push_back(inst);
+        }
+    }
+
+    void drawInstanced(Core* core, Mesh& mesh, D3D12_GPU_VIRTUAL_ADDRESS instanceData, unsigned int count)
+    {
+        D3D12_VERTEX_BUFFER_VIEW views[2];
+        views[0] = mesh.getVertexBufferView();
+        views[1].BufferLocation = instanceData;
+        views[1].StrideInBytes = sizeof(ImpostorInstance);
+        views[1].SizeInBytes = count * sizeof(ImpostorInstance);
+        core->getCommandList()->IASetVertexBuffers(0, 2, views);
+
+        D3D12_INDEX_BUFFER_VIEW ibView = mesh.getIndexBufferView();
+        core->getCommandList()->IASetIndexBuffer(&ibView);
+
+        core->getCommandList()->DrawIndexedInstanced(mesh.getIndexCount(), count, 0, 0, 0);
+        core->countDraw(count);
+    }
+
+    // Canopy and trunk at unit instance scale; the shadow stays a mesh at every distance
+    void bakeImpostor(Core* core, Shaders* shaders, PSOManager* psos)
+    {
+        impostorRenderer.init(core, shaders, psos, "Impostor_Tree");
+
+        shaders->load(core, "ImpostorBakeTree", "Shaders/VSImpostorBake.txt", "Shaders/PSTree.txt");
+        shaders->load(core, "ImpostorBakeTrunk", "Shaders/VSImpostorBake.txt", "Shaders/PSTreeTrunk.txt");
+        Shader* canopyShader = shaders->find("ImpostorBakeTree");
+        Shader* trunkShader = shaders->find("ImpostorBakeTrunk");
+
+        ImpostorBakePart canopy;
+        canopy.mesh = &treeMesh;
+        canopy.shader = canopyShader;
+        canopy.pso = psos->createPSO(core, "ImpostorBakeTreePSO", canopyShader->vs, canopyShader->ps,
+            VertexLayoutCache::getStaticLayout());
+        canopy.texture = treeTexture.srvHandle;
+
+        ImpostorBakePart trunk;
+        trunk.mesh = &trunkMesh;
+        trunk.shader = trunkShader;
+        trunk.pso = psos->createPSO(core, "ImpostorBakeTrunkPSO", trunkShader->vs, trunkShader->ps,
+            VertexLayoutCache::getStaticLayout());
+        trunk.texture = trunkTexture.srvHandle;
+        trunk.world = Matrix::scaling(Vec3(trunkRadius, trunkHeight, trunkRadius)) *
+            Matrix::translation(Vec3(0.0f, trunkOffsetY, 0.0f));
+
+        Vec3 localMin(std::min(canopyMin.x, -trunkRadius), std::min(canopyMin.y, trunkOffsetY), std::min(canopyMin.z, -trunkRadius));
+        Vec3 localMax(std::max(canopyMax.x, trunkRadius), std::max(canopyMax.y, trunkOffsetY + trunkHeight), std::max(canopyMax.z, trunkRadius));
+        impostor.bake(core, psos, { canopy, trunk }, localMin, localMax, "Tree");
+    }
+
     void createTrunkMesh(Core* core)
     {
         std::vector<STATIC_VERTEX> vertices;
         std::vector<unsigned int> indices;
 
-        // Build a unit cylinder (radius=1, height=1) aligned on +Y, then scale in drawTrunk().
-        // This keeps the mesh reusable for different trunkRadius/trunkHeight values via the world matrix.
+        // Build a unit cylinder (radius=1, height=1) aligned on +Y; draw() scales it through the trunk part scale.
+        // This keeps the mesh reusable for different trunkRadius/trunkHeight values without rebuilding it.
         int segments = 16;
         float radius = 1.0f;
         float height = 1.0f;
@@ -203,7 +397,7 @@ private:
         std::vector<STATIC_VERTEX> vertices;
         std::vector<unsigned int> indices;
 
-        // Build a unit disc (radius=1) on the XZ plane; it is scaled in drawShadow().
+        // Build a unit disc (radius=1) on the XZ plane; draw() scales it through the shadow part scale.
         // The shadow pixel shader typically outputs a dark color with alpha for soft blending.
         int segments = 32;
         float radius = 1.0f;
@@ -240,42 +434,4 @@ private:
 
         shadowMesh.init(core, vertices, indices);
     }
-
-    void drawTrunk(Core* core, PSOManager* psos, Shaders* shaders, const Matrix& vp)
-    {
-        // Place trunk at the tree base, then apply S*R*T so thickness/height are controllable per Tree instance.
-        Vec3 trunkPos = Vec3(position.x, position.y + trunkOffsetY, position.z);
-
-        Matrix S = Matrix::scaling(Vec3(trunkRadius * scale, trunkHeight * scale, trunkRadius * scale));
-        Matrix R = Matrix::rotateY(rotationY);
-        Matrix T = Matrix::translation(trunkPos);
-        Matrix world = S * R * T;
-
-        shaders->updateConstantVS(trunkShaderName, "staticMeshBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(trunkShaderName, "staticMeshBuffer", "W", (void*)&world);
-
-        shaders->apply(core, trunkShaderName);
-        psos->bind(core, trunkPsoName);
-
-        core->getCommandList()->SetGraphicsRootDescriptorTable(2, trunkTexture.srvHandle);
-        trunkMesh.draw(core);
-    }
-
-    void drawShadow(Core* core, PSOManager* psos, Shaders* shaders, const Matrix& vp)
-    {
-        // Offset slightly above ground to avoid z-fighting with terrain, then scale to desired radius.
-        Vec3 shadowPos = Vec3(position.x, position.y + 0.05f, position.z);
-
-        Matrix S = Matrix::scaling(Vec3(shadowRadius * scale, 1.0f, shadowRadius * scale));
-        Matrix T = Matrix::translation(shadowPos);
-        Matrix world = S * T;
-
-        shaders->updateConstantVS(shadowShaderName, "staticMeshBuffer", "VP", (void*)&vp);
-        shaders->updateConstantVS(shadowShaderName, "staticMeshBuffer", "W", (void*)&world);
-
-        shaders->apply(core, shadowShaderName);
-        psos->bind(core, shadowPsoName);
-
-        shadowMesh.draw(core);
-    }
 };
@@ -0,0 +1,482 @@
+#pragma once
+
+#include "HybridGrassField.h"
+#include "Rocks.h"
+#include "ThreadPool.h"
+#include "Maths.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+
+static const unsigned int VEG_CHUNK_MAGIC = 0x4B484356; // 'VCHK'
+static const unsigned int VEG_CHUNK_VERSION = 3;     // 2: RockInstance lost its per-frame LOD fields, 3: batched tile placement
+
+// Instance data for one streamed chunk, built on a worker thread
+struct VegetationChunkData
+{
+    std::vector<GrassInstance> grass;
+    std::vector<RockInstance> rocks;
+};
+
+struct VegetationStreamStats
+{
+    int totalChunks = 0;
+    int residentChunks = 0;
+    int pendingChunks = 0;              // Queued or building on a worker
+    int readyChunks = 0;                // Built, waiting for their upload slot
+    size_t residentBytes = 0;           // Instance data held by grass + rocks
+    size_t peakResidentBytes = 0;
+    size_t budgetBytes = 0;
+    int loadedThisUpdate = 0;
+    int evictedThisUpdate = 0;
+    unsigned long long totalLoads = 0;
+    unsigned long long totalEvictions = 0;
+    unsigned long long cacheHits = 0;
+    unsigned long long budgetEvictions = 0;
+};
+
+// ============================================================================
+// VegetationStreamer
+// ----------------------------------------------------------------------------
+// Keeps grass and rock instances resident only for chunks around the camera. Chunks inside
+// loadRadius are built on the ThreadPool - from the disk cache when present, otherwise by the
+// builder callback (e.g. VegetationGenerator::generateTile, deterministic per chunk) - and handed
+// to HybridGrassField/Rocks a few per update; chunks beyond unloadRadius are evicted. When the
+// resident instance data exceeds memoryBudgetBytes the farthest chunks go first. All consumer
+// changes happen inside update(), on the calling thread, before the frame's cull jobs run.
+// ============================================================================
+class VegetationStreamer
+{
+public:
+    using ChunkBuilder = std::function<void(int chunkX, int chunkZ, VegetationChunkData& out)>;
+
+    float loadRadius = 110.0f;                  // Chunk centres inside this are requested
+    float unloadRadius = 140.0f;                // ...and evicted beyond this (hysteresis against thrashing)
+    size_t memoryBudgetBytes = 48 * 1024 * 1024;
+    int maxUploadsPerUpdate = 4;                // Ready chunks handed to grass/rocks per update
+    int maxPendingJobs = 8;                     // Concurrent builds, further capped below the ThreadPool's worker count
+    std::string cacheDirectory;                 // Non-empty: read/write built chunks here
+    unsigned long long cacheKey = 0;            // Seed/config hash; cache files with another key are rebuilt
+
+    // worldSize x worldSize centred on the origin, chunkSize must match grass/rocks initStreaming
+    void init(float _worldSizeX, float _worldSizeZ, float _chunkSize, ChunkBuilder _builder)
+    {
+        worldSizeX = _worldSizeX;
+        worldSizeZ = _worldSizeZ;
+        chunkSize = _chunkSize;
+        builder = std::move(_builder);
+
+        chunksX = (int)std::ceil(worldSizeX / chunkSize);
+        chunksZ = (int)std::ceil(worldSizeZ / chunkSize);
+        slots.assign(chunksX * chunksZ, {});
+
+        stats = {};
+        stats.totalChunks = chunksX * chunksZ;
+        stats.budgetBytes = memoryBudgetBytes;
+
+        if (!cacheDirectory.empty())
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(cacheDirectory, ec);
+        }
+
+        std::cout << "[VegetationStreamer] " << chunksX << " x " << chunksZ << " chunks of " << chunkSize
+            << " m, load radius " << loadRadius << " m, budget " << (memoryBudgetBytes / (1024 * 1024)) << " MB\n";
+    }
+
+    // Once per frame, before culling: apply finished builds, evict, and request chunks near the camera
+    void update(const Vec3& cameraPos, HybridGrassField* grass, Rocks* rocks)
+    {
+        if (slots.empty()) return;
+
+        stats.loadedThisUpdate = 0;
+        stats.evictedThisUpdate = 0;
+
+        collectFinished(cameraPos);
+        evictOutOfRange(cameraPos, grass, rocks);
+        uploadReady(cameraPos, grass, rocks);
+        enforceBudget(cameraPos, grass, rocks);
+        requestInRange(cameraPos);
+
+        if (rocks && stats.loadedThisUpdate + stats.evictedThisUpdate > 0)
+            rocks->rebuildStreamedIndex();
+
+        stats.peakResidentBytes = (std::max)(stats.peakResidentBytes, stats.residentBytes);
+    }
+
+    // Build every chunk inside loadRadius before returning (startup, so the first frame is populated)
+    void preload(const Vec3& cameraPos, HybridGrassField* grass, Rocks* rocks)
+    {
+        int savedUploads = maxUploadsPerUpdate;
+        int savedJobs = maxPendingJobs;
+        maxUploadsPerUpdate = stats.totalChunks;
+        maxPendingJobs = stats.totalChunks;
+        preloading = true;                      // Main thread is blocked anyway, so use every worker
+
+        update(cameraPos, grass, rocks);
+        waitForPending();
+        update(cameraPos, grass, rocks);
+
+        maxUploadsPerUpdate = savedUploads;
+        maxPendingJobs = savedJobs;
+        preloading = false;
+    }
+
+    const VegetationStreamStats& getStats() const { return stats; }
+
+    void printStats() const
+    {
+        std::cout << "[VegetationStreamer] Resident " << stats.residentChunks << " / " << stats.totalChunks
+            << " chunks, pending " << stats.pendingChunks << ", ready " << stats.readyChunks << "\n";
+        std::cout << "  Memory: " << (stats.residentBytes / 1024) << " KB (peak " << (stats.peakResidentBytes / 1024)
+            << " KB, budget " << (stats.budgetBytes / 1024) << " KB)\n";
+        std::cout << "  Loads: " << stats.totalLoads << " (cache hits " << stats.cacheHits << "), evictions: "
+            << stats.totalEvictions << " (budget " << stats.budgetEvictions << ")\n";
+    }
+
+    // Block until no build is running (jobs reference this object)
+    void waitForPending()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobsDone.wait(lock, [this]() { return jobsInFlight == 0; });
+    }
+
+    ~VegetationStreamer()
+    {
+        waitForPending();
+    }
+
+private:
+    enum class ChunkState { Unloaded, Pending, Ready, Resident };
+
+    struct ChunkSlot
+    {
+        ChunkState state = ChunkState::Unloaded;
+        VegetationChunkData data;       // Only while Ready; moved into the consumers on upload
+        size_t bytes = 0;               // Resident size
+    };
+
+    struct FinishedBuild
+    {
+        int index;
+        bool fromCache;
+        VegetationChunkData data;
+    };
+
+    float worldSizeX = 0.0f;
+    float worldSizeZ = 0.0f;
+    float chunkSize = 32.0f;
+    int chunksX = 0;
+    int chunksZ = 0;
+    ChunkBuilder builder;
+    std::vector<ChunkSlot> slots;
+    VegetationStreamStats stats;
+    bool preloading = false;
+
+    // Shared with the worker jobs
+    std::mutex mutex;
+    std::condition_variable jobsDone;
+    std::deque<FinishedBuild> finished;
+    int jobsInFlight = 0;
+
+    Vec3 chunkCenter(int index) const
+    {
+        int cx = index % chunksX;
+        int cz = index / chunksX;
+        return Vec3(cx * chunkSize - worldSizeX * 0.5f + chunkSize * 0.5f, 0.0f,
+            cz * chunkSize - worldSizeZ * 0.5f + chunkSize * 0.5f);
+    }
+
+    float distanceSq(int index, const Vec3& cameraPos) const
+    {
+        Vec3 c = chunkCenter(index);
+        float dx = c.x - cameraPos.x;
+        float dz = c.z - cameraPos.z;
+        return dx * dx + dz * dz;
+    }
+
+    void collectFinished(const Vec3& cameraPos)
+    {
+        std::deque<FinishedBuild> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finished);
+        }
+
+        float unloadSq = unloadRadius * unloadRadius;
+        for (auto& build : done)
+        {
+            ChunkSlot& slot = slots[build.index];
+            stats.pendingChunks--;
+
+            // The camera moved away while it was building
+            if (distanceSq(build.index, cameraPos) > unloadSq)
+            {
+                slot.state = ChunkState::Unloaded;
+                continue;
+            }
+
+            slot.data = std::move(build.data);
+            slot.state = ChunkState::Ready;
+            stats.readyChunks++;
+            if (build.fromCache)
+                stats.cacheHits++;
+        }
+    }
+
+    void evictOutOfRange(const Vec3& cameraPos, HybridGrassField* grass, Rocks* rocks)
+    {
+        float unloadSq = unloadRadius * unloadRadius;
+        for (int i = 0; i < (int)slots.size(); i++)
+        {
+            ChunkSlot& slot = slots[i];
+            if (slot.state == ChunkState::Ready && distanceSq(i, cameraPos) > unloadSq)
+            {
+                slot.data = {};
+                slot.state = ChunkState::Unloaded;
+                stats.readyChunks--;
+            }
+            else if (slot.state == ChunkState::Resident && distanceSq(i, cameraPos) > unloadSq)
+            {
+                evict(i, grass, rocks);
+            }
+        }
+    }
+
+    void uploadReady(const Vec3& cameraPos, HybridGrassField* grass, Rocks* rocks)
+    {
+        std::vector<std::pair<float, int>> ready;
+        for (int i = 0; i < (int)slots.size(); i++)
+        {
+            if (slots[i].state == ChunkState::Ready)
+                ready.push_back({ distanceSq(i, cameraPos), i });
+        }
+        std::sort(ready.begin(), ready.end());
+
+        int uploads = (std::min)((int)ready.size(), maxUploadsPerUpdate);
+        for (int n = 0; n < uploads; n++)
+        {
+            int i = ready[n].second;
+            ChunkSlot& slot = slots[i];
+
+            if (grass) grass->setChunkInstances(i, std::move(slot.data.grass));
+            if (rocks) rocks->setChunkInstances(i, std::move(slot.data.rocks));
+            slot.data = {};
+
+            // Charge what the consumers actually keep (packed instances), not the build format
+            slot.bytes = (grass ? grass->getChunkBytes(i) : 0) + (rocks ? rocks->getChunkBytes(i) : 0);
+            slot.state = ChunkState::Resident;
+
+            stats.readyChunks--;
+            stats.residentChunks++;
+            stats.residentBytes += slot.bytes;
+            stats.loadedThisUpdate++;
+            stats.totalLoads++;
+        }
+    }
+
+    // Over budget: drop the farthest resident chunks
+    void enforceBudget(const Vec3& cameraPos, HybridGrassField* grass, Rocks* rocks)
+    {
+        if (stats.residentBytes <= memoryBudgetBytes) return;
+
+        std::vector<std::pair<float, int>> resident;
+        for (int i = 0; i < (int)slots.size(); i++)
+        {
+            if (slots[i].state == ChunkState::Resident)
+                resident.push_back({ distanceSq(i, cameraPos), i });
+        }
+        std::sort(resident.begin(), resident.end(), std::greater<std::pair<float, int>>());
+
+        for (const auto& entry : resident)
+        {
+            if (stats.residentBytes <= memoryBudgetBytes) break;
+            evict(entry.second, grass, rocks);
+            stats.budgetEvictions++;
+        }
+    }
+
+    void requestInRange(const Vec3& cameraPos)
+    {
+        // The ThreadPool queue is FIFO and shared with per-frame work (culling, parallel recording), so
+        // background builds leave at least one worker free; otherwise a burst of chunk requests would
+        // queue frame jobs behind whole-chunk builds
+        int maxJobs = maxPendingJobs;
+        if (!preloading)
+            maxJobs = (std::min)(maxJobs, (std::max)(1, (int)ThreadPool::get().getThreadCount() - 1));
+
+        int room = maxJobs - stats.pendingChunks;
+        if (room <= 0) return;
+
+        // Near the budget, only chunks closer than the farthest resident one are worth loading (they
+        // will displace it); anything else would be evicted again as soon as it arrived
+        float limitSq = loadRadius * loadRadius;
+        if (stats.residentChunks > 0)
+        {
+            size_t averageBytes = stats.residentBytes / stats.residentChunks;
+            if (stats.residentBytes + averageBytes * (stats.pendingChunks + stats.readyChunks + 1) > memoryBudgetBytes)
+            {
+                float farthestSq = 0.0f;
+                for (int i = 0; i < (int)slots.size(); i++)
+                {
+                    if (slots[i].state == ChunkState::Resident)
+                        farthestSq = (std::max)(farthestSq, distanceSq(i, cameraPos));
+                }
+                limitSq = (std::min)(limitSq, farthestSq - 1e-3f);
+            }
+        }
+
+        // Only the chunks under the load radius's bounding square
+        int reach = (int)std::ceil(loadRadius / chunkSize) + 1;
+        int camX = (int)std::floor((cameraPos.x + worldSizeX * 0.5f) / chunkSize);
+        int camZ = (int)std::floor((cameraPos.z + worldSizeZ * 0.5f) / chunkSize);
+
+        std::vector<std::pair<float, int>> wanted;
+        for (int cz = (std::max)(0, camZ - reach); cz <= (std::min)(chunksZ - 1, camZ + reach); cz++)
+        {
+            for (int cx = (std::max)(0, camX - reach); cx <= (std::min)(chunksX - 1, camX + reach); cx++)
+            {
+                int i = cz * chunksX + cx;
+                if (slots[i].state != ChunkState::Unloaded) continue;
+
+                float d = distanceSq(i, cameraPos);
+                if (d <= limitSq)
+                    wanted.push_back({ d, i });
+            }
+        }
+        std::sort(wanted.begin(), wanted.end());
+
+        int requests = (std::min)((int)wanted.size(), room);
+        for (int n = 0; n < requests; n++)
+        {
+            submitBuild(wanted[n].second);
+        }
+    }
+
+    void submitBuild(int index)
+    {
+        slots[index].state = ChunkState::Pending;
+        stats.pendingChunks++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobsInFlight++;
+        }
+
+        ThreadPool::get().submit([this, index]()
+            {
+                FinishedBuild build;
+                build.index = index;
+                build.fromCache = loadFromCache(index, build.data);
+                if (!build.fromCache)
+                {
+                    if (builder)
+                        builder(index % chunksX, index / chunksX, build.data);
+                    saveToCache(index, build.data);
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back(std::move(build));
+                jobsInFlight--;
+                jobsDone.notify_all();
+            });
+    }
+
+    void evict(int index, HybridGrassField* grass, Rocks* rocks)
+    {
+        ChunkSlot& slot = slots[index];
+        if (grass) grass->clearChunk(index);
+        if (rocks) rocks->clearChunk(index);
+
+        stats.residentChunks--;
+        stats.residentBytes -= slot.bytes;
+        stats.evictedThisUpdate++;
+        stats.totalEvictions++;
+
+        slot.bytes = 0;
+        slot.state = ChunkState::Unloaded;
+    }
+
+    // ------------------------------------------------------------------------
+    // Disk cache: header + raw instance arrays, one file per chunk
+    // ------------------------------------------------------------------------
+    struct CacheHeader
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long key;
+        unsigned int grassCount;
+        unsigned int rockCount;
+    };
+
+    std::string cachePath(int index) const
+    {
+        return cacheDirectory + "/chunk_" + std::to_string(index % chunksX) + "_" + std::to_string(index / chunksX) + ".veg";
+    }
+
+    bool loadFromCache(int index, VegetationChunkData& out) const
+    {
+        if (cacheDirectory.empty()) return false;
+
+        std::ifstream in(cachePath(index), std::ios::binary);
+        if (!in) return false;
+
+        CacheHeader header = {};
+        in.read((char*)&header, sizeof(header));
+        if (!in || header.magic != VEG_CHUNK_MAGIC || header.version != VEG_CHUNK_VERSION || header.key != cacheKey)
+            return false;
+
+        out.grass.resize(header.grassCount);
+        out.rocks.resize(header.rockCount);
+        in.read((char*)out.grass.data(), (std::streamsize)out.grass.size() * sizeof(GrassInstance));
+        in.read((char*)out.rocks.data(), (std::streamsize)out.rocks.size() * sizeof(RockInstance));
+        if (!in)
+        {
+            out = {};
+            return false;
+        }
+        return true;
+    }
+
+    void saveToCache(int index, const VegetationChunkData& data) const
+    {
+        if (cacheDirectory.empty()) return;
+
+        // Written to a temp file and renamed, so an interrupted write never leaves a truncated chunk
+        std::string path = cachePath(index);
+        std::string tempPath = path + ".tmp";
+        std::error_code ec;
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                std::cout << "[VegetationStreamer] WARNING: Cannot write " << path << "\n";
+                return;
+            }
+
+            CacheHeader header = {};
+            header.magic = VEG_CHUNK_MAGIC;
+            header.version = VEG_CHUNK_VERSION;
+            header.key = cacheKey;
+            header.grassCount = (unsigned int)data.grass.size();
+            header.rockCount = (unsigned int)data.rocks.size();
+            out.write((const char*)&header, sizeof(header));
+            out.write((const char*)data.grass.data(), (std::streamsize)data.grass.size() * sizeof(GrassInstance));
+            out.write((const char*)data.rocks.data(), (std::streamsize)data.rocks.size() * sizeof(RockInstance));
+            if (!out)
+            {
+                out.close();
+                std::filesystem::remove(tempPath, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path, ec);
+    }
+};
@@ -63,6 +63,7 @@ public:
     {
         // If the animation instance has no animation bound, nothing can be driven
         if (!inst.animation) return false;
+        resolveClips(inst);
 
         // Clamp dt to avoid huge simulation jumps (e.g., window drag / breakpoint resume)
         dt = std::min(dt, 0.05f);
@@ -79,8 +80,9 @@ public:
         bool moving = (w.keys['W'] || w.keys['A'] || w.keys['S'] || w.keys['D']);
 
         // First-time setup: decide initial clip based on current inputs, then start from time 0
-        if (currentClip.empty())
+        if (!started)
         {
+            started = true;
             zoomActive = wantZoom;
             currentClip = pickLocomotionClip(inst, moving, zoomActive);
             inst.resetAnimationTime();
@@ -88,7 +90,7 @@ public:
 
         // Reload is the highest priority action; if triggered, it overrides any zoom/fire state.
         // Requirement: if zooming and R pressed -> force unzoom -> reload -> if RMB still held, zoom again.
-        if (reloadPressed && has(reloadClip, inst))
+        if (reloadPressed && reloadHandle != INVALID_CLIP)
         {
             reloadArmed = false;
 
@@ -96,7 +98,7 @@ public:
             zoomActive = false;
 
             action = Action::Reload;
-            currentClip = reloadClip;
+            currentClip = reloadHandle;
             inst.resetAnimationTime();
 
             fireAccumulator = 0.0f;
@@ -131,9 +133,9 @@ public:
 
         if (allowHoldFire && fireDown)
         {
-            std::string fireUse = pickFireClip(inst, zoomActive);
+            AnimationClip fireUse = pickFireClip(zoomActive);
 
-            if (!fireUse.empty())
+            if (fireUse != INVALID_CLIP)
             {
                 action = Action::Fire;
                 fireAccumulator += dt;
@@ -158,8 +160,8 @@ public:
         fireAccumulator = 0.0f;
 
         // Locomotion selection: prefer zoom idle/walk if zoom is active and those clips exist, otherwise fallback to hip clips.
-        std::string desired = pickLocomotionClip(inst, moving, zoomActive);
-        if (!desired.empty() && desired != currentClip)
+        AnimationClip desired = pickLocomotionClip(inst, moving, zoomActive);
+        if (desired != INVALID_CLIP && desired != currentClip)
         {
             currentClip = desired;
             inst.resetAnimationTime();
@@ -200,7 +202,18 @@ private:
     enum class Action { None, Fire, Reload };
 
     Action action = Action::None;
-    std::string currentClip;
+    AnimationClip currentClip = INVALID_CLIP;
+    bool started = false;
+
+    // Clip handles resolved from the names above for the bound Animation
+    const Animation* resolvedFor = nullptr;
+    AnimationClip idleHandle = INVALID_CLIP;
+    AnimationClip walkHandle = INVALID_CLIP;
+    AnimationClip fireHandle = INVALID_CLIP;
+    AnimationClip reloadHandle = INVALID_CLIP;
+    AnimationClip zoomIdleHandle = INVALID_CLIP;
+    AnimationClip zoomWalkHandle = INVALID_CLIP;
+    AnimationClip zoomFireHandle = INVALID_CLIP;
 
     // Fire cadence accumulator used to emit shots at a fixed rate while holding LMB
     float fireAccumulator = 0.0f;
@@ -213,37 +226,45 @@ private:
     bool zoomActive = false;
 
 private:
-    // Check whether a named animation clip exists in the currently bound Animation object
-    bool has(const std::string& name, AnimationInstance& inst)
+    // Look the clip names up once per bound Animation instead of by string every frame
+    void resolveClips(AnimationInstance& inst)
     {
-        return inst.animation && inst.animation->hasAnimation(name);
+        if (resolvedFor == inst.animation) return;
+        resolvedFor = inst.animation;
+
+        idleHandle = inst.animation->findClip(idleClip);
+        walkHandle = inst.animation->findClip(walkClip);
+        fireHandle = inst.animation->findClip(fireClip);
+        reloadHandle = inst.animation->findClip(reloadClip);
+        zoomIdleHandle = inst.animation->findClip(zoomIdleClip);
+        zoomWalkHandle = inst.animation->findClip(zoomWalkClip);
+        zoomFireHandle = inst.animation->findClip(zoomFireClip);
     }
 
     // Pick the correct fire clip depending on ADS state, with fallback to hip-fire if zoom fire is missing
-    std::string pickFireClip(AnimationInstance& inst, bool zoom)
+    AnimationClip pickFireClip(bool zoom) const
     {
-        if (zoom && has(zoomFireClip, inst)) return zoomFireClip;
-        if (has(fireClip, inst)) return fireClip;
-        return "";
+        if (zoom && zoomFireHandle != INVALID_CLIP) return zoomFireHandle;
+        return fireHandle;
     }
 
     // Pick idle/walk clips based on movement and ADS state, with graceful fallback if zoom clips are not present
-    std::string pickLocomotionClip(AnimationInstance& inst, bool moving, bool zoom)
+    AnimationClip pickLocomotionClip(AnimationInstance& inst, bool moving, bool zoom) const
     {
         if (zoom)
         {
-            if (moving && has(zoomWalkClip, inst)) return zoomWalkClip;
-            if (!moving && has(zoomIdleClip, inst)) return zoomIdleClip;
+            if (moving && zoomWalkHandle != INVALID_CLIP) return zoomWalkHandle;
+            if (!moving && zoomIdleHandle != INVALID_CLIP) return zoomIdleHandle;
         }
 
-        if (moving && has(walkClip, inst)) return walkClip;
-        if (!moving && has(idleClip, inst)) return idleClip;
+        if (moving && walkHandle != INVALID_CLIP) return walkHandle;
+        if (!moving && idleHandle != INVALID_CLIP) return idleHandle;
 
         // Final fallback: if clip names are wrong, at least play the first available animation
-        if (inst.animation && !inst.animation->animations.empty())
-            return inst.animation->animations.begin()->first;
+        if (inst.animation && !inst.animation->clips.empty())
+            return 0;
 
-        return "";
+        return INVALID_CLIP;
     }
 
     // Select playback speed for locomotion clips (hip vs ADS variants)